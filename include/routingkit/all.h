@@ -3,10 +3,12 @@
 
 // generated using ls | sed -E "s_(.*)_#include <routingkit/\1>_"
 
+#include <routingkit/array_view.h>
 #include <routingkit/bit_vector.h>
 #include <routingkit/constants.h>
 #include <routingkit/contraction_hierarchy.h>
 #include <routingkit/customizable_contraction_hierarchy.h>
+#include <routingkit/customizable_contraction_hierarchy_metric_double_buffer.h>
 #include <routingkit/dijkstra.h>
 #include <routingkit/filter.h>
 #include <routingkit/geo_dist.h>
@@ -23,6 +25,7 @@
 #include <routingkit/osm_profile.h>
 #include <routingkit/osm_simple.h>
 #include <routingkit/permutation.h>
+#include <routingkit/query_statistics.h>
 #include <routingkit/sort.h>
 #include <routingkit/tag_map.h>
 #include <routingkit/timer.h>
@@ -0,0 +1,72 @@
+#ifndef ROUTING_KIT_ARRAY_VIEW_H
+#define ROUTING_KIT_ARRAY_VIEW_H
+
+#include <routingkit/bit_vector.h>
+
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+namespace RoutingKit{
+
+//! A read-only array that does not own its elements. It can point into a std::vector or into
+//! memory that is managed elsewhere, such as a memory mapped file. The pointed to memory must
+//! outlive the view.
+template<class T>
+class ConstArrayView{
+public:
+	ConstArrayView():data_(nullptr), size_(0){}
+	ConstArrayView(const T*data, uint64_t size):data_(data), size_(size){}
+	ConstArrayView(const std::vector<T>&v):data_(v.data()), size_(v.size()){}
+
+	const T&operator[](uint64_t i)const{
+		assert(i < size_ && "argument out of bounds");
+		return data_[i];
+	}
+
+	bool empty()const{ return size_ == 0; }
+	uint64_t size()const{ return size_; }
+
+	const T*data()const{ return data_; }
+	const T*begin()const{ return data_; }
+	const T*end()const{ return data_ + size_; }
+
+	const T&front()const{ assert(!empty()); return data_[0]; }
+	const T&back()const{ assert(!empty()); return data_[size_-1]; }
+
+	std::vector<T>to_vector()const{ return std::vector<T>(begin(), end()); }
+
+private:
+	const T*data_;
+	uint64_t size_;
+};
+
+//! A read-only view of a BitVector or of bits stored in the same layout. The memory does not
+//! need to be aligned.
+class ConstBitVectorView{
+public:
+	ConstBitVectorView():data_(nullptr), size_(0){}
+	ConstBitVectorView(const void*data, uint64_t size):data_(static_cast<const char*>(data)), size_(size){}
+	ConstBitVectorView(const BitVector&v):data_(reinterpret_cast<const char*>(v.data())), size_(v.size()){}
+
+	bool empty()const{ return size() == 0; }
+	uint64_t size()const{ return size_; }
+
+	bool is_set(uint64_t x)const{
+		assert(x < size_ && "argument out of bounds");
+		uint64_t a = x/64;
+		uint64_t b = x%64;
+		uint64_t d;
+		memcpy(&d, data_ + 8*a, 8);
+		return d & (1ull << b);
+	}
+
+private:
+	const char*data_;
+	uint64_t size_;
+};
+
+} // namespace RoutingKit
+
+#endif
@@ -5,6 +5,8 @@
 #include <routingkit/timestamp_flag.h>
 #include <routingkit/bit_vector.h>
 #include <routingkit/permutation.h>
+#include <routingkit/array_view.h>
+#include <routingkit/query_statistics.h>
 
 #include <vector>
 #include <string>
@@ -12,10 +14,21 @@
 #include <cassert>
 #include <type_traits>
 #include <climits>
+#include <memory>
 
 namespace RoutingKit
 {
 
+	// Arc IDs of a CH are 32 bit wide unless ROUTING_KIT_CH_64_BIT_ARC_ID is
+	// defined. Node IDs, weights and input arc IDs are always 32 bit wide.
+#ifdef ROUTING_KIT_CH_64_BIT_ARC_ID
+	typedef unsigned long long CHArcID;
+#else
+	typedef unsigned CHArcID;
+#endif
+
+	const CHArcID invalid_ch_arc_id = static_cast<CHArcID>(-1);
+
 	class ContractionHierarchy
 	{
 	public:
@@ -23,10 +36,25 @@ namespace RoutingKit
 
 		static ContractionHierarchy build(
 			unsigned node_count, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
-			const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count);
+			const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count,
+			unsigned thread_count = 1, bool contract_independent_node_sets = true);
+
+		static const unsigned default_checkpoint_interval_in_seconds = 1800;
+
+		static ContractionHierarchy build_with_checkpoints(
+			unsigned node_count, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
+			const std::string &checkpoint_dir, unsigned checkpoint_interval_in_seconds = default_checkpoint_interval_in_seconds,
+			const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count,
+			unsigned thread_count = 1);
 
 		static std::tuple<std::vector<unsigned int>, ContractionHierarchy> build_excluding_core(
-			std::vector<unsigned> rank_with_core, BitVector const &is_core_node, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight, double rel_core_size = 0.0, const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count);
+			std::vector<unsigned> rank_with_core, BitVector const &is_core_node, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight, double rel_core_size = 0.0, const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count,
+			unsigned thread_count = 1);
+
+		static void build_and_save_core_contraction_hierarchies(
+			std::vector<unsigned> rank_with_core, BitVector const &is_core_node, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
+			const std::string &export_dir, std::vector<double> rel_core_sizes,
+			const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count);
 
 		static void core_experiment(
 			std::vector<unsigned> rank_with_core, BitVector const &is_core_node, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight, const std::string &export_dir, double rel_core_size_start = 1.0,
@@ -35,12 +63,14 @@ namespace RoutingKit
 		static ContractionHierarchy build_given_rank(
 			std::vector<unsigned> rank,
 			std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
-			const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count);
+			const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count,
+			unsigned thread_count = 1);
 
 		static ContractionHierarchy build_given_order(
 			std::vector<unsigned> order,
 			std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
-			const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count);
+			const std::function<void(std::string)> &log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count,
+			unsigned thread_count = 1);
 
 		static ContractionHierarchy read(std::function<void(char *, unsigned long long)> data_source);
 		static ContractionHierarchy read(std::function<void(char *, unsigned long long)> data_source, unsigned long long file_size);
@@ -52,20 +82,34 @@ namespace RoutingKit
 		void write(std::ostream &out) const;
 		void save_file(const std::string &file_name) const;
 
+		// Only writes the data needed to compute distances and omits the data needed to unpack
+		// shortcuts, which makes the file about half as large. The file is read by the functions
+		// above. The resulting CH has empty shortcut vectors and has_path_data returns false.
+		void write_distance_only(std::function<void(const char *, unsigned long long)> data_sink) const;
+		void write_distance_only(std::ostream &out) const;
+		void save_distance_only_file(const std::string &file_name) const;
+
 		unsigned node_count() const
 		{
 			return rank.size();
 		}
 
+		// Returns false if the CH was read from a distance-only file. Such a CH can only be used
+		// to compute distances. Extracting a path throws a std::runtime_error.
+		bool has_path_data() const
+		{
+			return forward.shortcut_first_arc.size() == forward.head.size() && backward.shortcut_first_arc.size() == backward.head.size();
+		}
+
 		struct Side
 		{
-			std::vector<unsigned> first_out;
+			std::vector<CHArcID> first_out;
 			std::vector<unsigned> head;
 			std::vector<unsigned> weight;
 
 			BitVector is_shortcut_an_original_arc;
-			std::vector<unsigned> shortcut_first_arc;  // contains input arc ID if not shortcut
-			std::vector<unsigned> shortcut_second_arc; // contains input tail node ID if not shortcut
+			std::vector<CHArcID> shortcut_first_arc;  // contains input arc ID if not shortcut
+			std::vector<CHArcID> shortcut_second_arc; // contains input tail node ID if not shortcut
 		};
 
 		std::vector<unsigned> rank, order;
@@ -74,6 +118,87 @@ namespace RoutingKit
 
 	void check_contraction_hierarchy_for_errors(const ContractionHierarchy &ch);
 
+	// A read-only ContractionHierarchy that does not own its arrays. A view constructed from a
+	// ContractionHierarchy points into its vectors, which must outlive the view. A view returned
+	// by map_file points directly into a memory mapping of a CH file written by save_file. The
+	// mapping is shared by all copies of the view and is unmapped when the last copy is destroyed.
+	// As the mapping is read-only and backed by the file, all processes that map the same file
+	// share the page cache and opening it does not read the arcs. Only the order, which is not
+	// stored in the file, is computed and held in memory.
+	class ContractionHierarchyView
+	{
+	public:
+		ContractionHierarchyView() {}
+		ContractionHierarchyView(const ContractionHierarchy &ch);
+
+		static ContractionHierarchyView map_file(const std::string &file_name);
+
+		unsigned node_count() const
+		{
+			return rank.size();
+		}
+
+		bool has_path_data() const
+		{
+			return forward.shortcut_first_arc.size() == forward.head.size() && backward.shortcut_first_arc.size() == backward.head.size();
+		}
+
+		struct Side
+		{
+			ConstArrayView<CHArcID> first_out;
+			ConstArrayView<unsigned> head;
+			ConstArrayView<unsigned> weight;
+
+			ConstBitVectorView is_shortcut_an_original_arc;
+			ConstArrayView<CHArcID> shortcut_first_arc;
+			ConstArrayView<CHArcID> shortcut_second_arc;
+		};
+
+		ConstArrayView<unsigned> rank, order;
+		Side forward, backward;
+
+		// private:
+		std::shared_ptr<const void> storage;
+	};
+
+	// A compact CH that can only be used to compute distances. The arcs of every node are sorted
+	// by head and stored in a byte stream. Every arc consists of the difference between its head
+	// and the previous head (or the node itself for the first arc) as varint followed by the
+	// weight in weight_byte_count little-endian bytes. weight_byte_count is the smallest number
+	// of bytes that fits every weight. The arcs of node x start at byte
+	// block_first_byte[x/64] + first_byte[x] and end at the start of node x+1. All arcs of a
+	// node are therefore decoded from a single contiguous memory area.
+	class CompressedContractionHierarchy
+	{
+	public:
+		static const unsigned nodes_per_block = 64;
+
+		CompressedContractionHierarchy() : weight_byte_count(0) {}
+		explicit CompressedContractionHierarchy(const ContractionHierarchyView &ch);
+
+		static CompressedContractionHierarchy read(std::function<void(char *, unsigned long long)> data_source);
+		static CompressedContractionHierarchy load_file(const std::string &file_name);
+
+		void write(std::function<void(const char *, unsigned long long)> data_sink) const;
+		void save_file(const std::string &file_name) const;
+
+		unsigned node_count() const
+		{
+			return rank.size();
+		}
+
+		struct Side
+		{
+			std::vector<unsigned long long> block_first_byte;
+			std::vector<unsigned> first_byte;
+			std::vector<unsigned char> arc_data;
+		};
+
+		std::vector<unsigned> rank;
+		unsigned weight_byte_count;
+		Side forward, backward;
+	};
+
 	template <class Weight>
 	struct ContractionHierarchyExtraWeight
 	{
@@ -113,19 +238,23 @@ namespace RoutingKit
 		using GetExtraWeightType = typename GetExtraWeightTypeHelper<T>::type;
 	}
 
-	class ContractionHierarchyQuery
+	// The queue type can be MinIDQueue or RadixMinIDQueue. All searches of the query object only push
+	// keys that are not smaller than the last popped key, as required by RadixMinIDQueue. The query
+	// object is explicitly instantiated for both queue types.
+	template <class Queue>
+	class BasicContractionHierarchyQuery
 	{
 	public:
-		ContractionHierarchyQuery() : ch(0) {}
-		explicit ContractionHierarchyQuery(const ContractionHierarchy &ch);
+		BasicContractionHierarchyQuery() : stall_on_demand(true), settled_node_count(0), stalled_node_count(0) {}
+		explicit BasicContractionHierarchyQuery(ContractionHierarchyView ch);
 
-		ContractionHierarchyQuery &reset();
-		ContractionHierarchyQuery &reset(const ContractionHierarchy &ch);
+		BasicContractionHierarchyQuery &reset();
+		BasicContractionHierarchyQuery &reset(ContractionHierarchyView ch);
 
-		ContractionHierarchyQuery &add_source(unsigned s, unsigned dist_to_s = 0);
-		ContractionHierarchyQuery &add_target(unsigned t, unsigned dist_to_t = 0);
+		BasicContractionHierarchyQuery &add_source(unsigned s, unsigned dist_to_s = 0);
+		BasicContractionHierarchyQuery &add_target(unsigned t, unsigned dist_to_t = 0);
 
-		ContractionHierarchyQuery &run();
+		BasicContractionHierarchyQuery &run();
 
 		unsigned get_used_source();
 		unsigned get_used_target();
@@ -137,28 +266,53 @@ namespace RoutingKit
 		template <class ExtraWeight, class LinkFunction>
 		detail::GetExtraWeightType<ExtraWeight> get_extra_weight_distance(const ExtraWeight &extra_weight, const LinkFunction &link);
 
-		ContractionHierarchyQuery &reset_source();
-		ContractionHierarchyQuery &pin_targets(const std::vector<unsigned> &);
+		// Stall-on-demand skips the relaxation of the arcs of a node if the node can be reached on a
+		// shorter path through a higher ranked node. It is enabled by default and is used by run(),
+		// run_to_pinned_targets() and run_to_pinned_sources().
+		BasicContractionHierarchyQuery &set_stall_on_demand(bool enabled);
+		bool is_stall_on_demand_enabled() const;
+
+		// Number of nodes removed from the queues and the number of these nodes that were stalled.
+		// The counters are set to zero by reset(), reset_source() and reset_target().
+		unsigned get_settled_node_count() const;
+		unsigned get_stalled_node_count() const;
+
+		// Detailed counters filled by run(), run_to_pinned_targets(), run_to_pinned_sources(),
+		// get_distances_from_sources_to_pinned_targets(), get_node_path() and get_arc_path(). They are
+		// cleared by the same functions as the counters above and stay zero unless RoutingKit is compiled
+		// with ROUTING_KIT_QUERY_STATISTICS.
+		const QueryStatistics &get_statistics() const;
+
+		BasicContractionHierarchyQuery &reset_source();
+		BasicContractionHierarchyQuery &pin_targets(const std::vector<unsigned> &);
 		unsigned get_pinned_target_count();
-		ContractionHierarchyQuery &run_to_pinned_targets();
+		BasicContractionHierarchyQuery &run_to_pinned_targets();
 
-		ContractionHierarchyQuery &get_distances_to_targets(unsigned *dist);
+		BasicContractionHierarchyQuery &get_distances_to_targets(unsigned *dist);
 		std::vector<unsigned> get_distances_to_targets();
 
-		ContractionHierarchyQuery &reset_target();
-		ContractionHierarchyQuery &pin_sources(const std::vector<unsigned> &);
+		// Computes the distances from every node in source_list to all pinned targets and stores them row by row,
+		// i.e., the distance from source_list[s] to the t-th pinned target is at dist[s*get_pinned_target_count()+t].
+		// The sources are processed in groups. The upward searches of a group are run one after another, but the
+		// downward sweep over the pinned targets' search space is done once per group and relaxes every arc for all
+		// sources of the group at once. Any sources added before are discarded.
+		BasicContractionHierarchyQuery &get_distances_from_sources_to_pinned_targets(const std::vector<unsigned> &source_list, unsigned *dist);
+		std::vector<unsigned> get_distances_from_sources_to_pinned_targets(const std::vector<unsigned> &source_list);
+
+		BasicContractionHierarchyQuery &reset_target();
+		BasicContractionHierarchyQuery &pin_sources(const std::vector<unsigned> &);
 		unsigned get_pinned_source_count();
-		ContractionHierarchyQuery &run_to_pinned_sources();
+		BasicContractionHierarchyQuery &run_to_pinned_sources();
 
-		ContractionHierarchyQuery &get_distances_to_sources(unsigned *dist);
+		BasicContractionHierarchyQuery &get_distances_to_sources(unsigned *dist);
 		std::vector<unsigned> get_distances_to_sources();
 
 		// TODO: Mirror these functions in CCH
 
-		ContractionHierarchyQuery &get_used_sources_to_targets(unsigned *dist);
+		BasicContractionHierarchyQuery &get_used_sources_to_targets(unsigned *dist);
 		std::vector<unsigned> get_used_sources_to_targets();
 
-		ContractionHierarchyQuery &get_used_targets_to_sources(unsigned *dist);
+		BasicContractionHierarchyQuery &get_used_targets_to_sources(unsigned *dist);
 		std::vector<unsigned> get_used_targets_to_sources();
 
 		// The get_extra_weight_distances function follow a pattern.
@@ -209,25 +363,32 @@ namespace RoutingKit
 		template <class ExtraWeight, class LinkFunction, class TmpContainer>
 		std::vector<detail::GetExtraWeightType<ExtraWeight>> get_extra_weight_distances_to_targets(const ExtraWeight &extra_weight, const LinkFunction &link, TmpContainer &tmp);
 		template <class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer>
-		ContractionHierarchyQuery &get_extra_weight_distances_to_targets(const ExtraWeight &extra_weight, const LinkFunction &link, TmpContainer &tmp, DistContainer &dist);
+		BasicContractionHierarchyQuery &get_extra_weight_distances_to_targets(const ExtraWeight &extra_weight, const LinkFunction &link, TmpContainer &tmp, DistContainer &dist);
 		template <class ExtraWeight, class LinkFunction>
 		std::vector<detail::GetExtraWeightType<ExtraWeight>> get_extra_weight_distances_to_sources(const ExtraWeight &extra_weight, const LinkFunction &link);
 		template <class ExtraWeight, class LinkFunction, class TmpContainer>
 		std::vector<detail::GetExtraWeightType<ExtraWeight>> get_extra_weight_distances_to_sources(const ExtraWeight &extra_weight, const LinkFunction &link, TmpContainer &tmp);
 		template <class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer>
-		ContractionHierarchyQuery &get_extra_weight_distances_to_sources(const ExtraWeight &extra_weight, const LinkFunction &link, TmpContainer &tmp, DistContainer &dist);
+		BasicContractionHierarchyQuery &get_extra_weight_distances_to_sources(const ExtraWeight &extra_weight, const LinkFunction &link, TmpContainer &tmp, DistContainer &dist);
 
 		// private:
-		const ContractionHierarchy *ch;
+		ContractionHierarchyView ch;
 
 		TimestampFlags was_forward_pushed, was_backward_pushed;
-		MinIDQueue forward_queue, backward_queue;
+		Queue forward_queue, backward_queue;
 		std::vector<unsigned> forward_tentative_distance, backward_tentative_distance;
 		std::vector<unsigned> forward_predecessor_node, backward_predecessor_node;
-		std::vector<unsigned> forward_predecessor_arc, backward_predecessor_arc;
+		std::vector<CHArcID> forward_predecessor_arc, backward_predecessor_arc;
 		unsigned shortest_path_meeting_node;
 		unsigned many_to_many_source_or_target_count;
 
+		bool stall_on_demand;
+		unsigned settled_node_count, stalled_node_count;
+		QueryStatistics statistics;
+
+		// Only allocated by get_distances_from_sources_to_pinned_targets.
+		std::vector<unsigned> batch_select_position, batch_distance;
+
 		enum class InternalState : unsigned
 		{
 			initialized,
@@ -239,6 +400,342 @@ namespace RoutingKit
 		} state;
 	};
 
+	typedef BasicContractionHierarchyQuery<MinIDQueue> ContractionHierarchyQuery;
+
+	// Computes distances on a CompressedContractionHierarchy with stall-on-demand. Its interface
+	// is the subset of ContractionHierarchyQuery that does not require path data.
+	class CompressedContractionHierarchyQuery
+	{
+	public:
+		CompressedContractionHierarchyQuery() : ch(0), settled_node_count(0), stalled_node_count(0) {}
+		explicit CompressedContractionHierarchyQuery(const CompressedContractionHierarchy &ch);
+
+		CompressedContractionHierarchyQuery &reset();
+		CompressedContractionHierarchyQuery &reset(const CompressedContractionHierarchy &ch);
+
+		CompressedContractionHierarchyQuery &add_source(unsigned s, unsigned dist_to_s = 0);
+		CompressedContractionHierarchyQuery &add_target(unsigned t, unsigned dist_to_t = 0);
+
+		CompressedContractionHierarchyQuery &run();
+
+		unsigned get_distance();
+
+		unsigned get_settled_node_count() const;
+		unsigned get_stalled_node_count() const;
+
+		// private:
+		const CompressedContractionHierarchy *ch;
+
+		TimestampFlags was_forward_pushed, was_backward_pushed;
+		MinIDQueue forward_queue, backward_queue;
+		std::vector<unsigned> forward_tentative_distance, backward_tentative_distance;
+
+		unsigned shortest_path_length;
+		unsigned settled_node_count;
+		unsigned stalled_node_count;
+
+		enum class InternalState
+		{
+			initialized,
+			run
+		} state;
+	};
+
+	// Runs many independent queries on several threads. Every thread owns a ContractionHierarchyQuery
+	// object. The queries are handed out in small chunks to whichever thread is idle, so that threads
+	// that got short queries take over the remaining work. All results are in the order of the input.
+	// If RoutingKit is compiled without OpenMP, then all queries are run on the calling thread.
+	class ContractionHierarchyBatchQuery
+	{
+	public:
+		ContractionHierarchyBatchQuery() {}
+		// If thread_count is zero, one thread per processor is used.
+		explicit ContractionHierarchyBatchQuery(ContractionHierarchyView ch, unsigned thread_count = 0);
+
+		ContractionHierarchyBatchQuery &reset(ContractionHierarchyView ch, unsigned thread_count = 0);
+
+		unsigned get_thread_count() const;
+
+		// Computes the distance from source_list[i] to target_list[i] for every i. Unreachable pairs
+		// have distance inf_weight.
+		ContractionHierarchyBatchQuery &get_distances(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list, unsigned *dist);
+		std::vector<unsigned> get_distances(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list);
+
+		// The same as get_distances but also computes the shortest paths. The paths of unreachable pairs
+		// are empty. Throws a std::runtime_error before any query runs if the CH has no path data.
+		ContractionHierarchyBatchQuery &get_node_paths(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list, unsigned *dist, std::vector<unsigned> *node_path);
+		std::vector<std::vector<unsigned>> get_node_paths(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list);
+
+		ContractionHierarchyBatchQuery &get_arc_paths(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list, unsigned *dist, std::vector<unsigned> *arc_path);
+		std::vector<std::vector<unsigned>> get_arc_paths(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list);
+
+		// Runs one one-to-many job per source against the same set of targets. Every thread pins the
+		// targets once. The distances are stored row by row, i.e., the distance from source_list[s] to
+		// target_list[t] is at dist[s*target_list.size()+t].
+		ContractionHierarchyBatchQuery &get_distances_to_targets(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list, unsigned *dist);
+		std::vector<unsigned> get_distances_to_targets(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list);
+
+		// private:
+		std::vector<ContractionHierarchyQuery> query;
+	};
+
+	// Computes dense distance tables between a set of source nodes and a set of target nodes.
+	// pin_targets runs one upward backward search per target and stores the reached nodes in
+	// per-node buckets. run then runs one upward forward search per source and scans the buckets
+	// of the settled nodes. The buckets are kept, i.e., several source sets can be run against the
+	// same pinned targets.
+	class ContractionHierarchyManyToMany
+	{
+	public:
+		ContractionHierarchyManyToMany() : ch(0) {}
+		explicit ContractionHierarchyManyToMany(const ContractionHierarchy &ch);
+
+		ContractionHierarchyManyToMany &reset();
+		ContractionHierarchyManyToMany &reset(const ContractionHierarchy &ch);
+
+		ContractionHierarchyManyToMany &pin_targets(const std::vector<unsigned> &target_list);
+		ContractionHierarchyManyToMany &run(const std::vector<unsigned> &source_list);
+
+		unsigned get_source_count() const;
+		unsigned get_target_count() const;
+
+		// The distances are stored row by row, i.e., the distance from source_list[s] to
+		// target_list[t] is at position s*get_target_count()+t. Unreachable pairs have
+		// distance inf_weight.
+		unsigned get_distance(unsigned source_index, unsigned target_index) const;
+		ContractionHierarchyManyToMany &get_distances(unsigned *dist);
+		std::vector<unsigned> get_distances();
+
+		// For every target, the closest source node, and for every source, the closest target node.
+		// If no source or target can be reached, then the entry is invalid_id.
+		ContractionHierarchyManyToMany &get_used_sources_to_targets(unsigned *used_source);
+		std::vector<unsigned> get_used_sources_to_targets();
+
+		ContractionHierarchyManyToMany &get_used_targets_to_sources(unsigned *used_target);
+		std::vector<unsigned> get_used_targets_to_sources();
+
+		// private:
+		const ContractionHierarchy *ch;
+
+		TimestampFlags was_pushed;
+		MinIDQueue queue;
+		std::vector<unsigned> tentative_distance;
+
+		std::vector<unsigned> source_list, target_list;
+
+		// The bucket of node x consists of the entries bucket_first_entry[x] ... bucket_first_entry[x+1]-1.
+		// The entries of a bucket are sorted by target index.
+		std::vector<unsigned> bucket_first_entry;
+		std::vector<unsigned> bucket_target, bucket_distance;
+
+		std::vector<unsigned> distance;
+
+		enum class InternalState : unsigned
+		{
+			initialized,
+			target_pinned,
+			run
+		} state;
+	};
+
+	// Computes the distances from the sources to all nodes using PHAST. An upward search from the sources
+	// is followed by a linear sweep over all nodes by decreasing rank that relaxes the backward arcs.
+	// Within the CH, the node IDs are the ranks, so the sweep reads ch.backward sequentially.
+	class ContractionHierarchyOneToAll
+	{
+	public:
+		ContractionHierarchyOneToAll() : ch(0) {}
+		explicit ContractionHierarchyOneToAll(const ContractionHierarchy &ch);
+
+		ContractionHierarchyOneToAll &reset();
+		ContractionHierarchyOneToAll &reset(const ContractionHierarchy &ch);
+
+		ContractionHierarchyOneToAll &add_source(unsigned s, unsigned dist_to_s = 0);
+		ContractionHierarchyOneToAll &run();
+
+		// The distance from the closest source to node x, or inf_weight if x is unreachable.
+		unsigned get_distance(unsigned x) const;
+		ContractionHierarchyOneToAll &get_distances(unsigned *dist);
+		std::vector<unsigned> get_distances();
+
+		// Computes the distances from every node in source_list to all nodes. The distance from source_list[s]
+		// to node x is stored at dist[s*node_count+x]. Groups of sources share one sweep, which relaxes every
+		// arc for all sources of the group at once. The sources added with add_source are not affected.
+		ContractionHierarchyOneToAll &get_distances_from_sources(const std::vector<unsigned> &source_list, unsigned *dist);
+		std::vector<unsigned> get_distances_from_sources(const std::vector<unsigned> &source_list);
+
+		// private:
+		const ContractionHierarchy *ch;
+
+		TimestampFlags was_pushed;
+		MinIDQueue queue;
+		std::vector<unsigned> tentative_distance;
+
+		// Only allocated by get_distances_from_sources.
+		std::vector<unsigned> batch_distance;
+
+		enum class InternalState : unsigned
+		{
+			initialized,
+			run
+		} state;
+	};
+
+	// Answers queries on a core CH as built by ContractionHierarchy::build_excluding_core. The core consists
+	// of the core_node_count highest ranked nodes. They are not contracted and their forward and backward
+	// arcs are the outgoing and incoming arcs of the remaining core graph, which may lead to lower ranked
+	// core nodes. The searches are upward CH searches until they reach the core and continue as a
+	// bidirectional Dijkstra inside the core. Stall-on-demand is only used outside of the core.
+	class CoreContractionHierarchyQuery
+	{
+	public:
+		CoreContractionHierarchyQuery() : ch(0), core_rank_begin(0), settled_node_count(0), stalled_node_count(0) {}
+		CoreContractionHierarchyQuery(const ContractionHierarchy &ch, unsigned core_node_count);
+
+		CoreContractionHierarchyQuery &reset();
+		CoreContractionHierarchyQuery &reset(const ContractionHierarchy &ch, unsigned core_node_count);
+
+		CoreContractionHierarchyQuery &add_source(unsigned s, unsigned dist_to_s = 0);
+		CoreContractionHierarchyQuery &add_target(unsigned t, unsigned dist_to_t = 0);
+
+		CoreContractionHierarchyQuery &run();
+
+		unsigned get_used_source();
+		unsigned get_used_target();
+
+		unsigned get_distance();
+		std::vector<unsigned> get_node_path();
+		std::vector<unsigned> get_arc_path();
+
+		unsigned get_core_node_count() const;
+		bool is_core_node(unsigned x) const;
+
+		// Number of nodes removed from the queues and the number of these nodes that were stalled.
+		// The counters are set to zero by reset() and reset_source().
+		unsigned get_settled_node_count() const;
+		unsigned get_stalled_node_count() const;
+
+		// The forward search of run_to_pinned_targets does not stop before the core is exhausted.
+		// The distances to the core nodes are then relaxed downwards to the targets in a single sweep
+		// over the non-core nodes of the backward search spaces of the targets.
+		CoreContractionHierarchyQuery &reset_source();
+		CoreContractionHierarchyQuery &pin_targets(const std::vector<unsigned> &target_list);
+		unsigned get_pinned_target_count();
+		CoreContractionHierarchyQuery &run_to_pinned_targets();
+
+		CoreContractionHierarchyQuery &get_distances_to_targets(unsigned *dist);
+		std::vector<unsigned> get_distances_to_targets();
+
+		// private:
+		const ContractionHierarchy *ch;
+		unsigned core_rank_begin;
+
+		TimestampFlags was_forward_pushed, was_backward_pushed;
+		MinIDQueue forward_queue, backward_queue;
+		std::vector<unsigned> forward_tentative_distance, backward_tentative_distance;
+		std::vector<unsigned> forward_predecessor_node, backward_predecessor_node;
+		std::vector<CHArcID> forward_predecessor_arc, backward_predecessor_arc;
+		unsigned shortest_path_meeting_node;
+
+		// Only used with pinned targets. The select list contains the non-core nodes that the sweep
+		// relaxes, sorted by decreasing rank.
+		std::vector<unsigned> target_list, select_list;
+
+		unsigned settled_node_count, stalled_node_count;
+
+		enum class InternalState : unsigned
+		{
+			initialized,
+			run,
+			target_pinned,
+			target_run
+		} state;
+	};
+
+	// Computes routes that respect a maximum driving time on a core CH in which all parking nodes are in the
+	// core. After at most max_driving_time units of driving, the driver must take a break of break_duration
+	// at a parking node. The query minimizes the total travel time including the breaks. Within the core,
+	// it runs a label-setting search whose labels consist of the travel time and the driving time since
+	// the last break. A label is pruned if another label at the same node is not worse in both values.
+	class CoreContractionHierarchyBreakQuery
+	{
+	public:
+		// 4.5h of driving followed by a 45min break, in milliseconds
+		static const unsigned default_max_driving_time = 16200000;
+		static const unsigned default_break_duration = 2700000;
+
+		CoreContractionHierarchyBreakQuery() : ch(0) {}
+		CoreContractionHierarchyBreakQuery(
+			const ContractionHierarchy &ch, unsigned core_node_count, const BitVector &is_parking_node,
+			unsigned max_driving_time = default_max_driving_time, unsigned break_duration = default_break_duration);
+
+		CoreContractionHierarchyBreakQuery &reset();
+
+		CoreContractionHierarchyBreakQuery &add_source(unsigned s);
+		CoreContractionHierarchyBreakQuery &add_target(unsigned t);
+
+		CoreContractionHierarchyBreakQuery &run();
+
+		// The total travel time including the breaks, or inf_weight if no route respects the driving time limit.
+		unsigned get_distance();
+		unsigned get_break_count();
+		std::vector<unsigned> get_break_nodes();
+		std::vector<unsigned> get_node_path();
+		std::vector<unsigned> get_arc_path();
+
+		unsigned get_created_label_count() const;
+		unsigned get_pruned_label_count() const;
+		unsigned get_settled_label_count() const;
+
+		// private:
+		struct Label
+		{
+			unsigned node;
+			unsigned travel_time;
+			unsigned driving_time;
+			unsigned parent_label;
+			// invalid_ch_arc_id if the label was created by a break or by the upward search.
+			CHArcID parent_arc;
+			bool is_settled;
+		};
+
+		const ContractionHierarchy *ch;
+		unsigned core_rank_begin;
+		unsigned max_driving_time, break_duration;
+		BitVector is_parking_rank;
+
+		unsigned source, target;
+
+		TimestampFlags was_forward_pushed, was_backward_pushed;
+		MinIDQueue forward_queue, backward_queue;
+		std::vector<unsigned> forward_tentative_distance, backward_tentative_distance;
+		std::vector<unsigned> forward_predecessor_node, backward_predecessor_node;
+		std::vector<CHArcID> forward_predecessor_arc, backward_predecessor_arc;
+		std::vector<unsigned> forward_search_space, backward_search_space;
+
+		// Indexed by rank-core_rank_begin. A bag holds the IDs of the labels at a core node that are
+		// not dominated.
+		MinIDQueue label_queue;
+		std::vector<Label> label_list;
+		std::vector<std::vector<unsigned>> bag;
+		std::vector<unsigned> nonempty_bag_list;
+
+		// If shortest_path_label is invalid_id, then the route does not use the core and
+		// shortest_path_meeting_node is the meeting node of the upward searches. Otherwise it is the node
+		// at which the route leaves the core.
+		unsigned shortest_path_length;
+		unsigned shortest_path_meeting_node;
+		unsigned shortest_path_label;
+
+		unsigned created_label_count, pruned_label_count, settled_label_count;
+
+		enum class InternalState : unsigned
+		{
+			initialized,
+			run
+		} state;
+	};
+
 	struct SaturatedWeightAddition
 	{
 		unsigned operator()(unsigned l, unsigned r) const;
@@ -247,30 +744,149 @@ namespace RoutingKit
 
 	// ------ Template & inline implementations; no more interface descriptions beyond this line -------
 
-	inline unsigned ContractionHierarchyQuery::get_pinned_target_count()
+	template <class Queue>
+	inline unsigned BasicContractionHierarchyQuery<Queue>::get_pinned_target_count()
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::target_run || state == ContractionHierarchyQuery::InternalState::target_pinned);
+		assert(state == InternalState::target_run || state == InternalState::target_pinned);
 		return many_to_many_source_or_target_count;
 	}
 
-	inline unsigned ContractionHierarchyQuery::get_pinned_source_count()
+	template <class Queue>
+	inline unsigned BasicContractionHierarchyQuery<Queue>::get_pinned_source_count()
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::source_run || state == ContractionHierarchyQuery::InternalState::source_pinned);
+		assert(state == InternalState::source_run || state == InternalState::source_pinned);
 		return many_to_many_source_or_target_count;
 	}
 
+	template <class Queue>
+	inline BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::set_stall_on_demand(bool enabled)
+	{
+		stall_on_demand = enabled;
+		return *this;
+	}
+
+	template <class Queue>
+	inline bool BasicContractionHierarchyQuery<Queue>::is_stall_on_demand_enabled() const
+	{
+		return stall_on_demand;
+	}
+
+	template <class Queue>
+	inline unsigned BasicContractionHierarchyQuery<Queue>::get_settled_node_count() const
+	{
+		return settled_node_count;
+	}
+
+	template <class Queue>
+	inline unsigned BasicContractionHierarchyQuery<Queue>::get_stalled_node_count() const
+	{
+		return stalled_node_count;
+	}
+
+	template <class Queue>
+	inline const QueryStatistics &BasicContractionHierarchyQuery<Queue>::get_statistics() const
+	{
+		return statistics;
+	}
+
+	inline unsigned ContractionHierarchyBatchQuery::get_thread_count() const
+	{
+		return query.size();
+	}
+
+	inline unsigned ContractionHierarchyManyToMany::get_source_count() const
+	{
+		assert(state == ContractionHierarchyManyToMany::InternalState::run);
+		return source_list.size();
+	}
+
+	inline unsigned ContractionHierarchyManyToMany::get_target_count() const
+	{
+		assert(state == ContractionHierarchyManyToMany::InternalState::target_pinned || state == ContractionHierarchyManyToMany::InternalState::run);
+		return target_list.size();
+	}
+
+	inline unsigned ContractionHierarchyManyToMany::get_distance(unsigned source_index, unsigned target_index) const
+	{
+		assert(state == ContractionHierarchyManyToMany::InternalState::run);
+		assert(source_index < source_list.size() && "source index out of bounds");
+		assert(target_index < target_list.size() && "target index out of bounds");
+		return distance[(unsigned long long)source_index * target_list.size() + target_index];
+	}
+
+	inline unsigned ContractionHierarchyOneToAll::get_distance(unsigned x) const
+	{
+		assert(state == ContractionHierarchyOneToAll::InternalState::run);
+		assert(x < ch->node_count() && "node out of bounds");
+		return tentative_distance[ch->rank[x]];
+	}
+
+	inline unsigned CoreContractionHierarchyQuery::get_core_node_count() const
+	{
+		return ch->node_count() - core_rank_begin;
+	}
+
+	inline unsigned CompressedContractionHierarchyQuery::get_settled_node_count() const
+	{
+		return settled_node_count;
+	}
+
+	inline unsigned CompressedContractionHierarchyQuery::get_stalled_node_count() const
+	{
+		return stalled_node_count;
+	}
+
+	inline bool CoreContractionHierarchyQuery::is_core_node(unsigned x) const
+	{
+		assert(x < ch->node_count() && "node out of bounds");
+		return ch->rank[x] >= core_rank_begin;
+	}
+
+	inline unsigned CoreContractionHierarchyQuery::get_settled_node_count() const
+	{
+		return settled_node_count;
+	}
+
+	inline unsigned CoreContractionHierarchyQuery::get_stalled_node_count() const
+	{
+		return stalled_node_count;
+	}
+
+	inline unsigned CoreContractionHierarchyQuery::get_pinned_target_count()
+	{
+		assert(state == CoreContractionHierarchyQuery::InternalState::target_pinned || state == CoreContractionHierarchyQuery::InternalState::target_run);
+		return target_list.size();
+	}
+
+	inline unsigned CoreContractionHierarchyBreakQuery::get_created_label_count() const
+	{
+		return created_label_count;
+	}
+
+	inline unsigned CoreContractionHierarchyBreakQuery::get_pruned_label_count() const
+	{
+		return pruned_label_count;
+	}
+
+	inline unsigned CoreContractionHierarchyBreakQuery::get_settled_label_count() const
+	{
+		return settled_label_count;
+	}
+
+	template <class Queue>
 	template <class ExtraWeight, class LinkFunction>
-	std::vector<detail::GetExtraWeightType<ExtraWeight>> ContractionHierarchyQuery::get_extra_weight_distances_to_targets(
+	std::vector<detail::GetExtraWeightType<ExtraWeight>> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_targets(
 		const ExtraWeight &extra_weight,
 		const LinkFunction &link)
 	{
-		std::vector<detail::GetExtraWeightType<ExtraWeight>> tmp(ch->node_count()), dist(get_pinned_target_count());
+		std::vector<detail::GetExtraWeightType<ExtraWeight>> tmp(ch.node_count()), dist(get_pinned_target_count());
 		get_extra_weight_distances_to_targets(extra_weight, link, tmp, dist);
 		return dist; // NVRO
 	}
 
+	template <class Queue>
 	template <class ExtraWeight, class LinkFunction, class TmpContainer>
-	std::vector<detail::GetExtraWeightType<ExtraWeight>> ContractionHierarchyQuery::get_extra_weight_distances_to_targets(
+	std::vector<detail::GetExtraWeightType<ExtraWeight>> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_targets(
 		const ExtraWeight &extra_weight,
 		const LinkFunction &link,
 		TmpContainer &tmp)
@@ -280,18 +896,20 @@ namespace RoutingKit
 		return dist; // NVRO
 	}
 
+	template <class Queue>
 	template <class ExtraWeight, class LinkFunction>
-	std::vector<detail::GetExtraWeightType<ExtraWeight>> ContractionHierarchyQuery::get_extra_weight_distances_to_sources(
+	std::vector<detail::GetExtraWeightType<ExtraWeight>> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_sources(
 		const ExtraWeight &extra_weight,
 		const LinkFunction &link)
 	{
-		std::vector<detail::GetExtraWeightType<ExtraWeight>> tmp(ch->node_count()), dist(get_pinned_source_count());
+		std::vector<detail::GetExtraWeightType<ExtraWeight>> tmp(ch.node_count()), dist(get_pinned_source_count());
 		get_extra_weight_distances_to_sources(extra_weight, link, tmp, dist);
 		return dist; // NVRO
 	}
 
+	template <class Queue>
 	template <class ExtraWeight, class LinkFunction, class TmpContainer>
-	std::vector<detail::GetExtraWeightType<ExtraWeight>> ContractionHierarchyQuery::get_extra_weight_distances_to_sources(
+	std::vector<detail::GetExtraWeightType<ExtraWeight>> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_sources(
 		const ExtraWeight &extra_weight,
 		const LinkFunction &link,
 		TmpContainer &tmp)
@@ -360,11 +978,11 @@ namespace RoutingKit
 			const InputWeightContainer &input_weight;
 			const LinkFunction &link;
 
-			const ContractionHierarchy &ch;
+			ContractionHierarchyView ch;
 
-			ShortcutWeights(const InputWeightContainer &input_weight, const LinkFunction &link, const ContractionHierarchy &ch) : input_weight(input_weight), link(link), ch(ch) {}
+			ShortcutWeights(const InputWeightContainer &input_weight, const LinkFunction &link, ContractionHierarchyView ch) : input_weight(input_weight), link(link), ch(ch) {}
 
-			Weight get_forward_weight(unsigned a) const
+			Weight get_forward_weight(CHArcID a) const
 			{
 				assert(a < ch.forward.is_shortcut_an_original_arc.size());
 				if (ch.forward.is_shortcut_an_original_arc.is_set(a))
@@ -377,7 +995,7 @@ namespace RoutingKit
 				}
 			}
 
-			Weight get_backward_weight(unsigned a) const
+			Weight get_backward_weight(CHArcID a) const
 			{
 				assert(a < ch.backward.is_shortcut_an_original_arc.size());
 				if (ch.backward.is_shortcut_an_original_arc.is_set(a))
@@ -399,21 +1017,21 @@ namespace RoutingKit
 
 			const ContractionHierarchyExtraWeight<WeightT> &extra_weight;
 
-			explicit ShortcutWeights(const ContractionHierarchyExtraWeight<WeightT> &extra_weight, const LinkFunction &, const ContractionHierarchy &) : extra_weight(extra_weight) {}
+			explicit ShortcutWeights(const ContractionHierarchyExtraWeight<WeightT> &extra_weight, const LinkFunction &, const ContractionHierarchyView &) : extra_weight(extra_weight) {}
 
-			const Weight &get_forward_weight(unsigned a) const
+			const Weight &get_forward_weight(CHArcID a) const
 			{
 				return extra_weight.forward_weight[a];
 			}
 
-			const Weight &get_backward_weight(unsigned a) const
+			const Weight &get_backward_weight(CHArcID a) const
 			{
 				return extra_weight.backward_weight[a];
 			}
 		};
 
 		template <class ExtraWeight, class LinkFunction>
-		ShortcutWeights<ExtraWeight, LinkFunction> make_shortcut_weights(const ExtraWeight &extra_weight, const LinkFunction &link, const ContractionHierarchy &ch)
+		ShortcutWeights<ExtraWeight, LinkFunction> make_shortcut_weights(const ExtraWeight &extra_weight, const LinkFunction &link, const ContractionHierarchyView &ch)
 		{
 			return ShortcutWeights<ExtraWeight, LinkFunction>{extra_weight, link, ch};
 		}
@@ -427,12 +1045,12 @@ namespace RoutingKit
 
 			explicit InvertShorcutWeights(const ShortcutWeights &shortcut_weights) : shortcut_weights(shortcut_weights) {}
 
-			auto get_forward_weight(unsigned a) const -> decltype(std::declval<ShortcutWeights>().get_backward_weight(a))
+			auto get_forward_weight(CHArcID a) const -> decltype(std::declval<ShortcutWeights>().get_backward_weight(a))
 			{
 				return shortcut_weights.get_backward_weight(a);
 			}
 
-			auto get_backward_weight(unsigned a) const -> decltype(std::declval<ShortcutWeights>().get_forward_weight(a))
+			auto get_backward_weight(CHArcID a) const -> decltype(std::declval<ShortcutWeights>().get_forward_weight(a))
 			{
 				return shortcut_weights.get_forward_weight(a);
 			}
@@ -448,7 +1066,7 @@ namespace RoutingKit
 		ReturnTypeWhenPassedIntOf<GetForwardWeight> get_extra_weight_up_distance(
 			unsigned shortest_path_meeting_node,
 			const std::vector<unsigned> &forward_predecessor_node,
-			const std::vector<unsigned> &forward_predecessor_arc,
+			const std::vector<CHArcID> &forward_predecessor_arc,
 			const GetForwardWeight &get_forward_extra_weight,
 			const LinkFunction &link)
 		{
@@ -473,9 +1091,9 @@ namespace RoutingKit
 			const LinkFunction &link,
 			unsigned shortest_path_meeting_node,
 			const std::vector<unsigned> &forward_predecessor_node,
-			const std::vector<unsigned> &forward_predecessor_arc,
+			const std::vector<CHArcID> &forward_predecessor_arc,
 			const std::vector<unsigned> &backward_predecessor_node,
-			const std::vector<unsigned> &backward_predecessor_arc)
+			const std::vector<CHArcID> &backward_predecessor_arc)
 		{
 			using Weight = typename ShortcutWeights::Weight;
 
@@ -500,14 +1118,14 @@ namespace RoutingKit
 						shortest_path_meeting_node,
 						forward_predecessor_node,
 						forward_predecessor_arc,
-						[&](unsigned a) -> decltype(shortcut_weights.get_forward_weight(a))
+						[&](CHArcID a) -> decltype(shortcut_weights.get_forward_weight(a))
 						{ return shortcut_weights.get_forward_weight(a); },
 						link),
 					detail::get_extra_weight_up_distance(
 						shortest_path_meeting_node,
 						backward_predecessor_node,
 						backward_predecessor_arc,
-						[&](unsigned a) -> decltype(shortcut_weights.get_backward_weight(a))
+						[&](CHArcID a) -> decltype(shortcut_weights.get_backward_weight(a))
 						{ return shortcut_weights.get_backward_weight(a); },
 						inverted_link));
 			}
@@ -517,7 +1135,7 @@ namespace RoutingKit
 					shortest_path_meeting_node,
 					forward_predecessor_node,
 					forward_predecessor_arc,
-					[&](unsigned a) -> decltype(shortcut_weights.get_forward_weight(a))
+					[&](CHArcID a) -> decltype(shortcut_weights.get_forward_weight(a))
 					{ return shortcut_weights.get_forward_weight(a); },
 					link);
 			}
@@ -527,7 +1145,7 @@ namespace RoutingKit
 					shortest_path_meeting_node,
 					backward_predecessor_node,
 					backward_predecessor_arc,
-					[&](unsigned a) -> decltype(shortcut_weights.get_backward_weight(a))
+					[&](CHArcID a) -> decltype(shortcut_weights.get_backward_weight(a))
 					{ return shortcut_weights.get_backward_weight(a); },
 					inverted_link);
 			}
@@ -535,15 +1153,16 @@ namespace RoutingKit
 
 	}
 
+	template <class Queue>
 	template <class ExtraWeight, class LinkFunction>
-	detail::GetExtraWeightType<ExtraWeight> ContractionHierarchyQuery::get_extra_weight_distance(
+	detail::GetExtraWeightType<ExtraWeight> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distance(
 		const ExtraWeight &extra_weight,
 		const LinkFunction &link)
 	{
-		assert(ch && "query object must have an attached CH");
-		assert(state == ContractionHierarchyQuery::InternalState::run);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert(state == InternalState::run);
 
-		auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, *ch);
+		auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, ch);
 
 		return detail::internal_get_extra_weight_distance(
 			shortcut_weight, link,
@@ -563,7 +1182,7 @@ namespace RoutingKit
 
 		for (unsigned x = 0; x < node_count; ++x)
 		{
-			for (unsigned xy = ch.forward.first_out[x]; xy < ch.forward.first_out[x + 1]; ++xy)
+			for (CHArcID xy = ch.forward.first_out[x]; xy < ch.forward.first_out[x + 1]; ++xy)
 			{
 				if (ch.forward.is_shortcut_an_original_arc.is_set(xy))
 				{
@@ -576,7 +1195,7 @@ namespace RoutingKit
 						forward_weight[ch.forward.shortcut_second_arc[xy]]);
 				}
 			}
-			for (unsigned xy = ch.backward.first_out[x]; xy < ch.backward.first_out[x + 1]; ++xy)
+			for (CHArcID xy = ch.backward.first_out[x]; xy < ch.backward.first_out[x + 1]; ++xy)
 			{
 				if (ch.backward.is_shortcut_an_original_arc.is_set(xy))
 				{
@@ -602,20 +1221,20 @@ namespace RoutingKit
 
 			const TimestampFlags &has_forward_predecessor,
 			const std::vector<unsigned> &forward_predecessor_node,
-			const std::vector<unsigned> &predecessor_arc,
+			const std::vector<CHArcID> &predecessor_arc,
 
 			const ExtraWeight &extra_weight,
-			const std::vector<unsigned> &forward_first_out,
-			const std::vector<unsigned> &forward_head,
-			const std::vector<unsigned> &backward_first_out,
-			const std::vector<unsigned> &backward_head,
+			ConstArrayView<CHArcID> forward_first_out,
+			ConstArrayView<unsigned> forward_head,
+			ConstArrayView<CHArcID> backward_first_out,
+			ConstArrayView<unsigned> backward_head,
 
 			TmpContainer &source_to_node_distance,
 			TimestampFlags &has_source_to_node_distance,
 
 			DistContainer &output,
 
-			std::vector<unsigned> &stack,
+			std::vector<CHArcID> &stack,
 
 			const LinkFunction &link)
 		{
@@ -632,7 +1251,7 @@ namespace RoutingKit
 				stack[stack_size++] = x;
 			};
 
-			auto pop = [&]
+			auto pop = [&]() -> CHArcID
 			{
 				assert(stack_size != 0);
 				return stack[--stack_size];
@@ -644,7 +1263,7 @@ namespace RoutingKit
 				assert(has_forward_predecessor.is_set(x));
 				assert(forward_predecessor_node[x] != invalid_id);
 
-				unsigned a = predecessor_arc[x];
+				CHArcID a = predecessor_arc[x];
 				unsigned p = forward_predecessor_node[x];
 
 				if (has_source_to_node_distance.is_set(p))
@@ -659,7 +1278,7 @@ namespace RoutingKit
 				assert(!has_source_to_node_distance.is_set(x));
 				assert(!has_forward_predecessor.is_set(x));
 
-				unsigned a = predecessor_arc[x];
+				CHArcID a = predecessor_arc[x];
 				unsigned p = backward_head[a];
 
 				if (has_source_to_node_distance.is_set(p))
@@ -722,7 +1341,7 @@ namespace RoutingKit
 				unsigned t = target_list[i];
 				assert(t != invalid_id);
 
-				if (!has_forward_predecessor.is_set(t) && predecessor_arc[t] == invalid_id)
+				if (!has_forward_predecessor.is_set(t) && predecessor_arc[t] == invalid_ch_arc_id)
 				{
 					output[i] = Weight{}; // t is not reachable
 				}
@@ -735,16 +1354,17 @@ namespace RoutingKit
 		}
 	}
 
+	template <class Queue>
 	template <class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer>
-	ContractionHierarchyQuery &ContractionHierarchyQuery::get_extra_weight_distances_to_targets(
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_targets(
 		const ExtraWeight &extra_weight,
 		const LinkFunction &link,
 		TmpContainer &tmp,
 		DistContainer &dist)
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::target_run);
+		assert(state == InternalState::target_run);
 
-		auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, *ch);
+		auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, ch);
 
 		detail::extract_distances_to_targets(
 			backward_predecessor_node, many_to_many_source_or_target_count,
@@ -753,10 +1373,10 @@ namespace RoutingKit
 			forward_predecessor_node, forward_predecessor_arc,
 
 			shortcut_weight,
-			ch->forward.first_out,
-			ch->forward.head,
-			ch->backward.first_out,
-			ch->backward.head,
+			ch.forward.first_out,
+			ch.forward.head,
+			ch.backward.first_out,
+			ch.backward.head,
 
 			tmp,
 			was_backward_pushed,
@@ -770,18 +1390,19 @@ namespace RoutingKit
 		return *this;
 	}
 
+	template <class Queue>
 	template <class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer>
-	ContractionHierarchyQuery &ContractionHierarchyQuery::get_extra_weight_distances_to_sources(
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_sources(
 		const ExtraWeight &extra_weight,
 		const LinkFunction &link,
 		TmpContainer &tmp,
 		DistContainer &dist)
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::source_run);
+		assert(state == InternalState::source_run);
 
 		auto inverted_link = detail::inverse_link_function(link);
 
-		auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, *ch);
+		auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, ch);
 		auto inverted_shortcut_weight = detail::inverse_shortcut_weights(shortcut_weight);
 
 		detail::extract_distances_to_targets(
@@ -791,10 +1412,10 @@ namespace RoutingKit
 			backward_predecessor_node, backward_predecessor_arc,
 
 			inverted_shortcut_weight,
-			ch->backward.first_out,
-			ch->backward.head,
-			ch->forward.first_out,
-			ch->forward.head,
+			ch.backward.first_out,
+			ch.backward.head,
+			ch.forward.first_out,
+			ch.forward.head,
 
 			tmp,
 			was_forward_pushed,
@@ -808,6 +1429,8 @@ namespace RoutingKit
 		return *this;
 	}
 
+	extern template class BasicContractionHierarchyQuery<MinIDQueue>;
+	extern template class BasicContractionHierarchyQuery<RadixMinIDQueue>;
 	extern template struct ContractionHierarchyExtraWeight<unsigned>;
 	extern template struct ContractionHierarchyExtraWeight<int>;
 	extern template ContractionHierarchyQuery &ContractionHierarchyQuery::get_extra_weight_distances_to_targets<std::vector<int>, SaturatedWeightAddition, std::vector<int>, std::vector<int>>(const std::vector<int> &, const SaturatedWeightAddition &, std::vector<int> &, std::vector<int> &);
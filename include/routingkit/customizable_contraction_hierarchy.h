@@ -5,10 +5,12 @@
 #include <routingkit/id_set_queue.h>
 #include <routingkit/bit_vector.h>
 #include <routingkit/id_mapper.h>
+#include <routingkit/query_statistics.h>
 
 #include <vector>
 #include <string>
 #include <functional>
+#include <assert.h>
 
 namespace RoutingKit{
 
@@ -17,7 +19,7 @@ class ContractionHierarchy;
 struct CustomizableContractionHierarchy{
 	CustomizableContractionHierarchy(){}
 
-	CustomizableContractionHierarchy(std::vector<unsigned>order, std::vector<unsigned>tail, std::vector<unsigned>head, std::function<void(const std::string&)>log_message = [](const std::string&){}, bool filter_always_inf_arcs = false);
+	CustomizableContractionHierarchy(std::vector<unsigned>order, std::vector<unsigned>tail, std::vector<unsigned>head, std::function<void(const std::string&)>log_message = [](const std::string&){}, bool filter_always_inf_arcs = false, unsigned thread_count = 1);
 
 	unsigned node_count()const{
 		return rank.size();
@@ -31,6 +33,15 @@ struct CustomizableContractionHierarchy{
 		return up_head.size();
 	}
 
+	// The file stores everything that does not depend on the weights. Loading it is much faster than
+	// building the CCH from the order. The file starts with a version number and can only be loaded by a
+	// RoutingKit version that uses the same file layout.
+	static CustomizableContractionHierarchy read(std::function<void(char*, unsigned long long)>in, unsigned long long file_size);
+	void write(std::function<void(const char*, unsigned long long)>out)const;
+
+	static CustomizableContractionHierarchy load_file(const std::string&file_name);
+	void save_file(const std::string&file_name)const;
+
 // private:
 	std::vector<unsigned>order;
 	std::vector<unsigned>rank;
@@ -77,6 +88,15 @@ struct CustomizableContractionHierarchyMetric{
 
 	CustomizableContractionHierarchyMetric& customize();
 
+	// Instead of calling customize, the customized weights can be restored from a file written by save_file.
+	// The metric must be attached to the same CCH and to the same input weights as the saved metric, as
+	// get_arc_path compares the customized weights with the input weights.
+	CustomizableContractionHierarchyMetric& read(std::function<void(char*, unsigned long long)>in, unsigned long long file_size);
+	void write(std::function<void(const char*, unsigned long long)>out)const;
+
+	CustomizableContractionHierarchyMetric& load_file(const std::string&file_name);
+	void save_file(const std::string&file_name)const;
+
 	ContractionHierarchy build_contraction_hierarchy_using_perfect_witness_search();
 
 // private:
@@ -87,6 +107,32 @@ struct CustomizableContractionHierarchyMetric{
 
 };
 
+//! Customizes several metrics of the same CCH at once. Every lower triangle is enumerated only once
+//! per group of up to eight metrics and the weights of a group are stored interleaved per arc, so that
+//! the triangle relaxation is done with SIMD min and add instructions. The customized metrics are
+//! selected by index and can be used with CustomizableContractionHierarchyQuery like any other metric.
+struct CustomizableContractionHierarchyMultiMetric{
+	CustomizableContractionHierarchyMultiMetric():cch(nullptr){}
+	CustomizableContractionHierarchyMultiMetric(const CustomizableContractionHierarchy&cch, const std::vector<const unsigned*>&input_weight);
+	CustomizableContractionHierarchyMultiMetric(const CustomizableContractionHierarchy&cch, const std::vector<std::vector<unsigned>>&input_weight);
+
+	CustomizableContractionHierarchyMultiMetric& reset(const CustomizableContractionHierarchy&cch, const std::vector<const unsigned*>&input_weight);
+	CustomizableContractionHierarchyMultiMetric& reset(const CustomizableContractionHierarchy&cch, const std::vector<std::vector<unsigned>>&input_weight);
+
+	CustomizableContractionHierarchyMultiMetric& customize();
+
+	unsigned metric_count()const{ return metric.size(); }
+
+	const CustomizableContractionHierarchyMetric&get_metric(unsigned metric_index)const{
+		assert(metric_index < metric_count() && "metric index out of bounds");
+		return metric[metric_index];
+	}
+
+// private:
+	std::vector<CustomizableContractionHierarchyMetric>metric;
+	const CustomizableContractionHierarchy*cch;
+};
+
 struct CustomizableContractionHierarchyParallelization{
 	CustomizableContractionHierarchyParallelization(){}
 	explicit CustomizableContractionHierarchyParallelization(const CustomizableContractionHierarchy&cch);
@@ -107,6 +153,83 @@ struct CustomizableContractionHierarchyParallelization{
 
 };
 
+//! Parallel customization that has fewer synchronization points than
+//! CustomizableContractionHierarchyParallelization. The elimination tree is cut into independent
+//! subtrees that are customized bottom-up without barriers, the largest ones first, so that idle
+//! threads pick up the remaining subtrees. Only the few nodes above the subtrees, i.e., the top
+//! separators, are customized level by level with the work of a level split across the threads.
+struct CustomizableContractionHierarchySubtreeParallelization{
+	CustomizableContractionHierarchySubtreeParallelization(){}
+	explicit CustomizableContractionHierarchySubtreeParallelization(const CustomizableContractionHierarchy&cch);
+
+	CustomizableContractionHierarchySubtreeParallelization& reset(const CustomizableContractionHierarchy&cch){
+		*this = CustomizableContractionHierarchySubtreeParallelization(cch);
+		return *this;
+	}
+
+	CustomizableContractionHierarchySubtreeParallelization& customize(CustomizableContractionHierarchyMetric&metric);
+	CustomizableContractionHierarchySubtreeParallelization& customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count);
+
+// private:
+	// The nodes of every subtree in increasing rank, the subtrees ordered by decreasing work.
+	std::vector<unsigned>first_node_of_subtree;
+	std::vector<unsigned>subtree_node;
+
+	// The down arcs of the nodes above the subtrees, ordered by the level in the elimination tree.
+	std::vector<unsigned>first_top_down_arc_of_level;
+	std::vector<unsigned>top_down_arc;
+
+	const CustomizableContractionHierarchy*cch;
+};
+
+//! Enumerates all lower triangles of a CCH once and stores them. Customizing a metric then streams
+//! through the stored triangles instead of merging adjacency lists. This pays off if the same CCH is
+//! customized many times. The triangles {y,x,z} of a node x and a down neighbor y are stored as runs
+//! of consecutive up arcs yz that map onto consecutive up arcs xz. A run needs 16 bytes, independent
+//! of its length, and is relaxed with the same SIMD code as CustomizableContractionHierarchyMetric.
+//! The nodes are ordered by their height in the elimination tree. All lower triangles of the up arcs
+//! of a node are stored with it, so the nodes of a height are customized in parallel without atomic
+//! operations.
+struct CustomizableContractionHierarchyTriangles{
+	CustomizableContractionHierarchyTriangles():stored_triangle_count(0), cch(nullptr){}
+	explicit CustomizableContractionHierarchyTriangles(const CustomizableContractionHierarchy&cch, std::function<void(const std::string&)>log_message = [](const std::string&){});
+
+	CustomizableContractionHierarchyTriangles& reset(const CustomizableContractionHierarchy&cch, std::function<void(const std::string&)>log_message = [](const std::string&){}){
+		*this = CustomizableContractionHierarchyTriangles(cch, log_message);
+		return *this;
+	}
+
+	unsigned long long triangle_count()const{
+		return stored_triangle_count;
+	}
+
+	unsigned long long run_count()const{
+		return run.size();
+	}
+
+	CustomizableContractionHierarchyTriangles& customize(CustomizableContractionHierarchyMetric&metric);
+	CustomizableContractionHierarchyTriangles& customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count);
+
+// private:
+	// The triangles {y,x,z} with the arcs yx, yz+l and xz+l for all l < length.
+	struct TriangleRun{
+		unsigned yx;
+		unsigned yz;
+		unsigned xz;
+		unsigned length;
+	};
+
+	std::vector<unsigned>first_node_of_height;
+	std::vector<unsigned>node_by_height;
+
+	// The runs of the i-th node of node_by_height are run[first_run[i]] to run[first_run[i+1]-1].
+	std::vector<unsigned long long>first_run;
+	std::vector<TriangleRun>run;
+	unsigned long long stored_triangle_count;
+
+	const CustomizableContractionHierarchy*cch;
+};
+
 struct CustomizableContractionHierarchyPartialCustomization{
 	CustomizableContractionHierarchyPartialCustomization(){}
 	explicit CustomizableContractionHierarchyPartialCustomization(const CustomizableContractionHierarchy&cch);
@@ -122,6 +245,38 @@ struct CustomizableContractionHierarchyPartialCustomization{
 	const CustomizableContractionHierarchy*cch;
 };
 
+//! Parallel version of CustomizableContractionHierarchyPartialCustomization for large batches of
+//! changed weights. The affected CCH arcs are processed level by level. All arcs of a level are
+//! updated concurrently.
+struct CustomizableContractionHierarchyParallelPartialCustomization{
+	CustomizableContractionHierarchyParallelPartialCustomization(){}
+	explicit CustomizableContractionHierarchyParallelPartialCustomization(const CustomizableContractionHierarchy&cch);
+
+	CustomizableContractionHierarchyParallelPartialCustomization&reset();
+	CustomizableContractionHierarchyParallelPartialCustomization&reset(const CustomizableContractionHierarchy&cch);
+
+	//! Marks an input arc whose weight was changed.
+	CustomizableContractionHierarchyParallelPartialCustomization&update_arc(unsigned input_arc);
+	//! Sets input_weight[input_arc[i]] to new_weight[i] and marks the arcs.
+	CustomizableContractionHierarchyParallelPartialCustomization&update_weights(std::vector<unsigned>&input_weight, const std::vector<unsigned>&input_arc, const std::vector<unsigned>&new_weight);
+
+	CustomizableContractionHierarchyParallelPartialCustomization&customize(CustomizableContractionHierarchyMetric&metric);
+	CustomizableContractionHierarchyParallelPartialCustomization&customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count);
+
+	//! The CCH arcs whose forward or backward weight was changed by the last call to customize, in
+	//! increasing order. Cached results that use one of these arcs are outdated.
+	const std::vector<unsigned>&get_changed_cch_arcs()const{ return changed_cch_arc; }
+
+// private:
+	std::vector<unsigned>arc_level;
+	std::vector<std::vector<unsigned>>dirty_arc_of_level;
+	std::vector<unsigned char>is_arc_dirty;
+	std::vector<unsigned>old_forward;
+	std::vector<unsigned>old_backward;
+	std::vector<unsigned>changed_cch_arc;
+	const CustomizableContractionHierarchy*cch;
+};
+
 struct CustomizableContractionHierarchyQuery{
 	CustomizableContractionHierarchyQuery(){}
 	explicit CustomizableContractionHierarchyQuery(const CustomizableContractionHierarchyMetric&metric);
@@ -149,6 +304,11 @@ struct CustomizableContractionHierarchyQuery{
 	CustomizableContractionHierarchyQuery& get_distances_to_targets(unsigned*dist);
 	std::vector<unsigned> get_distances_to_targets();
 
+	// Many-To-Many with pinned targets: dist[s*target_count+t] is the distance from source_list[s]
+	// to the t-th pinned target. Groups of sources share one sweep over the targets' search space.
+	CustomizableContractionHierarchyQuery& get_distances_from_sources_to_pinned_targets(const std::vector<unsigned>&source_list, unsigned*dist);
+	std::vector<unsigned> get_distances_from_sources_to_pinned_targets(const std::vector<unsigned>&source_list);
+
 	// Many-To-One
 	CustomizableContractionHierarchyQuery& reset_target();
 	CustomizableContractionHierarchyQuery& pin_sources(const std::vector<unsigned>&);
@@ -157,6 +317,12 @@ struct CustomizableContractionHierarchyQuery{
 	CustomizableContractionHierarchyQuery& get_distances_to_sources(unsigned*dist);
 	std::vector<unsigned> get_distances_to_sources();
 
+	// Filled by run(), run_to_pinned_targets(), run_to_pinned_sources(), get_node_path() and get_arc_path()
+	// and cleared by reset(), reset_source() and reset_target(). The CCH query walks up the elimination tree
+	// and therefore only records elimination tree nodes, relaxed arcs and the unpacking counters. All counters
+	// stay zero unless RoutingKit is compiled with ROUTING_KIT_QUERY_STATISTICS.
+	const QueryStatistics&get_statistics()const{ return statistics; }
+
 // private:
 	std::vector<unsigned>forward_tentative_distance, backward_tentative_distance;
 	std::vector<unsigned>source_node;
@@ -170,9 +336,14 @@ struct CustomizableContractionHierarchyQuery{
 	
 	unsigned shortest_path_meeting_node;
 
+	// Only allocated by get_distances_from_sources_to_pinned_targets
+	std::vector<unsigned>batch_node, batch_position, batch_distance;
+
 	const CustomizableContractionHierarchy*cch;
 	const CustomizableContractionHierarchyMetric*metric;
 	unsigned state;
+
+	QueryStatistics statistics;
 };
 
 } // namespace RoutingKit
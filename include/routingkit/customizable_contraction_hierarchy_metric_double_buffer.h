@@ -0,0 +1,77 @@
+#ifndef ROUTING_KIT_CUSTOMIZABLE_CONTRACTION_HIERARCHY_METRIC_DOUBLE_BUFFER_H
+#define ROUTING_KIT_CUSTOMIZABLE_CONTRACTION_HIERARCHY_METRIC_DOUBLE_BUFFER_H
+
+#include <routingkit/customizable_contraction_hierarchy.h>
+
+#include <vector>
+#include <memory>
+
+namespace RoutingKit{
+
+//! Holds two metrics of the same CCH and their input weights. Queries run on the current metric,
+//! while updates are customized into the other metric and then published atomically. Each update
+//! increases the epoch by one.
+//!
+//! Any number of threads can take snapshots at the same time without locking. Updates are
+//! serialized internally. An update waits until no snapshot of the metric that it overwrites is left,
+//! i.e., a snapshot must not be held for longer than one update and a thread that holds a snapshot
+//! must not start two updates.
+class CustomizableContractionHierarchyMetricDoubleBuffer{
+private:
+	struct Impl;
+public:
+	//! Keeps the metric of one epoch alive as long as it exists.
+	class Snapshot{
+	public:
+		Snapshot():impl(nullptr), buffer(0){}
+
+		Snapshot(const Snapshot&)=delete;
+		Snapshot&operator=(const Snapshot&)=delete;
+
+		Snapshot(Snapshot&&);
+		Snapshot&operator=(Snapshot&&);
+
+		~Snapshot(){ release(); }
+
+		void release();
+
+		const CustomizableContractionHierarchyMetric&get_metric()const;
+		unsigned long long get_epoch()const;
+
+	private:
+		friend class CustomizableContractionHierarchyMetricDoubleBuffer;
+		Snapshot(Impl*impl, unsigned buffer):impl(impl), buffer(buffer){}
+
+		Impl*impl;
+		unsigned buffer;
+	};
+
+	CustomizableContractionHierarchyMetricDoubleBuffer();
+	//! Customizes the metric of epoch 0.
+	CustomizableContractionHierarchyMetricDoubleBuffer(const CustomizableContractionHierarchy&cch, std::vector<unsigned>input_weight);
+
+	CustomizableContractionHierarchyMetricDoubleBuffer(const CustomizableContractionHierarchyMetricDoubleBuffer&)=delete;
+	CustomizableContractionHierarchyMetricDoubleBuffer&operator=(const CustomizableContractionHierarchyMetricDoubleBuffer&)=delete;
+
+	CustomizableContractionHierarchyMetricDoubleBuffer(CustomizableContractionHierarchyMetricDoubleBuffer&&);
+	CustomizableContractionHierarchyMetricDoubleBuffer&operator=(CustomizableContractionHierarchyMetricDoubleBuffer&&);
+
+	~CustomizableContractionHierarchyMetricDoubleBuffer();
+
+	Snapshot get_snapshot()const;
+	unsigned long long get_epoch()const;
+
+	//! Replaces all input weights and customizes the metric from scratch. Returns the new epoch.
+	unsigned long long update_all_weights(std::vector<unsigned>input_weight);
+
+	//! Sets the weight of the input arc arc[i] to weight[i] and uses a partial customization. The other
+	//! weights are the same as in the current epoch. Returns the new epoch.
+	unsigned long long update_some_weights(const std::vector<unsigned>&arc, const std::vector<unsigned>&weight);
+
+private:
+	std::unique_ptr<Impl>impl;
+};
+
+} // namespace RoutingKit
+
+#endif
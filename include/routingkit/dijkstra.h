@@ -8,11 +8,15 @@
 
 namespace RoutingKit{
 
-class Dijkstra{
+//! The queue type can be MinIDQueue or RadixMinIDQueue. The latter requires non-negative weights
+//! and departure times that are not smaller than the keys already popped, which holds if all
+//! sources are added before the first call to settle.
+template<class Queue = MinIDQueue>
+class BasicDijkstra{
 public:
-	Dijkstra():first_out(nullptr){}
+	BasicDijkstra():first_out(nullptr){}
 
-	Dijkstra(const std::vector<unsigned>&first_out, const std::vector<unsigned>&tail, const std::vector<unsigned>&head):
+	BasicDijkstra(const std::vector<unsigned>&first_out, const std::vector<unsigned>&tail, const std::vector<unsigned>&head):
 		tentative_distance(first_out.size()-1),
 		predecessor_arc(first_out.size()-1),
 		was_popped(first_out.size()-1),
@@ -28,13 +32,13 @@ public:
 
 	}
 
-	Dijkstra&reset(){
+	BasicDijkstra&reset(){
 		queue.clear();
 		was_popped.reset_all();
 		return *this;
 	}
 
-	Dijkstra&reset(const std::vector<unsigned>&first_out, const std::vector<unsigned>&tail, const std::vector<unsigned>&head){
+	BasicDijkstra&reset(const std::vector<unsigned>&first_out, const std::vector<unsigned>&tail, const std::vector<unsigned>&head){
 		assert(!first_out.empty());
 		assert(first_out.front() == 0);
 		assert(first_out.back() == tail.size());
@@ -54,12 +58,12 @@ public:
 			tentative_distance.resize(first_out.size()-1);
 			predecessor_arc.resize(first_out.size()-1);
 			was_popped = TimestampFlags(first_out.size()-1);
-			queue = MinIDQueue(first_out.size()-1);
+			queue = Queue(first_out.size()-1);
 			return *this;
 		}
 	}
 
-	Dijkstra&add_source(unsigned id, unsigned departure_time = 0){
+	BasicDijkstra&add_source(unsigned id, unsigned departure_time = 0){
 		assert(id < first_out->size()-1);
 		tentative_distance[id] = departure_time;
 		predecessor_arc[id] = invalid_id;
@@ -151,13 +155,15 @@ private:
 	std::vector<unsigned>predecessor_arc;
 
 	TimestampFlags was_popped;
-	MinIDQueue queue;
+	Queue queue;
 
 	const std::vector<unsigned>*first_out;
 	const std::vector<unsigned>*tail;
 	const std::vector<unsigned>*head;
 };
 
+typedef BasicDijkstra<MinIDQueue> Dijkstra;
+
 class ScalarGetWeight{
 public:
 	explicit ScalarGetWeight(const std::vector<unsigned>&weight):weight(&weight){}
@@ -69,6 +69,16 @@ public:
 		return heap[id_pos[id]].key;
 	}
 
+	//! Returns the elements in the order of the internal heap array. Pushing them
+	//! in this order into an empty queue restores exactly the same queue state.
+	const IDKeyPair*heap_begin()const{
+		return heap.data();
+	}
+
+	const IDKeyPair*heap_end()const{
+		return heap.data() + heap_size;
+	}
+
 	//! Returns the smallest element key pair without removing it from the queue.
 	IDKeyPair peek()const{
 		assert(!empty());
@@ -176,6 +186,189 @@ private:
 	unsigned heap_size;
 };
 
+//! A priority queue with the same interface as MinIDQueue that only supports monotone keys, i.e.,
+//! no key may be pushed or decreased below the key of the last popped element. This holds for
+//! Dijkstra's algorithm with non-negative weights. The queue is a radix heap: an element is stored
+//! in the bucket given by the highest bit in which its key differs from the last popped key. Only
+//! when the first bucket runs empty, the next non-empty bucket is scanned for its minimum and its
+//! elements are distributed to lower buckets. Every element moves at most 32 times in total, which
+//! is usually much cheaper than the sift operations of a heap.
+class RadixMinIDQueue{
+private:
+	static const unsigned bucket_count = 33;
+public:
+	RadixMinIDQueue():element_count(0), last_key(0){}
+
+	explicit RadixMinIDQueue(unsigned id_count):
+		id_bucket(id_count, invalid_id),
+		id_pos(id_count),
+		element_count(0),
+		last_key(0){}
+
+	//! Returns whether the queue is empty. Equivalent to checking whether size() returns 0.
+	bool empty()const{
+		return element_count == 0;
+	}
+
+	//! Returns the number of elements in the queue.
+	unsigned size()const{
+		return element_count;
+	}
+
+	//! Returns the id_count value passed to the constructor.
+	unsigned id_count()const{
+		return id_bucket.size();
+	}
+
+	//! Checks whether an element is in the queue.
+	bool contains_id(unsigned id){
+		assert(id < id_count());
+		return id_bucket[id] != invalid_id;
+	}
+
+	//! Removes all elements from the queue. Afterwards, any key may be pushed again.
+	void clear(){
+		for(auto&b:bucket){
+			for(auto p:b)
+				id_bucket[p.id] = invalid_id;
+			b.clear();
+		}
+		element_count = 0;
+		last_key = 0;
+	}
+
+	friend void swap(RadixMinIDQueue&l, RadixMinIDQueue&r){
+		using std::swap;
+		swap(l.id_bucket, r.id_bucket);
+		swap(l.id_pos, r.id_pos);
+		swap(l.bucket, r.bucket);
+		swap(l.element_count, r.element_count);
+		swap(l.last_key, r.last_key);
+	}
+
+	//! Returns the current key of an element.
+	//! Undefined if the element is not part of the queue.
+	unsigned get_key(unsigned id)const{
+		assert(id < id_count());
+		assert(id_bucket[id] != invalid_id);
+		return bucket[id_bucket[id]][id_pos[id]].key;
+	}
+
+	//! Returns the smallest element key pair without removing it from the queue.
+	IDKeyPair peek()const{
+		assert(!empty());
+		fill_first_bucket();
+		return bucket[0].back();
+	}
+
+	//! Returns the smallest element key pair and removes it form the queue.
+	IDKeyPair pop(){
+		assert(!empty());
+		fill_first_bucket();
+		IDKeyPair p = bucket[0].back();
+		bucket[0].pop_back();
+		id_bucket[p.id] = invalid_id;
+		--element_count;
+		return p;
+	}
+
+	//! Inserts a element key pair.
+	//! Undefined if the element is part of the queue or if the key is smaller than the last popped key.
+	void push(IDKeyPair p){
+		assert(p.id < id_count());
+		assert(!contains_id(p.id));
+		assert(p.key >= last_key && "keys of a RadixMinIDQueue must be monotone");
+
+		insert_into_bucket(p, get_bucket(p.key, last_key));
+		++element_count;
+	}
+
+	//! Updates the key of an element if the new key is smaller than the old key.
+	//! Does nothing if the new key is larger.
+	//! Undefined if the element is not part of the queue or if the key is smaller than the last popped key.
+	bool decrease_key(IDKeyPair p){
+		assert(p.id < id_count());
+		assert(contains_id(p.id));
+		assert(p.key >= last_key && "keys of a RadixMinIDQueue must be monotone");
+
+		unsigned b = id_bucket[p.id];
+		unsigned pos = id_pos[p.id];
+
+		if(bucket[b][pos].key > p.key){
+			unsigned new_b = get_bucket(p.key, last_key);
+			if(new_b == b){
+				bucket[b][pos].key = p.key;
+			}else{
+				remove_from_bucket(b, pos);
+				insert_into_bucket(p, new_b);
+			}
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+private:
+	static unsigned get_bucket(unsigned key, unsigned last_key){
+		unsigned x = key ^ last_key;
+		if(x == 0)
+			return 0;
+		#ifndef ROUTING_KIT_NO_GCC_EXTENSIONS
+		return 32 - __builtin_clz(x);
+		#else
+		unsigned b = 0;
+		while(x != 0){
+			++b;
+			x >>= 1;
+		}
+		return b;
+		#endif
+	}
+
+	void insert_into_bucket(IDKeyPair p, unsigned b)const{
+		id_bucket[p.id] = b;
+		id_pos[p.id] = bucket[b].size();
+		bucket[b].push_back(p);
+	}
+
+	void remove_from_bucket(unsigned b, unsigned pos){
+		bucket[b][pos] = bucket[b].back();
+		id_pos[bucket[b][pos].id] = pos;
+		bucket[b].pop_back();
+	}
+
+	// Does not change the content of the queue, only its internal layout. It is therefore also
+	// called by peek.
+	void fill_first_bucket()const{
+		if(!bucket[0].empty())
+			return;
+
+		unsigned b = 1;
+		while(bucket[b].empty())
+			++b;
+
+		unsigned min_key = bucket[b][0].key;
+		for(auto p:bucket[b])
+			min_key = std::min(min_key, p.key);
+		last_key = min_key;
+
+		// Every element of bucket b goes to a lower bucket, as it agrees with min_key on all bits
+		// starting from bit b-1.
+		moved_elements.swap(bucket[b]);
+		for(auto p:moved_elements)
+			insert_into_bucket(p, get_bucket(p.key, last_key));
+		moved_elements.clear();
+	}
+
+	mutable std::vector<unsigned>id_bucket;
+	mutable std::vector<unsigned>id_pos;
+	mutable std::vector<IDKeyPair>bucket[bucket_count];
+	mutable std::vector<IDKeyPair>moved_elements;
+
+	unsigned element_count;
+	mutable unsigned last_key;
+};
+
 } // namespace RoutingKit
 
 #endif
@@ -0,0 +1,47 @@
+#ifndef ROUTING_KIT_QUERY_STATISTICS_H
+#define ROUTING_KIT_QUERY_STATISTICS_H
+
+namespace RoutingKit{
+
+//! Counters that describe the work done by a single query. They are only recorded if RoutingKit is
+//! compiled with ROUTING_KIT_QUERY_STATISTICS defined. Otherwise, the code that records them is removed
+//! by the preprocessor and all counters stay zero.
+struct QueryStatistics{
+	struct Direction{
+		//! Nodes removed from the queue, including the stalled ones.
+		unsigned settled_node_count;
+		//! Settled nodes whose arcs were not relaxed because of stall-on-demand.
+		unsigned stalled_node_count;
+		unsigned long long relaxed_arc_count;
+		unsigned queue_push_count;
+		unsigned decrease_key_count;
+		//! Only used by CCH queries, which walk up the elimination tree instead of using a queue.
+		unsigned elimination_tree_node_count;
+	};
+
+	Direction forward, backward;
+
+	//! Largest number of nested shortcuts that had to be unpacked by get_node_path or get_arc_path.
+	//! An arc of the input graph has depth zero.
+	unsigned unpacking_depth;
+	//! Time spent unpacking shortcuts in microseconds.
+	long long unpacking_time;
+
+	QueryStatistics(){ clear(); }
+
+	void clear(){
+		forward = backward = Direction{0, 0, 0, 0, 0, 0};
+		unpacking_depth = 0;
+		unpacking_time = 0;
+	}
+};
+
+} // namespace RoutingKit
+
+#ifdef ROUTING_KIT_QUERY_STATISTICS
+#define ROUTING_KIT_RECORD_QUERY_STATISTICS(statement) do{ statement; }while(false)
+#else
+#define ROUTING_KIT_RECORD_QUERY_STATISTICS(statement) do{}while(false)
+#endif
+
+#endif
@@ -13,6 +13,19 @@
 #include <stdexcept>
 #include <algorithm>
 #include <numeric>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef ROUTING_KIT_NO_POSIX
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include <routingkit/vector_io.h>
 #include <experimental/filesystem>
@@ -100,15 +113,235 @@ namespace RoutingKit
 			}
 		}
 
+		template <class T>
+		void write_vector_with_size(std::ostream &out, const std::vector<T> &v)
+		{
+			write_value(out, (unsigned long long)v.size());
+			if (!v.empty())
+				write_vector(out, v);
+		}
+
+		template <class T>
+		std::vector<T> read_vector_with_size(std::istream &in)
+		{
+			unsigned long long size = read_value<unsigned long long>(in);
+			if (size == 0)
+				return {};
+			return read_vector<T>(in, size);
+		}
+
 		class Graph
 		{
+		public:
+			struct Arc
+			{
+				unsigned node;
+				unsigned weight;
+				unsigned hop_length;
+				unsigned mid_node;
+			};
+
+		private:
+			// Stores the arcs of all nodes in one contiguous array. Every node owns a slot that may contain
+			// some unused space at its end. If a node's slot is full, it is moved to the end of the array and
+			// its capacity is doubled. The old slot becomes unused. Before the array is reallocated and once
+			// contracted nodes have freed half of it, all slots are compacted in place. This avoids the many
+			// small allocations and the fragmentation that one vector per node causes, while keeping the order
+			// of the arcs of every node.
+			class AdjacencyArray
+			{
+			public:
+				AdjacencyArray() : unused_arc_count_(0) {}
+
+				explicit AdjacencyArray(const std::vector<unsigned> &deg) : first_arc_(deg.size()),
+																			 deg_(deg.size(), 0),
+																			 capacity_(deg.size()),
+																			 unused_arc_count_(0)
+				{
+					unsigned long long arc_count = 0;
+					for (unsigned x = 0; x < deg.size(); ++x)
+					{
+						first_arc_[x] = arc_count;
+						capacity_[x] = compute_capacity_with_slack(deg[x]);
+						arc_count += capacity_[x];
+					}
+					arc_.resize(arc_count);
+				}
+
+				unsigned node_count() const
+				{
+					return deg_.size();
+				}
+
+				unsigned deg(unsigned x) const
+				{
+					assert(x < node_count());
+					return deg_[x];
+				}
+
+				Arc *begin(unsigned x)
+				{
+					assert(x < node_count());
+					return arc_.data() + first_arc_[x];
+				}
+
+				const Arc *begin(unsigned x) const
+				{
+					assert(x < node_count());
+					return arc_.data() + first_arc_[x];
+				}
+
+				Arc *end(unsigned x)
+				{
+					return begin(x) + deg_[x];
+				}
+
+				const Arc *end(unsigned x) const
+				{
+					return begin(x) + deg_[x];
+				}
+
+				void push_back(unsigned x, Arc a)
+				{
+					assert(x < node_count());
+					if (deg_[x] == capacity_[x])
+						grow_slot(x);
+					arc_[first_arc_[x] + deg_[x]] = a;
+					++deg_[x];
+				}
+
+				void erase(unsigned x, Arc *a)
+				{
+					assert(begin(x) <= a && a < end(x));
+					std::copy(a + 1, end(x), a);
+					--deg_[x];
+				}
+
+				void clear(unsigned x)
+				{
+					assert(x < node_count());
+					unused_arc_count_ += capacity_[x];
+					deg_[x] = 0;
+					capacity_[x] = 0;
+					if (is_worth_compacting(2))
+					{
+						compact();
+						if (arc_.size() < arc_.capacity() / 2)
+							arc_.shrink_to_fit();
+					}
+				}
+
+				// Only the degrees and the arcs are stored. The slots are rebuilt with the default slack.
+				void write(std::ostream &out) const
+				{
+					write_vector_with_size(out, deg_);
+					for (unsigned x = 0; x < node_count(); ++x)
+						if (deg_[x] != 0)
+							out.write((const char *)begin(x), sizeof(Arc) * deg_[x]);
+					if (!out)
+						throw std::runtime_error("Could not write graph arcs");
+				}
+
+				static AdjacencyArray read(std::istream &in)
+				{
+					auto deg = read_vector_with_size<unsigned>(in);
+					AdjacencyArray a(deg);
+					for (unsigned x = 0; x < deg.size(); ++x)
+					{
+						if (deg[x] != 0)
+						{
+							in.read((char *)a.begin(x), sizeof(Arc) * deg[x]);
+							a.deg_[x] = deg[x];
+						}
+					}
+					if (!in)
+						throw std::runtime_error("Could not read graph arcs");
+					return a;
+				}
+
+			private:
+				static unsigned compute_capacity_with_slack(unsigned deg)
+				{
+					return deg + deg / 4 + 1;
+				}
+
+				void grow_slot(unsigned x)
+				{
+					unsigned new_capacity = std::max(4u, 2 * capacity_[x]);
+					if (arc_.size() + new_capacity > arc_.capacity())
+					{
+						// Reuse the unused space before allocating more memory. The vector is grown
+						// explicitly by a small fraction, as letting it double would hold three times the arcs.
+						if (is_worth_compacting(8))
+							compact();
+						if (arc_.size() + new_capacity > arc_.capacity())
+							arc_.reserve(arc_.size() + arc_.size() / 8 + new_capacity);
+					}
+
+					unsigned long long new_first_arc = arc_.size();
+					arc_.resize(new_first_arc + new_capacity);
+					std::copy(arc_.begin() + first_arc_[x], arc_.begin() + first_arc_[x] + deg_[x], arc_.begin() + new_first_arc);
+
+					unused_arc_count_ += capacity_[x];
+					first_arc_[x] = new_first_arc;
+					capacity_[x] = new_capacity;
+				}
+
+				// A compaction looks at every node. Requiring more unused arcs than nodes keeps its cost
+				// amortized, even if only few arcs are left.
+				bool is_worth_compacting(unsigned long long fraction) const
+				{
+					return unused_arc_count_ > node_count() && unused_arc_count_ > arc_.size() / fraction;
+				}
+
+				// Moves all slots towards the front of the array in the order in which they are stored.
+				// A slot is never enlarged, so no slot is overwritten before it has been moved.
+				void compact()
+				{
+					std::vector<unsigned> node_by_first_arc;
+					for (unsigned x = 0; x < node_count(); ++x)
+						if (capacity_[x] != 0)
+							node_by_first_arc.push_back(x);
+					std::sort(node_by_first_arc.begin(), node_by_first_arc.end(), [&](unsigned l, unsigned r) {
+						return first_arc_[l] < first_arc_[r];
+					});
+
+					unsigned long long arc_count = 0;
+					for (unsigned x : node_by_first_arc)
+					{
+						std::copy(arc_.begin() + first_arc_[x], arc_.begin() + first_arc_[x] + deg_[x], arc_.begin() + arc_count);
+						first_arc_[x] = arc_count;
+						capacity_[x] = std::min(capacity_[x], compute_capacity_with_slack(deg_[x]));
+						arc_count += capacity_[x];
+					}
+					arc_.resize(arc_count);
+					unused_arc_count_ = 0;
+				}
+
+				std::vector<Arc> arc_;
+				std::vector<unsigned long long> first_arc_;
+				std::vector<unsigned> deg_;
+				std::vector<unsigned> capacity_;
+				unsigned long long unused_arc_count_;
+			};
+
 		public:
 			Graph() {}
 
-			Graph(unsigned node_count, const std::vector<unsigned> &tail, const std::vector<unsigned> &head, const std::vector<unsigned> &weight) : out_(node_count),
-																																					in_(node_count),
-																																					level_(node_count, 0)
+			Graph(unsigned node_count, const std::vector<unsigned> &tail, const std::vector<unsigned> &head, const std::vector<unsigned> &weight) : level_(node_count, 0)
 			{
+				std::vector<unsigned> out_deg(node_count, 0), in_deg(node_count, 0);
+				for (unsigned a = 0; a < head.size(); ++a)
+				{
+					if (tail[a] != head[a])
+					{
+						++out_deg[tail[a]];
+						++in_deg[head[a]];
+					}
+				}
+
+				out_ = AdjacencyArray(out_deg);
+				in_ = AdjacencyArray(in_deg);
 
 				for (unsigned a = 0; a < head.size(); ++a)
 				{
@@ -118,8 +351,8 @@ namespace RoutingKit
 
 					if (x != y)
 					{
-						out_[x].push_back({y, w, 1, invalid_id});
-						in_[y].push_back({x, w, 1, invalid_id});
+						out_.push_back(x, {y, w, 1, invalid_id});
+						in_.push_back(y, {x, w, 1, invalid_id});
 					}
 				}
 			}
@@ -132,30 +365,30 @@ namespace RoutingKit
 				assert(y < node_count());
 
 				auto reduce_arc_if_exists = [weight, hop_length, mid_node](
-												unsigned x, std::vector<Arc> &x_out,
-												unsigned y, std::vector<Arc> &y_in)
+												unsigned x, Arc *x_out_begin, Arc *x_out_end,
+												unsigned y, Arc *y_in_begin, Arc *y_in_end)
 				{
 					// Does arc exist?
-					for (unsigned out_arc = 0; out_arc < x_out.size(); ++out_arc)
+					for (Arc *out_arc = x_out_begin; out_arc != x_out_end; ++out_arc)
 					{
-						if (x_out[out_arc].node == y)
+						if (out_arc->node == y)
 						{
 
 							// Is the existing arc longer?
-							if (x_out[out_arc].weight <= weight)
+							if (out_arc->weight <= weight)
 								return true;
 
 							// We need to adjust the weights
-							for (unsigned in_arc = 0; in_arc < y_in.size(); ++in_arc)
+							for (Arc *in_arc = y_in_begin; in_arc != y_in_end; ++in_arc)
 							{
-								if (y_in[in_arc].node == x)
+								if (in_arc->node == x)
 								{
-									x_out[out_arc].weight = weight;
-									x_out[out_arc].hop_length = hop_length;
-									x_out[out_arc].mid_node = mid_node;
-									y_in[in_arc].weight = weight;
-									y_in[in_arc].hop_length = hop_length;
-									y_in[in_arc].mid_node = mid_node;
+									out_arc->weight = weight;
+									out_arc->hop_length = hop_length;
+									out_arc->mid_node = mid_node;
+									in_arc->weight = weight;
+									in_arc->hop_length = hop_length;
+									in_arc->mid_node = mid_node;
 									return true;
 								}
 							}
@@ -165,90 +398,80 @@ namespace RoutingKit
 					return false;
 				};
 
-				if (out_[x].size() <= in_[y].size())
+				if (out_.deg(x) <= in_.deg(y))
 				{
-					if (reduce_arc_if_exists(x, out_[x], y, in_[y]))
+					if (reduce_arc_if_exists(x, out_.begin(x), out_.end(x), y, in_.begin(y), in_.end(y)))
 						return;
 				}
 				else
 				{
-					if (reduce_arc_if_exists(y, in_[y], x, out_[x]))
+					if (reduce_arc_if_exists(y, in_.begin(y), in_.end(y), x, out_.begin(x), out_.end(x)))
 						return;
 				}
 
 				// The edges does not exist -> add the edge
-				out_[x].push_back({y, weight, hop_length, mid_node});
-				in_[y].push_back({x, weight, hop_length, mid_node});
+				out_.push_back(x, {y, weight, hop_length, mid_node});
+				in_.push_back(y, {x, weight, hop_length, mid_node});
 			}
 
 			void remove_all_incident_arcs(unsigned x)
 			{
 				assert(x < node_count());
 
-				auto remove_back_arcs = [&](unsigned x, const std::vector<Arc> &x_out, std::vector<std::vector<Arc>> &in)
+				auto remove_back_arcs = [&](unsigned x, const AdjacencyArray &x_out, AdjacencyArray &in)
 				{
-					for (unsigned out_arc = 0; out_arc < x_out.size(); ++out_arc)
+					for (const Arc *out_arc = x_out.begin(x); out_arc != x_out.end(x); ++out_arc)
 					{
-						unsigned y = x_out[out_arc].node;
-						for (auto in_arc = in[y].begin();; ++in_arc)
+						unsigned y = out_arc->node;
+						for (Arc *in_arc = in.begin(y);; ++in_arc)
 						{
-							assert(in_arc != in[y].end());
+							assert(in_arc != in.end(y));
 							if (in_arc->node == x)
 							{
-								in[y].erase(in_arc);
+								in.erase(y, in_arc);
 								break;
 							}
 						}
 					}
 				};
 
-				remove_back_arcs(x, out_[x], in_);
-				remove_back_arcs(x, in_[x], out_);
+				remove_back_arcs(x, out_, in_);
+				remove_back_arcs(x, in_, out_);
 
-				in_[x].clear();
-				out_[x].clear();
-				in_[x].shrink_to_fit();
-				out_[x].shrink_to_fit();
+				in_.clear(x);
+				out_.clear(x);
 			}
 
-			struct Arc
-			{
-				unsigned node;
-				unsigned weight;
-				unsigned hop_length;
-				unsigned mid_node;
-			};
-
 			unsigned out_deg(unsigned node) const
 			{
 				assert(node < node_count());
-				return out_[node].size();
+				return out_.deg(node);
 			}
 
 			unsigned in_deg(unsigned node) const
 			{
 				assert(node < node_count());
-				return in_[node].size();
+				return in_.deg(node);
 			}
 
 			Arc out(unsigned node, unsigned out_arc) const
 			{
 				assert(node < node_count());
-				assert(out_arc < out_[node].size());
-				return out_[node][out_arc];
+				assert(out_arc < out_.deg(node));
+				return out_.begin(node)[out_arc];
 			}
 
 			Arc in(unsigned node, unsigned in_arc) const
 			{
 				assert(node < node_count());
-				assert(in_arc < in_[node].size());
-				return in_[node][in_arc];
+				assert(in_arc < in_.deg(node));
+				return in_.begin(node)[in_arc];
 			}
 
 			unsigned node_count() const
 			{
-				assert(in_.size() == out_.size());
-				return out_.size();
+				assert(in_.node_count() == out_.node_count());
+				return out_.node_count();
 			}
 
 			unsigned level(unsigned node) const
@@ -266,16 +489,37 @@ namespace RoutingKit
 				}
 			}
 
+			void write(std::ostream &out) const
+			{
+				out_.write(out);
+				in_.write(out);
+				write_vector_with_size(out, level_);
+			}
+
+			static Graph read(std::istream &in)
+			{
+				Graph g;
+				g.out_ = AdjacencyArray::read(in);
+				g.in_ = AdjacencyArray::read(in);
+				g.level_ = read_vector_with_size<unsigned>(in);
+				if (g.out_.node_count() != g.level_.size() || g.in_.node_count() != g.level_.size())
+					throw std::runtime_error("Checkpoint graph is corrupt.");
+				return g;
+			}
+
 		private:
-			std::vector<std::vector<Arc>> out_, in_;
+			AdjacencyArray out_, in_;
 			std::vector<unsigned> level_;
 		};
 
-		class ShorterPathTest
+		// The witness searches only push keys that are at least the last popped key of the same
+		// direction. The queue can therefore be either a MinIDQueue or a RadixMinIDQueue.
+		template <class Queue>
+		class BasicShorterPathTest
 		{
 		public:
-			ShorterPathTest() {}
-			ShorterPathTest(const Graph &graph, unsigned max_pop_count) : max_pop_count(max_pop_count), graph(&graph),
+			BasicShorterPathTest() {}
+			BasicShorterPathTest(const Graph &graph, unsigned max_pop_count) : max_pop_count(max_pop_count), graph(&graph),
 																		  forward_tentative_distance(graph.node_count()), backward_tentative_distance(graph.node_count()),
 																		  forward_queue(graph.node_count()), backward_queue(graph.node_count()),
 																		  was_forward_pushed(graph.node_count()), was_backward_pushed(graph.node_count())
@@ -344,7 +588,7 @@ namespace RoutingKit
 
 			template <class GetOutDeg, class GetOutArc>
 			bool forward_settle(
-				MinIDQueue &forward_queue,
+				Queue &forward_queue,
 				TimestampFlags &was_forward_pushed,
 				const TimestampFlags &was_backward_pushed,
 				std::vector<unsigned> &forward_tentative_distance,
@@ -380,6 +624,9 @@ namespace RoutingKit
 					if (next_node == bypass)
 						continue;
 
+					if (excluded_nodes != nullptr && excluded_nodes->is_set(next_node))
+						continue;
+
 					unsigned next_node_distance = distance_to_popped_node + graph_out(popped_node, out_arc).weight;
 
 					if (was_forward_pushed.is_set(next_node))
@@ -601,17 +848,29 @@ namespace RoutingKit
 				return max_pop_count;
 			}
 
+			// The searches treat all nodes set in excluded_nodes as if they were already removed from the graph.
+			// Pass nullptr to search the whole graph again.
+			void set_excluded_nodes(const BitVector *new_excluded_nodes)
+			{
+				excluded_nodes = new_excluded_nodes;
+			}
+
 		private:
 			unsigned max_pop_count;
 			const Graph *graph;
+			const BitVector *excluded_nodes = nullptr;
 			std::vector<unsigned> forward_tentative_distance;
 			std::vector<unsigned> backward_tentative_distance;
-			MinIDQueue forward_queue;
-			MinIDQueue backward_queue;
+			Queue forward_queue;
+			Queue backward_queue;
 			TimestampFlags was_forward_pushed;
 			TimestampFlags was_backward_pushed;
 		};
 
+		// The witness searches are small and bounded by max_pop_count. On such searches the binary heap
+		// was measured to be faster than the radix heap, whose bucket redistribution does not amortize.
+		typedef BasicShorterPathTest<MinIDQueue> ShorterPathTest;
+
 		unsigned estimate_node_importance(const Graph &graph, ShorterPathTest &shorter_path_test, unsigned node)
 		{
 			unsigned level = graph.level(node);
@@ -685,6 +944,52 @@ namespace RoutingKit
 			assert(graph.in_deg(node_being_contracted) == 0);
 		}
 
+		struct Shortcut
+		{
+			unsigned tail;
+			unsigned mid_node;
+			unsigned head;
+			unsigned weight;
+			unsigned hop_length;
+		};
+
+		// Computes the shortcuts that contract_node would insert without modifying the graph. As the graph
+		// is only read, several nodes can be processed concurrently as long as every thread uses its own
+		// ShorterPathTest object.
+		void compute_shortcuts_of_node(const Graph &graph, ShorterPathTest &shorter_path_test, unsigned node_being_contracted, std::vector<Shortcut> &shortcuts)
+		{
+			shortcuts.clear();
+			for (unsigned in_arc = 0; in_arc < graph.in_deg(node_being_contracted); ++in_arc)
+			{
+				unsigned in_node = graph.in(node_being_contracted, in_arc).node;
+				shorter_path_test.pin_source(in_node, node_being_contracted);
+				for (unsigned out_arc = 0; out_arc < graph.out_deg(node_being_contracted); ++out_arc)
+				{
+					unsigned out_node = graph.out(node_being_contracted, out_arc).node;
+					if (in_node != out_node)
+					{
+						if (
+							!shorter_path_test.does_shorter_or_equal_path_to_target_exist(
+								out_node,
+								graph.in(node_being_contracted, in_arc).weight + graph.out(node_being_contracted, out_arc).weight))
+						{
+							shortcuts.push_back({in_node, node_being_contracted, out_node,
+												 graph.in(node_being_contracted, in_arc).weight + graph.out(node_being_contracted, out_arc).weight,
+												 graph.in(node_being_contracted, in_arc).hop_length + graph.out(node_being_contracted, out_arc).hop_length});
+						}
+					}
+				}
+			}
+		}
+
+		unsigned get_thread_id()
+		{
+#ifdef _OPENMP
+			return omp_get_thread_num();
+#else
+			return 0;
+#endif
+		}
 	}
 
 	namespace
@@ -701,12 +1006,121 @@ namespace RoutingKit
 			Side forward, backward;
 		};
 
+		const unsigned long long ch_checkpoint_magic_number = 0x4348436b70743031ull;
+
+		// Stores the state of build_ch_and_order between two contractions so that an interrupted build can
+		// be resumed. A checkpoint is first written to a temporary file that is then renamed. An interruption
+		// while writing therefore never destroys the previous checkpoint.
+		class BuildCheckpoint
+		{
+		public:
+			BuildCheckpoint(std::string file_name, unsigned interval_in_seconds, unsigned long long input_fingerprint) : file_name(std::move(file_name)),
+																													 interval_in_musec(1000000ll * interval_in_seconds),
+																													 input_fingerprint(input_fingerprint),
+																													 last_save_time(get_micro_time())
+			{
+			}
+
+			bool exists() const
+			{
+				return fs::exists(file_name);
+			}
+
+			bool is_due() const
+			{
+				return get_micro_time() - last_save_time >= interval_in_musec;
+			}
+
+			void save(const Graph &graph, const MinIDQueue &queue, const ContractionHierarchy &ch, const ContractionHierarchyExtraInfo &ch_extra, unsigned contracted_node_count)
+			{
+				const std::string tmp_file_name = file_name + ".tmp";
+				open_file_for_saving(tmp_file_name, [&](std::ostream &out)
+									 {
+					write_value(out, ch_checkpoint_magic_number);
+					write_value(out, input_fingerprint);
+					write_value(out, contracted_node_count);
+
+					graph.write(out);
+					write_vector_with_size(out, std::vector<IDKeyPair>(queue.heap_begin(), queue.heap_end()));
+
+					write_vector_with_size(out, ch.rank);
+					write_vector_with_size(out, ch.order);
+					write_vector_with_size(out, ch.forward.head);
+					write_vector_with_size(out, ch.forward.weight);
+					write_vector_with_size(out, ch_extra.forward.tail);
+					write_vector_with_size(out, ch_extra.forward.mid_node);
+					write_vector_with_size(out, ch.backward.head);
+					write_vector_with_size(out, ch.backward.weight);
+					write_vector_with_size(out, ch_extra.backward.tail);
+					write_vector_with_size(out, ch_extra.backward.mid_node);
+					out.flush();
+					if (!out)
+						throw std::runtime_error("Could not write CH checkpoint \"" + tmp_file_name + "\"."); });
+				fs::rename(tmp_file_name, file_name);
+				last_save_time = get_micro_time();
+			}
+
+			void load(Graph &graph, MinIDQueue &queue, ContractionHierarchy &ch, ContractionHierarchyExtraInfo &ch_extra, unsigned &contracted_node_count)
+			{
+				open_file_for_loading(file_name, [&](std::istream &in, unsigned long long)
+									  {
+					if (read_value<unsigned long long>(in) != ch_checkpoint_magic_number)
+						throw std::runtime_error("\"" + file_name + "\" is not a CH checkpoint.");
+					if (read_value<unsigned long long>(in) != input_fingerprint)
+						throw std::runtime_error("CH checkpoint \"" + file_name + "\" was written for a different input graph or max_pop_count.");
+					contracted_node_count = read_value<unsigned>(in);
+
+					graph = Graph::read(in);
+					const unsigned node_count = graph.node_count();
+
+					queue = MinIDQueue(node_count);
+					for (auto p : read_vector_with_size<IDKeyPair>(in))
+					{
+						if (p.id >= node_count || queue.contains_id(p.id))
+							throw std::runtime_error("CH checkpoint \"" + file_name + "\" is corrupt.");
+						queue.push(p);
+					}
+
+					ch.rank = read_vector_with_size<unsigned>(in);
+					ch.order = read_vector_with_size<unsigned>(in);
+					ch.forward.head = read_vector_with_size<unsigned>(in);
+					ch.forward.weight = read_vector_with_size<unsigned>(in);
+					ch_extra.forward.tail = read_vector_with_size<unsigned>(in);
+					ch_extra.forward.mid_node = read_vector_with_size<unsigned>(in);
+					ch.backward.head = read_vector_with_size<unsigned>(in);
+					ch.backward.weight = read_vector_with_size<unsigned>(in);
+					ch_extra.backward.tail = read_vector_with_size<unsigned>(in);
+					ch_extra.backward.mid_node = read_vector_with_size<unsigned>(in);
+
+					if (
+						ch.rank.size() != node_count || ch.order.size() != node_count ||
+						contracted_node_count + queue.size() != node_count ||
+						ch.forward.weight.size() != ch.forward.head.size() || ch_extra.forward.tail.size() != ch.forward.head.size() || ch_extra.forward.mid_node.size() != ch.forward.head.size() ||
+						ch.backward.weight.size() != ch.backward.head.size() || ch_extra.backward.tail.size() != ch.backward.head.size() || ch_extra.backward.mid_node.size() != ch.backward.head.size())
+						throw std::runtime_error("CH checkpoint \"" + file_name + "\" is corrupt."); });
+				last_save_time = get_micro_time();
+			}
+
+			void remove()
+			{
+				fs::remove(file_name);
+			}
+
+		private:
+			std::string file_name;
+			long long interval_in_musec;
+			unsigned long long input_fingerprint;
+			long long last_save_time;
+		};
+
 		void build_ch_and_order(
 			Graph &graph,
 			ContractionHierarchy &ch,
 			ContractionHierarchyExtraInfo &ch_extra,
 			unsigned max_pop_count,
-			const std::function<void(std::string)> &log_message)
+			unsigned thread_count,
+			const std::function<void(std::string)> &log_message,
+			BuildCheckpoint *checkpoint = nullptr)
 		{
 			long long timer = 0;				 // initialize to avoid warning, not needed
 			long long last_log_message_time = 0; // initialize to avoid warning, not needed
@@ -719,23 +1133,51 @@ namespace RoutingKit
 
 			const unsigned node_count = graph.node_count();
 
-			ShorterPathTest shorter_path_test(graph, max_pop_count);
+			// The priorities are computed using one witness search object per thread. All threads only read the
+			// graph and the results are applied to the queue in the same order as by a sequential computation.
+			// The order is therefore the same for every thread count.
+			std::vector<ShorterPathTest> shorter_path_test(thread_count, ShorterPathTest(graph, max_pop_count));
 
 			ch.rank.resize(node_count);
 			ch.order.resize(node_count);
 			MinIDQueue queue(node_count);
 
-			for (unsigned i = 0; i < node_count; ++i)
-			{
-				queue.push({i, estimate_node_importance(graph, shorter_path_test, i)});
+			unsigned contracted_node_count = 0;
 
+			if (checkpoint && checkpoint->exists())
+			{
+				checkpoint->load(graph, queue, ch, ch_extra, contracted_node_count);
+				if (graph.node_count() != node_count)
+					throw std::runtime_error("CH checkpoint has a different node count than the input graph.");
 				if (log_message)
+					log_message("Resumed from checkpoint. " + std::to_string(contracted_node_count) + " of " + std::to_string(node_count) + " nodes are already contracted.");
+			}
+			else
+			{
+				const unsigned block_size = 1 << 16;
+				std::vector<unsigned> key(std::min(node_count, block_size));
+
+				for (unsigned block_begin = 0; block_begin < node_count; block_begin += block_size)
 				{
-					long long current_time = get_micro_time();
-					if (current_time - last_log_message_time > 1000000)
+					const unsigned block_end = std::min(node_count, block_begin + block_size);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 256) if (thread_count > 1)
+#endif
+					for (unsigned i = block_begin; i < block_end; ++i)
+						key[i - block_begin] = estimate_node_importance(graph, shorter_path_test[get_thread_id()], i);
+
+					for (unsigned i = block_begin; i < block_end; ++i)
+						queue.push({i, key[i - block_begin]});
+
+					if (log_message)
 					{
-						last_log_message_time = current_time;
-						log_message("Added " + std::to_string(i + 1) + " of " + std::to_string(node_count) + " nodes to the queue. Running for " + std::to_string(timer + current_time) + "musec.");
+						long long current_time = get_micro_time();
+						if (current_time - last_log_message_time > 1000000)
+						{
+							last_log_message_time = current_time;
+							log_message("Added " + std::to_string(block_end) + " of " + std::to_string(node_count) + " nodes to the queue. Running for " + std::to_string(timer + current_time) + "musec.");
+						}
 					}
 				}
 			}
@@ -749,10 +1191,9 @@ namespace RoutingKit
 			}
 
 			std::vector<unsigned> neighbor_list;
+			std::vector<unsigned> neighbor_key;
 			std::vector<bool> is_neighbor(node_count, false);
 
-			unsigned contracted_node_count = 0;
-
 			while (!queue.empty())
 			{
 				unsigned node_being_contracted = queue.pop().id;
@@ -790,8 +1231,8 @@ namespace RoutingKit
 					ch_extra.forward.tail.push_back(node_being_contracted);
 
 					const auto &a = graph.out(node_being_contracted, out_arc);
-					if (ch.forward.head.size() == invalid_id)
-						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
+					if (ch.forward.head.size() == invalid_ch_arc_id)
+						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction. Define ROUTING_KIT_CH_64_BIT_ARC_ID to lift this limit.");
 					ch.forward.head.push_back(a.node);
 					ch.forward.weight.push_back(a.weight);
 					ch_extra.forward.mid_node.push_back(a.mid_node);
@@ -802,8 +1243,8 @@ namespace RoutingKit
 					ch_extra.backward.tail.push_back(node_being_contracted);
 
 					const auto &a = graph.in(node_being_contracted, in_arc);
-					if (ch.backward.head.size() == invalid_id)
-						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
+					if (ch.backward.head.size() == invalid_ch_arc_id)
+						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction. Define ROUTING_KIT_CH_64_BIT_ARC_ID to lift this limit.");
 					ch.backward.head.push_back(a.node);
 					ch.backward.weight.push_back(a.weight);
 					ch_extra.backward.mid_node.push_back(a.mid_node);
@@ -813,13 +1254,28 @@ namespace RoutingKit
 				unsigned out_deg = graph.out_deg(node_being_contracted);
 				unsigned in_deg = graph.in_deg(node_being_contracted);
 
-				contract_node(graph, shorter_path_test, node_being_contracted);
+				contract_node(graph, shorter_path_test[0], node_being_contracted);
 
+				// The importance of a node only depends on its own level, so raising all levels first
+				// does not change the keys.
 				for (auto x : neighbor_list)
 				{
 					is_neighbor[x] = false;
 					graph.raise_level(x, neighbor_level);
-					unsigned new_key = estimate_node_importance(graph, shorter_path_test, x);
+				}
+
+				neighbor_key.resize(neighbor_list.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(thread_count) schedule(dynamic) if (thread_count > 1 && neighbor_list.size() > 1)
+#endif
+				for (unsigned i = 0; i < neighbor_list.size(); ++i)
+					neighbor_key[i] = estimate_node_importance(graph, shorter_path_test[get_thread_id()], neighbor_list[i]);
+
+				for (unsigned i = 0; i < neighbor_list.size(); ++i)
+				{
+					unsigned x = neighbor_list[i];
+					unsigned new_key = neighbor_key[i];
 					assert(queue.contains_id(x));
 					unsigned old_key = queue.get_key(x);
 					if (old_key < new_key)
@@ -841,6 +1297,13 @@ namespace RoutingKit
 						log_message("Contracted " + std::to_string(contracted_node_count) + " of " + std::to_string(node_count) + ". The in degree of last node was " + std::to_string(in_deg) + " and out degree was " + std::to_string(out_deg) + ". Running for " + std::to_string(timer + current_time) + "musec.");
 					}
 				}
+
+				if (checkpoint && !queue.empty() && checkpoint->is_due())
+				{
+					checkpoint->save(graph, queue, ch, ch_extra, contracted_node_count);
+					if (log_message)
+						log_message("Wrote checkpoint after contracting " + std::to_string(contracted_node_count) + " of " + std::to_string(node_count) + " nodes.");
+				}
 			}
 
 			ch.forward.head.shrink_to_fit();
@@ -906,7 +1369,7 @@ namespace RoutingKit
 			}
 
 			ch.rank = invert_permutation(ch.order);
-			core = std::vector<unsigned int>(order.rbegin(), order.rend());
+			core = std::vector<unsigned int>(ch.order.rbegin(), ch.order.rend());
 
 			if (log_message)
 			{
@@ -922,8 +1385,8 @@ namespace RoutingKit
 					ch_extra.forward.tail.push_back(node_being_contracted);
 
 					const auto &a = graph.out(node_being_contracted, out_arc);
-					if (ch.forward.head.size() == invalid_id)
-						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
+					if (ch.forward.head.size() == invalid_ch_arc_id)
+						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction. Define ROUTING_KIT_CH_64_BIT_ARC_ID to lift this limit.");
 					ch.forward.head.push_back(a.node);
 					ch.forward.weight.push_back(a.weight);
 					ch_extra.forward.mid_node.push_back(a.mid_node);
@@ -934,8 +1397,8 @@ namespace RoutingKit
 					ch_extra.backward.tail.push_back(node_being_contracted);
 
 					const auto &a = graph.in(node_being_contracted, in_arc);
-					if (ch.backward.head.size() == invalid_id)
-						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
+					if (ch.backward.head.size() == invalid_ch_arc_id)
+						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction. Define ROUTING_KIT_CH_64_BIT_ARC_ID to lift this limit.");
 					ch.backward.head.push_back(a.node);
 					ch.backward.weight.push_back(a.weight);
 					ch_extra.backward.mid_node.push_back(a.mid_node);
@@ -1014,8 +1477,8 @@ namespace RoutingKit
 					ch_extra.forward.tail.push_back(node_being_contracted);
 
 					const auto &a = graph.out(node_being_contracted, out_arc);
-					if (ch.forward.head.size() == invalid_id)
-						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
+					if (ch.forward.head.size() == invalid_ch_arc_id)
+						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction. Define ROUTING_KIT_CH_64_BIT_ARC_ID to lift this limit.");
 					ch.forward.head.push_back(a.node);
 					ch.forward.weight.push_back(a.weight);
 					ch_extra.forward.mid_node.push_back(a.mid_node);
@@ -1026,8 +1489,8 @@ namespace RoutingKit
 					ch_extra.backward.tail.push_back(node_being_contracted);
 
 					const auto &a = graph.in(node_being_contracted, in_arc);
-					if (ch.backward.head.size() == invalid_id)
-						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
+					if (ch.backward.head.size() == invalid_ch_arc_id)
+						throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction. Define ROUTING_KIT_CH_64_BIT_ARC_ID to lift this limit.");
 					ch.backward.head.push_back(a.node);
 					ch.backward.weight.push_back(a.weight);
 					ch_extra.backward.mid_node.push_back(a.mid_node);
@@ -1066,75 +1529,505 @@ namespace RoutingKit
 			}
 		}
 
-		void make_internal_nodes_and_rank_coincide(
+		void add_arcs_of_node_to_ch(
+			const Graph &graph,
+			unsigned node,
 			ContractionHierarchy &ch,
-			ContractionHierarchyExtraInfo &ch_extra,
-			const std::function<void(std::string)> &log_message)
+			ContractionHierarchyExtraInfo &ch_extra)
 		{
-			long long timer = 0; // initialize to avoid warning, not needed
-			if (log_message)
+			for (unsigned out_arc = 0; out_arc < graph.out_deg(node); ++out_arc)
 			{
-				timer = -get_micro_time();
-				log_message("Start reordering nodes by rank.");
-			}
+				ch_extra.forward.tail.push_back(node);
 
-			inplace_apply_permutation_to_elements_of(ch.rank, ch.forward.head);
-			inplace_apply_permutation_to_elements_of(ch.rank, ch_extra.forward.tail);
-			inplace_apply_permutation_to_possibly_invalid_elements_of(ch.rank, ch_extra.forward.mid_node);
-			inplace_apply_permutation_to_elements_of(ch.rank, ch.backward.head);
-			inplace_apply_permutation_to_elements_of(ch.rank, ch_extra.backward.tail);
-			inplace_apply_permutation_to_possibly_invalid_elements_of(ch.rank, ch_extra.backward.mid_node);
-
-#ifndef NDEBUG
-			for (unsigned i = 0; i < ch_extra.forward.tail.size(); ++i)
-				assert(ch_extra.forward.tail[i] < ch.forward.head[i]);
-			for (unsigned i = 0; i < ch_extra.backward.tail.size(); ++i)
-				assert(ch_extra.backward.tail[i] < ch.backward.head[i]);
-#endif
+				const auto &a = graph.out(node, out_arc);
+				if (ch.forward.head.size() == invalid_ch_arc_id)
+					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction. Define ROUTING_KIT_CH_64_BIT_ARC_ID to lift this limit.");
+				ch.forward.head.push_back(a.node);
+				ch.forward.weight.push_back(a.weight);
+				ch_extra.forward.mid_node.push_back(a.mid_node);
+			}
 
-			if (log_message)
+			for (unsigned in_arc = 0; in_arc < graph.in_deg(node); ++in_arc)
 			{
-				timer += get_micro_time();
-				log_message("Finished reordering nodes by rank. Needed " + std::to_string(timer) + "musec.");
+				ch_extra.backward.tail.push_back(node);
+
+				const auto &a = graph.in(node, in_arc);
+				if (ch.backward.head.size() == invalid_ch_arc_id)
+					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction. Define ROUTING_KIT_CH_64_BIT_ARC_ID to lift this limit.");
+				ch.backward.head.push_back(a.node);
+				ch.backward.weight.push_back(a.weight);
+				ch_extra.backward.mid_node.push_back(a.mid_node);
 			}
 		}
 
-		void sort_ch_arcs_and_build_first_out_arrays(
+		// Contracts all nodes in nodes_to_contract in rounds. In every round, the nodes that must be contracted
+		// before all of their remaining neighbors according to is_contracted_before are selected. They form an
+		// independent set and are contracted concurrently: The witness searches run in parallel on the unmodified
+		// graph and ignore all nodes of the current round. Afterwards the shortcuts are inserted sequentially in
+		// the order given by is_contracted_before. The result does therefore not depend on the number of threads.
+		//
+		// After every round, on_round_finished is called with the contracted nodes sorted by is_contracted_before
+		// and with the nodes that were adjacent to them.
+		template <class IsContractedBefore, class OnRoundFinished>
+		void contract_independent_node_sets(
+			Graph &graph,
 			ContractionHierarchy &ch,
 			ContractionHierarchyExtraInfo &ch_extra,
+			std::vector<ShorterPathTest> &shorter_path_test,
+			std::vector<unsigned> nodes_to_contract,
+			const IsContractedBefore &is_contracted_before,
+			const OnRoundFinished &on_round_finished,
 			const std::function<void(std::string)> &log_message)
 		{
-			long long timer = 0; // initialize to avoid warning, not needed
+			const unsigned node_count = graph.node_count();
+			const unsigned thread_count = shorter_path_test.size();
+			const unsigned total_node_count = nodes_to_contract.size();
+			(void)thread_count;
+
+			long long timer = 0;				 // initialize to avoid warning, not needed
+			long long last_log_message_time = 0; // initialize to avoid warning, not needed
 			if (log_message)
 			{
-				timer = -get_micro_time();
-				log_message("Start sorting arcs.");
+				last_log_message_time = get_micro_time();
+				timer = -last_log_message_time;
+				log_message("Start contracting independent node sets using " + std::to_string(shorter_path_test.size()) + " threads.");
 			}
 
-			unsigned node_count = ch.rank.size();
+			BitVector is_in_round(node_count, false);
+			for (auto &t : shorter_path_test)
+				t.set_excluded_nodes(&is_in_round);
 
-			{
-				auto r = compute_inverse_sort_permutation_first_by_tail_then_by_head_and_apply_sort_to_tail(node_count, ch_extra.forward.tail, ch.forward.head);
+			std::vector<char> is_selected;
+			std::vector<unsigned> round;
+			std::vector<std::vector<Shortcut>> round_shortcuts;
 
-				ch.forward.head = apply_inverse_permutation(r, ch.forward.head);
-				ch.forward.weight = apply_inverse_permutation(r, ch.forward.weight);
-				ch_extra.forward.mid_node = apply_inverse_permutation(r, ch_extra.forward.mid_node);
+			std::vector<unsigned> neighbor_list;
+			std::vector<bool> is_neighbor(node_count, false);
 
-				ch.forward.first_out = invert_vector(ch_extra.forward.tail, node_count);
-			}
+			unsigned contracted_node_count = 0;
+			unsigned round_count = 0;
 
+			while (!nodes_to_contract.empty())
 			{
-				auto r = compute_inverse_sort_permutation_first_by_tail_then_by_head_and_apply_sort_to_tail(node_count, ch_extra.backward.tail, ch.backward.head);
-				ch.backward.head = apply_inverse_permutation(r, ch.backward.head);
-				ch.backward.weight = apply_inverse_permutation(r, ch.backward.weight);
-				ch_extra.backward.mid_node = apply_inverse_permutation(r, ch_extra.backward.mid_node);
+				is_selected.resize(nodes_to_contract.size());
 
-				ch.backward.first_out = invert_vector(ch_extra.backward.tail, node_count);
-			}
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(thread_count) schedule(static)
+#endif
+				for (unsigned i = 0; i < nodes_to_contract.size(); ++i)
+				{
+					unsigned x = nodes_to_contract[i];
+					bool is_selectable = true;
+					for (unsigned in_arc = 0; in_arc < graph.in_deg(x) && is_selectable; ++in_arc)
+						is_selectable = is_contracted_before(x, graph.in(x, in_arc).node);
+					for (unsigned out_arc = 0; out_arc < graph.out_deg(x) && is_selectable; ++out_arc)
+						is_selectable = is_contracted_before(x, graph.out(x, out_arc).node);
+					is_selected[i] = is_selectable;
+				}
 
-			if (log_message)
-			{
-				timer += get_micro_time();
+				round.clear();
+				{
+					unsigned remaining_node_count = 0;
+					for (unsigned i = 0; i < nodes_to_contract.size(); ++i)
+					{
+						if (is_selected[i])
+							round.push_back(nodes_to_contract[i]);
+						else
+							nodes_to_contract[remaining_node_count++] = nodes_to_contract[i];
+					}
+					nodes_to_contract.erase(nodes_to_contract.begin() + remaining_node_count, nodes_to_contract.end());
+				}
+				assert(!round.empty() && "the first remaining node must always be selectable");
+
+				std::sort(round.begin(), round.end(), is_contracted_before);
+
+				for (auto x : round)
+					is_in_round.set(x);
+
+				if (round_shortcuts.size() < round.size())
+					round_shortcuts.resize(round.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(thread_count) schedule(dynamic)
+#endif
+				for (unsigned i = 0; i < round.size(); ++i)
+					compute_shortcuts_of_node(graph, shorter_path_test[get_thread_id()], round[i], round_shortcuts[i]);
+
+				for (auto node_being_contracted : round)
+				{
+					unsigned neighbor_level = graph.level(node_being_contracted) + 1;
+
+					auto on_neighbor = [&](unsigned x)
+					{
+						assert(!is_in_round.is_set(x));
+						graph.raise_level(x, neighbor_level);
+						if (!is_neighbor[x])
+						{
+							neighbor_list.push_back(x);
+							is_neighbor[x] = true;
+						}
+					};
+
+					for (unsigned in_arc = 0; in_arc < graph.in_deg(node_being_contracted); ++in_arc)
+						on_neighbor(graph.in(node_being_contracted, in_arc).node);
+					for (unsigned out_arc = 0; out_arc < graph.out_deg(node_being_contracted); ++out_arc)
+						on_neighbor(graph.out(node_being_contracted, out_arc).node);
+
+					add_arcs_of_node_to_ch(graph, node_being_contracted, ch, ch_extra);
+				}
+
+				for (unsigned i = 0; i < round.size(); ++i)
+					for (const auto &s : round_shortcuts[i])
+						graph.add_arc_or_reduce_arc_weight(s.tail, s.mid_node, s.head, s.weight, s.hop_length);
+
+				for (auto x : round)
+				{
+					graph.remove_all_incident_arcs(x);
+					is_in_round.reset(x);
+				}
+
+				on_round_finished(round, neighbor_list);
+
+				for (auto x : neighbor_list)
+					is_neighbor[x] = false;
+				neighbor_list.clear();
+
+				contracted_node_count += round.size();
+				++round_count;
+
+				if (log_message)
+				{
+					long long current_time = get_micro_time();
+					if (current_time - last_log_message_time > 1000000)
+					{
+						last_log_message_time = current_time;
+						log_message("Contracted " + std::to_string(contracted_node_count) + " of " + std::to_string(total_node_count) + " nodes in " + std::to_string(round_count) + " rounds. The last round contracted " + std::to_string(round.size()) + " nodes. Running for " + std::to_string(timer + current_time) + "musec.");
+					}
+				}
+			}
+
+			for (auto &t : shorter_path_test)
+				t.set_excluded_nodes(nullptr);
+
+			if (log_message)
+			{
+				timer += get_micro_time();
+				log_message("Finished contracting independent node sets. Needed " + std::to_string(round_count) + " rounds and " + std::to_string(timer) + "musec.");
+			}
+		}
+
+		void shrink_ch_to_fit(ContractionHierarchy &ch, ContractionHierarchyExtraInfo &ch_extra)
+		{
+			ch.forward.head.shrink_to_fit();
+			ch.forward.weight.shrink_to_fit();
+			ch_extra.forward.mid_node.shrink_to_fit();
+			ch_extra.forward.tail.shrink_to_fit();
+
+			ch.backward.head.shrink_to_fit();
+			ch.backward.weight.shrink_to_fit();
+			ch_extra.backward.mid_node.shrink_to_fit();
+			ch_extra.backward.tail.shrink_to_fit();
+		}
+
+		void build_ch_and_order_using_independent_node_sets(
+			Graph &graph,
+			ContractionHierarchy &ch,
+			ContractionHierarchyExtraInfo &ch_extra,
+			unsigned max_pop_count,
+			unsigned thread_count,
+			const std::function<void(std::string)> &log_message)
+		{
+			long long timer = 0; // initialize to avoid warning, not needed
+			if (log_message)
+			{
+				timer = -get_micro_time();
+				log_message("Start computing initial node priorities.");
+			}
+
+			const unsigned node_count = graph.node_count();
+
+			std::vector<ShorterPathTest> shorter_path_test(thread_count, ShorterPathTest(graph, max_pop_count));
+
+			ch.rank.resize(node_count);
+			ch.order.resize(node_count);
+
+			std::vector<unsigned> priority(node_count);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 256)
+#endif
+			for (unsigned x = 0; x < node_count; ++x)
+				priority[x] = estimate_node_importance(graph, shorter_path_test[get_thread_id()], x);
+
+			if (log_message)
+			{
+				timer += get_micro_time();
+				log_message("Finished computing initial node priorities. Needed " + std::to_string(timer) + "musec time.");
+			}
+
+			unsigned contracted_node_count = 0;
+
+			contract_independent_node_sets(
+				graph, ch, ch_extra, shorter_path_test, identity_permutation(node_count),
+				[&](unsigned x, unsigned y)
+				{
+					return priority[x] < priority[y] || (priority[x] == priority[y] && x < y);
+				},
+				[&](const std::vector<unsigned> &round, const std::vector<unsigned> &neighbor_list)
+				{
+					for (auto x : round)
+					{
+						ch.rank[x] = contracted_node_count;
+						ch.order[contracted_node_count] = x;
+						++contracted_node_count;
+					}
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(thread_count) schedule(dynamic)
+#endif
+					for (unsigned i = 0; i < neighbor_list.size(); ++i)
+						priority[neighbor_list[i]] = estimate_node_importance(graph, shorter_path_test[get_thread_id()], neighbor_list[i]);
+				},
+				log_message);
+
+			assert(contracted_node_count == node_count);
+
+			shrink_ch_to_fit(ch, ch_extra);
+		}
+
+		void build_ch_given_rank_using_independent_node_sets(
+			Graph &graph,
+			ContractionHierarchy &ch,
+			ContractionHierarchyExtraInfo &ch_extra,
+			const std::vector<unsigned> &rank,
+			unsigned max_pop_count,
+			unsigned thread_count,
+			const std::function<void(std::string)> &log_message)
+		{
+			if (log_message)
+				log_message("Start building contraction hierarchy with given rank.");
+
+			std::vector<ShorterPathTest> shorter_path_test(thread_count, ShorterPathTest(graph, max_pop_count));
+			ch.rank = rank;
+			ch.order = invert_permutation(rank);
+
+			contract_independent_node_sets(
+				graph, ch, ch_extra, shorter_path_test, ch.order,
+				[&](unsigned x, unsigned y)
+				{
+					return ch.rank[x] < ch.rank[y];
+				},
+				[](const std::vector<unsigned> &, const std::vector<unsigned> &) {},
+				log_message);
+
+			shrink_ch_to_fit(ch, ch_extra);
+		}
+
+		void build_ch_given_rank_and_core_using_independent_node_sets(
+			Graph &graph,
+			ContractionHierarchy &ch,
+			ContractionHierarchyExtraInfo &ch_extra,
+			const std::vector<unsigned> &rank,
+			BitVector const &must_be_core_node,
+			std::vector<unsigned int> &core,
+			double rel_core_size,
+			unsigned max_pop_count,
+			unsigned thread_count,
+			const std::function<void(std::string)> &log_message)
+		{
+			unsigned int node_count = graph.node_count();
+			const unsigned int stop_at = (1.0 - rel_core_size) * node_count;
+
+			if (log_message)
+				log_message("Start building contraction hierarchy with given rank and core size.");
+
+			std::vector<ShorterPathTest> shorter_path_test(thread_count, ShorterPathTest(graph, max_pop_count));
+
+			// move core nodes to end
+			auto order = invert_permutation(rank);
+			size_t order_size = order.size();
+			ch.order.resize(order_size, order_size);
+			uint64_t min_core_node_count = must_be_core_node.count_true();
+			uint64_t shift = 0;
+
+			for (uint64_t i = 0; i < order_size; ++i)
+			{
+				if (must_be_core_node.is_set(order[i]))
+				{
+					ch.order[order_size - min_core_node_count + shift] = order[i];
+					++shift;
+				}
+				else
+				{
+					ch.order[i - shift] = order[i];
+				}
+			}
+
+			ch.rank = invert_permutation(ch.order);
+			core = std::vector<unsigned int>(ch.order.rbegin(), ch.order.rend());
+
+			if (log_message)
+			{
+				log_message("Starting contractions, core size target: " + std::to_string(node_count - stop_at) + " (" + std::to_string(rel_core_size * 100.0) + "%)");
+			}
+
+			std::vector<unsigned> nodes_to_contract;
+			for (unsigned i = 0; i < node_count && i < stop_at; ++i)
+				if (!must_be_core_node.is_set(ch.order[i]))
+					nodes_to_contract.push_back(ch.order[i]);
+
+			contract_independent_node_sets(
+				graph, ch, ch_extra, shorter_path_test, nodes_to_contract,
+				[&](unsigned x, unsigned y)
+				{
+					return ch.rank[x] < ch.rank[y];
+				},
+				[&](const std::vector<unsigned> &round, const std::vector<unsigned> &)
+				{
+					core.erase(core.end() - round.size(), core.end());
+				},
+				log_message);
+
+			// The arcs of the contracted nodes have already been added and were removed from the graph.
+			for (unsigned i = 0; i < node_count; ++i)
+				add_arcs_of_node_to_ch(graph, ch.order[i], ch, ch_extra);
+
+			core.shrink_to_fit();
+			std::reverse(core.begin(), core.end());
+
+			shrink_ch_to_fit(ch, ch_extra);
+		}
+
+		// The core_node_count highest ranked nodes form the core. Arcs between two
+		// core nodes may point downwards, all other arcs point upwards.
+		void make_internal_nodes_and_rank_coincide(
+			ContractionHierarchy &ch,
+			ContractionHierarchyExtraInfo &ch_extra,
+			unsigned core_node_count,
+			const std::function<void(std::string)> &log_message)
+		{
+			long long timer = 0; // initialize to avoid warning, not needed
+			if (log_message)
+			{
+				timer = -get_micro_time();
+				log_message("Start reordering nodes by rank.");
+			}
+
+			inplace_apply_permutation_to_elements_of(ch.rank, ch.forward.head);
+			inplace_apply_permutation_to_elements_of(ch.rank, ch_extra.forward.tail);
+			inplace_apply_permutation_to_possibly_invalid_elements_of(ch.rank, ch_extra.forward.mid_node);
+			inplace_apply_permutation_to_elements_of(ch.rank, ch.backward.head);
+			inplace_apply_permutation_to_elements_of(ch.rank, ch_extra.backward.tail);
+			inplace_apply_permutation_to_possibly_invalid_elements_of(ch.rank, ch_extra.backward.mid_node);
+
+#ifndef NDEBUG
+			const unsigned first_core_rank = ch.rank.size() - core_node_count;
+			for (unsigned i = 0; i < ch_extra.forward.tail.size(); ++i)
+				assert(ch_extra.forward.tail[i] < ch.forward.head[i] || (ch_extra.forward.tail[i] >= first_core_rank && ch.forward.head[i] >= first_core_rank));
+			for (unsigned i = 0; i < ch_extra.backward.tail.size(); ++i)
+				assert(ch_extra.backward.tail[i] < ch.backward.head[i] || (ch_extra.backward.tail[i] >= first_core_rank && ch.backward.head[i] >= first_core_rank));
+#endif
+
+			if (log_message)
+			{
+				timer += get_micro_time();
+				log_message("Finished reordering nodes by rank. Needed " + std::to_string(timer) + "musec.");
+			}
+		}
+
+		// Computes the permutation p that sorts the arcs first by tail and then
+		// by head, i.e., the arc at position i in the sorted order is p[i]. The
+		// result is the same as compute_inverse_sort_permutation_first_by_tail_then_by_head_and_apply_sort_to_tail
+		// but arc positions are CHArcIDs and first_out is computed on the way.
+		std::vector<CHArcID> compute_ch_arc_sort_permutation_and_first_out(
+			unsigned node_count,
+			const std::vector<unsigned> &tail,
+			const std::vector<unsigned> &head,
+			std::vector<CHArcID> &first_out)
+		{
+			const CHArcID arc_count = tail.size();
+
+			auto stable_counting_sort = [&](const std::vector<unsigned> &key, const std::vector<CHArcID> *in, std::vector<CHArcID> &out, std::vector<CHArcID> &begin)
+			{
+				std::fill(begin.begin(), begin.end(), 0);
+				for (CHArcID i = 0; i < arc_count; ++i)
+					++begin[key[in ? (*in)[i] : i] + 1];
+				for (unsigned x = 0; x < node_count; ++x)
+					begin[x + 1] += begin[x];
+				std::vector<CHArcID> pos(begin.begin(), begin.end() - 1);
+				for (CHArcID i = 0; i < arc_count; ++i)
+				{
+					CHArcID a = in ? (*in)[i] : i;
+					out[pos[key[a]]++] = a;
+				}
+			};
+
+			std::vector<CHArcID> by_head(arc_count), p(arc_count);
+			first_out.resize(node_count + 1);
+			stable_counting_sort(head, nullptr, by_head, first_out);
+			stable_counting_sort(tail, &by_head, p, first_out);
+			return p; // NVRO
+		}
+
+		template <class T>
+		std::vector<T> apply_ch_arc_permutation(const std::vector<CHArcID> &p, std::vector<T> v)
+		{
+			std::vector<T> r(p.size());
+			for (CHArcID i = 0; i < p.size(); ++i)
+				r[i] = std::move(v[p[i]]);
+			return r; // NVRO
+		}
+
+		CHArcID find_ch_arc_given_sorted_head(const std::vector<CHArcID> &first_out, const std::vector<unsigned> &head, unsigned x, unsigned y)
+		{
+			assert(x < first_out.size() - 1 && "node id out of bounds");
+			assert(y < first_out.size() - 1 && "node id out of bounds");
+
+			auto
+				begin = head.begin() + first_out[x],
+				end = head.begin() + first_out[x + 1];
+
+			assert(std::is_sorted(begin, end) && "heads are not sorted");
+			auto pos = std::lower_bound(begin, end, y);
+			assert(pos != end && *pos == y && "arc does not exist");
+			return pos - head.begin();
+		}
+
+		void sort_ch_arcs_and_build_first_out_arrays(
+			ContractionHierarchy &ch,
+			ContractionHierarchyExtraInfo &ch_extra,
+			const std::function<void(std::string)> &log_message)
+		{
+			long long timer = 0; // initialize to avoid warning, not needed
+			if (log_message)
+			{
+				timer = -get_micro_time();
+				log_message("Start sorting arcs.");
+			}
+
+			unsigned node_count = ch.rank.size();
+
+			{
+				auto p = compute_ch_arc_sort_permutation_and_first_out(node_count, ch_extra.forward.tail, ch.forward.head, ch.forward.first_out);
+
+				ch_extra.forward.tail = apply_ch_arc_permutation(p, std::move(ch_extra.forward.tail));
+				ch.forward.head = apply_ch_arc_permutation(p, std::move(ch.forward.head));
+				ch.forward.weight = apply_ch_arc_permutation(p, std::move(ch.forward.weight));
+				ch_extra.forward.mid_node = apply_ch_arc_permutation(p, std::move(ch_extra.forward.mid_node));
+			}
+
+			{
+				auto p = compute_ch_arc_sort_permutation_and_first_out(node_count, ch_extra.backward.tail, ch.backward.head, ch.backward.first_out);
+
+				ch_extra.backward.tail = apply_ch_arc_permutation(p, std::move(ch_extra.backward.tail));
+				ch.backward.head = apply_ch_arc_permutation(p, std::move(ch.backward.head));
+				ch.backward.weight = apply_ch_arc_permutation(p, std::move(ch.backward.weight));
+				ch_extra.backward.mid_node = apply_ch_arc_permutation(p, std::move(ch_extra.backward.mid_node));
+			}
+
+			if (log_message)
+			{
+				timer += get_micro_time();
 				log_message("Finished sorting arcs. Needed " + std::to_string(timer) + "musec.");
 			}
 		}
@@ -1152,13 +2045,13 @@ namespace RoutingKit
 			}
 
 			unsigned node_count = ch.rank.size();
-			unsigned forward_arc_count = ch.forward.head.size();
-			unsigned backward_arc_count = ch.backward.head.size();
+			CHArcID forward_arc_count = ch.forward.head.size();
+			CHArcID backward_arc_count = ch.backward.head.size();
 
 			std::vector<bool> is_in_bottom_level(node_count, true);
-			for (unsigned a = 0; a < forward_arc_count; ++a)
+			for (CHArcID a = 0; a < forward_arc_count; ++a)
 				is_in_bottom_level[ch.forward.head[a]] = false;
-			for (unsigned a = 0; a < backward_arc_count; ++a)
+			for (CHArcID a = 0; a < backward_arc_count; ++a)
 				is_in_bottom_level[ch.backward.head[a]] = false;
 			std::vector<unsigned> new_order(node_count);
 
@@ -1194,10 +2087,10 @@ namespace RoutingKit
 							}
 						};
 
-						for (unsigned xy = ch.forward.first_out[x]; xy < ch.forward.first_out[x + 1]; ++xy)
+						for (CHArcID xy = ch.forward.first_out[x]; xy < ch.forward.first_out[x + 1]; ++xy)
 							on_node(ch.forward.head[xy]);
 
-						for (unsigned xy = ch.backward.first_out[x]; xy < ch.backward.first_out[x + 1]; ++xy)
+						for (CHArcID xy = ch.backward.first_out[x]; xy < ch.backward.first_out[x + 1]; ++xy)
 							on_node(ch.backward.head[xy]);
 					}
 					std::reverse(new_order.begin() + new_order_end, new_order.begin() + search_space_end);
@@ -1235,18 +2128,18 @@ namespace RoutingKit
 				timer = -get_micro_time();
 			}
 
-			ch.forward.shortcut_first_arc = std::vector<unsigned>(ch.forward.head.size());
-			ch.forward.shortcut_second_arc = std::vector<unsigned>(ch.forward.head.size());
+			ch.forward.shortcut_first_arc = std::vector<CHArcID>(ch.forward.head.size());
+			ch.forward.shortcut_second_arc = std::vector<CHArcID>(ch.forward.head.size());
 			ch.forward.is_shortcut_an_original_arc = BitVector(ch.forward.head.size(), BitVector::uninitialized);
-			ch.backward.shortcut_first_arc = std::vector<unsigned>(ch.backward.head.size());
-			ch.backward.shortcut_second_arc = std::vector<unsigned>(ch.backward.head.size());
+			ch.backward.shortcut_first_arc = std::vector<CHArcID>(ch.backward.head.size());
+			ch.backward.shortcut_second_arc = std::vector<CHArcID>(ch.backward.head.size());
 			ch.backward.is_shortcut_an_original_arc = BitVector(ch.backward.head.size(), BitVector::uninitialized);
 
 			auto first_out = invert_vector(tail, node_count);
 
 			for (unsigned x = 0; x < node_count; ++x)
 			{
-				for (unsigned xy = ch.forward.first_out[x]; xy < ch.forward.first_out[x + 1]; ++xy)
+				for (CHArcID xy = ch.forward.first_out[x]; xy < ch.forward.first_out[x + 1]; ++xy)
 				{
 					unsigned y = ch.forward.head[xy];
 					unsigned z = ch_extra.forward.mid_node[xy];
@@ -1261,8 +2154,8 @@ namespace RoutingKit
 					else
 					{
 						ch.forward.is_shortcut_an_original_arc.reset(xy);
-						ch.forward.shortcut_first_arc[xy] = find_arc_given_sorted_head(ch.backward.first_out, ch.backward.head, z, x);
-						ch.forward.shortcut_second_arc[xy] = find_arc_given_sorted_head(ch.forward.first_out, ch.forward.head, z, y);
+						ch.forward.shortcut_first_arc[xy] = find_ch_arc_given_sorted_head(ch.backward.first_out, ch.backward.head, z, x);
+						ch.forward.shortcut_second_arc[xy] = find_ch_arc_given_sorted_head(ch.forward.first_out, ch.forward.head, z, y);
 
 						assert(ch.forward.weight[xy] == ch.backward.weight[ch.forward.shortcut_first_arc[xy]] + ch.forward.weight[ch.forward.shortcut_second_arc[xy]]);
 					}
@@ -1271,7 +2164,7 @@ namespace RoutingKit
 
 			for (unsigned x = 0; x < node_count; ++x)
 			{
-				for (unsigned xy = ch.backward.first_out[x]; xy < ch.backward.first_out[x + 1]; ++xy)
+				for (CHArcID xy = ch.backward.first_out[x]; xy < ch.backward.first_out[x + 1]; ++xy)
 				{
 					unsigned y = ch.backward.head[xy];
 					unsigned z = ch_extra.backward.mid_node[xy];
@@ -1285,8 +2178,8 @@ namespace RoutingKit
 					else
 					{
 						ch.backward.is_shortcut_an_original_arc.reset(xy);
-						ch.backward.shortcut_first_arc[xy] = find_arc_given_sorted_head(ch.backward.first_out, ch.backward.head, z, y);
-						ch.backward.shortcut_second_arc[xy] = find_arc_given_sorted_head(ch.forward.first_out, ch.forward.head, z, x);
+						ch.backward.shortcut_first_arc[xy] = find_ch_arc_given_sorted_head(ch.backward.first_out, ch.backward.head, z, y);
+						ch.backward.shortcut_second_arc[xy] = find_ch_arc_given_sorted_head(ch.forward.first_out, ch.forward.head, z, x);
 					}
 				}
 			}
@@ -1294,7 +2187,7 @@ namespace RoutingKit
 #ifndef NDEBUG
 			unsigned input_arc_count = max_element_of(input_arc_id, 0u) + 1;
 
-			for (unsigned a = 0; a < ch.forward.head.size(); ++a)
+			for (CHArcID a = 0; a < ch.forward.head.size(); ++a)
 			{
 				if (!ch.forward.is_shortcut_an_original_arc.is_set(a))
 				{
@@ -1307,7 +2200,7 @@ namespace RoutingKit
 					assert(ch.forward.shortcut_second_arc[a] < node_count);
 				}
 			}
-			for (unsigned a = 0; a < ch.backward.head.size(); ++a)
+			for (CHArcID a = 0; a < ch.backward.head.size(); ++a)
 			{
 				if (!ch.backward.is_shortcut_an_original_arc.is_set(a))
 				{
@@ -1359,8 +2252,9 @@ namespace RoutingKit
 
 	ContractionHierarchy ContractionHierarchy::build(
 		unsigned node_count, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
-		const std::function<void(std::string)> &log_message, unsigned max_pop_count)
+		const std::function<void(std::string)> &log_message, unsigned max_pop_count, unsigned thread_count, bool contract_independent_node_sets)
 	{
+		assert(thread_count != 0);
 		assert(tail.size() == head.size());
 		assert(tail.size() == weight.size());
 		assert(max_element_of(tail) < node_count);
@@ -1379,7 +2273,10 @@ namespace RoutingKit
 
 		{
 			Graph graph(node_count, tail, head, weight);
-			build_ch_and_order(graph, ch, ch_extra, max_pop_count, log_message);
+			if (thread_count == 1 || !contract_independent_node_sets)
+				build_ch_and_order(graph, ch, ch_extra, max_pop_count, thread_count, log_message);
+			else
+				build_ch_and_order_using_independent_node_sets(graph, ch, ch_extra, max_pop_count, thread_count, log_message);
 		}
 
 		{
@@ -1389,7 +2286,7 @@ namespace RoutingKit
 		}
 
 		{
-			make_internal_nodes_and_rank_coincide(ch, ch_extra, log_message);
+			make_internal_nodes_and_rank_coincide(ch, ch_extra, 0, log_message);
 			sort_ch_arcs_and_build_first_out_arrays(ch, ch_extra, log_message);
 		}
 
@@ -1400,14 +2297,36 @@ namespace RoutingKit
 		return ch;
 	}
 
-	std::tuple<std::vector<unsigned int>, ContractionHierarchy> ContractionHierarchy::build_excluding_core(
-		std::vector<unsigned> rank, BitVector const &must_be_core_node, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight, double rel_core_size,
-		const std::function<void(std::string)> &log_message, unsigned max_pop_count)
+	namespace
 	{
-		// build_given_rank
-		unsigned node_count = rank.size();
-
-		assert(tail.size() == head.size());
+		unsigned long long compute_build_input_fingerprint(
+			unsigned node_count, const std::vector<unsigned> &tail, const std::vector<unsigned> &head, const std::vector<unsigned> &weight, unsigned max_pop_count)
+		{
+			unsigned long long h = 14695981039346656037ull;
+			auto add = [&](unsigned x)
+			{
+				h ^= x;
+				h *= 1099511628211ull;
+			};
+			add(node_count);
+			add(max_pop_count);
+			for (unsigned a = 0; a < head.size(); ++a)
+			{
+				add(tail[a]);
+				add(head[a]);
+				add(weight[a]);
+			}
+			return h;
+		}
+	}
+
+	ContractionHierarchy ContractionHierarchy::build_with_checkpoints(
+		unsigned node_count, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
+		const std::string &checkpoint_dir, unsigned checkpoint_interval_in_seconds,
+		const std::function<void(std::string)> &log_message, unsigned max_pop_count, unsigned thread_count)
+	{
+		assert(thread_count != 0);
+		assert(tail.size() == head.size());
 		assert(tail.size() == weight.size());
 		assert(max_element_of(tail) < node_count);
 		assert(max_element_of(head) < node_count);
@@ -1422,14 +2341,27 @@ namespace RoutingKit
 		{
 			sort_arcs_and_remove_multi_and_loop_arcs(node_count, tail, head, weight, input_arc_id, log_message);
 		}
-		std::vector<unsigned int> core;
+
+		fs::create_directories(checkpoint_dir);
+		BuildCheckpoint checkpoint(
+			(fs::path(checkpoint_dir) / "ch_build_checkpoint").string(), checkpoint_interval_in_seconds,
+			compute_build_input_fingerprint(node_count, tail, head, weight, max_pop_count));
+
 		{
 			Graph graph(node_count, tail, head, weight);
-			build_ch_given_rank_and_core(graph, ch, ch_extra, rank, must_be_core_node, core, rel_core_size, max_pop_count, log_message);
+			// The independent node sets are not used, as the checkpoint must not depend on the thread count.
+			build_ch_and_order(graph, ch, ch_extra, max_pop_count, thread_count, log_message, &checkpoint);
+		}
+
+		checkpoint.remove();
+
+		{
+			sort_ch_arcs_and_build_first_out_arrays(ch, ch_extra, log_message);
+			optimize_order_for_cache(ch, ch_extra, log_message);
 		}
 
 		{
-			make_internal_nodes_and_rank_coincide(ch, ch_extra, log_message);
+			make_internal_nodes_and_rank_coincide(ch, ch_extra, 0, log_message);
 			sort_ch_arcs_and_build_first_out_arrays(ch, ch_extra, log_message);
 		}
 
@@ -1437,375 +2369,328 @@ namespace RoutingKit
 
 		log_contraction_hierarchy_statistics(ch, log_message);
 
-		if (log_message)
-		{
-			log_message("Final core ch has " + std::to_string(core.size()) + " core nodes.");
-		}
-
-		return std::make_tuple(core, ch);
+		return ch;
 	}
 
-	void build_ch_save_intervals(
-		Graph &graph,
-		const std::vector<unsigned> tail, const std::vector<unsigned> head, const std::vector<unsigned> input_arc_id,
-		ContractionHierarchy &ch,
-		ContractionHierarchyExtraInfo &ch_extra,
-		const std::vector<unsigned> &rank,
-		BitVector const &must_be_core_node,
-		const std::string &export_dir,
-		double rel_core_size_start,
-		double step_factor,
-		unsigned max_pop_count,
-		const std::function<void(std::string)> &log_message,
-		bool log_append = false,
-		bool save_core_ch = true)
-	{
-		unsigned int node_count = graph.node_count();
-		unsigned int stop_at = (1.0 - rel_core_size_start) * node_count;
-
-		long long timer = 0;				 // initialize to avoid warning, not needed
-		long long last_log_message_time = 0; // initialize to avoid warning, not needed
-		if (log_message)
-		{
-			last_log_message_time = get_micro_time();
-			timer = -last_log_message_time;
-			log_message("Start building contraction hierarchy with given rank and core size.");
-		}
-
-		ShorterPathTest shorter_path_test(graph, max_pop_count);
+	std::tuple<std::vector<unsigned int>, ContractionHierarchy> ContractionHierarchy::build_excluding_core(
+		std::vector<unsigned> rank, BitVector const &must_be_core_node, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight, double rel_core_size,
+		const std::function<void(std::string)> &log_message, unsigned max_pop_count, unsigned thread_count)
+	{
+		// build_given_rank
+		unsigned node_count = rank.size();
 
-		// move core nodes to end
-		auto ch_order_without_core = invert_permutation(rank);
-		size_t order_size = ch_order_without_core.size();
-		ch.order.resize(order_size, order_size);
-		uint64_t min_core_node_count = must_be_core_node.count_true();
-		uint64_t shift = 0;
+		assert(thread_count != 0);
+		assert(tail.size() == head.size());
+		assert(tail.size() == weight.size());
+		assert(max_element_of(tail) < node_count);
+		assert(max_element_of(head) < node_count);
 
-		for (uint64_t i = 0; i < order_size; ++i)
-		{
-			if (must_be_core_node.is_set(ch_order_without_core[i]))
-			{
-				ch.order[order_size - min_core_node_count + shift] = ch_order_without_core[i];
-				++shift;
-			}
-			else
-			{
-				ch.order[i - shift] = ch_order_without_core[i];
-			}
-		}
+		ContractionHierarchy ch;
+		ContractionHierarchyExtraInfo ch_extra;
 
-		ch.rank = invert_permutation(ch.order);
-		std::vector<unsigned int> core(ch.order.rbegin(), ch.order.rend());
+		log_input_graph_statistics(node_count, tail, head, log_message);
 
-		std::string logfile((fs::path(export_dir) / "core_experiment.log").string());
-		std::ofstream log_out;
+		std::vector<unsigned> input_arc_id = identity_permutation(head.size());
 
-		if (log_append)
 		{
-			log_out.open(logfile, std::ios_base::app);
+			sort_arcs_and_remove_multi_and_loop_arcs(node_count, tail, head, weight, input_arc_id, log_message);
 		}
-		else
+		std::vector<unsigned int> core;
+		{
+			Graph graph(node_count, tail, head, weight);
+			if (thread_count == 1)
+				build_ch_given_rank_and_core(graph, ch, ch_extra, rank, must_be_core_node, core, rel_core_size, max_pop_count, log_message);
+			else
+				build_ch_given_rank_and_core_using_independent_node_sets(graph, ch, ch_extra, rank, must_be_core_node, core, rel_core_size, max_pop_count, thread_count, log_message);
+		}
+
 		{
-			log_out.open(logfile, std::ofstream::trunc);
-			log_out << "rel_core_size,abs_core_size,time_ms,directory" << std::endl;
+			make_internal_nodes_and_rank_coincide(ch, ch_extra, core.size(), log_message);
+			sort_ch_arcs_and_build_first_out_arrays(ch, ch_extra, log_message);
 		}
 
-		auto contraction_start = get_micro_time();
+		build_unpacking_information(node_count, tail, head, input_arc_id, ch, ch_extra, log_message);
+
+		log_contraction_hierarchy_statistics(ch, log_message);
 
 		if (log_message)
 		{
-			log_message("Starting contractions, first core size target: " + std::to_string(node_count - stop_at) + " (" + std::to_string(rel_core_size_start * 100.0) + "%)");
+			log_message("Final core ch has " + std::to_string(core.size()) + " core nodes.");
 		}
 
-		for (unsigned i = 0; i < node_count && core.size() > min_core_node_count; ++i)
+		return std::make_tuple(core, ch);
+	}
+
+	namespace
+	{
+		// One direction of a core CH in which the node IDs coincide with the ranks. The arcs of a contracted
+		// node never change. As the nodes are contracted by increasing rank, appending the arcs of every
+		// contracted node sorted by head directly yields the first_out, head and weight arrays of the
+		// contracted part. The arcs of the core nodes are only read from the graph when a core CH is saved.
+		struct CoreCHSide
 		{
-			unsigned node_being_contracted = ch.order[i];
+			std::vector<CHArcID> first_out{0};
+			std::vector<unsigned> head;
+			std::vector<unsigned> weight;
+		};
 
-			for (unsigned out_arc = 0; out_arc < graph.out_deg(node_being_contracted); ++out_arc)
+		void get_arcs_sorted_by_head_rank(
+			const Graph &graph, bool forward, unsigned x, const std::vector<unsigned> &rank,
+			std::vector<std::pair<unsigned, unsigned>> &arcs)
+		{
+			arcs.clear();
+			const unsigned deg = forward ? graph.out_deg(x) : graph.in_deg(x);
+			for (unsigned i = 0; i < deg; ++i)
 			{
-				ch_extra.forward.tail.push_back(node_being_contracted);
-
-				const auto &a = graph.out(node_being_contracted, out_arc);
-				if (ch.forward.head.size() == invalid_id)
-					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-				ch.forward.head.push_back(a.node);
-				ch.forward.weight.push_back(a.weight);
-				ch_extra.forward.mid_node.push_back(a.mid_node);
+				const auto a = forward ? graph.out(x, i) : graph.in(x, i);
+				arcs.push_back({rank[a.node], a.weight});
 			}
+			std::sort(arcs.begin(), arcs.end());
+		}
 
-			for (unsigned in_arc = 0; in_arc < graph.in_deg(node_being_contracted); ++in_arc)
+		void add_arcs_of_contracted_node(
+			const Graph &graph, bool forward, unsigned x, const std::vector<unsigned> &rank,
+			std::vector<std::pair<unsigned, unsigned>> &arcs, CoreCHSide &side)
+		{
+			get_arcs_sorted_by_head_rank(graph, forward, x, rank, arcs);
+			if (side.head.size() + arcs.size() >= invalid_ch_arc_id)
+				throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction. Define ROUTING_KIT_CH_64_BIT_ARC_ID to lift this limit.");
+			for (auto a : arcs)
 			{
-				ch_extra.backward.tail.push_back(node_being_contracted);
-
-				const auto &a = graph.in(node_being_contracted, in_arc);
-				if (ch.backward.head.size() == invalid_id)
-					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-				ch.backward.head.push_back(a.node);
-				ch.backward.weight.push_back(a.weight);
-				ch_extra.backward.mid_node.push_back(a.mid_node);
+				side.head.push_back(a.first);
+				side.weight.push_back(a.second);
 			}
+			side.first_out.push_back(side.head.size());
+		}
 
-			unsigned out_deg = graph.out_deg(node_being_contracted);
-			unsigned in_deg = graph.in_deg(node_being_contracted);
-
-			contract_node(graph, shorter_path_test, node_being_contracted);
-			core.pop_back();
-
-			if (i == stop_at)
-			{
-
-				if (log_message)
-				{
-					log_message("Saving core_ch, core size: " + std::to_string(node_count - stop_at) + " (" + std::to_string(rel_core_size_start * 100.0) + "%)");
-				}
-
-				std::string core_size_str = std::to_string(rel_core_size_start);
-				core_size_str.erase(core_size_str.find_last_not_of('0') + 1, std::string::npos);
-				core_size_str.erase(core_size_str.find_last_not_of('.') + 1, std::string::npos);
+		template <class T>
+		void write_array(std::ostream &out, const T *begin, const T *end)
+		{
+			if (begin != end)
+				out.write((const char *)begin, sizeof(T) * (end - begin));
+			if (!out)
+				throw std::runtime_error("Could not write core CH data");
+		}
 
-				log_out << std::to_string(rel_core_size_start) << "," << std::to_string(core.size()) << "," << std::to_string((get_micro_time() - contraction_start) / 1000.0) << ",core_ch_" << core_size_str << std::endl;
+		// Writes the arrays of one direction in the same format as save_vector. The contracted part is
+		// copied from memory and the core part is streamed node by node from the graph.
+		CHArcID save_core_ch_side(
+			const fs::path &dir, const CoreCHSide &side, const Graph &graph, bool forward,
+			const std::vector<unsigned> &order, const std::vector<unsigned> &rank)
+		{
+			fs::create_directories(dir);
 
-				core.shrink_to_fit();
+			std::ofstream first_out_file((dir / "first_out").string(), std::ios::binary);
+			std::ofstream head_file((dir / "head").string(), std::ios::binary);
+			std::ofstream travel_time_file((dir / "travel_time").string(), std::ios::binary);
+			if (!first_out_file || !head_file || !travel_time_file)
+				throw std::runtime_error("Can not open the core CH files in \"" + dir.string() + "\" for writing.");
 
-				auto time_before_saving = get_micro_time();
+			write_array(first_out_file, side.first_out.data(), side.first_out.data() + side.first_out.size());
+			write_array(head_file, side.head.data(), side.head.data() + side.head.size());
+			write_array(travel_time_file, side.weight.data(), side.weight.data() + side.weight.size());
 
-				// save core ch
-				if (save_core_ch)
+			CHArcID arc_count = side.first_out.back();
+			std::vector<std::pair<unsigned, unsigned>> arcs;
+			for (unsigned r = side.first_out.size() - 1; r < order.size(); ++r)
+			{
+				get_arcs_sorted_by_head_rank(graph, forward, order[r], rank, arcs);
+				for (auto a : arcs)
 				{
-					ContractionHierarchy core_ch(ch);
-					ContractionHierarchyExtraInfo core_ch_extra(ch_extra);
-					Graph out_graph(graph);
-					std::vector<unsigned int> out_core(core.rbegin(), core.rend());
-
-					for (unsigned i_2 = stop_at + 1; i_2 < node_count; ++i_2)
-					{
-						unsigned node_being_contracted = core_ch.order[i_2];
-
-						for (unsigned out_arc = 0; out_arc < out_graph.out_deg(node_being_contracted); ++out_arc)
-						{
-							core_ch_extra.forward.tail.push_back(node_being_contracted);
-
-							const auto &a = out_graph.out(node_being_contracted, out_arc);
-							if (core_ch.forward.head.size() == invalid_id)
-								throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-							core_ch.forward.head.push_back(a.node);
-							core_ch.forward.weight.push_back(a.weight);
-							core_ch_extra.forward.mid_node.push_back(a.mid_node);
-						}
-
-						for (unsigned in_arc = 0; in_arc < out_graph.in_deg(node_being_contracted); ++in_arc)
-						{
-							core_ch_extra.backward.tail.push_back(node_being_contracted);
-
-							const auto &a = out_graph.in(node_being_contracted, in_arc);
-							if (core_ch.backward.head.size() == invalid_id)
-								throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-							core_ch.backward.head.push_back(a.node);
-							core_ch.backward.weight.push_back(a.weight);
-							core_ch_extra.backward.mid_node.push_back(a.mid_node);
-						}
-					}
-
-					make_internal_nodes_and_rank_coincide(core_ch, core_ch_extra, log_message);
-					sort_ch_arcs_and_build_first_out_arrays(core_ch, core_ch_extra, log_message);
-
-					build_unpacking_information(node_count, tail, head, input_arc_id, core_ch, core_ch_extra, log_message);
-
-					log_contraction_hierarchy_statistics(core_ch, log_message);
-
-					const fs::path core_ch_dir = fs::path(export_dir) / ("core_ch_" + core_size_str);
-					std::string core_ch_node_order_file = core_ch_dir / "order";
-					std::string core_ch_node_rank_file = core_ch_dir / "rank";
-					std::string core_ch_core_file = core_ch_dir / "core";
-
-					const fs::path core_ch_fw_graph_dir = core_ch_dir / "forward";
-					const fs::path core_ch_bw_graph_dir = core_ch_dir / "backward";
-					const std::string core_ch_fw_first_out_file = core_ch_fw_graph_dir / "first_out";
-					const std::string core_ch_fw_head_file = core_ch_fw_graph_dir / "head";
-					const std::string core_ch_fw_travel_time_file = core_ch_fw_graph_dir / "travel_time";
-					const std::string core_ch_bw_first_out_file = core_ch_bw_graph_dir / "first_out";
-					const std::string core_ch_bw_head_file = core_ch_bw_graph_dir / "head";
-					const std::string core_ch_bw_travel_time_file = core_ch_bw_graph_dir / "travel_time";
+					write_value(head_file, a.first);
+					write_value(travel_time_file, a.second);
+				}
+				arc_count += arcs.size();
+				write_value(first_out_file, arc_count);
+			}
+			return arc_count;
+		}
 
-					if (!fs::is_directory(core_ch_dir) || !fs::exists(core_ch_dir))
-					{
-						fs::create_directory(core_ch_dir);
-					}
+		void save_core_ch(
+			const fs::path &dir, const CoreCHSide &forward, const CoreCHSide &backward, const Graph &graph,
+			const std::vector<unsigned> &order, const std::vector<unsigned> &rank,
+			const std::function<void(std::string)> &log_message)
+		{
+			const unsigned contracted_node_count = forward.first_out.size() - 1;
+			assert(backward.first_out.size() - 1 == contracted_node_count);
 
-					if (!fs::is_directory(core_ch_fw_graph_dir) || !fs::exists(core_ch_fw_graph_dir))
-					{
-						fs::create_directory(core_ch_fw_graph_dir);
-					}
+			fs::create_directories(dir);
+			open_file_for_saving((dir / "order").string(), [&](std::ostream &out)
+								 { write_array(out, order.data(), order.data() + order.size()); });
+			open_file_for_saving((dir / "rank").string(), [&](std::ostream &out)
+								 { write_array(out, rank.data(), rank.data() + rank.size()); });
+			open_file_for_saving((dir / "core").string(), [&](std::ostream &out)
+								 { write_array(out, order.data() + contracted_node_count, order.data() + order.size()); });
 
-					if (!fs::is_directory(core_ch_bw_graph_dir) || !fs::exists(core_ch_bw_graph_dir))
-					{
-						fs::create_directory(core_ch_bw_graph_dir);
-					}
+			CHArcID forward_arc_count = save_core_ch_side(dir / "forward", forward, graph, true, order, rank);
+			CHArcID backward_arc_count = save_core_ch_side(dir / "backward", backward, graph, false, order, rank);
 
-					if (!core_ch_node_order_file.empty())
-						save_vector(core_ch_node_order_file, core_ch.order);
+			if (log_message)
+				log_message("Saved core CH with " + std::to_string(order.size() - contracted_node_count) + " core nodes, " + std::to_string(forward_arc_count) + " forward arcs and " + std::to_string(backward_arc_count) + " backward arcs to " + dir.string() + ".");
+		}
 
-					if (!core_ch_node_rank_file.empty())
-						save_vector(core_ch_node_rank_file, core_ch.rank);
+		std::string get_core_ch_dir_name(double rel_core_size)
+		{
+			std::string core_size_str = std::to_string(rel_core_size);
+			core_size_str.erase(core_size_str.find_last_not_of('0') + 1, std::string::npos);
+			core_size_str.erase(core_size_str.find_last_not_of('.') + 1, std::string::npos);
+			return "core_ch_" + core_size_str;
+		}
 
-					if (!core_ch_core_file.empty())
-						save_vector(core_ch_core_file, out_core);
+		// Contracts the nodes by the given rank, except for the core nodes, which are moved to the end of the
+		// order. Whenever the remaining core has one of the relative sizes in rel_core_sizes, the current core CH
+		// is written to export_dir/core_ch_<rel_core_size>. The core CH consisting only of the core nodes is
+		// written to export_dir/core_ch. Only the arcs of the contracted nodes are kept in memory in addition
+		// to the graph. If experiment_log is set, the contraction times are written to it.
+		void build_ch_save_intervals(
+			Graph &graph,
+			const std::vector<unsigned> &rank_with_core,
+			BitVector const &must_be_core_node,
+			const std::string &export_dir,
+			std::vector<double> rel_core_sizes,
+			unsigned max_pop_count,
+			const std::function<void(std::string)> &log_message,
+			std::ostream *experiment_log = nullptr,
+			bool save_core_ch_files = true)
+		{
+			const unsigned node_count = graph.node_count();
 
-					if (!core_ch_fw_first_out_file.empty())
-						save_vector(core_ch_fw_first_out_file, core_ch.forward.first_out);
-					if (!core_ch_fw_head_file.empty())
-						save_vector(core_ch_fw_head_file, core_ch.forward.head);
-					if (!core_ch_fw_travel_time_file.empty())
-						save_vector(core_ch_fw_travel_time_file, core_ch.forward.weight);
+			long long timer = 0;				 // initialize to avoid warning, not needed
+			long long last_log_message_time = 0; // initialize to avoid warning, not needed
+			if (log_message)
+			{
+				last_log_message_time = get_micro_time();
+				timer = -last_log_message_time;
+				log_message("Start building contraction hierarchy with given rank and core size.");
+			}
 
-					if (!core_ch_bw_first_out_file.empty())
-						save_vector(core_ch_bw_first_out_file, core_ch.backward.first_out);
-					if (!core_ch_bw_head_file.empty())
-						save_vector(core_ch_bw_head_file, core_ch.backward.head);
-					if (!core_ch_bw_travel_time_file.empty())
-						save_vector(core_ch_bw_travel_time_file, core_ch.backward.weight);
-				}
+			ShorterPathTest shorter_path_test(graph, max_pop_count);
 
-				rel_core_size_start *= step_factor;
-				stop_at = (1.0 - rel_core_size_start) * node_count;
+			// move core nodes to end
+			auto order_without_core = invert_permutation(rank_with_core);
+			std::vector<unsigned> order(node_count);
+			const unsigned min_core_node_count = must_be_core_node.count_true();
+			unsigned shift = 0;
 
-				if (log_message)
+			for (unsigned i = 0; i < node_count; ++i)
+			{
+				if (must_be_core_node.is_set(order_without_core[i]))
 				{
-					log_message("Next core size: " + std::to_string(node_count - stop_at) + " (" + std::to_string(rel_core_size_start * 100.0) + "%)");
+					order[node_count - min_core_node_count + shift] = order_without_core[i];
+					++shift;
 				}
-
-				contraction_start += get_micro_time() - time_before_saving;
-			}
-
-			if (log_message)
-			{
-				long long current_time = get_micro_time();
-				if (current_time - last_log_message_time > 1000000)
+				else
 				{
-					last_log_message_time = current_time;
-					log_message("Contracted " + std::to_string(i + 1) + " of " + std::to_string(node_count) + ". The in degree of last node was " + std::to_string(in_deg) + " and out degree was " + std::to_string(out_deg) + ". Running for " + std::to_string(timer + current_time) + "musec.");
+					order[i - shift] = order_without_core[i];
 				}
 			}
-		}
-
-		log_out << std::to_string(rel_core_size_start) << "," << std::to_string(core.size()) << "," << std::to_string((get_micro_time() - contraction_start) / 1000.0) << ",core_ch" << std::endl;
-		log_out.close();
+			order_without_core = std::vector<unsigned>();
 
-		ch.forward.head.shrink_to_fit();
-		ch.forward.weight.shrink_to_fit();
-		ch_extra.forward.mid_node.shrink_to_fit();
-		ch_extra.forward.tail.shrink_to_fit();
+			const std::vector<unsigned> rank = invert_permutation(order);
 
-		ch.backward.head.shrink_to_fit();
-		ch.backward.weight.shrink_to_fit();
-		ch_extra.backward.mid_node.shrink_to_fit();
-		ch_extra.backward.tail.shrink_to_fit();
+			std::sort(rel_core_sizes.begin(), rel_core_sizes.end(), std::greater<double>());
+			unsigned next_core_size = 0;
+			auto get_stop_at = [&](double rel_core_size)
+			{
+				return (unsigned)((1.0 - rel_core_size) * node_count);
+			};
 
-		if (log_message)
-		{
-			timer += get_micro_time();
-			log_message("Finished contracting nodes. Needed " + std::to_string(timer) + "musec.");
-		}
+			const unsigned contracted_node_count = node_count - min_core_node_count;
 
-		core.shrink_to_fit();
+			// Reject core sizes that can not be reached before any work is done, as they would otherwise be
+			// skipped silently.
+			for (double rel_core_size : rel_core_sizes)
+			{
+				if (!(0.0 <= rel_core_size && rel_core_size <= 1.0))
+					throw std::runtime_error("The relative core size " + std::to_string(rel_core_size) + " is not between 0 and 1.");
+				if (get_stop_at(rel_core_size) >= contracted_node_count)
+					throw std::runtime_error("The relative core size " + std::to_string(rel_core_size) + " is smaller than the " + std::to_string(min_core_node_count) + " of " + std::to_string(node_count) + " nodes that must be in the core.");
+			}
 
-		if (log_message)
-		{
-			log_message("Saving final core_ch, core size: " + std::to_string(core.size()) + " (" + std::to_string((double)core.size() / (double)node_count) + "%)");
-		}
+			CoreCHSide forward, backward;
+			std::vector<std::pair<unsigned, unsigned>> arcs;
 
-		for (unsigned i_2 = stop_at + 1; i_2 < node_count; ++i_2)
-		{
-			unsigned node_being_contracted = ch.order[i_2];
+			auto contraction_start = get_micro_time();
 
-			for (unsigned out_arc = 0; out_arc < graph.out_deg(node_being_contracted); ++out_arc)
+			for (unsigned i = 0; i < contracted_node_count; ++i)
 			{
-				ch_extra.forward.tail.push_back(node_being_contracted);
+				unsigned node_being_contracted = order[i];
 
-				const auto &a = graph.out(node_being_contracted, out_arc);
-				if (ch.forward.head.size() == invalid_id)
-					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-				ch.forward.head.push_back(a.node);
-				ch.forward.weight.push_back(a.weight);
-				ch_extra.forward.mid_node.push_back(a.mid_node);
-			}
+				if (save_core_ch_files)
+				{
+					add_arcs_of_contracted_node(graph, true, node_being_contracted, rank, arcs, forward);
+					add_arcs_of_contracted_node(graph, false, node_being_contracted, rank, arcs, backward);
+				}
 
-			for (unsigned in_arc = 0; in_arc < graph.in_deg(node_being_contracted); ++in_arc)
-			{
-				ch_extra.backward.tail.push_back(node_being_contracted);
+				unsigned out_deg = graph.out_deg(node_being_contracted);
+				unsigned in_deg = graph.in_deg(node_being_contracted);
 
-				const auto &a = graph.in(node_being_contracted, in_arc);
-				if (ch.backward.head.size() == invalid_id)
-					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-				ch.backward.head.push_back(a.node);
-				ch.backward.weight.push_back(a.weight);
-				ch_extra.backward.mid_node.push_back(a.mid_node);
-			}
-		}
+				contract_node(graph, shorter_path_test, node_being_contracted);
 
-		// save core ch
-		if (save_core_ch)
-		{
-			std::reverse(core.begin(), core.end());
-			make_internal_nodes_and_rank_coincide(ch, ch_extra, log_message);
-			sort_ch_arcs_and_build_first_out_arrays(ch, ch_extra, log_message);
+				while (next_core_size < rel_core_sizes.size() && get_stop_at(rel_core_sizes[next_core_size]) <= i)
+				{
+					double rel_core_size = rel_core_sizes[next_core_size++];
+					if (get_stop_at(rel_core_size) != i)
+						continue;
 
-			build_unpacking_information(node_count, tail, head, input_arc_id, ch, ch_extra, log_message);
+					const std::string dir_name = get_core_ch_dir_name(rel_core_size);
 
-			log_contraction_hierarchy_statistics(ch, log_message);
+					if (experiment_log)
+						*experiment_log << std::to_string(rel_core_size) << "," << std::to_string(node_count - i - 1) << "," << std::to_string((get_micro_time() - contraction_start) / 1000.0) << "," << dir_name << std::endl;
 
-			const fs::path core_ch_dir = fs::path(export_dir) / "core_ch";
-			std::string core_ch_node_order_file = core_ch_dir / "order";
-			std::string core_ch_node_rank_file = core_ch_dir / "rank";
-			std::string core_ch_core_file = core_ch_dir / "core";
+					auto time_before_saving = get_micro_time();
 
-			const fs::path core_ch_fw_graph_dir = core_ch_dir / "forward";
-			const fs::path core_ch_bw_graph_dir = core_ch_dir / "backward";
-			const std::string core_ch_fw_first_out_file = core_ch_fw_graph_dir / "first_out";
-			const std::string core_ch_fw_head_file = core_ch_fw_graph_dir / "head";
-			const std::string core_ch_fw_travel_time_file = core_ch_fw_graph_dir / "travel_time";
-			const std::string core_ch_bw_first_out_file = core_ch_bw_graph_dir / "first_out";
-			const std::string core_ch_bw_head_file = core_ch_bw_graph_dir / "head";
-			const std::string core_ch_bw_travel_time_file = core_ch_bw_graph_dir / "travel_time";
+					if (save_core_ch_files)
+						save_core_ch(fs::path(export_dir) / dir_name, forward, backward, graph, order, rank, log_message);
 
-			if (!fs::is_directory(core_ch_dir) || !fs::exists(core_ch_dir))
-			{
-				fs::create_directory(core_ch_dir);
-			}
+					contraction_start += get_micro_time() - time_before_saving;
+				}
 
-			if (!fs::is_directory(core_ch_fw_graph_dir) || !fs::exists(core_ch_fw_graph_dir))
-			{
-				fs::create_directory(core_ch_fw_graph_dir);
+				if (log_message)
+				{
+					long long current_time = get_micro_time();
+					if (current_time - last_log_message_time > 1000000)
+					{
+						last_log_message_time = current_time;
+						log_message("Contracted " + std::to_string(i + 1) + " of " + std::to_string(node_count) + ". The in degree of last node was " + std::to_string(in_deg) + " and out degree was " + std::to_string(out_deg) + ". Running for " + std::to_string(timer + current_time) + "musec.");
+					}
+				}
 			}
 
-			if (!fs::is_directory(core_ch_bw_graph_dir) || !fs::exists(core_ch_bw_graph_dir))
+			if (experiment_log)
+				*experiment_log << std::to_string((double)min_core_node_count / node_count) << "," << std::to_string(min_core_node_count) << "," << std::to_string((get_micro_time() - contraction_start) / 1000.0) << ",core_ch" << std::endl;
+
+			if (log_message)
 			{
-				fs::create_directory(core_ch_bw_graph_dir);
+				timer += get_micro_time();
+				log_message("Finished contracting nodes. Needed " + std::to_string(timer) + "musec.");
 			}
 
-			if (!core_ch_node_order_file.empty())
-				save_vector(core_ch_node_order_file, ch.order);
+			if (save_core_ch_files)
+				save_core_ch(fs::path(export_dir) / "core_ch", forward, backward, graph, order, rank, log_message);
+		}
+	}
+
+	void ContractionHierarchy::build_and_save_core_contraction_hierarchies(
+		std::vector<unsigned> rank_with_core, BitVector const &is_core_node, std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
+		const std::string &export_dir, std::vector<double> rel_core_sizes,
+		const std::function<void(std::string)> &log_message, unsigned max_pop_count)
+	{
+		unsigned node_count = rank_with_core.size();
 
-			if (!core_ch_node_rank_file.empty())
-				save_vector(core_ch_node_rank_file, ch.rank);
+		assert(tail.size() == head.size());
+		assert(tail.size() == weight.size());
+		assert(max_element_of(tail) < node_count);
+		assert(max_element_of(head) < node_count);
+		assert(is_core_node.size() == node_count);
 
-			if (!core_ch_core_file.empty())
-				save_vector(core_ch_core_file, core);
+		log_input_graph_statistics(node_count, tail, head, log_message);
 
-			if (!core_ch_fw_first_out_file.empty())
-				save_vector(core_ch_fw_first_out_file, ch.forward.first_out);
-			if (!core_ch_fw_head_file.empty())
-				save_vector(core_ch_fw_head_file, ch.forward.head);
-			if (!core_ch_fw_travel_time_file.empty())
-				save_vector(core_ch_fw_travel_time_file, ch.forward.weight);
+		std::vector<unsigned> input_arc_id = identity_permutation(head.size());
+		sort_arcs_and_remove_multi_and_loop_arcs(node_count, tail, head, weight, input_arc_id, log_message);
 
-			if (!core_ch_bw_first_out_file.empty())
-				save_vector(core_ch_bw_first_out_file, ch.backward.first_out);
-			if (!core_ch_bw_head_file.empty())
-				save_vector(core_ch_bw_head_file, ch.backward.head);
-			if (!core_ch_bw_travel_time_file.empty())
-				save_vector(core_ch_bw_travel_time_file, ch.backward.weight);
-		}
+		Graph graph(node_count, tail, head, weight);
+		build_ch_save_intervals(graph, rank_with_core, is_core_node, export_dir, std::move(rel_core_sizes), max_pop_count, log_message);
 	}
 
 	void ContractionHierarchy::core_experiment(
@@ -1821,9 +2706,6 @@ namespace RoutingKit
 		assert(max_element_of(tail) < node_count);
 		assert(max_element_of(head) < node_count);
 
-		ContractionHierarchy ch;
-		ContractionHierarchyExtraInfo ch_extra;
-
 		log_input_graph_statistics(node_count, tail, head, log_message);
 
 		std::vector<unsigned> input_arc_id = identity_permutation(head.size());
@@ -1832,6 +2714,27 @@ namespace RoutingKit
 			sort_arcs_and_remove_multi_and_loop_arcs(node_count, tail, head, weight, input_arc_id, log_message);
 		}
 
+		// The core sizes are rel_core_size_start, rel_core_size_start*step_factor, ... as long as they can be
+		// reached before only the nodes that must be in the core remain.
+		std::vector<double> rel_core_sizes;
+		{
+			const unsigned contracted_node_count = node_count - must_be_core_node.count_true();
+			double rel_core_size = rel_core_size_start;
+			for (;;)
+			{
+				unsigned stop_at = (1.0 - rel_core_size) * node_count;
+				if (stop_at >= contracted_node_count)
+					break;
+				rel_core_sizes.push_back(rel_core_size);
+				rel_core_size *= step_factor;
+				if ((unsigned)((1.0 - rel_core_size) * node_count) <= stop_at)
+					break;
+			}
+		}
+
+		std::ofstream experiment_log((fs::path(export_dir) / "core_experiment.log").string(), std::ofstream::trunc);
+		experiment_log << "rel_core_size,abs_core_size,time_ms,directory" << std::endl;
+
 		Graph graph(node_count, tail, head, weight);
 
 		for (unsigned i = 1; i <= n; ++i)
@@ -1844,8 +2747,7 @@ namespace RoutingKit
 
 			{
 				Graph current_graph(graph);
-				build_ch_save_intervals(current_graph, tail, head, input_arc_id, ch, ch_extra, rank, must_be_core_node, export_dir, rel_core_size_start,
-										step_factor, max_pop_count, log_message, i > 1, i == 1);
+				build_ch_save_intervals(current_graph, rank, must_be_core_node, export_dir, rel_core_sizes, max_pop_count, log_message, &experiment_log, i == 1);
 			}
 		}
 	}
@@ -1853,10 +2755,11 @@ namespace RoutingKit
 	ContractionHierarchy ContractionHierarchy::build_given_rank(
 		std::vector<unsigned> rank,
 		std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
-		const std::function<void(std::string)> &log_message, unsigned max_pop_count)
+		const std::function<void(std::string)> &log_message, unsigned max_pop_count, unsigned thread_count)
 	{
 		unsigned node_count = rank.size();
 
+		assert(thread_count != 0);
 		assert(tail.size() == head.size());
 		assert(tail.size() == weight.size());
 		assert(max_element_of(tail) < node_count);
@@ -1875,11 +2778,14 @@ namespace RoutingKit
 
 		{
 			Graph graph(node_count, tail, head, weight);
-			build_ch_given_rank(graph, ch, ch_extra, rank, max_pop_count, log_message);
+			if (thread_count == 1)
+				build_ch_given_rank(graph, ch, ch_extra, rank, max_pop_count, log_message);
+			else
+				build_ch_given_rank_using_independent_node_sets(graph, ch, ch_extra, rank, max_pop_count, thread_count, log_message);
 		}
 
 		{
-			make_internal_nodes_and_rank_coincide(ch, ch_extra, log_message);
+			make_internal_nodes_and_rank_coincide(ch, ch_extra, 0, log_message);
 			sort_ch_arcs_and_build_first_out_arrays(ch, ch_extra, log_message);
 		}
 
@@ -1893,9 +2799,9 @@ namespace RoutingKit
 	ContractionHierarchy ContractionHierarchy::build_given_order(
 		std::vector<unsigned> order,
 		std::vector<unsigned> tail, std::vector<unsigned> head, std::vector<unsigned> weight,
-		const std::function<void(std::string)> &log_message, unsigned max_pop_count)
+		const std::function<void(std::string)> &log_message, unsigned max_pop_count, unsigned thread_count)
 	{
-		return build_given_rank(invert_permutation(order), tail, head, weight, log_message, max_pop_count);
+		return build_given_rank(invert_permutation(order), tail, head, weight, log_message, max_pop_count, thread_count);
 	}
 
 	void check_contraction_hierarchy_for_errors(const ContractionHierarchy &ch)
@@ -1910,7 +2816,12 @@ namespace RoutingKit
 		if (ch.backward.first_out.size() != node_count + 1)
 			throw std::runtime_error("CH is invalid because: ch.backward.first_out.size() != node_count+1");
 
-		unsigned forward_arc_count = ch.forward.first_out.back();
+		CHArcID forward_arc_count = ch.forward.first_out.back();
+		CHArcID backward_arc_count = ch.backward.first_out.back();
+
+		bool has_path_data = ch.has_path_data();
+		CHArcID path_data_forward_arc_count = has_path_data ? forward_arc_count : 0;
+		CHArcID path_data_backward_arc_count = has_path_data ? backward_arc_count : 0;
 
 		if (ch.forward.first_out.front() != 0)
 			throw std::runtime_error("CH is invalid because: ch.forward.first_out.front() != 0");
@@ -1920,17 +2831,15 @@ namespace RoutingKit
 			throw std::runtime_error("CH is invalid because: ch.forward.head.size() != forward_arc_count");
 		if (ch.forward.weight.size() != forward_arc_count)
 			throw std::runtime_error("CH is invalid because: ch.forward.weight.size() != forward_arc_count");
-		if (ch.forward.shortcut_first_arc.size() != forward_arc_count)
-			throw std::runtime_error("CH is invalid because: ch.forward.shortcut_first_arc.size() != forward_arc_count");
-		if (ch.forward.shortcut_second_arc.size() != forward_arc_count)
-			throw std::runtime_error("CH is invalid because: ch.forward.shortcut_second_arc.size() != forward_arc_count");
-		if (ch.forward.is_shortcut_an_original_arc.size() != forward_arc_count)
-			throw std::runtime_error("CH is invalid because: ch.forward.is_shortcut_an_original_arc.size() != forward_arc_count");
+		if (ch.forward.shortcut_first_arc.size() != path_data_forward_arc_count)
+			throw std::runtime_error("CH is invalid because: ch.forward.shortcut_first_arc.size() != forward_arc_count and the CH has path data");
+		if (ch.forward.shortcut_second_arc.size() != path_data_forward_arc_count)
+			throw std::runtime_error("CH is invalid because: ch.forward.shortcut_second_arc.size() != forward_arc_count and the CH has path data");
+		if (ch.forward.is_shortcut_an_original_arc.size() != path_data_forward_arc_count)
+			throw std::runtime_error("CH is invalid because: ch.forward.is_shortcut_an_original_arc.size() != forward_arc_count and the CH has path data");
 		if (!ch.forward.head.empty() && max_element_of(ch.forward.head) >= node_count)
 			throw std::runtime_error("CH is invalid because: !ch.forward.head.empty() && max_element_of(ch.forward.head) >= node_count");
 
-		unsigned backward_arc_count = ch.backward.first_out.back();
-
 		if (ch.backward.first_out.front() != 0)
 			throw std::runtime_error("CH is invalid because: ch.backward.first_out.front() != 0");
 		if (!is_sorted_using_less(ch.backward.first_out))
@@ -1939,24 +2848,24 @@ namespace RoutingKit
 			throw std::runtime_error("CH is invalid because: ch.backward.head.size() != backward_arc_count");
 		if (ch.backward.weight.size() != backward_arc_count)
 			throw std::runtime_error("CH is invalid because: ch.backward.weight.size() != backward_arc_count");
-		if (ch.backward.shortcut_first_arc.size() != backward_arc_count)
-			throw std::runtime_error("CH is invalid because: ch.backward.shortcut_first_arc.size() != backward_arc_count");
-		if (ch.backward.shortcut_second_arc.size() != backward_arc_count)
-			throw std::runtime_error("CH is invalid because: ch.backward.shortcut_second_arc.size() != backward_arc_count");
-		if (ch.backward.is_shortcut_an_original_arc.size() != backward_arc_count)
-			throw std::runtime_error("CH is invalid because: ch.backward.is_shortcut_an_original_arc.size() != backward_arc_count");
+		if (ch.backward.shortcut_first_arc.size() != path_data_backward_arc_count)
+			throw std::runtime_error("CH is invalid because: ch.backward.shortcut_first_arc.size() != backward_arc_count and the CH has path data");
+		if (ch.backward.shortcut_second_arc.size() != path_data_backward_arc_count)
+			throw std::runtime_error("CH is invalid because: ch.backward.shortcut_second_arc.size() != backward_arc_count and the CH has path data");
+		if (ch.backward.is_shortcut_an_original_arc.size() != path_data_backward_arc_count)
+			throw std::runtime_error("CH is invalid because: ch.backward.is_shortcut_an_original_arc.size() != backward_arc_count and the CH has path data");
 		if (!ch.backward.head.empty() && max_element_of(ch.backward.head) >= node_count)
 			throw std::runtime_error("CH is invalid because: !ch.backward.head.empty() && max_element_of(ch.backward.head) >= node_count");
 
 		for (unsigned x = 0; x < node_count; ++x)
 		{
-			for (unsigned xy = ch.forward.first_out[x]; xy < ch.forward.first_out[x + 1]; ++xy)
+			for (CHArcID xy = ch.forward.first_out[x]; xy < ch.forward.first_out[x + 1]; ++xy)
 			{
 				unsigned y = ch.forward.head[xy];
 				if (y <= x)
 					throw std::runtime_error("CH is invalid because: forward graph contains downward arc " + std::to_string(x) + " -> " + std::to_string(y));
 			}
-			for (unsigned xy = ch.backward.first_out[x]; xy < ch.backward.first_out[x + 1]; ++xy)
+			for (CHArcID xy = ch.backward.first_out[x]; xy < ch.backward.first_out[x + 1]; ++xy)
 			{
 				unsigned y = ch.backward.head[xy];
 				if (y <= x)
@@ -1964,7 +2873,10 @@ namespace RoutingKit
 			}
 		}
 
-		for (unsigned xy = 0; xy < forward_arc_count; ++xy)
+		if (!has_path_data)
+			return;
+
+		for (CHArcID xy = 0; xy < forward_arc_count; ++xy)
 		{
 			if (!ch.forward.is_shortcut_an_original_arc.is_set(xy))
 			{
@@ -1986,7 +2898,7 @@ namespace RoutingKit
 			}
 		}
 
-		for (unsigned xy = 0; xy < backward_arc_count; ++xy)
+		for (CHArcID xy = 0; xy < backward_arc_count; ++xy)
 		{
 			if (!ch.backward.is_shortcut_an_original_arc.is_set(xy))
 			{
@@ -2012,14 +2924,51 @@ namespace RoutingKit
 	namespace
 	{
 		const unsigned long long ch_magic_number = 0x436f6e7448696572ull;
+		const unsigned long long ch_64_bit_arc_id_magic_number = 0x436f6e7448696536ull;
+		const unsigned long long ch_distance_only_magic_number = 0x436f6e7448696564ull;
+		const unsigned long long ch_64_bit_arc_id_distance_only_magic_number = 0x436f6e7448696544ull;
+
+#ifdef ROUTING_KIT_CH_64_BIT_ARC_ID
+		const unsigned long long ch_arc_id_magic_number = ch_64_bit_arc_id_magic_number;
+		const unsigned long long ch_other_arc_id_magic_number = ch_magic_number;
+		const unsigned long long ch_arc_id_distance_only_magic_number = ch_64_bit_arc_id_distance_only_magic_number;
+		const unsigned long long ch_other_arc_id_distance_only_magic_number = ch_distance_only_magic_number;
+#else
+		const unsigned long long ch_arc_id_magic_number = ch_magic_number;
+		const unsigned long long ch_other_arc_id_magic_number = ch_64_bit_arc_id_magic_number;
+		const unsigned long long ch_arc_id_distance_only_magic_number = ch_distance_only_magic_number;
+		const unsigned long long ch_other_arc_id_distance_only_magic_number = ch_64_bit_arc_id_distance_only_magic_number;
+#endif
 
+		// With 32 bit arc IDs the layout is the same as the one of files
+		// written before the arc ID width became selectable. The padding the
+		// compiler would insert is an explicit member, so that saved files
+		// contain no uninitialized bytes.
 		struct CHFileHeader
 		{
 			unsigned long long magic_number;
 			unsigned node_count;
-			unsigned forward_arc_count;
-			unsigned backward_arc_count;
+#ifdef ROUTING_KIT_CH_64_BIT_ARC_ID
+			unsigned padding;
+#endif
+			CHArcID forward_arc_count;
+			CHArcID backward_arc_count;
+#ifndef ROUTING_KIT_CH_64_BIT_ARC_ID
+			unsigned padding;
+#endif
 		};
+		static_assert(sizeof(CHFileHeader) == 2 * sizeof(unsigned long long) + 2 * sizeof(CHArcID), "CHFileHeader must not contain implicit padding");
+
+		// Every array in a CH file starts at a multiple of its element size, so
+		// that the file can be memory mapped. The header size is a multiple of
+		// sizeof(CHArcID), and all arrays after the ranks come in pairs of unsigned
+		// arrays of the same length, as bit vectors or as CHArcID arrays. Only the
+		// ranks are therefore followed by padding. With 32 bit arc IDs there is no
+		// padding and the layout is unchanged.
+		unsigned long long get_rank_padding_byte_count(unsigned node_count)
+		{
+			return (sizeof(CHArcID) - sizeof(unsigned) * (unsigned long long)node_count % sizeof(CHArcID)) % sizeof(CHArcID);
+		}
 	}
 
 	ContractionHierarchy ContractionHierarchy::read(std::istream &in)
@@ -2067,33 +3016,87 @@ namespace RoutingKit
 							 { write(out); });
 	}
 
+	void ContractionHierarchy::write_distance_only(std::ostream &out) const
+	{
+		write_distance_only(
+			[&](const char *p, unsigned long long l)
+			{
+				if (!out.write(p, l))
+					throw std::runtime_error("std::ostream::write failed while writing a contraction hierarchy");
+			});
+	}
+
+	void ContractionHierarchy::save_distance_only_file(const std::string &file_name) const
+	{
+		open_file_for_saving(file_name, [&](std::ostream &out)
+							 { write_distance_only(out); });
+	}
+
 	namespace
 	{
-		void check_header(CHFileHeader header)
+		// Returns whether the file contains path data.
+		bool check_header(CHFileHeader header)
 		{
-			if (header.magic_number != ch_magic_number)
+			if (header.magic_number == ch_other_arc_id_magic_number || header.magic_number == ch_other_arc_id_distance_only_magic_number)
+			{
+#ifdef ROUTING_KIT_CH_64_BIT_ARC_ID
+				throw std::runtime_error("CH file uses 32 bit arc IDs but RoutingKit was compiled with ROUTING_KIT_CH_64_BIT_ARC_ID.");
+#else
+				throw std::runtime_error("CH file uses 64 bit arc IDs. Compile RoutingKit with ROUTING_KIT_CH_64_BIT_ARC_ID to read it.");
+#endif
+			}
+			if (header.magic_number == ch_arc_id_distance_only_magic_number)
+				return false;
+			if (header.magic_number != ch_arc_id_magic_number)
 				throw std::runtime_error("CH file magic number broken. Is this really a CH file?");
+			return true;
+		}
+
+		unsigned long long get_expected_file_size(CHFileHeader header, bool has_path_data)
+		{
+			unsigned long long file_size =
+				sizeof(CHFileHeader) +
+				sizeof(unsigned) * (header.node_count + 2 * (unsigned long long)header.forward_arc_count + 2 * (unsigned long long)header.backward_arc_count) +
+				get_rank_padding_byte_count(header.node_count) +
+				sizeof(CHArcID) * (2 * ((unsigned long long)header.node_count + 1));
+			if (has_path_data)
+				file_size +=
+					sizeof(CHArcID) * (2 * (unsigned long long)header.forward_arc_count + 2 * (unsigned long long)header.backward_arc_count) +
+					((header.backward_arc_count + 511) / 512) * 64 + ((header.forward_arc_count + 511) / 512) * 64;
+			return file_size;
 		}
 
-		ContractionHierarchy finish_read(std::function<void(char *, unsigned long long)> in, CHFileHeader header)
+		ContractionHierarchy finish_read(std::function<void(char *, unsigned long long)> in, CHFileHeader header, bool has_path_data)
 		{
 			ContractionHierarchy ch;
 			ch.rank = read_vector<unsigned>(in, header.node_count);
 			ch.order = invert_permutation(ch.rank);
+			{
+				char padding[sizeof(CHArcID)];
+				unsigned long long padding_byte_count = get_rank_padding_byte_count(header.node_count);
+				if (padding_byte_count != 0)
+					in(padding, padding_byte_count);
+			}
 
-			ch.forward.first_out = read_vector<unsigned>(in, header.node_count + 1);
+			ch.forward.first_out = read_vector<CHArcID>(in, header.node_count + 1);
 			ch.forward.head = read_vector<unsigned>(in, header.forward_arc_count);
 			ch.forward.weight = read_vector<unsigned>(in, header.forward_arc_count);
-			ch.forward.is_shortcut_an_original_arc = read_bit_vector(in, header.forward_arc_count);
-			ch.forward.shortcut_first_arc = read_vector<unsigned>(in, header.forward_arc_count);
-			ch.forward.shortcut_second_arc = read_vector<unsigned>(in, header.forward_arc_count);
+			if (has_path_data)
+			{
+				ch.forward.is_shortcut_an_original_arc = read_bit_vector(in, header.forward_arc_count);
+				ch.forward.shortcut_first_arc = read_vector<CHArcID>(in, header.forward_arc_count);
+				ch.forward.shortcut_second_arc = read_vector<CHArcID>(in, header.forward_arc_count);
+			}
 
-			ch.backward.first_out = read_vector<unsigned>(in, header.node_count + 1);
+			ch.backward.first_out = read_vector<CHArcID>(in, header.node_count + 1);
 			ch.backward.head = read_vector<unsigned>(in, header.backward_arc_count);
 			ch.backward.weight = read_vector<unsigned>(in, header.backward_arc_count);
-			ch.backward.is_shortcut_an_original_arc = read_bit_vector(in, header.backward_arc_count);
-			ch.backward.shortcut_first_arc = read_vector<unsigned>(in, header.backward_arc_count);
-			ch.backward.shortcut_second_arc = read_vector<unsigned>(in, header.backward_arc_count);
+			if (has_path_data)
+			{
+				ch.backward.is_shortcut_an_original_arc = read_bit_vector(in, header.backward_arc_count);
+				ch.backward.shortcut_first_arc = read_vector<CHArcID>(in, header.backward_arc_count);
+				ch.backward.shortcut_second_arc = read_vector<CHArcID>(in, header.backward_arc_count);
+			}
 
 			return ch; // NVRO
 		}
@@ -2102,67 +3105,242 @@ namespace RoutingKit
 	ContractionHierarchy ContractionHierarchy::read(std::function<void(char *, unsigned long long)> in, unsigned long long file_size)
 	{
 		CHFileHeader header = read_value<CHFileHeader>(in);
-		check_header(header);
-		unsigned long long expected_file_size = (sizeof(CHFileHeader) + sizeof(unsigned) * (header.node_count + (header.node_count + 1 + 4 * header.forward_arc_count
-
-																												 ) +
-																							(header.node_count + 1 + 4 * header.backward_arc_count
-
-																							 )) +
-												 ((header.backward_arc_count + 511) / 512) * 64 + ((header.forward_arc_count + 511) / 512) * 64);
-		if (expected_file_size != file_size)
+		bool has_path_data = check_header(header);
+		if (get_expected_file_size(header, has_path_data) != file_size)
 			throw std::runtime_error("CH file has a different size than specified in the header. This file is corrupt.");
-		return finish_read(in, header);
+		return finish_read(in, header, has_path_data);
 	}
 
 	ContractionHierarchy ContractionHierarchy::read(std::function<void(char *, unsigned long long)> in)
 	{
 		CHFileHeader header = read_value<CHFileHeader>(in);
-		check_header(header);
-		return finish_read(in, header);
+		bool has_path_data = check_header(header);
+		return finish_read(in, header, has_path_data);
+	}
+
+	namespace
+	{
+		void write_contraction_hierarchy(const ContractionHierarchy &ch, std::function<void(const char *, unsigned long long)> out, bool with_path_data)
+		{
+			CHFileHeader header = {};
+			header.magic_number = with_path_data ? ch_arc_id_magic_number : ch_arc_id_distance_only_magic_number;
+			header.node_count = ch.forward.first_out.size() - 1;
+			header.forward_arc_count = ch.forward.head.size();
+			header.backward_arc_count = ch.backward.head.size();
+			header.padding = 0;
+
+			write_value(out, header);
+			write_vector(out, ch.rank);
+			{
+				const char padding[sizeof(CHArcID)] = {};
+				unsigned long long padding_byte_count = get_rank_padding_byte_count(header.node_count);
+				if (padding_byte_count != 0)
+					out(padding, padding_byte_count);
+			}
+
+			write_vector(out, ch.forward.first_out);
+			write_vector(out, ch.forward.head);
+			write_vector(out, ch.forward.weight);
+			if (with_path_data)
+			{
+				write_bit_vector(out, ch.forward.is_shortcut_an_original_arc);
+				write_vector(out, ch.forward.shortcut_first_arc);
+				write_vector(out, ch.forward.shortcut_second_arc);
+			}
+
+			write_vector(out, ch.backward.first_out);
+			write_vector(out, ch.backward.head);
+			write_vector(out, ch.backward.weight);
+			if (with_path_data)
+			{
+				write_bit_vector(out, ch.backward.is_shortcut_an_original_arc);
+				write_vector(out, ch.backward.shortcut_first_arc);
+				write_vector(out, ch.backward.shortcut_second_arc);
+			}
+		}
 	}
 
 	void ContractionHierarchy::write(std::function<void(const char *, unsigned long long)> out) const
 	{
+		write_contraction_hierarchy(*this, out, has_path_data());
+	}
+
+	void ContractionHierarchy::write_distance_only(std::function<void(const char *, unsigned long long)> out) const
+	{
+		write_contraction_hierarchy(*this, out, false);
+	}
+
+	ContractionHierarchyView::ContractionHierarchyView(const ContractionHierarchy &ch) : rank(ch.rank), order(ch.order)
+	{
+		forward.first_out = ch.forward.first_out;
+		forward.head = ch.forward.head;
+		forward.weight = ch.forward.weight;
+		forward.is_shortcut_an_original_arc = ch.forward.is_shortcut_an_original_arc;
+		forward.shortcut_first_arc = ch.forward.shortcut_first_arc;
+		forward.shortcut_second_arc = ch.forward.shortcut_second_arc;
+
+		backward.first_out = ch.backward.first_out;
+		backward.head = ch.backward.head;
+		backward.weight = ch.backward.weight;
+		backward.is_shortcut_an_original_arc = ch.backward.is_shortcut_an_original_arc;
+		backward.shortcut_first_arc = ch.backward.shortcut_first_arc;
+		backward.shortcut_second_arc = ch.backward.shortcut_second_arc;
+	}
+
+#ifndef ROUTING_KIT_NO_POSIX
+	namespace
+	{
+		// Owns the memory mapping of a CH file and the order, which is not stored in the file.
+		class MappedContractionHierarchyFile
+		{
+		public:
+			explicit MappedContractionHierarchyFile(const std::string &file_name) : data(nullptr), size(0)
+			{
+				int file_descriptor = ::open(file_name.c_str(), O_RDONLY);
+				if (file_descriptor == -1)
+				{
+					int error = errno;
+					throw std::runtime_error("Could not open file \"" + file_name + "\" for reading. The errno is " + std::to_string(error) + ". strerror(errno) says the following : " + strerror(error));
+				}
+
+				struct stat file_stat;
+				if (fstat(file_descriptor, &file_stat) == -1)
+				{
+					int error = errno;
+					::close(file_descriptor);
+					throw std::runtime_error("Could not determine the size of \"" + file_name + "\". The errno is " + std::to_string(error) + ". strerror(errno) says the following : " + strerror(error));
+				}
+				size = file_stat.st_size;
+
+				if (size != 0)
+				{
+					void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+					if (p == MAP_FAILED)
+					{
+						int error = errno;
+						::close(file_descriptor);
+						throw std::runtime_error("Could not memory map \"" + file_name + "\". The errno is " + std::to_string(error) + ". strerror(errno) says the following : " + strerror(error));
+					}
+					data = static_cast<const char *>(p);
+				}
+
+				// The mapping stays valid after the file descriptor is closed.
+				::close(file_descriptor);
+			}
+
+			~MappedContractionHierarchyFile()
+			{
+				if (data != nullptr)
+					munmap(const_cast<char *>(data), size);
+			}
+
+			MappedContractionHierarchyFile(const MappedContractionHierarchyFile &) = delete;
+			MappedContractionHierarchyFile &operator=(const MappedContractionHierarchyFile &) = delete;
+
+			const char *data;
+			unsigned long long size;
+			std::vector<unsigned> order;
+		};
+
+		template <class T>
+		ConstArrayView<T> map_array(const char *&pos, unsigned long long element_count)
+		{
+			if (reinterpret_cast<std::uintptr_t>(pos) % alignof(T) != 0)
+				throw std::runtime_error("An array in the CH file is not aligned and can therefore not be memory mapped. Use ContractionHierarchy::load_file instead.");
+			ConstArrayView<T> v(reinterpret_cast<const T *>(pos), element_count);
+			pos += element_count * sizeof(T);
+			return v;
+		}
+
+		ConstBitVectorView map_bit_vector(const char *&pos, unsigned long long bit_count)
+		{
+			ConstBitVectorView v(pos, bit_count);
+			pos += ((bit_count + 511) / 512) * 64;
+			return v;
+		}
+	}
+
+	ContractionHierarchyView ContractionHierarchyView::map_file(const std::string &file_name)
+	{
+		auto file = std::make_shared<MappedContractionHierarchyFile>(file_name);
+
+		if (file->size < sizeof(CHFileHeader))
+			throw std::runtime_error("CH file is too small to contain a header. This file is corrupt.");
 		CHFileHeader header;
-		header.magic_number = ch_magic_number;
-		header.node_count = forward.first_out.size() - 1;
-		header.forward_arc_count = forward.head.size();
-		header.backward_arc_count = backward.head.size();
+		memcpy(&header, file->data, sizeof(CHFileHeader));
+		bool has_path_data = check_header(header);
+		if (get_expected_file_size(header, has_path_data) != file->size)
+			throw std::runtime_error("CH file has a different size than specified in the header. This file is corrupt.");
 
-		write_value(out, header);
-		write_vector(out, rank);
+		ContractionHierarchyView ch;
+		const char *pos = file->data + sizeof(CHFileHeader);
+
+		ch.rank = map_array<unsigned>(pos, header.node_count);
+		pos += get_rank_padding_byte_count(header.node_count);
+
+		ch.forward.first_out = map_array<CHArcID>(pos, header.node_count + 1);
+		ch.forward.head = map_array<unsigned>(pos, header.forward_arc_count);
+		ch.forward.weight = map_array<unsigned>(pos, header.forward_arc_count);
+		if (has_path_data)
+		{
+			ch.forward.is_shortcut_an_original_arc = map_bit_vector(pos, header.forward_arc_count);
+			ch.forward.shortcut_first_arc = map_array<CHArcID>(pos, header.forward_arc_count);
+			ch.forward.shortcut_second_arc = map_array<CHArcID>(pos, header.forward_arc_count);
+		}
+
+		ch.backward.first_out = map_array<CHArcID>(pos, header.node_count + 1);
+		ch.backward.head = map_array<unsigned>(pos, header.backward_arc_count);
+		ch.backward.weight = map_array<unsigned>(pos, header.backward_arc_count);
+		if (has_path_data)
+		{
+			ch.backward.is_shortcut_an_original_arc = map_bit_vector(pos, header.backward_arc_count);
+			ch.backward.shortcut_first_arc = map_array<CHArcID>(pos, header.backward_arc_count);
+			ch.backward.shortcut_second_arc = map_array<CHArcID>(pos, header.backward_arc_count);
+		}
+
+		assert(pos == file->data + file->size);
 
-		write_vector(out, forward.first_out);
-		write_vector(out, forward.head);
-		write_vector(out, forward.weight);
-		write_bit_vector(out, forward.is_shortcut_an_original_arc);
-		write_vector(out, forward.shortcut_first_arc);
-		write_vector(out, forward.shortcut_second_arc);
+		file->order.resize(header.node_count);
+		for (unsigned x = 0; x < header.node_count; ++x)
+		{
+			if (ch.rank[x] >= header.node_count)
+				throw std::runtime_error("The rank in the CH file is not a permutation. This file is corrupt.");
+			file->order[ch.rank[x]] = x;
+		}
+		ch.order = file->order;
 
-		write_vector(out, backward.first_out);
-		write_vector(out, backward.head);
-		write_vector(out, backward.weight);
-		write_bit_vector(out, backward.is_shortcut_an_original_arc);
-		write_vector(out, backward.shortcut_first_arc);
-		write_vector(out, backward.shortcut_second_arc);
+		ch.storage = std::move(file);
+		return ch; // NVRO
+	}
+#else
+	ContractionHierarchyView ContractionHierarchyView::map_file(const std::string &file_name)
+	{
+		// Without POSIX there is no mmap. The file is loaded into memory owned by the view instead.
+		auto loaded_ch = std::make_shared<ContractionHierarchy>(ContractionHierarchy::load_file(file_name));
+		ContractionHierarchyView ch(*loaded_ch);
+		ch.storage = std::move(loaded_ch);
+		return ch; // NVRO
 	}
+#endif
 
-	ContractionHierarchyQuery::ContractionHierarchyQuery(const ContractionHierarchy &ch) : ch(&ch),
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue>::BasicContractionHierarchyQuery(ContractionHierarchyView ch) : ch(ch),
 																						   was_forward_pushed(ch.node_count()), was_backward_pushed(ch.node_count()),
 																						   forward_queue(ch.node_count()), backward_queue(ch.node_count()),
 																						   forward_tentative_distance(ch.node_count()), backward_tentative_distance(ch.node_count()),
 																						   forward_predecessor_node(ch.node_count()), backward_predecessor_node(ch.node_count()),
 																						   forward_predecessor_arc(ch.node_count()), backward_predecessor_arc(ch.node_count()),
 																						   shortest_path_meeting_node(invalid_id),
-																						   state(ContractionHierarchyQuery::InternalState::initialized)
+																						   stall_on_demand(true), settled_node_count(0), stalled_node_count(0),
+																						   state(InternalState::initialized)
 
 	{
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::reset()
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::reset()
 	{
-		assert(ch && "query object must have an attached CH");
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
 
 		was_forward_pushed.reset_all();
 		forward_queue.clear();
@@ -2171,31 +3349,39 @@ namespace RoutingKit
 
 		shortest_path_meeting_node = invalid_id;
 
-		state = ContractionHierarchyQuery::InternalState::initialized;
+		settled_node_count = 0;
+		stalled_node_count = 0;
+		statistics.clear();
+
+		state = InternalState::initialized;
 		return *this;
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::reset(const ContractionHierarchy &new_ch)
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::reset(ContractionHierarchyView new_ch)
 	{
 		if (forward_tentative_distance.size() == new_ch.node_count())
 		{
 			reset();
-			ch = &new_ch;
+			ch = new_ch;
 		}
 		else
 		{
-			*this = ContractionHierarchyQuery(new_ch);
+			bool old_stall_on_demand = stall_on_demand;
+			*this = BasicContractionHierarchyQuery(new_ch);
+			stall_on_demand = old_stall_on_demand;
 		}
 		return *this;
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::add_source(unsigned external_s, unsigned dist_to_s)
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::add_source(unsigned external_s, unsigned dist_to_s)
 	{
-		assert(ch && "query object must have an attached CH");
-		assert(external_s < ch->node_count() && "node out of bounds");
-		assert(state == ContractionHierarchyQuery::InternalState::initialized || state == ContractionHierarchyQuery::InternalState::target_pinned);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert(external_s < ch.node_count() && "node out of bounds");
+		assert(state == InternalState::initialized || state == InternalState::target_pinned);
 
-		unsigned s = ch->rank[external_s];
+		unsigned s = ch.rank[external_s];
 
 		if (!forward_queue.contains_id(s))
 		{
@@ -2216,13 +3402,14 @@ namespace RoutingKit
 		return *this;
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::add_target(unsigned external_t, unsigned dist_to_t)
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::add_target(unsigned external_t, unsigned dist_to_t)
 	{
-		assert(ch && "query object must have an attached CH");
-		assert(external_t < ch->node_count() && "node out of bounds");
-		assert(state == ContractionHierarchyQuery::InternalState::initialized || state == ContractionHierarchyQuery::InternalState::source_pinned);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert(external_t < ch.node_count() && "node out of bounds");
+		assert(state == InternalState::initialized || state == InternalState::source_pinned);
 
-		unsigned t = ch->rank[external_t];
+		unsigned t = ch.rank[external_t];
 		if (!backward_queue.contains_id(t))
 		{
 			backward_queue.push({t, dist_to_t});
@@ -2245,19 +3432,22 @@ namespace RoutingKit
 	namespace
 	{
 
-		template <class SetPred>
+		template <class Queue, class SetPred>
 		void forward_expand_upward_ch_arcs_of_node(
 			unsigned node,
 			unsigned distance_to_node,
-			const std::vector<unsigned> &forward_first_out,
-			const std::vector<unsigned> &forward_head,
-			const std::vector<unsigned> &forward_weight,
+			ConstArrayView<CHArcID> forward_first_out,
+			ConstArrayView<unsigned> forward_head,
+			ConstArrayView<unsigned> forward_weight,
 			TimestampFlags &was_forward_pushed,
-			MinIDQueue &forward_queue,
+			Queue &forward_queue,
 			std::vector<unsigned> &forward_tentative_distance,
-			const SetPred &set_predecessor)
+			const SetPred &set_predecessor,
+			QueryStatistics::Direction &statistics)
 		{
-			for (unsigned arc = forward_first_out[node]; arc < forward_first_out[node + 1]; ++arc)
+			(void)statistics;
+			ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.relaxed_arc_count += forward_first_out[node + 1] - forward_first_out[node]);
+			for (CHArcID arc = forward_first_out[node]; arc < forward_first_out[node + 1]; ++arc)
 			{
 				unsigned h = forward_head[arc], d = distance_to_node + forward_weight[arc];
 				if (was_forward_pushed.is_set(h))
@@ -2267,6 +3457,7 @@ namespace RoutingKit
 						forward_queue.decrease_key({h, d});
 						forward_tentative_distance[h] = d;
 						set_predecessor(h, node, arc);
+						ROUTING_KIT_RECORD_QUERY_STATISTICS(++statistics.decrease_key_count);
 					}
 				}
 				else if (d < inf_weight)
@@ -2275,17 +3466,39 @@ namespace RoutingKit
 					forward_tentative_distance[h] = d;
 					was_forward_pushed.set(h);
 					set_predecessor(h, node, arc);
+					ROUTING_KIT_RECORD_QUERY_STATISTICS(++statistics.queue_push_count);
 				}
 			}
 		}
 
+		// Used by the queries that do not record statistics.
+		template <class Queue, class SetPred>
+		void forward_expand_upward_ch_arcs_of_node(
+			unsigned node,
+			unsigned distance_to_node,
+			ConstArrayView<CHArcID> forward_first_out,
+			ConstArrayView<unsigned> forward_head,
+			ConstArrayView<unsigned> forward_weight,
+			TimestampFlags &was_forward_pushed,
+			Queue &forward_queue,
+			std::vector<unsigned> &forward_tentative_distance,
+			const SetPred &set_predecessor)
+		{
+			QueryStatistics::Direction ignored_statistics;
+			forward_expand_upward_ch_arcs_of_node(
+				node, distance_to_node,
+				forward_first_out, forward_head, forward_weight,
+				was_forward_pushed, forward_queue, forward_tentative_distance,
+				set_predecessor, ignored_statistics);
+		}
+
 		bool forward_can_stall_at_node(
 			unsigned node,
-			const std::vector<unsigned> &backward_first_out, const std::vector<unsigned> &backward_head, const std::vector<unsigned> &backward_weight,
+			ConstArrayView<CHArcID> backward_first_out, ConstArrayView<unsigned> backward_head, ConstArrayView<unsigned> backward_weight,
 			const TimestampFlags &was_forward_pushed,
-			std::vector<unsigned> &forward_tentative_distance, const std::vector<unsigned> &backward_tentative_distance)
+			const std::vector<unsigned> &forward_tentative_distance)
 		{
-			for (unsigned arc = backward_first_out[node]; arc < backward_first_out[node + 1]; ++arc)
+			for (CHArcID arc = backward_first_out[node]; arc < backward_first_out[node + 1]; ++arc)
 			{
 				unsigned x = backward_head[arc];
 				if (was_forward_pushed.is_set(x))
@@ -2297,20 +3510,25 @@ namespace RoutingKit
 			return false;
 		}
 
+		template <class Queue>
 		void forward_settle_node(
 			unsigned &shortest_path_length,
 			unsigned &shortest_path_meeting_node,
-			const std::vector<unsigned> &forward_first_out, const std::vector<unsigned> &forward_head, const std::vector<unsigned> &forward_weight,
-			const std::vector<unsigned> &backward_first_out, const std::vector<unsigned> &backward_head, const std::vector<unsigned> &backward_weight,
+			ConstArrayView<CHArcID> forward_first_out, ConstArrayView<unsigned> forward_head, ConstArrayView<unsigned> forward_weight,
+			ConstArrayView<CHArcID> backward_first_out, ConstArrayView<unsigned> backward_head, ConstArrayView<unsigned> backward_weight,
 			TimestampFlags &was_forward_pushed, const TimestampFlags &was_backward_pushed,
-			MinIDQueue &forward_queue,
+			Queue &forward_queue,
 			std::vector<unsigned> &forward_tentative_distance, const std::vector<unsigned> &backward_tentative_distance,
-			std::vector<unsigned> &forward_predecessor_node, std::vector<unsigned> &forward_predecessor_arc)
+			std::vector<unsigned> &forward_predecessor_node, std::vector<CHArcID> &forward_predecessor_arc,
+			bool stall_on_demand, unsigned &settled_node_count, unsigned &stalled_node_count,
+			QueryStatistics::Direction &statistics)
 		{
 
 			auto p = forward_queue.pop();
 			auto popped_node = p.id;
 			auto distance_to_popped_node = p.key;
+			++settled_node_count;
+			ROUTING_KIT_RECORD_QUERY_STATISTICS(++statistics.settled_node_count);
 
 			if (was_backward_pushed.is_set(popped_node))
 			{
@@ -2322,57 +3540,115 @@ namespace RoutingKit
 			}
 
 			if (
-				!forward_can_stall_at_node(
+				stall_on_demand &&
+				forward_can_stall_at_node(
 					popped_node,
 					backward_first_out, backward_head, backward_weight,
 					was_forward_pushed,
-					forward_tentative_distance, backward_tentative_distance))
-				forward_expand_upward_ch_arcs_of_node(
-					popped_node, distance_to_popped_node,
-					forward_first_out, forward_head, forward_weight,
-					was_forward_pushed, forward_queue,
-					forward_tentative_distance,
-					[&](unsigned x, unsigned pred_node, unsigned pred_arc)
-					{
-						forward_predecessor_node[x] = pred_node;
-						forward_predecessor_arc[x] = pred_arc;
-					});
+					forward_tentative_distance))
+			{
+				++stalled_node_count;
+				ROUTING_KIT_RECORD_QUERY_STATISTICS(++statistics.stalled_node_count);
+				return;
+			}
+
+			forward_expand_upward_ch_arcs_of_node(
+				popped_node, distance_to_popped_node,
+				forward_first_out, forward_head, forward_weight,
+				was_forward_pushed, forward_queue,
+				forward_tentative_distance,
+				[&](unsigned x, unsigned pred_node, CHArcID pred_arc)
+				{
+					forward_predecessor_node[x] = pred_node;
+					forward_predecessor_arc[x] = pred_arc;
+				},
+				statistics);
+		}
+
+		// Used by the queries that do not record statistics.
+		template <class Queue>
+		void forward_settle_node(
+			unsigned &shortest_path_length,
+			unsigned &shortest_path_meeting_node,
+			ConstArrayView<CHArcID> forward_first_out, ConstArrayView<unsigned> forward_head, ConstArrayView<unsigned> forward_weight,
+			ConstArrayView<CHArcID> backward_first_out, ConstArrayView<unsigned> backward_head, ConstArrayView<unsigned> backward_weight,
+			TimestampFlags &was_forward_pushed, const TimestampFlags &was_backward_pushed,
+			Queue &forward_queue,
+			std::vector<unsigned> &forward_tentative_distance, const std::vector<unsigned> &backward_tentative_distance,
+			std::vector<unsigned> &forward_predecessor_node, std::vector<CHArcID> &forward_predecessor_arc,
+			bool stall_on_demand, unsigned &settled_node_count, unsigned &stalled_node_count)
+		{
+			QueryStatistics::Direction ignored_statistics;
+			forward_settle_node(
+				shortest_path_length, shortest_path_meeting_node,
+				forward_first_out, forward_head, forward_weight,
+				backward_first_out, backward_head, backward_weight,
+				was_forward_pushed, was_backward_pushed,
+				forward_queue,
+				forward_tentative_distance, backward_tentative_distance,
+				forward_predecessor_node, forward_predecessor_arc,
+				stall_on_demand, settled_node_count, stalled_node_count,
+				ignored_statistics);
 		}
 
+		// A stalled node keeps its tentative distance, which is the length of some path and therefore
+		// an upper bound. The node that stalled it is reached by the same search and is higher ranked,
+		// so the downward sweep of pinned_run still finds the correct distances.
+		template <class Queue>
 		void full_forward_search(
-			const std::vector<unsigned> &forward_first_out, const std::vector<unsigned> &forward_head, const std::vector<unsigned> &forward_weight,
+			ConstArrayView<CHArcID> forward_first_out, ConstArrayView<unsigned> forward_head, ConstArrayView<unsigned> forward_weight,
+			ConstArrayView<CHArcID> backward_first_out, ConstArrayView<unsigned> backward_head, ConstArrayView<unsigned> backward_weight,
 			TimestampFlags &was_forward_pushed,
-			MinIDQueue &forward_queue,
+			Queue &forward_queue,
 			std::vector<unsigned> &forward_tentative_distance,
-			std::vector<unsigned> &forward_predecessor_node, std::vector<unsigned> &forward_predecessor_arc)
+			std::vector<unsigned> &forward_predecessor_node, std::vector<CHArcID> &forward_predecessor_arc,
+			bool stall_on_demand, unsigned &settled_node_count, unsigned &stalled_node_count,
+			QueryStatistics::Direction &statistics)
 		{
 			while (!forward_queue.empty())
 			{
 				auto p = forward_queue.pop();
 				auto popped_node = p.id;
 				auto distance_to_popped_node = p.key;
+				++settled_node_count;
+				ROUTING_KIT_RECORD_QUERY_STATISTICS(++statistics.settled_node_count);
+
+				if (
+					stall_on_demand &&
+					forward_can_stall_at_node(
+						popped_node,
+						backward_first_out, backward_head, backward_weight,
+						was_forward_pushed,
+						forward_tentative_distance))
+				{
+					++stalled_node_count;
+					ROUTING_KIT_RECORD_QUERY_STATISTICS(++statistics.stalled_node_count);
+					continue;
+				}
 
 				forward_expand_upward_ch_arcs_of_node(
 					popped_node, distance_to_popped_node,
 					forward_first_out, forward_head, forward_weight,
 					was_forward_pushed, forward_queue,
 					forward_tentative_distance,
-					[&](unsigned x, unsigned pred_node, unsigned pred_arc)
+					[&](unsigned x, unsigned pred_node, CHArcID pred_arc)
 					{
 						forward_predecessor_node[x] = pred_node;
 						forward_predecessor_arc[x] = pred_arc;
-					});
+					},
+					statistics);
 			}
 		}
 
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::run()
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::run()
 	{
-		assert(ch && "query object must have an attached CH");
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
 		assert(!forward_queue.empty() && "must add at least one source before calling run");
 		assert(!backward_queue.empty() && "must add at least one target before calling run");
-		assert(state == ContractionHierarchyQuery::InternalState::initialized);
+		assert(state == InternalState::initialized);
 
 		unsigned shortest_path_length = inf_weight;
 		shortest_path_meeting_node = invalid_id;
@@ -2405,36 +3681,41 @@ namespace RoutingKit
 			{
 				forward_settle_node(
 					shortest_path_length, shortest_path_meeting_node,
-					ch->forward.first_out, ch->forward.head, ch->forward.weight,
-					ch->backward.first_out, ch->backward.head, ch->backward.weight,
+					ch.forward.first_out, ch.forward.head, ch.forward.weight,
+					ch.backward.first_out, ch.backward.head, ch.backward.weight,
 					was_forward_pushed, was_backward_pushed,
 					forward_queue,
 					forward_tentative_distance, backward_tentative_distance,
-					forward_predecessor_node, forward_predecessor_arc);
+					forward_predecessor_node, forward_predecessor_arc,
+					stall_on_demand, settled_node_count, stalled_node_count,
+					statistics.forward);
 				forward_next = false;
 			}
 			else
 			{
 				forward_settle_node(
 					shortest_path_length, shortest_path_meeting_node,
-					ch->backward.first_out, ch->backward.head, ch->backward.weight,
-					ch->forward.first_out, ch->forward.head, ch->forward.weight,
+					ch.backward.first_out, ch.backward.head, ch.backward.weight,
+					ch.forward.first_out, ch.forward.head, ch.forward.weight,
 					was_backward_pushed, was_forward_pushed,
 					backward_queue,
 					backward_tentative_distance, forward_tentative_distance,
-					backward_predecessor_node, backward_predecessor_arc);
+					backward_predecessor_node, backward_predecessor_arc,
+					stall_on_demand, settled_node_count, stalled_node_count,
+					statistics.backward);
 				forward_next = true;
 			}
 		}
 
-		state = ContractionHierarchyQuery::InternalState::run;
+		state = InternalState::run;
 		return *this;
 	}
 
-	unsigned ContractionHierarchyQuery::get_used_source()
+	template <class Queue>
+	unsigned BasicContractionHierarchyQuery<Queue>::get_used_source()
 	{
-		assert(ch && "query object must have an attached CH");
-		assert(state == ContractionHierarchyQuery::InternalState::run);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert(state == InternalState::run);
 
 		if (shortest_path_meeting_node == invalid_id)
 			return invalid_id;
@@ -2442,20 +3723,21 @@ namespace RoutingKit
 		while (forward_predecessor_node[x] != invalid_id)
 			x = forward_predecessor_node[x];
 
-		return ch->order[x];
+		return ch.order[x];
 	}
 
-	unsigned ContractionHierarchyQuery::get_used_target()
+	template <class Queue>
+	unsigned BasicContractionHierarchyQuery<Queue>::get_used_target()
 	{
-		assert(ch && "query object must have an attached CH");
-		assert(state == ContractionHierarchyQuery::InternalState::run);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert(state == InternalState::run);
 
 		if (shortest_path_meeting_node == invalid_id)
 			return invalid_id;
 		unsigned x = shortest_path_meeting_node;
 		while (backward_predecessor_node[x] != invalid_id)
 			x = backward_predecessor_node[x];
-		return ch->order[x];
+		return ch.order[x];
 	}
 
 	namespace
@@ -2467,13 +3749,13 @@ namespace RoutingKit
 		// The source node of the path must be obtained by some other mean
 
 		template <class OnNewInputArc>
-		void unpack_forward_arc(const ContractionHierarchy &ch, unsigned arc, const OnNewInputArc &on_new_input_arc);
+		void unpack_forward_arc(const ContractionHierarchyView &ch, CHArcID arc, const OnNewInputArc &on_new_input_arc);
 
 		template <class OnNewInputArc>
-		void unpack_backward_arc(const ContractionHierarchy &ch, unsigned arc, const OnNewInputArc &on_new_input_arc);
+		void unpack_backward_arc(const ContractionHierarchyView &ch, CHArcID arc, const OnNewInputArc &on_new_input_arc);
 
 		template <class OnNewInputArc>
-		void unpack_forward_arc(const ContractionHierarchy &ch, unsigned arc, const OnNewInputArc &on_new_input_arc)
+		void unpack_forward_arc(const ContractionHierarchyView &ch, CHArcID arc, const OnNewInputArc &on_new_input_arc)
 		{
 			if (ch.forward.is_shortcut_an_original_arc.is_set(arc))
 			{
@@ -2489,7 +3771,7 @@ namespace RoutingKit
 		}
 
 		template <class OnNewInputArc>
-		void unpack_backward_arc(const ContractionHierarchy &ch, unsigned arc, const OnNewInputArc &on_new_input_arc)
+		void unpack_backward_arc(const ContractionHierarchyView &ch, CHArcID arc, const OnNewInputArc &on_new_input_arc)
 		{
 			if (ch.backward.is_shortcut_an_original_arc.is_set(arc))
 			{
@@ -2503,11 +3785,41 @@ namespace RoutingKit
 				unpack_forward_arc(ch, ch.backward.shortcut_second_arc[arc], on_new_input_arc);
 			}
 		}
+
+#ifdef ROUTING_KIT_QUERY_STATISTICS
+		// Returns the number of nested shortcuts of an arc. Arcs of the input graph have depth zero.
+		unsigned get_unpacking_depth(const ContractionHierarchyView &ch, CHArcID arc, bool is_forward)
+		{
+			const ContractionHierarchyView::Side &side = is_forward ? ch.forward : ch.backward;
+			if (side.is_shortcut_an_original_arc.is_set(arc))
+				return 0;
+			return 1 + std::max(
+						   get_unpacking_depth(ch, side.shortcut_first_arc[arc], false),
+						   get_unpacking_depth(ch, side.shortcut_second_arc[arc], true));
+		}
+
+		unsigned get_path_unpacking_depth(
+			const ContractionHierarchyView &ch, unsigned shortest_path_meeting_node,
+			const std::vector<unsigned> &forward_predecessor_node, const std::vector<CHArcID> &forward_predecessor_arc,
+			const std::vector<unsigned> &backward_predecessor_node, const std::vector<CHArcID> &backward_predecessor_arc)
+		{
+			unsigned depth = 0;
+			if (shortest_path_meeting_node != invalid_id)
+			{
+				for (unsigned x = shortest_path_meeting_node; forward_predecessor_node[x] != invalid_id; x = forward_predecessor_node[x])
+					depth = std::max(depth, get_unpacking_depth(ch, forward_predecessor_arc[x], true));
+				for (unsigned x = shortest_path_meeting_node; backward_predecessor_node[x] != invalid_id; x = backward_predecessor_node[x])
+					depth = std::max(depth, get_unpacking_depth(ch, backward_predecessor_arc[x], false));
+			}
+			return depth;
+		}
+#endif
 	}
 
-	unsigned ContractionHierarchyQuery::get_distance()
+	template <class Queue>
+	unsigned BasicContractionHierarchyQuery<Queue>::get_distance()
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::run);
+		assert(state == InternalState::run);
 
 		if (shortest_path_meeting_node == invalid_id)
 			return inf_weight;
@@ -2515,28 +3827,43 @@ namespace RoutingKit
 			return forward_tentative_distance[shortest_path_meeting_node] + backward_tentative_distance[shortest_path_meeting_node];
 	}
 
-	std::vector<unsigned> ContractionHierarchyQuery::get_arc_path()
+	namespace
 	{
-		assert(ch && "query object must have an attached CH");
-		assert(state == ContractionHierarchyQuery::InternalState::run);
+		// A distance-only file can be passed in by the user, so this is not an assert.
+		template <class CH>
+		void throw_if_ch_has_no_path_data(const CH &ch)
+		{
+			if (!ch.has_path_data())
+				throw std::runtime_error("Paths can only be extracted if the CH was not loaded from a distance-only file.");
+		}
+	}
+
+	template <class Queue>
+	std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_arc_path()
+	{
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		throw_if_ch_has_no_path_data(ch);
+		assert(state == InternalState::run);
+
+		ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_time -= get_micro_time());
 
 		std::vector<unsigned> path;
 		if (shortest_path_meeting_node != invalid_id)
 		{
-			std::vector<unsigned> up_path;
+			std::vector<CHArcID> up_path;
 			{
 				unsigned x = shortest_path_meeting_node;
 				while (forward_predecessor_node[x] != invalid_id)
 				{
 					assert(was_forward_pushed.is_set(x));
 					up_path.push_back(forward_predecessor_arc[x]);
-					// up_path.push_back(find_arc_given_sorted_head(ch->forward.first_out, ch->forward.head, forward_predecessor_node[x], x));
+					// up_path.push_back(find_arc_given_sorted_head(ch.forward.first_out, ch.forward.head, forward_predecessor_node[x], x));
 					x = forward_predecessor_node[x];
 				}
 			}
 			for (unsigned i = up_path.size(); i > 0; --i)
 			{
-				unpack_forward_arc(*ch, up_path[i - 1], [&](unsigned xy, unsigned y)
+				unpack_forward_arc(ch, up_path[i - 1], [&](unsigned xy, unsigned y)
 								   { path.push_back(xy); });
 			}
 			{
@@ -2544,25 +3871,37 @@ namespace RoutingKit
 				while (backward_predecessor_node[x] != invalid_id)
 				{
 					assert(was_backward_pushed.is_set(x));
-					unpack_backward_arc(*ch, backward_predecessor_arc[x], [&](unsigned xy, unsigned y)
+					unpack_backward_arc(ch, backward_predecessor_arc[x], [&](unsigned xy, unsigned y)
 										{ path.push_back(xy); });
-					// unpack_backward_arc(*ch, find_arc_given_sorted_head(ch->backward.first_out, ch->backward.head, backward_predecessor_node[x], x), [&](unsigned xy, unsigned y){path.push_back(xy);});
+					// unpack_backward_arc(ch, find_arc_given_sorted_head(ch.backward.first_out, ch.backward.head, backward_predecessor_node[x], x), [&](unsigned xy, unsigned y){path.push_back(xy);});
 					x = backward_predecessor_node[x];
 				}
 			}
 		}
+
+		ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_time += get_micro_time());
+		ROUTING_KIT_RECORD_QUERY_STATISTICS(
+			statistics.unpacking_depth = get_path_unpacking_depth(
+				ch, shortest_path_meeting_node,
+				forward_predecessor_node, forward_predecessor_arc,
+				backward_predecessor_node, backward_predecessor_arc));
+
 		return path; // NVRO
 	}
 
-	std::vector<unsigned> ContractionHierarchyQuery::get_node_path()
+	template <class Queue>
+	std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_node_path()
 	{
-		assert(ch && "query object must have an attached CH");
-		assert(state == ContractionHierarchyQuery::InternalState::run);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		throw_if_ch_has_no_path_data(ch);
+		assert(state == InternalState::run);
+
+		ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_time -= get_micro_time());
 
 		std::vector<unsigned> path;
 		if (shortest_path_meeting_node != invalid_id)
 		{
-			std::vector<unsigned> up_path;
+			std::vector<CHArcID> up_path;
 			{
 				unsigned x = shortest_path_meeting_node;
 				while (forward_predecessor_node[x] != invalid_id)
@@ -2571,11 +3910,11 @@ namespace RoutingKit
 					up_path.push_back(forward_predecessor_arc[x]);
 					x = forward_predecessor_node[x];
 				}
-				path.push_back(ch->order[x]);
+				path.push_back(ch.order[x]);
 			}
 			for (unsigned i = up_path.size(); i > 0; --i)
 			{
-				unpack_forward_arc(*ch, up_path[i - 1], [&](unsigned xy, unsigned y)
+				unpack_forward_arc(ch, up_path[i - 1], [&](unsigned xy, unsigned y)
 								   { path.push_back(y); });
 			}
 			{
@@ -2583,36 +3922,54 @@ namespace RoutingKit
 				while (backward_predecessor_node[x] != invalid_id)
 				{
 					assert(was_backward_pushed.is_set(x));
-					unpack_backward_arc(*ch, backward_predecessor_arc[x], [&](unsigned xy, unsigned y)
+					unpack_backward_arc(ch, backward_predecessor_arc[x], [&](unsigned xy, unsigned y)
 										{ path.push_back(y); });
 					x = backward_predecessor_node[x];
 				}
 			}
 		}
+
+		ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_time += get_micro_time());
+		ROUTING_KIT_RECORD_QUERY_STATISTICS(
+			statistics.unpacking_depth = get_path_unpacking_depth(
+				ch, shortest_path_meeting_node,
+				forward_predecessor_node, forward_predecessor_arc,
+				backward_predecessor_node, backward_predecessor_arc));
+
 		return path; // NVRO
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::reset_source()
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::reset_source()
 	{
-		assert(ch && "query object must have an attached CH");
-		assert(state == ContractionHierarchyQuery::InternalState::target_pinned || state == ContractionHierarchyQuery::InternalState::target_run);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert(state == InternalState::target_pinned || state == InternalState::target_run);
 
 		was_forward_pushed.reset_all();
 		forward_queue.clear();
 
-		state = ContractionHierarchyQuery::InternalState::target_pinned;
+		settled_node_count = 0;
+		stalled_node_count = 0;
+		statistics.clear();
+
+		state = InternalState::target_pinned;
 		return *this;
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::reset_target()
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::reset_target()
 	{
-		assert(ch && "query object must have an attached CH");
-		assert(state == ContractionHierarchyQuery::InternalState::source_pinned || state == ContractionHierarchyQuery::InternalState::source_run);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert(state == InternalState::source_pinned || state == InternalState::source_run);
 
 		was_backward_pushed.reset_all();
 		backward_queue.clear();
 
-		state = ContractionHierarchyQuery::InternalState::source_pinned;
+		settled_node_count = 0;
+		stalled_node_count = 0;
+		statistics.clear();
+
+		state = InternalState::source_pinned;
 		return *this;
 	}
 
@@ -2629,17 +3986,18 @@ namespace RoutingKit
 		// The IDs are with repect to the CH and not with respect to the input.
 		// select_list is ordered decreasing by rank.
 
+		template <class Queue>
 		void pin(
 			const std::vector<unsigned> &external_target_list,
-			const std::vector<unsigned> &external_node_to_internal_node,
+			ConstArrayView<unsigned> external_node_to_internal_node,
 			std::vector<unsigned> &target_list,
 			unsigned &target_count,
 			std::vector<unsigned> &select_list,
 			unsigned &select_count,
-			MinIDQueue &q,
-			const std::vector<unsigned> &backward_first_out,
-			const std::vector<unsigned> &backward_head,
-			const std::vector<unsigned> &backward_weight)
+			Queue &q,
+			ConstArrayView<CHArcID> backward_first_out,
+			ConstArrayView<unsigned> backward_head,
+			ConstArrayView<unsigned> backward_weight)
 		{
 			target_count = external_target_list.size();
 
@@ -2658,7 +4016,7 @@ namespace RoutingKit
 				auto x = q.pop().id;
 				select_list[select_count++] = x;
 
-				for (unsigned xy = backward_first_out[x]; xy < backward_first_out[x + 1]; ++xy)
+				for (CHArcID xy = backward_first_out[x]; xy < backward_first_out[x + 1]; ++xy)
 				{
 					unsigned y = backward_head[xy];
 					assert(x < y);
@@ -2681,42 +4039,49 @@ namespace RoutingKit
 		//  2) !has_forward_predecessor.is_set(x)
 		//
 
+		template <class Queue>
 		void pinned_run(
 			std::vector<unsigned> &select_list,
 			unsigned &select_count,
 
 			TimestampFlags &has_forward_predecessor,
-			MinIDQueue &forward_queue,
+			Queue &forward_queue,
 			std::vector<unsigned> &tentative_distance,
 
 			std::vector<unsigned> &forward_predecessor_node,
-			std::vector<unsigned> &predecessor_arc,
+			std::vector<CHArcID> &predecessor_arc,
+
+			ConstArrayView<CHArcID> forward_first_out,
+			ConstArrayView<unsigned> forward_head,
+			ConstArrayView<unsigned> forward_weight,
 
-			const std::vector<unsigned> &forward_first_out,
-			const std::vector<unsigned> &forward_head,
-			const std::vector<unsigned> &forward_weight,
+			ConstArrayView<CHArcID> backward_first_out,
+			ConstArrayView<unsigned> backward_head,
+			ConstArrayView<unsigned> backward_weight,
 
-			const std::vector<unsigned> &backward_first_out,
-			const std::vector<unsigned> &backward_head,
-			const std::vector<unsigned> &backward_weight)
+			bool stall_on_demand, unsigned &settled_node_count, unsigned &stalled_node_count,
+			QueryStatistics::Direction &statistics)
 		{
 			full_forward_search(
 				forward_first_out, forward_head, forward_weight,
+				backward_first_out, backward_head, backward_weight,
 				has_forward_predecessor,
 				forward_queue,
 				tentative_distance,
-				forward_predecessor_node, predecessor_arc);
+				forward_predecessor_node, predecessor_arc,
+				stall_on_demand, settled_node_count, stalled_node_count,
+				statistics);
 
 			for (unsigned i = 0; i < select_count; ++i)
 			{
 				unsigned
 					x = select_list[i],
-					dist = inf_weight,
-					pred = invalid_id;
+					dist = inf_weight;
+				CHArcID pred = invalid_ch_arc_id;
 				if (has_forward_predecessor.is_set(x))
 					dist = tentative_distance[x];
 
-				for (unsigned xy = backward_first_out[x]; xy < backward_first_out[x + 1]; ++xy)
+				for (CHArcID xy = backward_first_out[x]; xy < backward_first_out[x + 1]; ++xy)
 				{
 					unsigned y = backward_head[xy];
 
@@ -2728,7 +4093,7 @@ namespace RoutingKit
 					}
 				}
 
-				if (pred != invalid_id)
+				if (pred != invalid_ch_arc_id)
 				{
 					tentative_distance[x] = dist;
 					predecessor_arc[x] = pred;
@@ -2737,7 +4102,7 @@ namespace RoutingKit
 				else if (dist == inf_weight)
 				{
 					tentative_distance[x] = inf_weight;
-					predecessor_arc[x] = invalid_id;
+					predecessor_arc[x] = invalid_ch_arc_id;
 				}
 			}
 		}
@@ -2763,15 +4128,16 @@ namespace RoutingKit
 		}
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::pin_targets(const std::vector<unsigned> &external_target_list)
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::pin_targets(const std::vector<unsigned> &external_target_list)
 	{
-		assert(ch && "query object must have an attached CH");
-		assert((external_target_list.empty() || max_element_of(external_target_list) < ch->node_count()) && "node id out of bounds");
-		assert(state == ContractionHierarchyQuery::InternalState::initialized);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert((external_target_list.empty() || max_element_of(external_target_list) < ch.node_count()) && "node id out of bounds");
+		assert(state == InternalState::initialized);
 
 		pin(
 			external_target_list,
-			ch->rank,
+			ch.rank,
 
 			// the following 4 variables happen to be unused and of the
 			// required size -> use them to avoid allocating unnecessary
@@ -2780,40 +4146,42 @@ namespace RoutingKit
 
 			backward_queue,
 
-			ch->backward.first_out,
-			ch->backward.head,
-			ch->backward.weight);
+			ch.backward.first_out,
+			ch.backward.head,
+			ch.backward.weight);
 
-		state = ContractionHierarchyQuery::InternalState::target_pinned;
+		state = InternalState::target_pinned;
 		return *this;
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::pin_sources(const std::vector<unsigned> &external_source_list)
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::pin_sources(const std::vector<unsigned> &external_source_list)
 	{
-		assert(ch && "query object must have an attached CH");
-		assert((external_source_list.empty() || max_element_of(external_source_list) < ch->node_count()) && "node id out of bounds");
-		assert(state == ContractionHierarchyQuery::InternalState::initialized);
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert((external_source_list.empty() || max_element_of(external_source_list) < ch.node_count()) && "node id out of bounds");
+		assert(state == InternalState::initialized);
 
 		pin(
 			external_source_list,
-			ch->rank,
+			ch.rank,
 
 			forward_predecessor_node, many_to_many_source_or_target_count, forward_tentative_distance, shortest_path_meeting_node,
 
 			forward_queue,
-			ch->forward.first_out,
-			ch->forward.head,
-			ch->forward.weight);
+			ch.forward.first_out,
+			ch.forward.head,
+			ch.forward.weight);
 
-		state = ContractionHierarchyQuery::InternalState::source_pinned;
+		state = InternalState::source_pinned;
 		return *this;
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::run_to_pinned_targets()
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::run_to_pinned_targets()
 	{
-		assert(ch && "query object must have an attached CH");
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
 		assert(!forward_queue.empty() && "must add at least one source before calling run");
-		assert(state == ContractionHierarchyQuery::InternalState::target_pinned);
+		assert(state == InternalState::target_pinned);
 
 		pinned_run(
 			backward_tentative_distance, shortest_path_meeting_node,
@@ -2824,23 +4192,27 @@ namespace RoutingKit
 
 			forward_predecessor_node, forward_predecessor_arc,
 
-			ch->forward.first_out,
-			ch->forward.head,
-			ch->forward.weight,
+			ch.forward.first_out,
+			ch.forward.head,
+			ch.forward.weight,
+
+			ch.backward.first_out,
+			ch.backward.head,
+			ch.backward.weight,
 
-			ch->backward.first_out,
-			ch->backward.head,
-			ch->backward.weight);
+			stall_on_demand, settled_node_count, stalled_node_count,
+			statistics.forward);
 
-		state = ContractionHierarchyQuery::InternalState::target_run;
+		state = InternalState::target_run;
 		return *this;
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::run_to_pinned_sources()
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::run_to_pinned_sources()
 	{
-		assert(ch && "query object must have an attached CH");
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
 		assert(!backward_queue.empty() && "must add at least one target before calling run");
-		assert(state == ContractionHierarchyQuery::InternalState::source_pinned);
+		assert(state == InternalState::source_pinned);
 
 		pinned_run(
 			forward_tentative_distance, shortest_path_meeting_node,
@@ -2851,43 +4223,167 @@ namespace RoutingKit
 
 			backward_predecessor_node, backward_predecessor_arc,
 
-			ch->backward.first_out,
-			ch->backward.head,
-			ch->backward.weight,
+			ch.backward.first_out,
+			ch.backward.head,
+			ch.backward.weight,
+
+			ch.forward.first_out,
+			ch.forward.head,
+			ch.forward.weight,
 
-			ch->forward.first_out,
-			ch->forward.head,
-			ch->forward.weight);
-		state = ContractionHierarchyQuery::InternalState::source_run;
+			stall_on_demand, settled_node_count, stalled_node_count,
+			statistics.backward);
+		state = InternalState::source_run;
 		return *this;
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::get_distances_to_targets(unsigned *dist)
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::get_distances_to_targets(unsigned *dist)
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::target_run);
+		assert(state == InternalState::target_run);
 		extract_distances_to_targets(backward_predecessor_node, many_to_many_source_or_target_count, forward_tentative_distance, dist);
 		return *this;
 	}
 
-	std::vector<unsigned> ContractionHierarchyQuery::get_distances_to_targets()
+	template <class Queue>
+	std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_distances_to_targets()
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::target_run);
+		assert(state == InternalState::target_run);
 		return extract_distances_to_targets(backward_predecessor_node, many_to_many_source_or_target_count, forward_tentative_distance);
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::get_distances_to_sources(unsigned *dist)
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::get_distances_to_sources(unsigned *dist)
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::source_run);
+		assert(state == InternalState::source_run);
 		extract_distances_to_targets(forward_predecessor_node, many_to_many_source_or_target_count, backward_tentative_distance, dist);
 		return *this;
 	}
 
-	std::vector<unsigned> ContractionHierarchyQuery::get_distances_to_sources()
+	template <class Queue>
+	std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_distances_to_sources()
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::source_run);
+		assert(state == InternalState::source_run);
 		return extract_distances_to_targets(forward_predecessor_node, many_to_many_source_or_target_count, backward_tentative_distance);
 	}
 
+	namespace
+	{
+		// Number of sources whose distances are relaxed together in the downward sweep. The per-arc
+		// loops over the lanes have a fixed length and no branches, so that the compiler can map them
+		// to SIMD min and add instructions. 16 lanes fill one AVX-512 or two AVX2 registers.
+		const unsigned batch_lane_count = 16;
+
+		// Downward sweep of pinned_run for batch_lane_count sources. distance[i*batch_lane_count+l] is the
+		// distance from the l-th source to select_list[i]. On entry it contains the results of the upward
+		// searches. select_position maps a node in select_list to its position.
+		void batched_pinned_sweep(
+			const std::vector<unsigned> &select_list,
+			unsigned select_count,
+			const std::vector<unsigned> &select_position,
+			std::vector<unsigned> &distance,
+			ConstArrayView<CHArcID> backward_first_out,
+			ConstArrayView<unsigned> backward_head,
+			ConstArrayView<unsigned> backward_weight)
+		{
+			for (unsigned i = 0; i < select_count; ++i)
+			{
+				unsigned x = select_list[i];
+				unsigned *dist_x = distance.data() + (unsigned long long)i * batch_lane_count;
+
+				for (CHArcID xy = backward_first_out[x]; xy < backward_first_out[x + 1]; ++xy)
+				{
+					const unsigned *dist_y = distance.data() + (unsigned long long)select_position[backward_head[xy]] * batch_lane_count;
+					const unsigned w = backward_weight[xy];
+					for (unsigned l = 0; l < batch_lane_count; ++l)
+						dist_x[l] = std::min(dist_x[l], dist_y[l] + w);
+				}
+			}
+		}
+	}
+
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::get_distances_from_sources_to_pinned_targets(const std::vector<unsigned> &source_list, unsigned *dist)
+	{
+		assert(!ch.forward.first_out.empty() && "query object must have an attached CH");
+		assert((source_list.empty() || max_element_of(source_list) < ch.node_count()) && "node id out of bounds");
+		assert(state == InternalState::target_pinned || state == InternalState::target_run);
+
+		// See pin_targets for which member stores what.
+		const std::vector<unsigned> &target_list = backward_predecessor_node;
+		const unsigned target_count = many_to_many_source_or_target_count;
+		const std::vector<unsigned> &select_list = backward_tentative_distance;
+		const unsigned select_count = shortest_path_meeting_node;
+
+		batch_select_position.resize(ch.node_count());
+		for (unsigned i = 0; i < select_count; ++i)
+			batch_select_position[select_list[i]] = i;
+		batch_distance.resize((unsigned long long)select_count * batch_lane_count);
+
+		const unsigned source_count = source_list.size();
+		for (unsigned first_source = 0; first_source < source_count; first_source += batch_lane_count)
+		{
+			const unsigned lane_count = std::min(batch_lane_count, source_count - first_source);
+
+			for (unsigned l = 0; l < batch_lane_count; ++l)
+			{
+				if (l < lane_count)
+				{
+					was_forward_pushed.reset_all();
+					forward_queue.clear();
+					unsigned s = ch.rank[source_list[first_source + l]];
+					forward_queue.push({s, 0});
+					forward_tentative_distance[s] = 0;
+					forward_predecessor_node[s] = invalid_id;
+					was_forward_pushed.set(s);
+
+					full_forward_search(
+						ch.forward.first_out, ch.forward.head, ch.forward.weight,
+						ch.backward.first_out, ch.backward.head, ch.backward.weight,
+						was_forward_pushed,
+						forward_queue,
+						forward_tentative_distance,
+						forward_predecessor_node, forward_predecessor_arc,
+						stall_on_demand, settled_node_count, stalled_node_count,
+						statistics.forward);
+
+					for (unsigned i = 0; i < select_count; ++i)
+					{
+						unsigned x = select_list[i];
+						batch_distance[(unsigned long long)i * batch_lane_count + l] = was_forward_pushed.is_set(x) ? forward_tentative_distance[x] : inf_weight;
+					}
+				}
+				else
+				{
+					for (unsigned i = 0; i < select_count; ++i)
+						batch_distance[(unsigned long long)i * batch_lane_count + l] = inf_weight;
+				}
+			}
+
+			batched_pinned_sweep(
+				select_list, select_count, batch_select_position, batch_distance,
+				ch.backward.first_out, ch.backward.head, ch.backward.weight);
+
+			for (unsigned l = 0; l < lane_count; ++l)
+				for (unsigned t = 0; t < target_count; ++t)
+					dist[(unsigned long long)(first_source + l) * target_count + t] = batch_distance[(unsigned long long)batch_select_position[target_list[t]] * batch_lane_count + l];
+		}
+
+		was_forward_pushed.reset_all();
+		forward_queue.clear();
+
+		state = InternalState::target_pinned;
+		return *this;
+	}
+
+	template <class Queue>
+	std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_distances_from_sources_to_pinned_targets(const std::vector<unsigned> &source_list)
+	{
+		std::vector<unsigned> dist((unsigned long long)source_list.size() * get_pinned_target_count());
+		get_distances_from_sources_to_pinned_targets(source_list, dist.data());
+		return dist; // NVRO
+	}
+
 	namespace
 	{
 		void internal_get_used_sources_to_targets(
@@ -2896,18 +4392,18 @@ namespace RoutingKit
 
 			const TimestampFlags &has_forward_predecessor,
 			const std::vector<unsigned> &forward_predecessor_node,
-			const std::vector<unsigned> &predecessor_arc,
+			const std::vector<CHArcID> &predecessor_arc,
 
-			const std::vector<unsigned> &backward_head,
+			ConstArrayView<unsigned> backward_head,
 
-			const std::vector<unsigned> &ch_order,
+			ConstArrayView<unsigned> ch_order,
 
 			unsigned *output)
 		{
 			for (unsigned i = 0; i < target_count; ++i)
 			{
 				unsigned x = target_list[i];
-				if (!has_forward_predecessor.is_set(x) && predecessor_arc[x] == invalid_id)
+				if (!has_forward_predecessor.is_set(x) && predecessor_arc[x] == invalid_ch_arc_id)
 				{
 					output[i] = invalid_id;
 				}
@@ -2932,9 +4428,10 @@ namespace RoutingKit
 		}
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::get_used_sources_to_targets(unsigned *output)
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::get_used_sources_to_targets(unsigned *output)
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::target_run);
+		assert(state == InternalState::target_run);
 
 		internal_get_used_sources_to_targets(
 			backward_predecessor_node, many_to_many_source_or_target_count,
@@ -2942,25 +4439,27 @@ namespace RoutingKit
 			was_forward_pushed,
 			forward_predecessor_node, forward_predecessor_arc,
 
-			ch->backward.head,
-			ch->order,
+			ch.backward.head,
+			ch.order,
 
 			output);
 
 		return *this;
 	}
 
-	std::vector<unsigned> ContractionHierarchyQuery::get_used_sources_to_targets()
+	template <class Queue>
+	std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_used_sources_to_targets()
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::target_run);
+		assert(state == InternalState::target_run);
 		std::vector<unsigned> ret(many_to_many_source_or_target_count);
 		get_used_sources_to_targets(&ret[0]);
 		return ret; // NVRO
 	}
 
-	ContractionHierarchyQuery &ContractionHierarchyQuery::get_used_targets_to_sources(unsigned *output)
+	template <class Queue>
+	BasicContractionHierarchyQuery<Queue> &BasicContractionHierarchyQuery<Queue>::get_used_targets_to_sources(unsigned *output)
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::source_run);
+		assert(state == InternalState::source_run);
 
 		internal_get_used_sources_to_targets(
 			forward_predecessor_node, many_to_many_source_or_target_count,
@@ -2968,22 +4467,1744 @@ namespace RoutingKit
 			was_backward_pushed,
 			backward_predecessor_node, backward_predecessor_arc,
 
-			ch->forward.head,
-			ch->order,
+			ch.forward.head,
+			ch.order,
 
 			output);
 
 		return *this;
 	}
 
-	std::vector<unsigned> ContractionHierarchyQuery::get_used_targets_to_sources()
+	template <class Queue>
+	std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_used_targets_to_sources()
 	{
-		assert(state == ContractionHierarchyQuery::InternalState::source_run);
+		assert(state == InternalState::source_run);
 		std::vector<unsigned> ret(many_to_many_source_or_target_count);
 		get_used_targets_to_sources(&ret[0]);
 		return ret; // NVRO
 	}
 
+	ContractionHierarchyBatchQuery::ContractionHierarchyBatchQuery(ContractionHierarchyView ch, unsigned thread_count)
+	{
+		reset(std::move(ch), thread_count);
+	}
+
+	ContractionHierarchyBatchQuery &ContractionHierarchyBatchQuery::reset(ContractionHierarchyView ch, unsigned thread_count)
+	{
+#ifdef _OPENMP
+		if (thread_count == 0)
+			thread_count = omp_get_num_procs();
+#else
+		thread_count = 1;
+#endif
+		query.clear();
+		query.resize(thread_count, ContractionHierarchyQuery(std::move(ch)));
+		return *this;
+	}
+
+	namespace
+	{
+		// Each chunk contains only a few queries, as a single query is cheap compared to handing out a chunk
+		// but the running times of queries differ a lot.
+		const unsigned batch_query_chunk_size = 16;
+
+		template <class OnQuery>
+		void run_batch_queries(std::vector<ContractionHierarchyQuery> &query, const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list, const OnQuery &on_query)
+		{
+			assert(!query.empty() && "batch query object must have an attached CH");
+			assert(source_list.size() == target_list.size() && "there must be as many sources as targets");
+
+			const unsigned thread_count = query.size();
+			(void)thread_count;
+			const long long query_count = source_list.size();
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(thread_count) schedule(dynamic, batch_query_chunk_size) if (thread_count > 1)
+#endif
+			for (long long i = 0; i < query_count; ++i)
+			{
+				ContractionHierarchyQuery &q = query[get_thread_id()];
+				q.reset().add_source(source_list[i]).add_target(target_list[i]).run();
+				on_query(q, i);
+			}
+		}
+	}
+
+	ContractionHierarchyBatchQuery &ContractionHierarchyBatchQuery::get_distances(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list, unsigned *dist)
+	{
+		run_batch_queries(query, source_list, target_list, [&](ContractionHierarchyQuery &q, long long i)
+						  { dist[i] = q.get_distance(); });
+		return *this;
+	}
+
+	std::vector<unsigned> ContractionHierarchyBatchQuery::get_distances(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list)
+	{
+		std::vector<unsigned> dist(source_list.size());
+		get_distances(source_list, target_list, dist.data());
+		return dist; // NVRO
+	}
+
+	ContractionHierarchyBatchQuery &ContractionHierarchyBatchQuery::get_node_paths(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list, unsigned *dist, std::vector<unsigned> *node_path)
+	{
+		// Checked before the queries run, as an exception can not leave the parallel loop.
+		if (!query.empty())
+			throw_if_ch_has_no_path_data(query[0].ch);
+		run_batch_queries(query, source_list, target_list, [&](ContractionHierarchyQuery &q, long long i)
+						  {
+			if(dist != nullptr)
+				dist[i] = q.get_distance();
+			node_path[i] = q.get_node_path(); });
+		return *this;
+	}
+
+	std::vector<std::vector<unsigned>> ContractionHierarchyBatchQuery::get_node_paths(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list)
+	{
+		std::vector<std::vector<unsigned>> node_path(source_list.size());
+		get_node_paths(source_list, target_list, nullptr, node_path.data());
+		return node_path; // NVRO
+	}
+
+	ContractionHierarchyBatchQuery &ContractionHierarchyBatchQuery::get_arc_paths(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list, unsigned *dist, std::vector<unsigned> *arc_path)
+	{
+		// Checked before the queries run, as an exception can not leave the parallel loop.
+		if (!query.empty())
+			throw_if_ch_has_no_path_data(query[0].ch);
+		run_batch_queries(query, source_list, target_list, [&](ContractionHierarchyQuery &q, long long i)
+						  {
+			if(dist != nullptr)
+				dist[i] = q.get_distance();
+			arc_path[i] = q.get_arc_path(); });
+		return *this;
+	}
+
+	std::vector<std::vector<unsigned>> ContractionHierarchyBatchQuery::get_arc_paths(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list)
+	{
+		std::vector<std::vector<unsigned>> arc_path(source_list.size());
+		get_arc_paths(source_list, target_list, nullptr, arc_path.data());
+		return arc_path; // NVRO
+	}
+
+	ContractionHierarchyBatchQuery &ContractionHierarchyBatchQuery::get_distances_to_targets(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list, unsigned *dist)
+	{
+		assert(!query.empty() && "batch query object must have an attached CH");
+
+		const unsigned thread_count = query.size();
+		(void)thread_count;
+		const long long source_count = source_list.size();
+		const unsigned target_count = target_list.size();
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(thread_count) if (thread_count > 1)
+#endif
+		{
+			ContractionHierarchyQuery &q = query[get_thread_id()];
+			q.reset().pin_targets(target_list);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, batch_query_chunk_size)
+#endif
+			for (long long i = 0; i < source_count; ++i)
+				q.reset_source().add_source(source_list[i]).run_to_pinned_targets().get_distances_to_targets(dist + i * target_count);
+		}
+		return *this;
+	}
+
+	std::vector<unsigned> ContractionHierarchyBatchQuery::get_distances_to_targets(const std::vector<unsigned> &source_list, const std::vector<unsigned> &target_list)
+	{
+		std::vector<unsigned> dist(source_list.size() * target_list.size());
+		get_distances_to_targets(source_list, target_list, dist.data());
+		return dist; // NVRO
+	}
+
+	ContractionHierarchyManyToMany::ContractionHierarchyManyToMany(const ContractionHierarchy &ch) : ch(&ch),
+																									 was_pushed(ch.node_count()), queue(ch.node_count()), tentative_distance(ch.node_count()),
+																									 state(ContractionHierarchyManyToMany::InternalState::initialized)
+	{
+	}
+
+	ContractionHierarchyManyToMany &ContractionHierarchyManyToMany::reset()
+	{
+		assert(ch && "many-to-many object must have an attached CH");
+
+		source_list.clear();
+		target_list.clear();
+		bucket_first_entry.clear();
+		bucket_target.clear();
+		bucket_distance.clear();
+		distance.clear();
+
+		state = ContractionHierarchyManyToMany::InternalState::initialized;
+		return *this;
+	}
+
+	ContractionHierarchyManyToMany &ContractionHierarchyManyToMany::reset(const ContractionHierarchy &new_ch)
+	{
+		if (tentative_distance.size() == new_ch.node_count())
+		{
+			reset();
+			ch = &new_ch;
+		}
+		else
+		{
+			*this = ContractionHierarchyManyToMany(new_ch);
+		}
+		return *this;
+	}
+
+	namespace
+	{
+		// Runs an upward search with stall-on-demand from s and calls on_settle(x, distance_to_x)
+		// for every settled node x that is not stalled.
+		template <class Queue, class OnSettle>
+		void stalling_upward_search(
+			unsigned s,
+			const std::vector<CHArcID> &up_first_out, const std::vector<unsigned> &up_head, const std::vector<unsigned> &up_weight,
+			const std::vector<CHArcID> &down_first_out, const std::vector<unsigned> &down_head, const std::vector<unsigned> &down_weight,
+			TimestampFlags &was_pushed,
+			Queue &queue,
+			std::vector<unsigned> &tentative_distance,
+			const OnSettle &on_settle)
+		{
+			assert(queue.empty());
+			was_pushed.reset_all();
+
+			queue.push({s, 0});
+			tentative_distance[s] = 0;
+			was_pushed.set(s);
+
+			while (!queue.empty())
+			{
+				auto p = queue.pop();
+				auto popped_node = p.id;
+				auto distance_to_popped_node = p.key;
+
+				if (forward_can_stall_at_node(popped_node, down_first_out, down_head, down_weight, was_pushed, tentative_distance))
+					continue;
+
+				on_settle(popped_node, distance_to_popped_node);
+
+				forward_expand_upward_ch_arcs_of_node(
+					popped_node, distance_to_popped_node,
+					up_first_out, up_head, up_weight,
+					was_pushed, queue,
+					tentative_distance,
+					[](unsigned, unsigned, CHArcID) {});
+			}
+		}
+
+		void get_used_nodes_of_distance_table(
+			const std::vector<unsigned> &distance,
+			unsigned row_count, unsigned column_count,
+			bool per_column,
+			const std::vector<unsigned> &node_list,
+			const std::vector<unsigned> &ch_order,
+			unsigned *output)
+		{
+			unsigned output_count = per_column ? column_count : row_count;
+			unsigned candidate_count = per_column ? row_count : column_count;
+			for (unsigned i = 0; i < output_count; ++i)
+			{
+				unsigned best_distance = inf_weight;
+				unsigned best_node = invalid_id;
+				for (unsigned j = 0; j < candidate_count; ++j)
+				{
+					unsigned d = per_column ? distance[(unsigned long long)j * column_count + i] : distance[(unsigned long long)i * column_count + j];
+					if (d < best_distance)
+					{
+						best_distance = d;
+						best_node = ch_order[node_list[j]];
+					}
+				}
+				output[i] = best_node;
+			}
+		}
+	}
+
+	ContractionHierarchyManyToMany &ContractionHierarchyManyToMany::pin_targets(const std::vector<unsigned> &external_target_list)
+	{
+		assert(ch && "many-to-many object must have an attached CH");
+		assert((external_target_list.empty() || max_element_of(external_target_list) < ch->node_count()) && "node id out of bounds");
+		assert(state == ContractionHierarchyManyToMany::InternalState::initialized);
+
+		const unsigned node_count = ch->node_count();
+		const unsigned target_count = external_target_list.size();
+
+		target_list.resize(target_count);
+		for (unsigned i = 0; i < target_count; ++i)
+			target_list[i] = ch->rank[external_target_list[i]];
+
+		std::vector<unsigned> bucket_node;
+		bucket_target.clear();
+		bucket_distance.clear();
+
+		for (unsigned i = 0; i < target_count; ++i)
+		{
+			stalling_upward_search(
+				target_list[i],
+				ch->backward.first_out, ch->backward.head, ch->backward.weight,
+				ch->forward.first_out, ch->forward.head, ch->forward.weight,
+				was_pushed, queue, tentative_distance,
+				[&](unsigned x, unsigned distance_to_x)
+				{
+					bucket_node.push_back(x);
+					bucket_target.push_back(i);
+					bucket_distance.push_back(distance_to_x);
+				});
+			if (bucket_node.size() >= invalid_id)
+				throw std::runtime_error("The buckets of a ContractionHierarchyManyToMany may contain at most 2^32-1 entries. Pin fewer targets.");
+		}
+
+		// The entries are generated ordered by target. A stable sort by node therefore keeps every bucket ordered by target.
+		{
+			auto p = compute_inverse_stable_sort_permutation_using_key(bucket_node, node_count, [](unsigned x)
+																	  { return x; });
+			bucket_node = apply_inverse_permutation(p, std::move(bucket_node));
+			bucket_target = apply_inverse_permutation(p, std::move(bucket_target));
+			bucket_distance = apply_inverse_permutation(p, std::move(bucket_distance));
+		}
+		bucket_first_entry = invert_vector(bucket_node, node_count);
+
+		state = ContractionHierarchyManyToMany::InternalState::target_pinned;
+		return *this;
+	}
+
+	ContractionHierarchyManyToMany &ContractionHierarchyManyToMany::run(const std::vector<unsigned> &external_source_list)
+	{
+		assert(ch && "many-to-many object must have an attached CH");
+		assert((external_source_list.empty() || max_element_of(external_source_list) < ch->node_count()) && "node id out of bounds");
+		assert(state == ContractionHierarchyManyToMany::InternalState::target_pinned || state == ContractionHierarchyManyToMany::InternalState::run);
+
+		const unsigned source_count = external_source_list.size();
+		const unsigned target_count = target_list.size();
+
+		source_list.resize(source_count);
+		for (unsigned i = 0; i < source_count; ++i)
+			source_list[i] = ch->rank[external_source_list[i]];
+
+		distance.assign((unsigned long long)source_count * target_count, inf_weight);
+
+		for (unsigned i = 0; i < source_count; ++i)
+		{
+			unsigned *row = distance.data() + (unsigned long long)i * target_count;
+			stalling_upward_search(
+				source_list[i],
+				ch->forward.first_out, ch->forward.head, ch->forward.weight,
+				ch->backward.first_out, ch->backward.head, ch->backward.weight,
+				was_pushed, queue, tentative_distance,
+				[&](unsigned x, unsigned distance_to_x)
+				{
+					for (unsigned e = bucket_first_entry[x]; e < bucket_first_entry[x + 1]; ++e)
+					{
+						unsigned d = distance_to_x + bucket_distance[e];
+						if (d < row[bucket_target[e]])
+							row[bucket_target[e]] = d;
+					}
+				});
+		}
+
+		state = ContractionHierarchyManyToMany::InternalState::run;
+		return *this;
+	}
+
+	ContractionHierarchyManyToMany &ContractionHierarchyManyToMany::get_distances(unsigned *dist)
+	{
+		assert(state == ContractionHierarchyManyToMany::InternalState::run);
+		std::copy(distance.begin(), distance.end(), dist);
+		return *this;
+	}
+
+	std::vector<unsigned> ContractionHierarchyManyToMany::get_distances()
+	{
+		assert(state == ContractionHierarchyManyToMany::InternalState::run);
+		return distance;
+	}
+
+	ContractionHierarchyManyToMany &ContractionHierarchyManyToMany::get_used_sources_to_targets(unsigned *used_source)
+	{
+		assert(state == ContractionHierarchyManyToMany::InternalState::run);
+		get_used_nodes_of_distance_table(distance, source_list.size(), target_list.size(), true, source_list, ch->order, used_source);
+		return *this;
+	}
+
+	std::vector<unsigned> ContractionHierarchyManyToMany::get_used_sources_to_targets()
+	{
+		assert(state == ContractionHierarchyManyToMany::InternalState::run);
+		std::vector<unsigned> ret(target_list.size());
+		get_used_sources_to_targets(ret.data());
+		return ret; // NVRO
+	}
+
+	ContractionHierarchyManyToMany &ContractionHierarchyManyToMany::get_used_targets_to_sources(unsigned *used_target)
+	{
+		assert(state == ContractionHierarchyManyToMany::InternalState::run);
+		get_used_nodes_of_distance_table(distance, source_list.size(), target_list.size(), false, target_list, ch->order, used_target);
+		return *this;
+	}
+
+	std::vector<unsigned> ContractionHierarchyManyToMany::get_used_targets_to_sources()
+	{
+		assert(state == ContractionHierarchyManyToMany::InternalState::run);
+		std::vector<unsigned> ret(source_list.size());
+		get_used_targets_to_sources(ret.data());
+		return ret; // NVRO
+	}
+
+	ContractionHierarchyOneToAll::ContractionHierarchyOneToAll(const ContractionHierarchy &ch) : ch(&ch),
+																								 was_pushed(ch.node_count()), queue(ch.node_count()), tentative_distance(ch.node_count(), inf_weight),
+																								 state(ContractionHierarchyOneToAll::InternalState::initialized)
+	{
+	}
+
+	ContractionHierarchyOneToAll &ContractionHierarchyOneToAll::reset()
+	{
+		assert(ch && "one-to-all object must have an attached CH");
+
+		was_pushed.reset_all();
+		queue.clear();
+		std::fill(tentative_distance.begin(), tentative_distance.end(), inf_weight);
+
+		state = ContractionHierarchyOneToAll::InternalState::initialized;
+		return *this;
+	}
+
+	ContractionHierarchyOneToAll &ContractionHierarchyOneToAll::reset(const ContractionHierarchy &new_ch)
+	{
+		if (tentative_distance.size() == new_ch.node_count())
+		{
+			ch = &new_ch;
+			reset();
+		}
+		else
+		{
+			*this = ContractionHierarchyOneToAll(new_ch);
+		}
+		return *this;
+	}
+
+	ContractionHierarchyOneToAll &ContractionHierarchyOneToAll::add_source(unsigned external_s, unsigned dist_to_s)
+	{
+		assert(ch && "one-to-all object must have an attached CH");
+		assert(external_s < ch->node_count() && "node out of bounds");
+		assert(state == ContractionHierarchyOneToAll::InternalState::initialized);
+
+		unsigned s = ch->rank[external_s];
+
+		if (!queue.contains_id(s))
+		{
+			queue.push({s, dist_to_s});
+			tentative_distance[s] = dist_to_s;
+			was_pushed.set(s);
+		}
+		else if (dist_to_s < tentative_distance[s])
+		{
+			tentative_distance[s] = dist_to_s;
+			queue.decrease_key({s, dist_to_s});
+		}
+		return *this;
+	}
+
+	ContractionHierarchyOneToAll &ContractionHierarchyOneToAll::run()
+	{
+		assert(ch && "one-to-all object must have an attached CH");
+		assert(state == ContractionHierarchyOneToAll::InternalState::initialized);
+
+		while (!queue.empty())
+		{
+			auto p = queue.pop();
+			auto popped_node = p.id;
+			auto distance_to_popped_node = p.key;
+
+			if (forward_can_stall_at_node(popped_node, ch->backward.first_out, ch->backward.head, ch->backward.weight, was_pushed, tentative_distance))
+				continue;
+
+			forward_expand_upward_ch_arcs_of_node(
+				popped_node, distance_to_popped_node,
+				ch->forward.first_out, ch->forward.head, ch->forward.weight,
+				was_pushed, queue,
+				tentative_distance,
+				[](unsigned, unsigned, CHArcID) {});
+		}
+
+		const std::vector<CHArcID> &first_out = ch->backward.first_out;
+		const std::vector<unsigned> &head = ch->backward.head;
+		const std::vector<unsigned> &weight = ch->backward.weight;
+
+		for (unsigned x = ch->node_count() - 1; x != (unsigned)-1; --x)
+		{
+			unsigned d = tentative_distance[x];
+			for (CHArcID xy = first_out[x]; xy < first_out[x + 1]; ++xy)
+				d = std::min(d, tentative_distance[head[xy]] + weight[xy]);
+			tentative_distance[x] = d;
+		}
+
+		state = ContractionHierarchyOneToAll::InternalState::run;
+		return *this;
+	}
+
+	ContractionHierarchyOneToAll &ContractionHierarchyOneToAll::get_distances(unsigned *dist)
+	{
+		assert(state == ContractionHierarchyOneToAll::InternalState::run);
+		const unsigned node_count = ch->node_count();
+		for (unsigned x = 0; x < node_count; ++x)
+			dist[x] = tentative_distance[ch->rank[x]];
+		return *this;
+	}
+
+	std::vector<unsigned> ContractionHierarchyOneToAll::get_distances()
+	{
+		assert(state == ContractionHierarchyOneToAll::InternalState::run);
+		std::vector<unsigned> dist(ch->node_count());
+		get_distances(dist.data());
+		return dist; // NVRO
+	}
+
+	ContractionHierarchyOneToAll &ContractionHierarchyOneToAll::get_distances_from_sources(const std::vector<unsigned> &source_list, unsigned *dist)
+	{
+		assert(ch && "one-to-all object must have an attached CH");
+		assert((source_list.empty() || max_element_of(source_list) < ch->node_count()) && "node id out of bounds");
+
+		const unsigned node_count = ch->node_count();
+		const unsigned source_count = source_list.size();
+
+		const std::vector<CHArcID> &first_out = ch->backward.first_out;
+		const std::vector<unsigned> &head = ch->backward.head;
+		const std::vector<unsigned> &weight = ch->backward.weight;
+
+		// The upward searches use their own queue and flags so that the state of a previous run is kept.
+		TimestampFlags batch_was_pushed(node_count);
+		MinIDQueue batch_queue(node_count);
+		std::vector<unsigned> batch_tentative_distance(node_count);
+
+		batch_distance.resize((unsigned long long)node_count * batch_lane_count);
+
+		for (unsigned first_source = 0; first_source < source_count; first_source += batch_lane_count)
+		{
+			const unsigned lane_count = std::min(batch_lane_count, source_count - first_source);
+
+			std::fill(batch_distance.begin(), batch_distance.end(), inf_weight);
+
+			// Stalled nodes are not recorded. The node that stalls a node is recorded and the sweep
+			// relaxes the arc between them.
+			for (unsigned l = 0; l < lane_count; ++l)
+				stalling_upward_search(
+					ch->rank[source_list[first_source + l]],
+					ch->forward.first_out, ch->forward.head, ch->forward.weight,
+					ch->backward.first_out, ch->backward.head, ch->backward.weight,
+					batch_was_pushed, batch_queue, batch_tentative_distance,
+					[&](unsigned x, unsigned distance_to_x)
+					{
+						batch_distance[(unsigned long long)x * batch_lane_count + l] = distance_to_x;
+					});
+
+			for (unsigned x = node_count - 1; x != (unsigned)-1; --x)
+			{
+				unsigned *dist_x = batch_distance.data() + (unsigned long long)x * batch_lane_count;
+				for (CHArcID xy = first_out[x]; xy < first_out[x + 1]; ++xy)
+				{
+					const unsigned *dist_y = batch_distance.data() + (unsigned long long)head[xy] * batch_lane_count;
+					const unsigned w = weight[xy];
+					for (unsigned l = 0; l < batch_lane_count; ++l)
+						dist_x[l] = std::min(dist_x[l], dist_y[l] + w);
+				}
+			}
+
+			for (unsigned l = 0; l < lane_count; ++l)
+			{
+				unsigned *row = dist + (unsigned long long)(first_source + l) * node_count;
+				for (unsigned x = 0; x < node_count; ++x)
+					row[x] = batch_distance[(unsigned long long)ch->rank[x] * batch_lane_count + l];
+			}
+		}
+
+		return *this;
+	}
+
+	std::vector<unsigned> ContractionHierarchyOneToAll::get_distances_from_sources(const std::vector<unsigned> &source_list)
+	{
+		std::vector<unsigned> dist((unsigned long long)source_list.size() * ch->node_count());
+		get_distances_from_sources(source_list, dist.data());
+		return dist; // NVRO
+	}
+
+	namespace
+	{
+		void append_varint(std::vector<unsigned char> &out, unsigned x)
+		{
+			while (x >= 128)
+			{
+				out.push_back((unsigned char)(x | 128));
+				x >>= 7;
+			}
+			out.push_back((unsigned char)x);
+		}
+
+		// Heads are stored as differences modulo 2^32. As the arcs of a node are sorted by head,
+		// only the first difference can wrap around, which only happens for downward arcs.
+		void compress_contraction_hierarchy_side(
+			const ContractionHierarchyView::Side &side, unsigned node_count, unsigned weight_byte_count,
+			CompressedContractionHierarchy::Side &compressed_side)
+		{
+			const unsigned nodes_per_block = CompressedContractionHierarchy::nodes_per_block;
+
+			compressed_side.block_first_byte.clear();
+			compressed_side.first_byte.resize(node_count + 1);
+			compressed_side.arc_data.clear();
+
+			std::vector<std::pair<unsigned, unsigned>> arcs;
+
+			for (unsigned x = 0; x <= node_count; ++x)
+			{
+				if (x % nodes_per_block == 0)
+					compressed_side.block_first_byte.push_back(compressed_side.arc_data.size());
+
+				unsigned long long offset = compressed_side.arc_data.size() - compressed_side.block_first_byte[x / nodes_per_block];
+				if (offset > UINT_MAX)
+					throw std::runtime_error("The arcs of " + std::to_string(nodes_per_block) + " consecutive nodes need more than 4GB in a CompressedContractionHierarchy");
+				compressed_side.first_byte[x] = offset;
+
+				if (x == node_count)
+					break;
+
+				arcs.clear();
+				for (CHArcID xy = side.first_out[x]; xy < side.first_out[x + 1]; ++xy)
+					arcs.push_back({side.head[xy], side.weight[xy]});
+				std::sort(arcs.begin(), arcs.end());
+
+				unsigned previous_head = x;
+				for (auto a : arcs)
+				{
+					append_varint(compressed_side.arc_data, a.first - previous_head);
+					previous_head = a.first;
+					for (unsigned i = 0; i < weight_byte_count; ++i)
+						compressed_side.arc_data.push_back((unsigned char)(a.second >> (8 * i)));
+				}
+			}
+
+			compressed_side.arc_data.shrink_to_fit();
+		}
+
+		// The weight byte count is a template parameter so that the weight decoding is unrolled.
+		template <unsigned weight_byte_count>
+		class CompressedArcDecoder
+		{
+		public:
+			CompressedArcDecoder(const CompressedContractionHierarchy::Side &side, unsigned x) : head(x)
+			{
+				const unsigned nodes_per_block = CompressedContractionHierarchy::nodes_per_block;
+				pos = side.arc_data.data() + side.block_first_byte[x / nodes_per_block] + side.first_byte[x];
+				end = side.arc_data.data() + side.block_first_byte[(x + 1) / nodes_per_block] + side.first_byte[x + 1];
+			}
+
+			bool is_finished() const
+			{
+				return pos == end;
+			}
+
+			// Decodes the next arc and returns its head. Its weight is stored in weight.
+			unsigned next(unsigned &weight)
+			{
+				unsigned b = *pos++;
+				unsigned delta = b & 127;
+				for (unsigned shift = 7; b >= 128; shift += 7)
+				{
+					b = *pos++;
+					delta |= (b & 127) << shift;
+				}
+				head += delta;
+
+				weight = 0;
+				for (unsigned i = 0; i < weight_byte_count; ++i)
+					weight |= (unsigned)pos[i] << (8 * i);
+				pos += weight_byte_count;
+
+				return head;
+			}
+
+		private:
+			const unsigned char *pos, *end;
+			unsigned head;
+		};
+
+		// The same as forward_settle_node without predecessor information but on a compressed CH.
+		template <unsigned weight_byte_count>
+		void compressed_forward_settle_node(
+			unsigned &shortest_path_length,
+			const CompressedContractionHierarchy::Side &forward, const CompressedContractionHierarchy::Side &backward,
+			TimestampFlags &was_forward_pushed, const TimestampFlags &was_backward_pushed,
+			MinIDQueue &forward_queue,
+			std::vector<unsigned> &forward_tentative_distance, const std::vector<unsigned> &backward_tentative_distance,
+			unsigned &settled_node_count, unsigned &stalled_node_count)
+		{
+			auto p = forward_queue.pop();
+			auto popped_node = p.id;
+			auto distance_to_popped_node = p.key;
+			++settled_node_count;
+
+			if (was_backward_pushed.is_set(popped_node))
+			{
+				if (shortest_path_length > distance_to_popped_node + backward_tentative_distance[popped_node])
+					shortest_path_length = distance_to_popped_node + backward_tentative_distance[popped_node];
+			}
+
+			for (CompressedArcDecoder<weight_byte_count> arc(backward, popped_node); !arc.is_finished();)
+			{
+				unsigned w;
+				unsigned x = arc.next(w);
+				if (was_forward_pushed.is_set(x))
+				{
+					if (forward_tentative_distance[x] + w <= distance_to_popped_node)
+					{
+						++stalled_node_count;
+						return;
+					}
+				}
+			}
+
+			for (CompressedArcDecoder<weight_byte_count> arc(forward, popped_node); !arc.is_finished();)
+			{
+				unsigned w;
+				unsigned h = arc.next(w);
+				unsigned d = distance_to_popped_node + w;
+				if (was_forward_pushed.is_set(h))
+				{
+					if (d < forward_tentative_distance[h])
+					{
+						forward_queue.decrease_key({h, d});
+						forward_tentative_distance[h] = d;
+					}
+				}
+				else if (d < inf_weight)
+				{
+					forward_queue.push({h, d});
+					forward_tentative_distance[h] = d;
+					was_forward_pushed.set(h);
+				}
+			}
+		}
+
+		const unsigned long long compressed_ch_magic_number = 0x436f6d7043484331ull;
+
+		struct CompressedCHFileHeader
+		{
+			unsigned long long magic_number;
+			unsigned node_count;
+			unsigned weight_byte_count;
+			unsigned long long forward_byte_count;
+			unsigned long long backward_byte_count;
+		};
+	}
+
+	CompressedContractionHierarchy::CompressedContractionHierarchy(const ContractionHierarchyView &ch) : rank(ch.rank.to_vector()), weight_byte_count(1)
+	{
+		unsigned max_weight = 0;
+		for (unsigned w : ch.forward.weight)
+			max_weight = std::max(max_weight, w);
+		for (unsigned w : ch.backward.weight)
+			max_weight = std::max(max_weight, w);
+		while (weight_byte_count < 4 && (max_weight >> (8 * weight_byte_count)) != 0)
+			++weight_byte_count;
+
+		compress_contraction_hierarchy_side(ch.forward, ch.node_count(), weight_byte_count, forward);
+		compress_contraction_hierarchy_side(ch.backward, ch.node_count(), weight_byte_count, backward);
+	}
+
+	CompressedContractionHierarchy CompressedContractionHierarchy::read(std::function<void(char *, unsigned long long)> in)
+	{
+		CompressedCHFileHeader header = read_value<CompressedCHFileHeader>(in);
+		if (header.magic_number != compressed_ch_magic_number)
+			throw std::runtime_error("Compressed CH file magic number broken. Is this really a compressed CH file?");
+		if (header.weight_byte_count < 1 || header.weight_byte_count > 4)
+			throw std::runtime_error("Compressed CH file has an invalid weight byte count. This file is corrupt.");
+
+		const unsigned long long block_count = header.node_count / nodes_per_block + 1;
+
+		CompressedContractionHierarchy ch;
+		ch.rank = read_vector<unsigned>(in, header.node_count);
+		ch.weight_byte_count = header.weight_byte_count;
+
+		ch.forward.block_first_byte = read_vector<unsigned long long>(in, block_count);
+		ch.forward.first_byte = read_vector<unsigned>(in, header.node_count + 1);
+		ch.forward.arc_data = read_vector<unsigned char>(in, header.forward_byte_count);
+
+		ch.backward.block_first_byte = read_vector<unsigned long long>(in, block_count);
+		ch.backward.first_byte = read_vector<unsigned>(in, header.node_count + 1);
+		ch.backward.arc_data = read_vector<unsigned char>(in, header.backward_byte_count);
+
+		for (auto side : {&ch.forward, &ch.backward})
+			if (side->block_first_byte.back() + side->first_byte.back() != side->arc_data.size())
+				throw std::runtime_error("Compressed CH file has inconsistent arc offsets. This file is corrupt.");
+
+		return ch; // NVRO
+	}
+
+	CompressedContractionHierarchy CompressedContractionHierarchy::load_file(const std::string &file_name)
+	{
+		CompressedContractionHierarchy ch;
+		open_file_for_loading(file_name, [&](std::istream &in, unsigned long long)
+							  { ch = read([&](char *p, unsigned long long l)
+										  {
+											  if (!in.read(p, l))
+												  throw std::runtime_error("std::istream::read failed while reading a compressed contraction hierarchy");
+										  }); });
+		return ch;
+	}
+
+	void CompressedContractionHierarchy::write(std::function<void(const char *, unsigned long long)> out) const
+	{
+		CompressedCHFileHeader header = {};
+		header.magic_number = compressed_ch_magic_number;
+		header.node_count = rank.size();
+		header.weight_byte_count = weight_byte_count;
+		header.forward_byte_count = forward.arc_data.size();
+		header.backward_byte_count = backward.arc_data.size();
+
+		write_value(out, header);
+		write_vector(out, rank);
+
+		write_vector(out, forward.block_first_byte);
+		write_vector(out, forward.first_byte);
+		write_vector(out, forward.arc_data);
+
+		write_vector(out, backward.block_first_byte);
+		write_vector(out, backward.first_byte);
+		write_vector(out, backward.arc_data);
+	}
+
+	void CompressedContractionHierarchy::save_file(const std::string &file_name) const
+	{
+		open_file_for_saving(file_name, [&](std::ostream &out)
+							 { write([&](const char *p, unsigned long long l)
+									 {
+										 if (!out.write(p, l))
+											 throw std::runtime_error("std::ostream::write failed while writing a compressed contraction hierarchy");
+									 }); });
+	}
+
+	CompressedContractionHierarchyQuery::CompressedContractionHierarchyQuery(const CompressedContractionHierarchy &ch) : ch(&ch),
+																													  was_forward_pushed(ch.node_count()), was_backward_pushed(ch.node_count()),
+																													  forward_queue(ch.node_count()), backward_queue(ch.node_count()),
+																													  forward_tentative_distance(ch.node_count()), backward_tentative_distance(ch.node_count()),
+																													  shortest_path_length(inf_weight), settled_node_count(0), stalled_node_count(0),
+																													  state(InternalState::initialized)
+	{
+	}
+
+	CompressedContractionHierarchyQuery &CompressedContractionHierarchyQuery::reset()
+	{
+		assert(ch && "query object must have an attached CH");
+
+		was_forward_pushed.reset_all();
+		forward_queue.clear();
+		was_backward_pushed.reset_all();
+		backward_queue.clear();
+
+		shortest_path_length = inf_weight;
+		settled_node_count = 0;
+		stalled_node_count = 0;
+
+		state = InternalState::initialized;
+		return *this;
+	}
+
+	CompressedContractionHierarchyQuery &CompressedContractionHierarchyQuery::reset(const CompressedContractionHierarchy &new_ch)
+	{
+		if (forward_tentative_distance.size() == new_ch.node_count())
+		{
+			reset();
+			ch = &new_ch;
+		}
+		else
+		{
+			*this = CompressedContractionHierarchyQuery(new_ch);
+		}
+		return *this;
+	}
+
+	CompressedContractionHierarchyQuery &CompressedContractionHierarchyQuery::add_source(unsigned external_s, unsigned dist_to_s)
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(external_s < ch->node_count() && "node out of bounds");
+		assert(state == InternalState::initialized);
+
+		unsigned s = ch->rank[external_s];
+
+		if (!forward_queue.contains_id(s))
+		{
+			forward_queue.push({s, dist_to_s});
+			forward_tentative_distance[s] = dist_to_s;
+		}
+		else if (dist_to_s < forward_tentative_distance[s])
+		{
+			forward_tentative_distance[s] = dist_to_s;
+			forward_queue.decrease_key({s, dist_to_s});
+		}
+
+		was_forward_pushed.set(s);
+		return *this;
+	}
+
+	CompressedContractionHierarchyQuery &CompressedContractionHierarchyQuery::add_target(unsigned external_t, unsigned dist_to_t)
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(external_t < ch->node_count() && "node out of bounds");
+		assert(state == InternalState::initialized);
+
+		unsigned t = ch->rank[external_t];
+
+		if (!backward_queue.contains_id(t))
+		{
+			backward_queue.push({t, dist_to_t});
+			backward_tentative_distance[t] = dist_to_t;
+		}
+		else if (dist_to_t < backward_tentative_distance[t])
+		{
+			backward_tentative_distance[t] = dist_to_t;
+			backward_queue.decrease_key({t, dist_to_t});
+		}
+
+		was_backward_pushed.set(t);
+		return *this;
+	}
+
+	namespace
+	{
+		template <unsigned weight_byte_count>
+		void compressed_bidirectional_search(
+			unsigned &shortest_path_length,
+			const CompressedContractionHierarchy &ch,
+			TimestampFlags &was_forward_pushed, TimestampFlags &was_backward_pushed,
+			MinIDQueue &forward_queue, MinIDQueue &backward_queue,
+			std::vector<unsigned> &forward_tentative_distance, std::vector<unsigned> &backward_tentative_distance,
+			unsigned &settled_node_count, unsigned &stalled_node_count)
+		{
+			bool forward_next = true;
+
+			for (;;)
+			{
+				bool forward_finished = forward_queue.empty() || forward_queue.peek().key >= shortest_path_length;
+				bool backward_finished = backward_queue.empty() || backward_queue.peek().key >= shortest_path_length;
+
+				if (forward_finished && backward_finished)
+					break;
+
+				if (forward_finished)
+					forward_next = false;
+				if (backward_finished)
+					forward_next = true;
+
+				if (forward_next)
+				{
+					compressed_forward_settle_node<weight_byte_count>(
+						shortest_path_length,
+						ch.forward, ch.backward,
+						was_forward_pushed, was_backward_pushed,
+						forward_queue,
+						forward_tentative_distance, backward_tentative_distance,
+						settled_node_count, stalled_node_count);
+					forward_next = false;
+				}
+				else
+				{
+					compressed_forward_settle_node<weight_byte_count>(
+						shortest_path_length,
+						ch.backward, ch.forward,
+						was_backward_pushed, was_forward_pushed,
+						backward_queue,
+						backward_tentative_distance, forward_tentative_distance,
+						settled_node_count, stalled_node_count);
+					forward_next = true;
+				}
+			}
+		}
+	}
+
+	CompressedContractionHierarchyQuery &CompressedContractionHierarchyQuery::run()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(!forward_queue.empty() && "must add at least one source before calling run");
+		assert(!backward_queue.empty() && "must add at least one target before calling run");
+		assert(state == InternalState::initialized);
+
+		shortest_path_length = inf_weight;
+
+		switch (ch->weight_byte_count)
+		{
+		case 1:
+			compressed_bidirectional_search<1>(shortest_path_length, *ch, was_forward_pushed, was_backward_pushed, forward_queue, backward_queue, forward_tentative_distance, backward_tentative_distance, settled_node_count, stalled_node_count);
+			break;
+		case 2:
+			compressed_bidirectional_search<2>(shortest_path_length, *ch, was_forward_pushed, was_backward_pushed, forward_queue, backward_queue, forward_tentative_distance, backward_tentative_distance, settled_node_count, stalled_node_count);
+			break;
+		case 3:
+			compressed_bidirectional_search<3>(shortest_path_length, *ch, was_forward_pushed, was_backward_pushed, forward_queue, backward_queue, forward_tentative_distance, backward_tentative_distance, settled_node_count, stalled_node_count);
+			break;
+		default:
+			compressed_bidirectional_search<4>(shortest_path_length, *ch, was_forward_pushed, was_backward_pushed, forward_queue, backward_queue, forward_tentative_distance, backward_tentative_distance, settled_node_count, stalled_node_count);
+			break;
+		}
+
+		state = InternalState::run;
+		return *this;
+	}
+
+	unsigned CompressedContractionHierarchyQuery::get_distance()
+	{
+		assert(state == InternalState::run);
+		return shortest_path_length;
+	}
+
+	CoreContractionHierarchyQuery::CoreContractionHierarchyQuery(const ContractionHierarchy &ch, unsigned core_node_count) : ch(&ch), core_rank_begin(ch.node_count() - core_node_count),
+																															  was_forward_pushed(ch.node_count()), was_backward_pushed(ch.node_count()),
+																															  forward_queue(ch.node_count()), backward_queue(ch.node_count()),
+																															  forward_tentative_distance(ch.node_count()), backward_tentative_distance(ch.node_count()),
+																															  forward_predecessor_node(ch.node_count()), backward_predecessor_node(ch.node_count()),
+																															  forward_predecessor_arc(ch.node_count()), backward_predecessor_arc(ch.node_count()),
+																															  shortest_path_meeting_node(invalid_id),
+																															  settled_node_count(0), stalled_node_count(0),
+																															  state(CoreContractionHierarchyQuery::InternalState::initialized)
+	{
+		assert(core_node_count <= ch.node_count() && "core can not be larger than the graph");
+	}
+
+	CoreContractionHierarchyQuery &CoreContractionHierarchyQuery::reset()
+	{
+		assert(ch && "query object must have an attached CH");
+
+		was_forward_pushed.reset_all();
+		forward_queue.clear();
+		was_backward_pushed.reset_all();
+		backward_queue.clear();
+
+		target_list.clear();
+		select_list.clear();
+
+		settled_node_count = 0;
+		stalled_node_count = 0;
+
+		state = CoreContractionHierarchyQuery::InternalState::initialized;
+		return *this;
+	}
+
+	CoreContractionHierarchyQuery &CoreContractionHierarchyQuery::reset(const ContractionHierarchy &new_ch, unsigned core_node_count)
+	{
+		assert(core_node_count <= new_ch.node_count() && "core can not be larger than the graph");
+
+		if (forward_tentative_distance.size() == new_ch.node_count())
+		{
+			ch = &new_ch;
+			core_rank_begin = new_ch.node_count() - core_node_count;
+			reset();
+		}
+		else
+		{
+			*this = CoreContractionHierarchyQuery(new_ch, core_node_count);
+		}
+		return *this;
+	}
+
+	CoreContractionHierarchyQuery &CoreContractionHierarchyQuery::add_source(unsigned external_s, unsigned dist_to_s)
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(external_s < ch->node_count() && "node out of bounds");
+		assert(state == CoreContractionHierarchyQuery::InternalState::initialized || state == CoreContractionHierarchyQuery::InternalState::target_pinned);
+
+		unsigned s = ch->rank[external_s];
+
+		if (!forward_queue.contains_id(s))
+		{
+			forward_queue.push({s, dist_to_s});
+			forward_tentative_distance[s] = dist_to_s;
+			forward_predecessor_node[s] = invalid_id;
+		}
+		else if (dist_to_s < forward_tentative_distance[s])
+		{
+			forward_tentative_distance[s] = dist_to_s;
+			forward_queue.decrease_key({s, dist_to_s});
+		}
+
+		was_forward_pushed.set(s);
+		return *this;
+	}
+
+	CoreContractionHierarchyQuery &CoreContractionHierarchyQuery::add_target(unsigned external_t, unsigned dist_to_t)
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(external_t < ch->node_count() && "node out of bounds");
+		assert(state == CoreContractionHierarchyQuery::InternalState::initialized);
+
+		unsigned t = ch->rank[external_t];
+
+		if (!backward_queue.contains_id(t))
+		{
+			backward_queue.push({t, dist_to_t});
+			backward_tentative_distance[t] = dist_to_t;
+			backward_predecessor_node[t] = invalid_id;
+		}
+		else if (dist_to_t < backward_tentative_distance[t])
+		{
+			backward_tentative_distance[t] = dist_to_t;
+			backward_queue.decrease_key({t, dist_to_t});
+		}
+
+		was_backward_pushed.set(t);
+		return *this;
+	}
+
+	CoreContractionHierarchyQuery &CoreContractionHierarchyQuery::run()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(!forward_queue.empty() && "must add at least one source before calling run");
+		assert(!backward_queue.empty() && "must add at least one target before calling run");
+		assert(state == CoreContractionHierarchyQuery::InternalState::initialized);
+
+		unsigned shortest_path_length = inf_weight;
+		shortest_path_meeting_node = invalid_id;
+
+		bool forward_next = true;
+
+		// Within the core, both searches are plain Dijkstra searches. Each search must therefore run until
+		// its smallest key reaches the shortest path length found so far, just as the upward searches do.
+		for (;;)
+		{
+			bool forward_finished = forward_queue.empty() || forward_queue.peek().key >= shortest_path_length;
+			bool backward_finished = backward_queue.empty() || backward_queue.peek().key >= shortest_path_length;
+
+			if (forward_finished && backward_finished)
+				break;
+
+			if (forward_finished)
+				forward_next = false;
+			if (backward_finished)
+				forward_next = true;
+
+			if (forward_next)
+			{
+				// A core node reached through a core arc always satisfies the stall condition for its
+				// predecessor. Stalling is therefore restricted to the contracted nodes.
+				forward_settle_node(
+					shortest_path_length, shortest_path_meeting_node,
+					ch->forward.first_out, ch->forward.head, ch->forward.weight,
+					ch->backward.first_out, ch->backward.head, ch->backward.weight,
+					was_forward_pushed, was_backward_pushed,
+					forward_queue,
+					forward_tentative_distance, backward_tentative_distance,
+					forward_predecessor_node, forward_predecessor_arc,
+					forward_queue.peek().id < core_rank_begin, settled_node_count, stalled_node_count);
+				forward_next = false;
+			}
+			else
+			{
+				forward_settle_node(
+					shortest_path_length, shortest_path_meeting_node,
+					ch->backward.first_out, ch->backward.head, ch->backward.weight,
+					ch->forward.first_out, ch->forward.head, ch->forward.weight,
+					was_backward_pushed, was_forward_pushed,
+					backward_queue,
+					backward_tentative_distance, forward_tentative_distance,
+					backward_predecessor_node, backward_predecessor_arc,
+					backward_queue.peek().id < core_rank_begin, settled_node_count, stalled_node_count);
+				forward_next = true;
+			}
+		}
+
+		state = CoreContractionHierarchyQuery::InternalState::run;
+		return *this;
+	}
+
+	unsigned CoreContractionHierarchyQuery::get_used_source()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(state == CoreContractionHierarchyQuery::InternalState::run);
+
+		if (shortest_path_meeting_node == invalid_id)
+			return invalid_id;
+		unsigned x = shortest_path_meeting_node;
+		while (forward_predecessor_node[x] != invalid_id)
+			x = forward_predecessor_node[x];
+		return ch->order[x];
+	}
+
+	unsigned CoreContractionHierarchyQuery::get_used_target()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(state == CoreContractionHierarchyQuery::InternalState::run);
+
+		if (shortest_path_meeting_node == invalid_id)
+			return invalid_id;
+		unsigned x = shortest_path_meeting_node;
+		while (backward_predecessor_node[x] != invalid_id)
+			x = backward_predecessor_node[x];
+		return ch->order[x];
+	}
+
+	unsigned CoreContractionHierarchyQuery::get_distance()
+	{
+		assert(state == CoreContractionHierarchyQuery::InternalState::run);
+
+		if (shortest_path_meeting_node == invalid_id)
+			return inf_weight;
+		else
+			return forward_tentative_distance[shortest_path_meeting_node] + backward_tentative_distance[shortest_path_meeting_node];
+	}
+
+	namespace
+	{
+		// The core arcs are unpacked in the same way as the other arcs, as the middle node of a
+		// shortcut is always a contracted node.
+		template <class OnNewInputArc>
+		void unpack_core_ch_path(
+			const ContractionHierarchy &ch, unsigned meeting_node,
+			const std::vector<unsigned> &forward_predecessor_node, const std::vector<CHArcID> &forward_predecessor_arc,
+			const std::vector<unsigned> &backward_predecessor_node, const std::vector<CHArcID> &backward_predecessor_arc,
+			const OnNewInputArc &on_new_input_arc)
+		{
+			std::vector<CHArcID> up_path;
+			for (unsigned x = meeting_node; forward_predecessor_node[x] != invalid_id; x = forward_predecessor_node[x])
+				up_path.push_back(forward_predecessor_arc[x]);
+			for (unsigned i = up_path.size(); i > 0; --i)
+				unpack_forward_arc(ch, up_path[i - 1], on_new_input_arc);
+			for (unsigned x = meeting_node; backward_predecessor_node[x] != invalid_id; x = backward_predecessor_node[x])
+				unpack_backward_arc(ch, backward_predecessor_arc[x], on_new_input_arc);
+		}
+	}
+
+	std::vector<unsigned> CoreContractionHierarchyQuery::get_arc_path()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(state == CoreContractionHierarchyQuery::InternalState::run);
+		throw_if_ch_has_no_path_data(*ch);
+
+		std::vector<unsigned> path;
+		if (shortest_path_meeting_node != invalid_id)
+			unpack_core_ch_path(
+				*ch, shortest_path_meeting_node,
+				forward_predecessor_node, forward_predecessor_arc,
+				backward_predecessor_node, backward_predecessor_arc,
+				[&](unsigned xy, unsigned y)
+				{ path.push_back(xy); });
+		return path; // NVRO
+	}
+
+	std::vector<unsigned> CoreContractionHierarchyQuery::get_node_path()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(state == CoreContractionHierarchyQuery::InternalState::run);
+		throw_if_ch_has_no_path_data(*ch);
+
+		std::vector<unsigned> path;
+		if (shortest_path_meeting_node != invalid_id)
+		{
+			path.push_back(get_used_source());
+			unpack_core_ch_path(
+				*ch, shortest_path_meeting_node,
+				forward_predecessor_node, forward_predecessor_arc,
+				backward_predecessor_node, backward_predecessor_arc,
+				[&](unsigned xy, unsigned y)
+				{ path.push_back(y); });
+		}
+		return path; // NVRO
+	}
+
+	CoreContractionHierarchyQuery &CoreContractionHierarchyQuery::reset_source()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(state == CoreContractionHierarchyQuery::InternalState::target_pinned || state == CoreContractionHierarchyQuery::InternalState::target_run);
+
+		was_forward_pushed.reset_all();
+		forward_queue.clear();
+
+		settled_node_count = 0;
+		stalled_node_count = 0;
+
+		state = CoreContractionHierarchyQuery::InternalState::target_pinned;
+		return *this;
+	}
+
+	CoreContractionHierarchyQuery &CoreContractionHierarchyQuery::pin_targets(const std::vector<unsigned> &external_target_list)
+	{
+		assert(ch && "query object must have an attached CH");
+		assert((external_target_list.empty() || max_element_of(external_target_list) < ch->node_count()) && "node id out of bounds");
+		assert(state == CoreContractionHierarchyQuery::InternalState::initialized);
+
+		target_list.resize(external_target_list.size());
+		for (unsigned i = 0; i < external_target_list.size(); ++i)
+			target_list[i] = ch->rank[external_target_list[i]];
+
+		// The backward search spaces of the targets are collected without a queue, as only the set of
+		// nodes is needed. The search does not enter the core.
+		select_list.clear();
+		was_backward_pushed.reset_all();
+		std::vector<unsigned> stack;
+		for (unsigned t : target_list)
+		{
+			if (t < core_rank_begin && !was_backward_pushed.is_set(t))
+			{
+				was_backward_pushed.set(t);
+				stack.push_back(t);
+			}
+		}
+		while (!stack.empty())
+		{
+			unsigned x = stack.back();
+			stack.pop_back();
+			select_list.push_back(x);
+			for (CHArcID xy = ch->backward.first_out[x]; xy < ch->backward.first_out[x + 1]; ++xy)
+			{
+				unsigned y = ch->backward.head[xy];
+				if (y < core_rank_begin && !was_backward_pushed.is_set(y))
+				{
+					was_backward_pushed.set(y);
+					stack.push_back(y);
+				}
+			}
+		}
+		std::sort(select_list.begin(), select_list.end(), std::greater<unsigned>());
+
+		state = CoreContractionHierarchyQuery::InternalState::target_pinned;
+		return *this;
+	}
+
+	CoreContractionHierarchyQuery &CoreContractionHierarchyQuery::run_to_pinned_targets()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(!forward_queue.empty() && "must add at least one source before calling run");
+		assert(state == CoreContractionHierarchyQuery::InternalState::target_pinned);
+
+		while (!forward_queue.empty())
+		{
+			unsigned popped_node = forward_queue.peek().id;
+			++settled_node_count;
+
+			if (
+				popped_node < core_rank_begin &&
+				forward_can_stall_at_node(
+					popped_node,
+					ch->backward.first_out, ch->backward.head, ch->backward.weight,
+					was_forward_pushed,
+					forward_tentative_distance))
+			{
+				forward_queue.pop();
+				++stalled_node_count;
+				continue;
+			}
+
+			auto p = forward_queue.pop();
+			forward_expand_upward_ch_arcs_of_node(
+				p.id, p.key,
+				ch->forward.first_out, ch->forward.head, ch->forward.weight,
+				was_forward_pushed, forward_queue,
+				forward_tentative_distance,
+				[](unsigned, unsigned, CHArcID) {});
+		}
+
+		// Every backward arc of a selected node leads to a higher ranked selected node or to a core node.
+		// The nodes not reached by the forward search are marked as reached with distance inf_weight.
+		for (unsigned x : select_list)
+		{
+			unsigned d = was_forward_pushed.is_set(x) ? forward_tentative_distance[x] : inf_weight;
+			for (CHArcID xy = ch->backward.first_out[x]; xy < ch->backward.first_out[x + 1]; ++xy)
+			{
+				unsigned y = ch->backward.head[xy];
+				if (was_forward_pushed.is_set(y))
+					d = std::min(d, forward_tentative_distance[y] + ch->backward.weight[xy]);
+			}
+			forward_tentative_distance[x] = d;
+			was_forward_pushed.set(x);
+		}
+
+		state = CoreContractionHierarchyQuery::InternalState::target_run;
+		return *this;
+	}
+
+	CoreContractionHierarchyQuery &CoreContractionHierarchyQuery::get_distances_to_targets(unsigned *dist)
+	{
+		assert(state == CoreContractionHierarchyQuery::InternalState::target_run);
+		for (unsigned i = 0; i < target_list.size(); ++i)
+		{
+			unsigned t = target_list[i];
+			dist[i] = was_forward_pushed.is_set(t) ? forward_tentative_distance[t] : inf_weight;
+		}
+		return *this;
+	}
+
+	std::vector<unsigned> CoreContractionHierarchyQuery::get_distances_to_targets()
+	{
+		assert(state == CoreContractionHierarchyQuery::InternalState::target_run);
+		std::vector<unsigned> dist(target_list.size());
+		get_distances_to_targets(dist.data());
+		return dist; // NVRO
+	}
+
+	CoreContractionHierarchyBreakQuery::CoreContractionHierarchyBreakQuery(
+		const ContractionHierarchy &ch, unsigned core_node_count, const BitVector &is_parking_node,
+		unsigned max_driving_time, unsigned break_duration) : ch(&ch), core_rank_begin(ch.node_count() - core_node_count),
+															  max_driving_time(max_driving_time), break_duration(break_duration),
+															  is_parking_rank(ch.node_count(), false),
+															  source(invalid_id), target(invalid_id),
+															  was_forward_pushed(ch.node_count()), was_backward_pushed(ch.node_count()),
+															  forward_queue(ch.node_count()), backward_queue(ch.node_count()),
+															  forward_tentative_distance(ch.node_count()), backward_tentative_distance(ch.node_count()),
+															  forward_predecessor_node(ch.node_count()), backward_predecessor_node(ch.node_count()),
+															  forward_predecessor_arc(ch.node_count()), backward_predecessor_arc(ch.node_count()),
+															  label_queue(core_node_count), bag(core_node_count),
+															  shortest_path_length(inf_weight), shortest_path_meeting_node(invalid_id), shortest_path_label(invalid_id),
+															  created_label_count(0), pruned_label_count(0), settled_label_count(0),
+															  state(CoreContractionHierarchyBreakQuery::InternalState::initialized)
+	{
+		assert(core_node_count <= ch.node_count() && "core can not be larger than the graph");
+		assert(is_parking_node.size() == ch.node_count() && "parking flags must have the same size as the graph");
+
+		for (unsigned x = 0; x < ch.node_count(); ++x)
+		{
+			if (is_parking_node.is_set(x))
+			{
+				assert(ch.rank[x] >= core_rank_begin && "all parking nodes must be in the core");
+				is_parking_rank.set(ch.rank[x]);
+			}
+		}
+	}
+
+	CoreContractionHierarchyBreakQuery &CoreContractionHierarchyBreakQuery::reset()
+	{
+		assert(ch && "query object must have an attached CH");
+
+		source = invalid_id;
+		target = invalid_id;
+
+		for (unsigned i : nonempty_bag_list)
+			bag[i].clear();
+		nonempty_bag_list.clear();
+		label_list.clear();
+		label_queue.clear();
+
+		created_label_count = 0;
+		pruned_label_count = 0;
+		settled_label_count = 0;
+
+		state = CoreContractionHierarchyBreakQuery::InternalState::initialized;
+		return *this;
+	}
+
+	CoreContractionHierarchyBreakQuery &CoreContractionHierarchyBreakQuery::add_source(unsigned external_s)
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(external_s < ch->node_count() && "node out of bounds");
+		assert(source == invalid_id && "break query supports only one source");
+		source = ch->rank[external_s];
+		return *this;
+	}
+
+	CoreContractionHierarchyBreakQuery &CoreContractionHierarchyBreakQuery::add_target(unsigned external_t)
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(external_t < ch->node_count() && "node out of bounds");
+		assert(target == invalid_id && "break query supports only one target");
+		target = ch->rank[external_t];
+		return *this;
+	}
+
+	namespace
+	{
+		// Runs an upward search from s that settles but does not expand core nodes. Nodes further away
+		// than max_distance are not expanded either. The settled nodes are appended to search_space.
+		template <class Queue>
+		void upward_search_until_core(
+			unsigned s, unsigned core_rank_begin, unsigned max_distance,
+			const std::vector<CHArcID> &up_first_out, const std::vector<unsigned> &up_head, const std::vector<unsigned> &up_weight,
+			const std::vector<CHArcID> &down_first_out, const std::vector<unsigned> &down_head, const std::vector<unsigned> &down_weight,
+			TimestampFlags &was_pushed,
+			Queue &queue,
+			std::vector<unsigned> &tentative_distance,
+			std::vector<unsigned> &predecessor_node, std::vector<CHArcID> &predecessor_arc,
+			std::vector<unsigned> &search_space)
+		{
+			was_pushed.reset_all();
+			queue.clear();
+			search_space.clear();
+
+			queue.push({s, 0});
+			tentative_distance[s] = 0;
+			predecessor_node[s] = invalid_id;
+			was_pushed.set(s);
+
+			while (!queue.empty())
+			{
+				auto p = queue.pop();
+				search_space.push_back(p.id);
+
+				if (p.id >= core_rank_begin || p.key > max_distance)
+					continue;
+
+				if (forward_can_stall_at_node(p.id, down_first_out, down_head, down_weight, was_pushed, tentative_distance))
+					continue;
+
+				forward_expand_upward_ch_arcs_of_node(
+					p.id, p.key,
+					up_first_out, up_head, up_weight,
+					was_pushed, queue,
+					tentative_distance,
+					[&](unsigned x, unsigned pred_node, CHArcID pred_arc)
+					{
+						predecessor_node[x] = pred_node;
+						predecessor_arc[x] = pred_arc;
+					});
+			}
+		}
+	}
+
+	CoreContractionHierarchyBreakQuery &CoreContractionHierarchyBreakQuery::run()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(source != invalid_id && "must add a source before calling run");
+		assert(target != invalid_id && "must add a target before calling run");
+		assert(state == CoreContractionHierarchyBreakQuery::InternalState::initialized);
+
+		shortest_path_length = inf_weight;
+		shortest_path_meeting_node = invalid_id;
+		shortest_path_label = invalid_id;
+
+		upward_search_until_core(
+			source, core_rank_begin, max_driving_time,
+			ch->forward.first_out, ch->forward.head, ch->forward.weight,
+			ch->backward.first_out, ch->backward.head, ch->backward.weight,
+			was_forward_pushed, forward_queue, forward_tentative_distance,
+			forward_predecessor_node, forward_predecessor_arc,
+			forward_search_space);
+
+		upward_search_until_core(
+			target, core_rank_begin, max_driving_time,
+			ch->backward.first_out, ch->backward.head, ch->backward.weight,
+			ch->forward.first_out, ch->forward.head, ch->forward.weight,
+			was_backward_pushed, backward_queue, backward_tentative_distance,
+			backward_predecessor_node, backward_predecessor_arc,
+			backward_search_space);
+
+		// Routes that need no break and do not use a core arc meet in the upward search spaces.
+		for (unsigned x : forward_search_space)
+		{
+			if (was_backward_pushed.is_set(x))
+			{
+				unsigned d = forward_tentative_distance[x] + backward_tentative_distance[x];
+				if (d <= max_driving_time && d < shortest_path_length)
+				{
+					shortest_path_length = d;
+					shortest_path_meeting_node = x;
+				}
+			}
+		}
+
+		auto add_label = [&](unsigned x, unsigned travel_time, unsigned driving_time, unsigned parent_label, CHArcID parent_arc)
+		{
+			++created_label_count;
+
+			const unsigned i = x - core_rank_begin;
+			std::vector<unsigned> &b = bag[i];
+			if (b.empty())
+				nonempty_bag_list.push_back(i);
+
+			for (unsigned l : b)
+			{
+				if (label_list[l].travel_time <= travel_time && label_list[l].driving_time <= driving_time)
+				{
+					++pruned_label_count;
+					return;
+				}
+			}
+
+			for (unsigned j = 0; j < b.size();)
+			{
+				const Label &other = label_list[b[j]];
+				if (travel_time <= other.travel_time && driving_time <= other.driving_time)
+				{
+					++pruned_label_count;
+					b[j] = b.back();
+					b.pop_back();
+				}
+				else
+				{
+					++j;
+				}
+			}
+
+			b.push_back(label_list.size());
+			label_list.push_back({x, travel_time, driving_time, parent_label, parent_arc, false});
+
+			if (!label_queue.contains_id(i))
+				label_queue.push({i, travel_time});
+			else if (travel_time < label_queue.get_key(i))
+				label_queue.decrease_key({i, travel_time});
+		};
+
+		for (unsigned x : forward_search_space)
+			if (x >= core_rank_begin && forward_tentative_distance[x] <= max_driving_time)
+				add_label(x, forward_tentative_distance[x], forward_tentative_distance[x], invalid_id, invalid_ch_arc_id);
+
+		while (!label_queue.empty() && label_queue.peek().key < shortest_path_length)
+		{
+			const unsigned i = label_queue.pop().id;
+			const unsigned x = core_rank_begin + i;
+
+			unsigned l = invalid_id;
+			unsigned next_travel_time = inf_weight;
+			for (unsigned m : bag[i])
+			{
+				if (label_list[m].is_settled)
+					continue;
+				if (l == invalid_id || label_list[m].travel_time < label_list[l].travel_time)
+				{
+					if (l != invalid_id)
+						next_travel_time = std::min(next_travel_time, label_list[l].travel_time);
+					l = m;
+				}
+				else
+				{
+					next_travel_time = std::min(next_travel_time, label_list[m].travel_time);
+				}
+			}
+			if (l == invalid_id)
+				continue;
+			if (next_travel_time != inf_weight)
+				label_queue.push({i, next_travel_time});
+
+			label_list[l].is_settled = true;
+			++settled_label_count;
+
+			// The label is copied, as add_label may reallocate label_list.
+			const Label label = label_list[l];
+
+			if (was_backward_pushed.is_set(x))
+			{
+				unsigned driving_time = label.driving_time + backward_tentative_distance[x];
+				unsigned travel_time = label.travel_time + backward_tentative_distance[x];
+				if (driving_time <= max_driving_time && travel_time < shortest_path_length)
+				{
+					shortest_path_length = travel_time;
+					shortest_path_meeting_node = x;
+					shortest_path_label = l;
+				}
+			}
+
+			if (is_parking_rank.is_set(x) && label.driving_time != 0)
+				add_label(x, label.travel_time + break_duration, 0, l, invalid_ch_arc_id);
+
+			for (CHArcID xy = ch->forward.first_out[x]; xy < ch->forward.first_out[x + 1]; ++xy)
+			{
+				unsigned driving_time = label.driving_time + ch->forward.weight[xy];
+				if (driving_time <= max_driving_time)
+					add_label(ch->forward.head[xy], label.travel_time + ch->forward.weight[xy], driving_time, l, xy);
+			}
+		}
+
+		state = CoreContractionHierarchyBreakQuery::InternalState::run;
+		return *this;
+	}
+
+	unsigned CoreContractionHierarchyBreakQuery::get_distance()
+	{
+		assert(state == CoreContractionHierarchyBreakQuery::InternalState::run);
+		return shortest_path_length;
+	}
+
+	std::vector<unsigned> CoreContractionHierarchyBreakQuery::get_break_nodes()
+	{
+		assert(state == CoreContractionHierarchyBreakQuery::InternalState::run);
+
+		std::vector<unsigned> break_nodes;
+		if (shortest_path_label != invalid_id)
+		{
+			for (unsigned l = shortest_path_label; label_list[l].parent_label != invalid_id; l = label_list[l].parent_label)
+				if (label_list[l].parent_arc == invalid_ch_arc_id)
+					break_nodes.push_back(ch->order[label_list[l].node]);
+			std::reverse(break_nodes.begin(), break_nodes.end());
+		}
+		return break_nodes; // NVRO
+	}
+
+	unsigned CoreContractionHierarchyBreakQuery::get_break_count()
+	{
+		return get_break_nodes().size();
+	}
+
+	namespace
+	{
+		// Calls on_new_input_arc for every input arc of the route. The breaks do not correspond to arcs
+		// and are skipped.
+		template <class OnNewInputArc>
+		void unpack_break_query_path(
+			const ContractionHierarchy &ch, unsigned meeting_node, unsigned last_label,
+			const std::vector<CoreContractionHierarchyBreakQuery::Label> &label_list,
+			const std::vector<unsigned> &forward_predecessor_node, const std::vector<CHArcID> &forward_predecessor_arc,
+			const std::vector<unsigned> &backward_predecessor_node, const std::vector<CHArcID> &backward_predecessor_arc,
+			const OnNewInputArc &on_new_input_arc)
+		{
+			std::vector<unsigned> core_label_path;
+			unsigned core_entry_node = meeting_node;
+			if (last_label != invalid_id)
+			{
+				unsigned l = last_label;
+				for (; label_list[l].parent_label != invalid_id; l = label_list[l].parent_label)
+					core_label_path.push_back(l);
+				core_entry_node = label_list[l].node;
+			}
+
+			std::vector<CHArcID> up_path;
+			for (unsigned x = core_entry_node; forward_predecessor_node[x] != invalid_id; x = forward_predecessor_node[x])
+				up_path.push_back(forward_predecessor_arc[x]);
+			for (unsigned i = up_path.size(); i > 0; --i)
+				unpack_forward_arc(ch, up_path[i - 1], on_new_input_arc);
+
+			for (unsigned i = core_label_path.size(); i > 0; --i)
+			{
+				const auto &label = label_list[core_label_path[i - 1]];
+				if (label.parent_arc != invalid_ch_arc_id)
+					unpack_forward_arc(ch, label.parent_arc, on_new_input_arc);
+			}
+
+			for (unsigned x = meeting_node; backward_predecessor_node[x] != invalid_id; x = backward_predecessor_node[x])
+				unpack_backward_arc(ch, backward_predecessor_arc[x], on_new_input_arc);
+		}
+	}
+
+	std::vector<unsigned> CoreContractionHierarchyBreakQuery::get_arc_path()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(state == CoreContractionHierarchyBreakQuery::InternalState::run);
+		throw_if_ch_has_no_path_data(*ch);
+
+		std::vector<unsigned> path;
+		if (shortest_path_meeting_node != invalid_id)
+			unpack_break_query_path(
+				*ch, shortest_path_meeting_node, shortest_path_label, label_list,
+				forward_predecessor_node, forward_predecessor_arc,
+				backward_predecessor_node, backward_predecessor_arc,
+				[&](unsigned xy, unsigned y)
+				{ path.push_back(xy); });
+		return path; // NVRO
+	}
+
+	std::vector<unsigned> CoreContractionHierarchyBreakQuery::get_node_path()
+	{
+		assert(ch && "query object must have an attached CH");
+		assert(state == CoreContractionHierarchyBreakQuery::InternalState::run);
+		throw_if_ch_has_no_path_data(*ch);
+
+		std::vector<unsigned> path;
+		if (shortest_path_meeting_node != invalid_id)
+		{
+			path.push_back(ch->order[source]);
+			unpack_break_query_path(
+				*ch, shortest_path_meeting_node, shortest_path_label, label_list,
+				forward_predecessor_node, forward_predecessor_arc,
+				backward_predecessor_node, backward_predecessor_arc,
+				[&](unsigned xy, unsigned y)
+				{ path.push_back(y); });
+		}
+		return path; // NVRO
+	}
+
+	template class BasicContractionHierarchyQuery<MinIDQueue>;
+	template class BasicContractionHierarchyQuery<RadixMinIDQueue>;
+
 	template struct ContractionHierarchyExtraWeight<unsigned>;
 	template struct ContractionHierarchyExtraWeight<int>;
 	template ContractionHierarchyQuery &ContractionHierarchyQuery::get_extra_weight_distances_to_targets<std::vector<int>, SaturatedWeightAddition, std::vector<int>, std::vector<int>>(const std::vector<int> &, const SaturatedWeightAddition &, std::vector<int> &, std::vector<int> &);
@@ -8,6 +8,7 @@
 #include <routingkit/graph_util.h>
 #include <routingkit/id_mapper.h>
 #include <routingkit/timer.h>
+#include <routingkit/vector_io.h>
 
 #include "emulate_gcc_builtin.h"
 
@@ -15,6 +16,7 @@
 #include <assert.h>
 #include <algorithm>
 #include <stdexcept>
+#include <string.h>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -22,37 +24,125 @@
 namespace RoutingKit{
 
 namespace{
-	template<class OnNewArc>
-	unsigned compute_chordal_supergraph(unsigned node_count, const std::vector<unsigned>&tail, const std::vector<unsigned>&head, const OnNewArc&on_new_arc){
-		std::vector<std::vector<unsigned>> nodes(node_count);
-		for(unsigned i = 0; i < tail.size(); ++i){
-			if(tail[i] < head[i]) {
-				nodes[tail[i]].push_back(head[i]);
+	// Orders the nodes by their height in the elimination tree, i.e., the number of nodes on the longest
+	// path down to a leaf of their subtree. All nodes in the subtree of a node have a smaller height.
+	void order_nodes_by_elimination_tree_height(
+		const std::vector<unsigned>&elimination_tree_parent,
+		std::vector<unsigned>&node_by_height, std::vector<unsigned>&first_node_of_height
+	){
+		const unsigned node_count = elimination_tree_parent.size();
+		std::vector<unsigned>node_height(node_count, 0);
+		unsigned height_count = 0;
+		for(unsigned x=0; x<node_count; ++x){
+			max_to(height_count, node_height[x]+1);
+			if(elimination_tree_parent[x] != invalid_id)
+				max_to(node_height[elimination_tree_parent[x]], node_height[x]+1);
+		}
+		node_by_height = compute_stable_sort_permutation_using_key(node_height, height_count, [](unsigned x){ return x; });
+		first_node_of_height = invert_vector(apply_permutation(node_by_height, node_height), height_count);
+	}
+
+	// Computes the elimination tree of the chordal supergraph without computing the supergraph.
+	// lower_neighbor[first_lower_neighbor[y]...first_lower_neighbor[y+1]-1] must contain the neighbors
+	// of y with a lower ID. This is Liu's algorithm with path compression.
+	std::vector<unsigned>compute_elimination_tree(unsigned node_count, const std::vector<unsigned>&first_lower_neighbor, const std::vector<unsigned>&lower_neighbor){
+		std::vector<unsigned>parent(node_count, invalid_id);
+		std::vector<unsigned>ancestor(node_count, invalid_id);
+		for(unsigned y=0; y<node_count; ++y){
+			for(unsigned i=first_lower_neighbor[y]; i<first_lower_neighbor[y+1]; ++i){
+				unsigned x = lower_neighbor[i];
+				while(x != invalid_id && x < y){
+					unsigned next = ancestor[x];
+					ancestor[x] = y;
+					if(next == invalid_id)
+						parent[x] = y;
+					x = next;
+				}
 			}
 		}
+		return parent; // NVRO
+	}
 
-		for(unsigned n = 0; n < node_count; ++n){
-			std::sort(nodes[n].begin(), nodes[n].end());
-			auto it = std::unique(nodes[n].begin(), nodes[n].end());
-			nodes[n].resize(std::distance(nodes[n].begin(), it));
+	// Computes the upward neighbors in the chordal supergraph of the graph given by tail and head, if
+	// the nodes are contracted in the order of their IDs. Contracting x adds its upward neighbors to
+	// those of its parent in the elimination tree. As the parent only depends on its children, all
+	// nodes of the same height in the elimination tree are processed in parallel. The returned
+	// neighbors are sorted.
+	unsigned compute_chordal_supergraph(unsigned node_count, const std::vector<unsigned>&tail, const std::vector<unsigned>&head, unsigned thread_count, std::vector<std::vector<unsigned>>&upward_neighbor){
+		(void)thread_count;
+
+		upward_neighbor.clear();
+		upward_neighbor.resize(node_count);
+		for(unsigned i = 0; i < tail.size(); ++i){
+			if(tail[i] < head[i])
+				upward_neighbor[tail[i]].push_back(head[i]);
+			else if(tail[i] > head[i])
+				upward_neighbor[head[i]].push_back(tail[i]);
 		}
 
-		size_t max_upward_degree = 0;
-		for(unsigned n = 0; n < node_count; ++n){
-			if(nodes[n].size() == 0){ continue; }
-			const unsigned lowest_neighbor = nodes[n][0];
-
-			std::vector<unsigned> merged(nodes[n].size() + nodes[lowest_neighbor].size() - 1);
-			std::merge(++nodes[n].begin(), nodes[n].end(), nodes[lowest_neighbor].begin(), nodes[lowest_neighbor].end(), merged.begin());
-			auto it = std::unique(merged.begin(), merged.end());
-			merged.resize(std::distance(merged.begin(), it));
-			nodes[lowest_neighbor] = std::move(merged);
-
-			for(unsigned neighbor : nodes[n]){
-				on_new_arc(n, neighbor);
+		#ifdef _OPENMP
+		#pragma omp parallel for num_threads(thread_count) schedule(dynamic,1024) if(thread_count > 1)
+		#endif
+		for(unsigned x = 0; x < node_count; ++x){
+			std::sort(upward_neighbor[x].begin(), upward_neighbor[x].end());
+			upward_neighbor[x].erase(std::unique(upward_neighbor[x].begin(), upward_neighbor[x].end()), upward_neighbor[x].end());
+		}
+
+		std::vector<unsigned>parent;
+		{
+			std::vector<unsigned>first_lower_neighbor(node_count+1, 0);
+			for(unsigned x = 0; x < node_count; ++x)
+				for(unsigned y:upward_neighbor[x])
+					++first_lower_neighbor[y+1];
+			for(unsigned y = 0; y < node_count; ++y)
+				first_lower_neighbor[y+1] += first_lower_neighbor[y];
+			std::vector<unsigned>lower_neighbor(first_lower_neighbor.back());
+			std::vector<unsigned>next_lower_neighbor(first_lower_neighbor.begin(), first_lower_neighbor.end()-1);
+			for(unsigned x = 0; x < node_count; ++x)
+				for(unsigned y:upward_neighbor[x])
+					lower_neighbor[next_lower_neighbor[y]++] = x;
+			parent = compute_elimination_tree(node_count, first_lower_neighbor, lower_neighbor);
+		}
+
+		std::vector<unsigned>node_by_height, first_node_of_height;
+		order_nodes_by_elimination_tree_height(parent, node_by_height, first_node_of_height);
+		const unsigned height_count = first_node_of_height.size()-1;
+
+		std::vector<unsigned>first_child(node_count+1, 0);
+		for(unsigned x = 0; x < node_count; ++x)
+			if(parent[x] != invalid_id)
+				++first_child[parent[x]+1];
+		for(unsigned x = 0; x < node_count; ++x)
+			first_child[x+1] += first_child[x];
+		std::vector<unsigned>child(first_child.back());
+		{
+			std::vector<unsigned>next_child(first_child.begin(), first_child.end()-1);
+			for(unsigned x = 0; x < node_count; ++x)
+				if(parent[x] != invalid_id)
+					child[next_child[parent[x]]++] = x;
+		}
+
+		for(unsigned h = 1; h < height_count; ++h){
+			#ifdef _OPENMP
+			#pragma omp parallel for num_threads(thread_count) schedule(dynamic,16) if(thread_count > 1)
+			#endif
+			for(unsigned i = first_node_of_height[h]; i < first_node_of_height[h+1]; ++i){
+				const unsigned y = node_by_height[i];
+				for(unsigned j = first_child[y]; j < first_child[y+1]; ++j){
+					const std::vector<unsigned>&child_neighbor = upward_neighbor[child[j]];
+					assert(child_neighbor.front() == y);
+
+					std::vector<unsigned> merged(upward_neighbor[y].size() + child_neighbor.size() - 1);
+					std::merge(upward_neighbor[y].begin(), upward_neighbor[y].end(), child_neighbor.begin()+1, child_neighbor.end(), merged.begin());
+					merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+					upward_neighbor[y] = std::move(merged);
+				}
 			}
-			max_to(max_upward_degree, nodes[n].size());
 		}
+
+		size_t max_upward_degree = 0;
+		for(unsigned x = 0; x < node_count; ++x)
+			max_to(max_upward_degree, upward_neighbor[x].size());
 		return max_upward_degree;
 	}
 
@@ -198,10 +288,16 @@ CustomizableContractionHierarchy::CustomizableContractionHierarchy(
 	std::vector<unsigned>input_tail,
 	std::vector<unsigned>input_head,
 	std::function<void(const std::string&)>log_message,
-	bool filter_always_inf_arcs
+	bool filter_always_inf_arcs,
+	unsigned thread_count
 ):
 	order(std::move(arg_order))
 {
+	assert(thread_count != 0);
+	#ifndef _OPENMP
+	thread_count = 1;
+	#endif
+
 	unsigned node_count = order.size();
 	unsigned input_arc_count = input_tail.size();
 
@@ -214,48 +310,25 @@ CustomizableContractionHierarchy::CustomizableContractionHierarchy(
 
 	rank = invert_permutation(order);
 
-	#ifndef NDEBUG
-	std::vector<unsigned> raw_input_tail = input_tail;
-	std::vector<unsigned> raw_input_head = input_head;
-	#endif
-
-
 	if(log_message){
 		log_message("Start reordering nodes according to order");
 		timer = -get_micro_time();
 	}
 
-	input_tail = apply_permutation_to_elements_of(rank, std::move(input_tail));
-	input_head = apply_permutation_to_elements_of(rank, std::move(input_head));
-
-	if(log_message){
-		timer += get_micro_time();
-		log_message("Finished reordering nodes, needed "+std::to_string(timer)+"musec");
-	}
-
-	std::vector<unsigned>input_arc_id;
-
-	if(log_message){
-		log_message("Start sorting arcs");
-		timer = -get_micro_time();
-	}
-
-	{
-		input_arc_id = compute_sort_permutation_first_by_tail_then_by_head_and_apply_sort_to_tail(node_count, input_tail, input_head);
-		input_head = apply_permutation(input_arc_id, input_head);
+	assert(input_head.size() == input_arc_count);
+	#ifdef _OPENMP
+	#pragma omp parallel for num_threads(thread_count) if(thread_count > 1)
+	#endif
+	for(unsigned input_arc=0; input_arc<input_arc_count; ++input_arc){
+		assert(input_tail[input_arc] < node_count && input_head[input_arc] < node_count);
+		input_tail[input_arc] = rank[input_tail[input_arc]];
+		input_head[input_arc] = rank[input_head[input_arc]];
 	}
 
 	if(log_message){
 		timer += get_micro_time();
-		log_message("Finished sorting arcs, needed "+std::to_string(timer)+"musec");
-	}
-
-	#ifndef NDEBUG
-	for(unsigned input_arc=0; input_arc<input_arc_count; ++input_arc){
-		assert(rank[raw_input_head[input_arc_id[input_arc]]] == input_head[input_arc]);
-		assert(rank[raw_input_tail[input_arc_id[input_arc]]] == input_tail[input_arc]);
+		log_message("Finished reordering nodes, needed "+std::to_string(timer)+"musec");
 	}
-	#endif
 
 	// Compute up graph
 
@@ -264,54 +337,38 @@ CustomizableContractionHierarchy::CustomizableContractionHierarchy(
 		timer = -get_micro_time();
 	}
 	{
-		// Make graph symmetric & remove multi edges
-		std::vector<unsigned>symmetric_tail(2*input_arc_count);
-		std::vector<unsigned>symmetric_head(2*input_arc_count);
-		std::copy(input_tail.begin(), input_tail.end(), symmetric_tail.begin());
-		std::copy(input_head.begin(), input_head.end(), symmetric_head.begin());
-		std::copy(input_tail.begin(), input_tail.end(), symmetric_head.begin()+input_arc_count);
-		std::copy(input_head.begin(), input_head.end(), symmetric_tail.begin()+input_arc_count);
-
-		{
-			auto p = compute_inverse_sort_permutation_first_by_tail_then_by_head_and_apply_sort_to_tail(node_count, symmetric_tail, symmetric_head);
-			symmetric_head = apply_inverse_permutation(p, std::move(symmetric_head));
-		}
-
-		BitVector filter(2*input_arc_count, BitVector::uninitialized);
-		if(input_arc_count != 0)
-			filter.set(0, symmetric_tail[0] != symmetric_head[0]);
-		for(unsigned i=1; i<2*input_arc_count; ++i)
-			filter.set(i, (symmetric_head[i] != symmetric_head[i-1] || symmetric_tail[i] != symmetric_tail[i-1]) && (symmetric_tail[i] != symmetric_head[i]));
-
-		inplace_keep_element_of_vector_if(filter, symmetric_tail);
-		inplace_keep_element_of_vector_if(filter, symmetric_head);
-
-		unsigned upper_treewidth_bound = compute_chordal_supergraph(
-			node_count, symmetric_tail, symmetric_head,
-			[&](unsigned x, unsigned y){
-				if(up_tail.size() == invalid_id){
-					if(log_message)
-						log_message("CCH Construction aborted because chordal supergraph contains 2^32 or more arcs");
-					throw std::runtime_error("CCH must contain at most 2^32-1 arcs");
-				}
-				up_tail.push_back(x);
-				up_head.push_back(y);
-			}
-		);
+		std::vector<std::vector<unsigned>>upward_neighbor;
+		unsigned upper_treewidth_bound = compute_chordal_supergraph(node_count, input_tail, input_head, thread_count, upward_neighbor);
 
 		if(log_message){
 			log_message("The treewidth of the input graph is bounded by "+std::to_string(upper_treewidth_bound));
 		}
 
-		up_head.shrink_to_fit();
-		up_tail.shrink_to_fit();
-
-		{
-			auto p = compute_inverse_sort_permutation_first_by_tail_then_by_head_and_apply_sort_to_tail(node_count, up_tail, up_head);
-			up_head = apply_inverse_permutation(p, up_head);
+		// The up arcs are ordered by tail and then by head, as the neighbors are sorted.
+		up_first_out.resize(node_count+1);
+		up_first_out[0] = 0;
+		unsigned long long arc_count = 0;
+		for(unsigned x=0; x<node_count; ++x){
+			arc_count += upward_neighbor[x].size();
+			if(arc_count >= invalid_id){
+				if(log_message)
+					log_message("CCH Construction aborted because chordal supergraph contains 2^32 or more arcs");
+				throw std::runtime_error("CCH must contain at most 2^32-1 arcs");
+			}
+			up_first_out[x+1] = arc_count;
 		}
 
-		up_first_out = invert_vector(up_tail, node_count);
+		up_tail.resize(arc_count);
+		up_head.resize(arc_count);
+
+		#ifdef _OPENMP
+		#pragma omp parallel for num_threads(thread_count) schedule(dynamic,1024) if(thread_count > 1)
+		#endif
+		for(unsigned x=0; x<node_count; ++x){
+			std::fill(up_tail.begin()+up_first_out[x], up_tail.begin()+up_first_out[x+1], x);
+			std::copy(upward_neighbor[x].begin(), upward_neighbor[x].end(), up_head.begin()+up_first_out[x]);
+			std::vector<unsigned>().swap(upward_neighbor[x]);
+		}
 	}
 
 	unsigned cch_arc_count = up_tail.size();
@@ -329,52 +386,31 @@ CustomizableContractionHierarchy::CustomizableContractionHierarchy(
 		timer = -get_micro_time();
 	}
 
-	if(cch_arc_count == 0){
-		input_arc_to_cch_arc.resize(input_arc_count, invalid_id);
-		is_input_arc_upward.resize(input_arc_count, false);
-	}else{
-		input_arc_to_cch_arc.resize(input_arc_count);
-		is_input_arc_upward.resize(input_arc_count, false);
-
-		{
-			unsigned cch_up_arc = 0;
-			for(unsigned input_arc=0; input_arc<input_arc_count; ++input_arc){
-				if(input_tail[input_arc] < input_head[input_arc]){
-					while(input_tail[input_arc] != up_tail[cch_up_arc] || input_head[input_arc] != up_head[cch_up_arc]){
-						assert(cch_up_arc < cch_arc_count);
-						++cch_up_arc;
-					}
-					assert(input_tail[input_arc] == up_tail[cch_up_arc]);
-					assert(input_head[input_arc] == up_head[cch_up_arc]);
-					input_arc_to_cch_arc[input_arc_id[input_arc]] = cch_up_arc;
-					is_input_arc_upward.set(input_arc_id[input_arc]);
-				}else if(input_tail[input_arc] == input_head[input_arc]){
-					input_arc_to_cch_arc[input_arc_id[input_arc]] = invalid_id; // input arc is a loop
-				}
-			}
-		}
-
-		{
-			std::swap(input_tail, input_head);
-			auto p = compute_inverse_sort_permutation_first_by_tail_then_by_head_and_apply_sort_to_tail(node_count, input_tail, input_head);
-			input_head = apply_inverse_permutation(p, input_head);
-			input_arc_id = apply_inverse_permutation(p, input_arc_id);
-		}
+	input_arc_to_cch_arc.resize(input_arc_count);
+	is_input_arc_upward.resize(input_arc_count, false);
 
-		{
-			unsigned cch_up_arc = 0;
-			for(unsigned input_arc=0; input_arc<input_arc_count; ++input_arc){
-				if(input_tail[input_arc] < input_head[input_arc]){
-					while(input_tail[input_arc] != up_tail[cch_up_arc] || input_head[input_arc] != up_head[cch_up_arc]){
-						assert(cch_up_arc < cch_arc_count);
-						++cch_up_arc;
-					}
-					input_arc_to_cch_arc[input_arc_id[input_arc]] = cch_up_arc;
-				}
-			}
+	// The CCH arc of a non-loop input arc is found by a binary search among the up arcs of its lower end.
+	#ifdef _OPENMP
+	#pragma omp parallel for num_threads(thread_count) if(thread_count > 1)
+	#endif
+	for(unsigned input_arc=0; input_arc<input_arc_count; ++input_arc){
+		unsigned x = input_tail[input_arc];
+		unsigned y = input_head[input_arc];
+		if(x == y){
+			input_arc_to_cch_arc[input_arc] = invalid_id; // input arc is a loop
+		}else{
+			if(x > y)
+				std::swap(x, y);
+			auto pos = std::lower_bound(up_head.begin()+up_first_out[x], up_head.begin()+up_first_out[x+1], y);
+			assert(pos != up_head.begin()+up_first_out[x+1] && *pos == y);
+			input_arc_to_cch_arc[input_arc] = pos - up_head.begin();
 		}
 	}
 
+	for(unsigned input_arc=0; input_arc<input_arc_count; ++input_arc)
+		if(input_tail[input_arc] < input_head[input_arc])
+			is_input_arc_upward.set(input_arc);
+
 	if(log_message){
 		timer += get_micro_time();
 		log_message("Finished computing mapping, needed "+std::to_string(timer)+"musec");
@@ -462,7 +498,9 @@ CustomizableContractionHierarchy::CustomizableContractionHierarchy(
 		assert(down_head.empty());
 		assert(does_cch_arc_have_extra_input_arc.empty());
 
-		BitVector
+		// One byte per arc instead of a BitVector, so that threads can set flags of different arcs
+		// concurrently.
+		std::vector<unsigned char>
 			can_forward_weight_be_non_inf(cch_arc_count, false),
 			can_backward_weight_be_non_inf(cch_arc_count, false);
 
@@ -470,43 +508,60 @@ CustomizableContractionHierarchy::CustomizableContractionHierarchy(
 			unsigned cch_arc=input_arc_to_cch_arc[input_arc];
 			if(cch_arc != invalid_id){
 				if(is_input_arc_upward.is_set(input_arc))
-					can_forward_weight_be_non_inf.set(cch_arc);
+					can_forward_weight_be_non_inf[cch_arc] = true;
 				else
-					can_backward_weight_be_non_inf.set(cch_arc);
+					can_backward_weight_be_non_inf[cch_arc] = true;
 			}
 		}
 
+		// The flags of the top arc of a triangle only depend on arcs with a lower tail. All nodes with
+		// the same height in the elimination tree can therefore be processed in parallel.
+		std::vector<unsigned>node_by_height, first_node_of_height;
+		order_nodes_by_elimination_tree_height(elimination_tree_parent, node_by_height, first_node_of_height);
+		const unsigned height_count = first_node_of_height.size()-1;
 
 		unsigned long long triangle_count = 0;
 
-		for(unsigned a=0; a<cch_arc_count; ++a){
-			forall_upper_triangles_of_arc(
-				*this, a,
-				[&](
-					unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
-					unsigned bottom_node, unsigned mid_node, unsigned top_node
-				){
-					(void) bottom_node; (void) mid_node; (void) top_node;
-
-					// TODO: Micro-optimizing this code could decrease 1% to 10% of the whole CCH build process.
-
-					if(!can_forward_weight_be_non_inf.is_set(top_arc)){
-						if(can_backward_weight_be_non_inf.is_set(bottom_arc) && can_forward_weight_be_non_inf.is_set(mid_arc))
-							can_forward_weight_be_non_inf.set(top_arc);
-					}
+		for(unsigned h=0; h<height_count; ++h){
+			#ifdef _OPENMP
+			#pragma omp parallel for num_threads(thread_count) schedule(dynamic,16) reduction(+:triangle_count) if(thread_count > 1)
+			#endif
+			for(unsigned i=first_node_of_height[h]; i<first_node_of_height[h+1]; ++i){
+				const unsigned x = node_by_height[i];
+				for(unsigned a=up_first_out[x]; a<up_first_out[x+1]; ++a){
+					forall_upper_triangles_of_arc(
+						*this, x, up_head[a], a,
+						[&](
+							unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
+							unsigned bottom_node, unsigned mid_node, unsigned top_node
+						){
+							(void) bottom_node; (void) mid_node; (void) top_node;
+
+							// The bottom and mid arcs start at x and are final. The top arc is shared
+							// with the triangles of other nodes of the same height, which may set its
+							// flags concurrently. Flags are only ever set, so relaxed accesses suffice.
+							if(!__atomic_load_n(&can_forward_weight_be_non_inf[top_arc], __ATOMIC_RELAXED)){
+								if(can_backward_weight_be_non_inf[bottom_arc] && can_forward_weight_be_non_inf[mid_arc])
+									__atomic_store_n(&can_forward_weight_be_non_inf[top_arc], (unsigned char)true, __ATOMIC_RELAXED);
+							}
 
-					if(!can_backward_weight_be_non_inf.is_set(top_arc)){
-						if(can_forward_weight_be_non_inf.is_set(bottom_arc) && can_backward_weight_be_non_inf.is_set(mid_arc))
-							can_backward_weight_be_non_inf.set(top_arc);
-					}
+							if(!__atomic_load_n(&can_backward_weight_be_non_inf[top_arc], __ATOMIC_RELAXED)){
+								if(can_forward_weight_be_non_inf[bottom_arc] && can_backward_weight_be_non_inf[mid_arc])
+									__atomic_store_n(&can_backward_weight_be_non_inf[top_arc], (unsigned char)true, __ATOMIC_RELAXED);
+							}
 
-					++triangle_count;
-					return true;
+							++triangle_count;
+							return true;
+						}
+					);
 				}
-			);
+			}
 		}
 
-		BitVector must_keep_arc = can_forward_weight_be_non_inf | can_backward_weight_be_non_inf;
+		BitVector must_keep_arc(cch_arc_count, false);
+		for(unsigned a=0; a<cch_arc_count; ++a)
+			if(can_forward_weight_be_non_inf[a] || can_backward_weight_be_non_inf[a])
+				must_keep_arc.set(a);
 
 		up_head = keep_element_of_vector_if(must_keep_arc, std::move(up_head));
 		up_tail = keep_element_of_vector_if(must_keep_arc, std::move(up_tail));
@@ -532,15 +587,24 @@ CustomizableContractionHierarchy::CustomizableContractionHierarchy(
 		timer = -get_micro_time();
 	}
 
-	// compute down graph
-	auto down_tail = up_head;
-	down_head = up_tail;
-
+	// compute down graph using a counting sort by head. As the up arcs are ordered by tail, the down
+	// arcs of a node are ordered by their head.
 	{
-		down_to_up = compute_sort_permutation_first_by_tail_then_by_head_and_apply_sort_to_tail(node_count, down_tail, down_head);
-		down_head = apply_permutation(down_to_up, std::move(down_head));
+		down_first_out.assign(node_count+1, 0);
+		for(unsigned xy=0; xy<cch_arc_count; ++xy)
+			++down_first_out[up_head[xy]+1];
+		for(unsigned y=0; y<node_count; ++y)
+			down_first_out[y+1] += down_first_out[y];
+
+		down_head.resize(cch_arc_count);
+		down_to_up.resize(cch_arc_count);
+		std::vector<unsigned>next_down_arc(down_first_out.begin(), down_first_out.end()-1);
+		for(unsigned xy=0; xy<cch_arc_count; ++xy){
+			unsigned yx = next_down_arc[up_head[xy]]++;
+			down_head[yx] = up_tail[xy];
+			down_to_up[yx] = xy;
+		}
 	}
-	down_first_out = invert_vector(down_tail, node_count);
 
 	if(log_message){
 		timer += get_micro_time();
@@ -654,6 +718,192 @@ CustomizableContractionHierarchy::CustomizableContractionHierarchy(
 //		forall_lower_triangles_of_arc(*this, a, TriangleVerifier(*this));
 }
 
+namespace{
+	const unsigned long long cch_magic_number = 0x4343484669726172ull;
+	const unsigned long long cch_metric_magic_number = 0x434348576569676bull;
+
+	// Increase if the layout of the files changes.
+	const unsigned cch_file_version = 1;
+
+	// The header size is a multiple of 8 and the bit vectors come first, as their size is a multiple
+	// of 64 bytes. Every array in the file is therefore aligned to its element size.
+	struct CCHFileHeader{
+		unsigned long long magic_number;
+		unsigned version;
+		unsigned node_count;
+		unsigned input_arc_count;
+		unsigned cch_arc_count;
+		unsigned cch_arc_with_input_arc_count;
+		unsigned cch_arc_with_extra_input_arc_count;
+		unsigned extra_forward_input_arc_count;
+		unsigned extra_backward_input_arc_count;
+	};
+
+	struct CCHMetricFileHeader{
+		unsigned long long magic_number;
+		unsigned version;
+		unsigned node_count;
+		unsigned input_arc_count;
+		unsigned cch_arc_count;
+	};
+
+	unsigned long long get_bit_vector_file_size(unsigned long long bit_count){
+		return ((bit_count + 511) / 512) * 64;
+	}
+
+	unsigned long long get_expected_file_size(CCHFileHeader header){
+		return
+			sizeof(CCHFileHeader) +
+			get_bit_vector_file_size(header.input_arc_count) +
+			2*get_bit_vector_file_size(header.cch_arc_count) +
+			sizeof(unsigned) * (
+				4*(unsigned long long)header.node_count + 2 +
+				3*(unsigned long long)header.cch_arc_count +
+				header.input_arc_count +
+				2*(unsigned long long)header.cch_arc_with_input_arc_count +
+				2*(unsigned long long)header.cch_arc_with_extra_input_arc_count + 2 +
+				header.extra_forward_input_arc_count +
+				header.extra_backward_input_arc_count
+			);
+	}
+
+	unsigned long long get_expected_file_size(CCHMetricFileHeader header){
+		return sizeof(CCHMetricFileHeader) + 2*sizeof(unsigned)*(unsigned long long)header.cch_arc_count;
+	}
+
+	void check_version(unsigned long long magic_number, unsigned long long expected_magic_number, unsigned version, const std::string&what){
+		if(magic_number != expected_magic_number)
+			throw std::runtime_error(what+" file magic number broken. Is this really a "+what+" file?");
+		if(version != cch_file_version)
+			throw std::runtime_error(what+" file has version "+std::to_string(version)+" but this version of RoutingKit can only read version "+std::to_string(cch_file_version)+".");
+	}
+}
+
+CustomizableContractionHierarchy CustomizableContractionHierarchy::read(std::function<void(char*, unsigned long long)>in, unsigned long long file_size){
+	CCHFileHeader header = read_value<CCHFileHeader>(in);
+	check_version(header.magic_number, cch_magic_number, header.version, "CCH");
+	if(get_expected_file_size(header) != file_size)
+		throw std::runtime_error("CCH file has a different size than specified in the header. This file is corrupt.");
+
+	CustomizableContractionHierarchy cch;
+
+	cch.is_input_arc_upward = read_bit_vector(in, header.input_arc_count);
+	cch.does_cch_arc_have_input_arc = read_bit_vector(in, header.cch_arc_count);
+	cch.does_cch_arc_have_extra_input_arc = read_bit_vector(in, header.cch_arc_count);
+
+	cch.order = read_vector<unsigned>(in, header.node_count);
+	cch.elimination_tree_parent = read_vector<unsigned>(in, header.node_count);
+
+	cch.up_first_out = read_vector<unsigned>(in, header.node_count+1);
+	cch.up_head = read_vector<unsigned>(in, header.cch_arc_count);
+
+	cch.down_first_out = read_vector<unsigned>(in, header.node_count+1);
+	cch.down_head = read_vector<unsigned>(in, header.cch_arc_count);
+	cch.down_to_up = read_vector<unsigned>(in, header.cch_arc_count);
+
+	cch.input_arc_to_cch_arc = read_vector<unsigned>(in, header.input_arc_count);
+
+	cch.forward_input_arc_of_cch = read_vector<unsigned>(in, header.cch_arc_with_input_arc_count);
+	cch.backward_input_arc_of_cch = read_vector<unsigned>(in, header.cch_arc_with_input_arc_count);
+
+	cch.first_extra_forward_input_arc_of_cch = read_vector<unsigned>(in, header.cch_arc_with_extra_input_arc_count+1);
+	cch.first_extra_backward_input_arc_of_cch = read_vector<unsigned>(in, header.cch_arc_with_extra_input_arc_count+1);
+
+	cch.extra_forward_input_arc_of_cch = read_vector<unsigned>(in, header.extra_forward_input_arc_count);
+	cch.extra_backward_input_arc_of_cch = read_vector<unsigned>(in, header.extra_backward_input_arc_count);
+
+	// The remaining members are computed in linear time from the data in the file.
+
+	if(!is_permutation(cch.order))
+		throw std::runtime_error("The order in the CCH file is not a permutation. This file is corrupt.");
+	cch.rank = invert_permutation(cch.order);
+
+	if(cch.up_first_out.front() != 0 || cch.up_first_out.back() != header.cch_arc_count || !std::is_sorted(cch.up_first_out.begin(), cch.up_first_out.end()))
+		throw std::runtime_error("The upward arcs in the CCH file are broken. This file is corrupt.");
+	cch.up_tail = invert_inverse_vector(cch.up_first_out);
+
+	cch.does_cch_arc_have_input_arc_mapper = LocalIDMapper(cch.does_cch_arc_have_input_arc);
+	cch.does_cch_arc_have_extra_input_arc_mapper = LocalIDMapper(cch.does_cch_arc_have_extra_input_arc);
+
+	if(cch.does_cch_arc_have_input_arc_mapper.local_id_count() != header.cch_arc_with_input_arc_count)
+		throw std::runtime_error("The number of CCH arcs with input arcs does not match the header. This file is corrupt.");
+	if(cch.does_cch_arc_have_extra_input_arc_mapper.local_id_count() != header.cch_arc_with_extra_input_arc_count)
+		throw std::runtime_error("The number of CCH arcs with extra input arcs does not match the header. This file is corrupt.");
+
+	return cch; // NVRO
+}
+
+void CustomizableContractionHierarchy::write(std::function<void(const char*, unsigned long long)>out)const{
+	CCHFileHeader header = {};
+	header.magic_number = cch_magic_number;
+	header.version = cch_file_version;
+	header.node_count = node_count();
+	header.input_arc_count = input_arc_count();
+	header.cch_arc_count = cch_arc_count();
+	header.cch_arc_with_input_arc_count = forward_input_arc_of_cch.size();
+	header.cch_arc_with_extra_input_arc_count = first_extra_forward_input_arc_of_cch.size()-1;
+	header.extra_forward_input_arc_count = extra_forward_input_arc_of_cch.size();
+	header.extra_backward_input_arc_count = extra_backward_input_arc_of_cch.size();
+
+	write_value(out, header);
+
+	write_bit_vector(out, is_input_arc_upward);
+	write_bit_vector(out, does_cch_arc_have_input_arc);
+	write_bit_vector(out, does_cch_arc_have_extra_input_arc);
+
+	write_vector(out, order);
+	write_vector(out, elimination_tree_parent);
+
+	write_vector(out, up_first_out);
+	write_vector(out, up_head);
+
+	write_vector(out, down_first_out);
+	write_vector(out, down_head);
+	write_vector(out, down_to_up);
+
+	write_vector(out, input_arc_to_cch_arc);
+
+	write_vector(out, forward_input_arc_of_cch);
+	write_vector(out, backward_input_arc_of_cch);
+
+	write_vector(out, first_extra_forward_input_arc_of_cch);
+	write_vector(out, first_extra_backward_input_arc_of_cch);
+
+	write_vector(out, extra_forward_input_arc_of_cch);
+	write_vector(out, extra_backward_input_arc_of_cch);
+}
+
+CustomizableContractionHierarchy CustomizableContractionHierarchy::load_file(const std::string&file_name){
+	CustomizableContractionHierarchy cch;
+	open_file_for_loading(
+		file_name,
+		[&](std::istream&in, unsigned long long file_size){
+			cch = read(
+				[&](char*p, unsigned long long l){
+					if(!in.read(p, l))
+						throw std::runtime_error("std::istream::read failed while reading a CCH");
+				},
+				file_size
+			);
+		}
+	);
+	return cch; // NVRO
+}
+
+void CustomizableContractionHierarchy::save_file(const std::string&file_name)const{
+	open_file_for_saving(
+		file_name,
+		[&](std::ostream&out){
+			write(
+				[&](const char*p, unsigned long long l){
+					if(!out.write(p, l))
+						throw std::runtime_error("std::ostream::write failed while writing a CCH");
+				}
+			);
+		}
+	);
+}
+
 namespace{
 
 	void extract_initial_metric_of_cch_arc(const CustomizableContractionHierarchy&cch, CustomizableContractionHierarchyMetric&metric, unsigned cch_arc){
@@ -730,6 +980,123 @@ namespace{
 		CustomizableContractionHierarchyMetric*metric;
 	};
 	#endif
+
+	// Number of triangles relaxed at once by relax_lower_triangles_of_node. With GCC extensions, the
+	// lanes are mapped onto one SIMD register of the target architecture. Otherwise, the loops over the
+	// lanes have a fixed length and no branches, so that the compiler can vectorize them.
+	const unsigned triangle_lane_count = 8;
+
+	#ifndef ROUTING_KIT_NO_GCC_EXTENSIONS
+	typedef unsigned v8_unsigned __attribute__((vector_size(triangle_lane_count*sizeof(unsigned))));
+	#endif
+
+	// dst[l] = min(dst[l], x + src[l]) for all lanes l.
+	inline void relax_triangle_lanes(unsigned*__restrict__ dst, unsigned x, const unsigned*__restrict__ src){
+		#ifndef ROUTING_KIT_NO_GCC_EXTENSIONS
+		v8_unsigned d, s;
+		memcpy(&d, dst, sizeof(d));
+		memcpy(&s, src, sizeof(s));
+		s += x;
+		d = s < d ? s : d;
+		memcpy(dst, &d, sizeof(d));
+		#else
+		for(unsigned l=0; l<triangle_lane_count; ++l){
+			const unsigned t = x + src[l];
+			dst[l] = t < dst[l] ? t : dst[l];
+		}
+		#endif
+	}
+
+	// Relaxes all lower triangles {y,x,z} of the up arcs xz of x. The up arcs of the down neighbors y of x
+	// must be final. arc_id_cache[z] must be xz for every up neighbor z of x. Other entries must not be
+	// up arcs of x.
+	//
+	// Unless always-inf arcs were filtered, the CCH is chordal and the up neighbors z>x of y are a subset
+	// of the up neighbors of x. Mostly, consecutive up arcs yz map then onto consecutive up arcs xz. Such a
+	// run is detected by comparing the heads of triangle_lane_count arcs and is relaxed without looking
+	// up the arc IDs.
+	void relax_lower_triangles_of_node(
+		const CustomizableContractionHierarchy&cch,
+		unsigned*__restrict__ forward, unsigned*__restrict__ backward,
+		const unsigned*arc_id_cache, unsigned x
+	){
+		const unsigned*up_head = cch.up_head.data();
+		const unsigned xz_up_begin = cch.up_first_out[x];
+		const unsigned xz_up_end = cch.up_first_out[x+1];
+
+		const unsigned xy_down_end = cch.down_first_out[x+1];
+		for(unsigned xy_down = cch.down_first_out[x]; xy_down < xy_down_end; ++xy_down){
+			const unsigned yx_up = cch.down_to_up[xy_down];
+			const unsigned y = cch.down_head[xy_down];
+			const unsigned yx_forward = forward[yx_up];
+			const unsigned yx_backward = backward[yx_up];
+
+			const unsigned yz_up_end = cch.up_first_out[y+1];
+			unsigned yz_up = yx_up+1;
+			while(yz_up != yz_up_end){
+				const unsigned xz_up = arc_id_cache[up_head[yz_up]];
+				if(xz_up - xz_up_begin >= xz_up_end - xz_up_begin){
+					// xz was filtered, i.e., the triangle cannot improve anything
+					++yz_up;
+					continue;
+				}
+
+				if(
+					yz_up_end - yz_up >= triangle_lane_count && xz_up_end - xz_up >= triangle_lane_count &&
+					memcmp(up_head+xz_up, up_head+yz_up, triangle_lane_count*sizeof(unsigned)) == 0
+				){
+					relax_triangle_lanes(forward+xz_up, yx_backward, forward+yz_up);
+					relax_triangle_lanes(backward+xz_up, yx_forward, backward+yz_up);
+					yz_up += triangle_lane_count;
+				}else{
+					// Relax the arcs up to the first one that does not belong to the run.
+					unsigned l = 0;
+					do{
+						min_to(forward[xz_up+l], yx_backward + forward[yz_up+l]);
+						min_to(backward[xz_up+l], yx_forward + backward[yz_up+l]);
+						++l;
+					}while(
+						l < triangle_lane_count && yz_up+l != yz_up_end && xz_up+l != xz_up_end &&
+						up_head[xz_up+l] == up_head[yz_up+l]
+					);
+					yz_up += l;
+				}
+			}
+		}
+	}
+
+	// Calls on_run(yx, yz, xz, length) for all maximal runs of lower triangles {y,x,z} with the arcs yx,
+	// yz+l and xz+l for all l < length. The runs are found as in relax_lower_triangles_of_node, except
+	// that arc_id_cache is filled here.
+	template<class F>
+	void forall_lower_triangle_runs_of_node(const CustomizableContractionHierarchy&cch, unsigned*arc_id_cache, unsigned x, const F&on_run){
+		const unsigned*up_head = cch.up_head.data();
+		const unsigned xz_up_begin = cch.up_first_out[x];
+		const unsigned xz_up_end = cch.up_first_out[x+1];
+		for(unsigned xz_up = xz_up_begin; xz_up < xz_up_end; ++xz_up)
+			arc_id_cache[up_head[xz_up]] = xz_up;
+
+		const unsigned xy_down_end = cch.down_first_out[x+1];
+		for(unsigned xy_down = cch.down_first_out[x]; xy_down < xy_down_end; ++xy_down){
+			const unsigned yx_up = cch.down_to_up[xy_down];
+			const unsigned y = cch.down_head[xy_down];
+			const unsigned yz_up_end = cch.up_first_out[y+1];
+			unsigned yz_up = yx_up+1;
+			while(yz_up != yz_up_end){
+				const unsigned xz_up = arc_id_cache[up_head[yz_up]];
+				if(xz_up - xz_up_begin >= xz_up_end - xz_up_begin){
+					// xz was filtered, i.e., the triangle cannot improve anything
+					++yz_up;
+					continue;
+				}
+				unsigned length = 1;
+				while(yz_up+length != yz_up_end && xz_up+length != xz_up_end && up_head[xz_up+length] == up_head[yz_up+length])
+					++length;
+				on_run(yx_up, yz_up, xz_up, length);
+				yz_up += length;
+			}
+		}
+	}
 }
 
 CustomizableContractionHierarchyMetric::CustomizableContractionHierarchyMetric(const CustomizableContractionHierarchy&cch, const std::vector<unsigned>&input_weight):
@@ -770,12 +1137,70 @@ CustomizableContractionHierarchyMetric& CustomizableContractionHierarchyMetric::
 	return *this;
 }
 
+CustomizableContractionHierarchyMetric& CustomizableContractionHierarchyMetric::read(std::function<void(char*, unsigned long long)>in, unsigned long long file_size){
+	assert(cch && "Need to be attached to a CCH");
+	CCHMetricFileHeader header = read_value<CCHMetricFileHeader>(in);
+	check_version(header.magic_number, cch_metric_magic_number, header.version, "CCH metric");
+	if(get_expected_file_size(header) != file_size)
+		throw std::runtime_error("CCH metric file has a different size than specified in the header. This file is corrupt.");
+	if(header.node_count != cch->node_count() || header.input_arc_count != cch->input_arc_count() || header.cch_arc_count != cch->cch_arc_count())
+		throw std::runtime_error("CCH metric file was saved for a different CCH.");
+
+	forward = read_vector<unsigned>(in, header.cch_arc_count);
+	backward = read_vector<unsigned>(in, header.cch_arc_count);
+	return *this;
+}
+
+void CustomizableContractionHierarchyMetric::write(std::function<void(const char*, unsigned long long)>out)const{
+	assert(cch && "Need to be attached to a CCH");
+	CCHMetricFileHeader header = {};
+	header.magic_number = cch_metric_magic_number;
+	header.version = cch_file_version;
+	header.node_count = cch->node_count();
+	header.input_arc_count = cch->input_arc_count();
+	header.cch_arc_count = cch->cch_arc_count();
+
+	write_value(out, header);
+	write_vector(out, forward);
+	write_vector(out, backward);
+}
+
+CustomizableContractionHierarchyMetric& CustomizableContractionHierarchyMetric::load_file(const std::string&file_name){
+	open_file_for_loading(
+		file_name,
+		[&](std::istream&in, unsigned long long file_size){
+			read(
+				[&](char*p, unsigned long long l){
+					if(!in.read(p, l))
+						throw std::runtime_error("std::istream::read failed while reading a CCH metric");
+				},
+				file_size
+			);
+		}
+	);
+	return *this;
+}
+
+void CustomizableContractionHierarchyMetric::save_file(const std::string&file_name)const{
+	open_file_for_saving(
+		file_name,
+		[&](std::ostream&out){
+			write(
+				[&](const char*p, unsigned long long l){
+					if(!out.write(p, l))
+						throw std::runtime_error("std::ostream::write failed while writing a CCH metric");
+				}
+			);
+		}
+	);
+}
+
 CustomizableContractionHierarchyMetric& CustomizableContractionHierarchyMetric::customize(){
 	assert(input_weight != nullptr && "Metric must be connected to a weight vector");
 
 	extract_initial_metric(*cch, *this);
 
-	std::vector<unsigned> arc_id_cache(cch->node_count());
+	std::vector<unsigned> arc_id_cache(cch->node_count(), invalid_id);
 
 	for(unsigned x=0; x<cch->node_count(); ++x){
 		const unsigned xz_up_end = cch->up_first_out[x+1];
@@ -783,18 +1208,7 @@ CustomizableContractionHierarchyMetric& CustomizableContractionHierarchyMetric::
 			arc_id_cache[cch->up_head[xz_up]] = xz_up;
 		}
 
-		const unsigned xy_down_end = cch->down_first_out[x+1];
-		for(unsigned xy_down = cch->down_first_out[x]; xy_down < xy_down_end; ++xy_down){
-			const unsigned yx_up = cch->down_to_up[xy_down];
-			const unsigned y = cch->down_head[xy_down];
-			const unsigned yz_up_end_reversed = cch->up_first_out[y];
-			for(unsigned yz_up_reversed = cch->up_first_out[y+1]; yz_up_reversed > yz_up_end_reversed; --yz_up_reversed){
-				const unsigned yz_up = yz_up_reversed-1;
-				const unsigned z = cch->up_head[yz_up];
-				if (z <= x) { break; }
-				LowerTriangleRelaxer(*this)(yx_up, yz_up, arc_id_cache[z], y, x, z);
-			}
-		}
+		relax_lower_triangles_of_node(*cch, forward.data(), backward.data(), arc_id_cache.data(), x);
 	}
 
 	#ifndef NDEBUG
@@ -804,6 +1218,120 @@ CustomizableContractionHierarchyMetric& CustomizableContractionHierarchyMetric::
 	return *this;
 }
 
+CustomizableContractionHierarchyMultiMetric::CustomizableContractionHierarchyMultiMetric(const CustomizableContractionHierarchy&cch, const std::vector<const unsigned*>&input_weight){
+	reset(cch, input_weight);
+}
+
+CustomizableContractionHierarchyMultiMetric::CustomizableContractionHierarchyMultiMetric(const CustomizableContractionHierarchy&cch, const std::vector<std::vector<unsigned>>&input_weight){
+	reset(cch, input_weight);
+}
+
+CustomizableContractionHierarchyMultiMetric& CustomizableContractionHierarchyMultiMetric::reset(const CustomizableContractionHierarchy&cch_, const std::vector<const unsigned*>&input_weight){
+	cch = &cch_;
+	metric.resize(input_weight.size());
+	for(unsigned i=0; i<input_weight.size(); ++i)
+		metric[i].reset(cch_, input_weight[i]);
+	return *this;
+}
+
+CustomizableContractionHierarchyMultiMetric& CustomizableContractionHierarchyMultiMetric::reset(const CustomizableContractionHierarchy&cch_, const std::vector<std::vector<unsigned>>&input_weight){
+	std::vector<const unsigned*>input_weight_pointer(input_weight.size());
+	for(unsigned i=0; i<input_weight.size(); ++i){
+		assert(input_weight[i].size() == cch_.input_arc_count() && "Input weight vector has the wrong size");
+		input_weight_pointer[i] = input_weight[i].data();
+	}
+	return reset(cch_, input_weight_pointer);
+}
+
+namespace{
+	// Number of metrics that share one enumeration of the lower triangles. The loops over the lanes
+	// have a fixed length and no branches, so that the compiler can map them to SIMD min and add
+	// instructions. Unused lanes are set to inf_weight, which is large enough that inf_weight+inf_weight
+	// does not overflow.
+	const unsigned multi_metric_lane_count = 8;
+
+	// The forward and the backward weights of an arc are stored next to each other, so that one
+	// relaxation only touches one cache line per arc.
+	struct MultiMetricArcWeight{
+		unsigned forward[multi_metric_lane_count];
+		unsigned backward[multi_metric_lane_count];
+	};
+}
+
+CustomizableContractionHierarchyMultiMetric& CustomizableContractionHierarchyMultiMetric::customize(){
+	assert(cch && "Need to be attached to a CCH");
+
+	const unsigned cch_arc_count = cch->cch_arc_count();
+
+	std::vector<unsigned> arc_id_cache(cch->node_count());
+	std::vector<MultiMetricArcWeight> arc_weight(cch_arc_count);
+
+	for(unsigned first_metric = 0; first_metric < metric_count(); first_metric += multi_metric_lane_count){
+		const unsigned lane_count = std::min(multi_metric_lane_count, metric_count() - first_metric);
+
+		for(unsigned l=0; l<multi_metric_lane_count; ++l){
+			if(l < lane_count){
+				CustomizableContractionHierarchyMetric&m = metric[first_metric+l];
+				assert(m.input_weight != nullptr && "Metric must be connected to a weight vector");
+				extract_initial_metric(*cch, m);
+				for(unsigned a=0; a<cch_arc_count; ++a){
+					arc_weight[a].forward[l] = m.forward[a];
+					arc_weight[a].backward[l] = m.backward[a];
+				}
+			}else{
+				for(unsigned a=0; a<cch_arc_count; ++a){
+					arc_weight[a].forward[l] = inf_weight;
+					arc_weight[a].backward[l] = inf_weight;
+				}
+			}
+		}
+
+		for(unsigned x=0; x<cch->node_count(); ++x){
+			const unsigned xz_up_end = cch->up_first_out[x+1];
+			for(unsigned xz_up = cch->up_first_out[x]; xz_up < xz_up_end; ++xz_up){
+				arc_id_cache[cch->up_head[xz_up]] = xz_up;
+			}
+
+			const unsigned xy_down_end = cch->down_first_out[x+1];
+			for(unsigned xy_down = cch->down_first_out[x]; xy_down < xy_down_end; ++xy_down){
+				const unsigned yx_up = cch->down_to_up[xy_down];
+				const unsigned y = cch->down_head[xy_down];
+				const MultiMetricArcWeight bottom = arc_weight[yx_up];
+				const unsigned yz_up_end_reversed = cch->up_first_out[y];
+				for(unsigned yz_up_reversed = cch->up_first_out[y+1]; yz_up_reversed > yz_up_end_reversed; --yz_up_reversed){
+					const unsigned yz_up = yz_up_reversed-1;
+					const unsigned z = cch->up_head[yz_up];
+					if (z <= x) { break; }
+					const MultiMetricArcWeight&mid = arc_weight[yz_up];
+					MultiMetricArcWeight&top = arc_weight[arc_id_cache[z]];
+
+					// The new weights are computed into a local copy first, as the compiler cannot
+					// know that the top arc differs from the mid arc.
+					MultiMetricArcWeight new_top;
+					for(unsigned l=0; l<multi_metric_lane_count; ++l){
+						new_top.forward[l] = std::min(top.forward[l], bottom.backward[l] + mid.forward[l]);
+						new_top.backward[l] = std::min(top.backward[l], bottom.forward[l] + mid.backward[l]);
+					}
+					top = new_top;
+				}
+			}
+		}
+
+		for(unsigned l=0; l<lane_count; ++l){
+			CustomizableContractionHierarchyMetric&m = metric[first_metric+l];
+			for(unsigned a=0; a<cch_arc_count; ++a){
+				m.forward[a] = arc_weight[a].forward[l];
+				m.backward[a] = arc_weight[a].backward[l];
+			}
+			#ifndef NDEBUG
+			for(unsigned a=0; a<cch_arc_count; ++a)
+				forall_upper_triangles_of_arc(*cch, a, LowerTriangleInequalityVerifier(m));
+			#endif
+		}
+	}
+	return *this;
+}
+
 namespace{
 	template<class T>
 	void atomic_min_to(T&x, const T&y){
@@ -833,12 +1361,14 @@ namespace{
 	};
 }
 
-CustomizableContractionHierarchyParallelization::CustomizableContractionHierarchyParallelization(const CustomizableContractionHierarchy&cch){
-	const unsigned node_count = cch.node_count();
+namespace{
+	// A node is on level 0 if it has no down arcs. Otherwise its level is one more than the largest
+	// level of its down neighbors. The up arcs of all nodes on a level can be customized independently
+	// once the lower levels are done.
+	std::vector<unsigned>compute_node_level(const CustomizableContractionHierarchy&cch, unsigned&level_count){
+		const unsigned node_count = cch.node_count();
 
-	std::vector<unsigned>node_level(node_count);
-	unsigned level_count;
-	{
+		std::vector<unsigned>node_level(node_count);
 		std::vector<unsigned>lock(node_count);
 		std::vector<unsigned>zero_lock_list(node_count);
 		unsigned zero_lock_count = 0;
@@ -850,52 +1380,223 @@ CustomizableContractionHierarchyParallelization::CustomizableContractionHierarch
 			}
 		}
 
-		level_count = 0;
-		std::vector<unsigned>next_zero_lock_list(node_count);
-		while(zero_lock_count != 0){
-			unsigned next_zero_lock_count = 0;
-			for(unsigned i=0; i<zero_lock_count; ++i){
-				unsigned x = zero_lock_list[i];
-				node_level[x] = level_count;
-				for(unsigned xy=cch.up_first_out[x]; xy < cch.up_first_out[x+1]; ++xy){
-					unsigned y = cch.up_head[xy];
-					--lock[y];
-					if(lock[y] == 0){
-						next_zero_lock_list[next_zero_lock_count] = y;
-						++next_zero_lock_count;
-					}
-				}
-			}
-			++level_count;
-			std::swap(next_zero_lock_list, zero_lock_list);
-			zero_lock_count = next_zero_lock_count;
+		level_count = 0;
+		std::vector<unsigned>next_zero_lock_list(node_count);
+		while(zero_lock_count != 0){
+			unsigned next_zero_lock_count = 0;
+			for(unsigned i=0; i<zero_lock_count; ++i){
+				unsigned x = zero_lock_list[i];
+				node_level[x] = level_count;
+				for(unsigned xy=cch.up_first_out[x]; xy < cch.up_first_out[x+1]; ++xy){
+					unsigned y = cch.up_head[xy];
+					--lock[y];
+					if(lock[y] == 0){
+						next_zero_lock_list[next_zero_lock_count] = y;
+						++next_zero_lock_count;
+					}
+				}
+			}
+			++level_count;
+			std::swap(next_zero_lock_list, zero_lock_list);
+			zero_lock_count = next_zero_lock_count;
+		}
+		return node_level; // NVRO
+	}
+}
+
+CustomizableContractionHierarchyParallelization::CustomizableContractionHierarchyParallelization(const CustomizableContractionHierarchy&cch){
+	const unsigned node_count = cch.node_count();
+
+	unsigned level_count;
+	std::vector<unsigned>node_level = compute_node_level(cch, level_count);
+
+	const unsigned arc_count = cch.cch_arc_count();
+
+	std::vector<unsigned>arc_level(arc_count);
+	arcs_ordered_by_level.resize(arc_count);
+
+	auto p = compute_stable_sort_permutation_using_key(node_level, level_count, [&](unsigned x){ return x; });
+
+	unsigned j = 0;
+	for(unsigned i=0; i<node_count; ++i){
+		unsigned x = p[i];
+		for(unsigned xy=cch.up_first_out[x]; xy<cch.up_first_out[x+1]; ++xy){
+			arc_level[j] = node_level[x];
+			arcs_ordered_by_level[j] = xy;
+			++j;
+		}
+	}
+
+	first_arc_of_level = invert_vector(arc_level, level_count);
+
+	this->cch = &cch;
+}
+
+
+CustomizableContractionHierarchyParallelization& CustomizableContractionHierarchyParallelization::customize(CustomizableContractionHierarchyMetric&metric) {
+	// If OpenMP is enabled, it is used to parallelize the code. If OpenMP is disabled, the code will compile but will run sequentially.
+	#ifdef _OPENMP
+	customize(metric, omp_get_num_procs());
+	#else
+	customize(metric, 1);
+	#endif
+	return *this;
+}
+
+CustomizableContractionHierarchyParallelization& CustomizableContractionHierarchyParallelization::customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count) {
+	assert(cch == metric.cch);
+	assert(thread_count != 0);
+	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
+
+	if(thread_count == 1){
+		metric.customize();
+	} else {
+		#ifdef _OPENMP
+		#pragma omp parallel num_threads(thread_count)
+		#endif
+		{
+			#ifdef _OPENMP
+			#pragma omp for
+			#endif
+			for(unsigned cch_arc=0; cch_arc<cch->cch_arc_count(); ++cch_arc){
+				extract_initial_metric_of_cch_arc(*cch, metric, cch_arc);
+			}
+
+			for(unsigned l=0; l<first_arc_of_level.size()-1; ++l){
+				#ifdef _OPENMP
+				#pragma omp for schedule(dynamic,256)
+				#endif
+				for(unsigned i=first_arc_of_level[l]; i<first_arc_of_level[l+1]; ++i){
+					forall_upper_triangles_of_arc(*cch, arcs_ordered_by_level[i], AtomicLowerTriangleRelaxer(metric));
+				}
+			}
+		}
+
+
+
+		#ifndef NDEBUG
+		for(unsigned a=0; a<cch->cch_arc_count(); ++a)
+			forall_upper_triangles_of_arc(*cch, a, LowerTriangleInequalityVerifier(metric));
+		#endif
+	}
+	return *this;
+}
+
+namespace{
+	// The elimination tree is cut into roughly this many subtrees of similar work. More subtrees than
+	// threads are needed, as the subtrees are not equally large.
+	const unsigned subtree_parallelization_subtree_count = 1024;
+
+	// Let x be the upper node of the down arc xz. Enumerates all lower triangles {z,x,y} with y above x,
+	// i.e., all lower triangles of the up arcs of x whose bottom node is z. Only the up arcs of x are
+	// modified. The arcs of z and of its descendants in the elimination tree are only read.
+	template<class F>
+	void forall_lower_triangles_with_bottom_down_arc(const CustomizableContractionHierarchy&cch, unsigned xz_down, const F&f){
+		const unsigned zx_up = cch.down_to_up[xz_down];
+		const unsigned z = cch.down_head[xz_down];
+		const unsigned x = cch.up_head[zx_up];
+
+		// Unless always-inf arcs were filtered, the CCH is chordal and every up neighbor y>x of z is an
+		// up neighbor of x. A filtered arc xy cannot be improved, and the triangle is skipped.
+		unsigned xy_up = cch.up_first_out[x];
+		const unsigned xy_up_end = cch.up_first_out[x+1];
+		const unsigned zy_up_end = cch.up_first_out[z+1];
+		for(unsigned zy_up = zx_up+1; zy_up < zy_up_end; ++zy_up){
+			const unsigned y = cch.up_head[zy_up];
+			while(xy_up != xy_up_end && cch.up_head[xy_up] < y)
+				++xy_up;
+			if(xy_up == xy_up_end)
+				break;
+			if(cch.up_head[xy_up] == y)
+				f(zx_up, zy_up, xy_up, z, x, y);
+		}
+	}
+}
+
+CustomizableContractionHierarchySubtreeParallelization::CustomizableContractionHierarchySubtreeParallelization(const CustomizableContractionHierarchy&cch){
+	const unsigned node_count = cch.node_count();
+
+	// The work of a node is the number of lower triangles of its up arcs plus one.
+	std::vector<unsigned long long>subtree_work(node_count, 0);
+	unsigned long long total_work = 0;
+	for(unsigned x=0; x<node_count; ++x){
+		unsigned long long work = 1;
+		for(unsigned xz=cch.down_first_out[x]; xz<cch.down_first_out[x+1]; ++xz)
+			work += cch.up_first_out[cch.down_head[xz]+1] - cch.down_to_up[xz] - 1;
+		subtree_work[x] += work;
+		total_work += work;
+		if(cch.elimination_tree_parent[x] != invalid_id)
+			subtree_work[cch.elimination_tree_parent[x]] += subtree_work[x];
+	}
+
+	const unsigned long long max_subtree_work = total_work / subtree_parallelization_subtree_count + 1;
+
+	// A node is the root of a subtree if its subtree is small enough but the subtree of its parent is
+	// not. The remaining nodes are above the subtrees and have the subtree ID invalid_id.
+	std::vector<unsigned>node_subtree(node_count, invalid_id);
+	std::vector<unsigned long long>work_of_subtree;
+	for(unsigned x=node_count; x>0; --x){
+		const unsigned parent = cch.elimination_tree_parent[x-1];
+		if(parent != invalid_id && node_subtree[parent] != invalid_id){
+			node_subtree[x-1] = node_subtree[parent];
+		}else if(subtree_work[x-1] <= max_subtree_work){
+			node_subtree[x-1] = work_of_subtree.size();
+			work_of_subtree.push_back(subtree_work[x-1]);
 		}
 	}
 
-	const unsigned arc_count = cch.cch_arc_count();
+	const unsigned subtree_count = work_of_subtree.size();
+	{
+		auto subtree_rank = invert_permutation(
+			compute_sort_permutation_using_comparator(work_of_subtree, [](unsigned long long l, unsigned long long r){ return l > r; })
+		);
 
-	std::vector<unsigned>arc_level(arc_count);
-	arcs_ordered_by_level.resize(arc_count);
+		std::vector<unsigned>node_key(node_count);
+		for(unsigned x=0; x<node_count; ++x){
+			if(node_subtree[x] != invalid_id)
+				node_key[x] = subtree_rank[node_subtree[x]];
+			else
+				node_key[x] = subtree_count;
+		}
 
-	auto p = compute_stable_sort_permutation_using_key(node_level, level_count, [&](unsigned x){ return x; });
+		auto p = compute_stable_sort_permutation_using_key(node_key, subtree_count+1, [&](unsigned x){ return x; });
+		first_node_of_subtree = invert_vector(apply_permutation(p, node_key), subtree_count+1);
+		first_node_of_subtree.pop_back();
+		p.resize(first_node_of_subtree.back());
+		subtree_node = std::move(p);
+	}
 
-	unsigned j = 0;
-	for(unsigned i=0; i<node_count; ++i){
-		unsigned x = p[i];
-		for(unsigned xy=cch.up_first_out[x]; xy<cch.up_first_out[x+1]; ++xy){
-			arc_level[j] = node_level[x];
-			arcs_ordered_by_level[j] = xy;
-			++j;
+	// The parent of a node above the subtrees is also above the subtrees. The level of such a node is
+	// one more than the largest level of its children above the subtrees.
+	std::vector<unsigned>node_level(node_count, 0);
+	unsigned level_count = 0;
+	for(unsigned x=0; x<node_count; ++x){
+		if(node_subtree[x] == invalid_id){
+			level_count = std::max(level_count, node_level[x]+1);
+			const unsigned parent = cch.elimination_tree_parent[x];
+			if(parent != invalid_id)
+				node_level[parent] = std::max(node_level[parent], node_level[x]+1);
 		}
 	}
 
-	first_arc_of_level = invert_vector(arc_level, level_count);
+	std::vector<unsigned>arc_level;
+	for(unsigned x=0; x<node_count; ++x){
+		if(node_subtree[x] == invalid_id){
+			for(unsigned xz=cch.down_first_out[x]; xz<cch.down_first_out[x+1]; ++xz){
+				top_down_arc.push_back(xz);
+				arc_level.push_back(node_level[x]);
+			}
+		}
+	}
+
+	auto p = compute_stable_sort_permutation_using_key(arc_level, level_count, [&](unsigned x){ return x; });
+	top_down_arc = apply_permutation(p, top_down_arc);
+	first_top_down_arc_of_level = invert_vector(apply_permutation(p, arc_level), level_count);
 
 	this->cch = &cch;
 }
 
-
-CustomizableContractionHierarchyParallelization& CustomizableContractionHierarchyParallelization::customize(CustomizableContractionHierarchyMetric&metric) {
+CustomizableContractionHierarchySubtreeParallelization& CustomizableContractionHierarchySubtreeParallelization::customize(CustomizableContractionHierarchyMetric&metric){
 	// If OpenMP is enabled, it is used to parallelize the code. If OpenMP is disabled, the code will compile but will run sequentially.
 	#ifdef _OPENMP
 	customize(metric, omp_get_num_procs());
@@ -905,7 +1606,7 @@ CustomizableContractionHierarchyParallelization& CustomizableContractionHierarch
 	return *this;
 }
 
-CustomizableContractionHierarchyParallelization& CustomizableContractionHierarchyParallelization::customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count) {
+CustomizableContractionHierarchySubtreeParallelization& CustomizableContractionHierarchySubtreeParallelization::customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count){
 	assert(cch == metric.cch);
 	assert(thread_count != 0);
 	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
@@ -913,6 +1614,9 @@ CustomizableContractionHierarchyParallelization& CustomizableContractionHierarch
 	if(thread_count == 1){
 		metric.customize();
 	} else {
+		const unsigned subtree_count = first_node_of_subtree.size()-1;
+		const unsigned level_count = first_top_down_arc_of_level.size()-1;
+
 		#ifdef _OPENMP
 		#pragma omp parallel num_threads(thread_count)
 		#endif
@@ -924,18 +1628,32 @@ CustomizableContractionHierarchyParallelization& CustomizableContractionHierarch
 				extract_initial_metric_of_cch_arc(*cch, metric, cch_arc);
 			}
 
-			for(unsigned l=0; l<first_arc_of_level.size()-1; ++l){
+			std::vector<unsigned>arc_id_cache(cch->node_count(), invalid_id);
+
+			// The subtrees are independent. Each is processed by one thread without synchronization.
+			#ifdef _OPENMP
+			#pragma omp for schedule(dynamic,1)
+			#endif
+			for(unsigned s=0; s<subtree_count; ++s){
+				for(unsigned i=first_node_of_subtree[s]; i<first_node_of_subtree[s+1]; ++i){
+					const unsigned x = subtree_node[i];
+					for(unsigned xy=cch->up_first_out[x]; xy<cch->up_first_out[x+1]; ++xy)
+						arc_id_cache[cch->up_head[xy]] = xy;
+					relax_lower_triangles_of_node(*cch, metric.forward.data(), metric.backward.data(), arc_id_cache.data(), x);
+				}
+			}
+
+			// Several threads can relax the up arcs of the same node, so atomic operations are needed.
+			for(unsigned l=0; l<level_count; ++l){
 				#ifdef _OPENMP
-				#pragma omp for schedule(dynamic,256)
+				#pragma omp for schedule(dynamic,16)
 				#endif
-				for(unsigned i=first_arc_of_level[l]; i<first_arc_of_level[l+1]; ++i){
-					forall_upper_triangles_of_arc(*cch, arcs_ordered_by_level[i], AtomicLowerTriangleRelaxer(metric));
+				for(unsigned i=first_top_down_arc_of_level[l]; i<first_top_down_arc_of_level[l+1]; ++i){
+					forall_lower_triangles_with_bottom_down_arc(*cch, top_down_arc[i], AtomicLowerTriangleRelaxer(metric));
 				}
 			}
 		}
 
-
-
 		#ifndef NDEBUG
 		for(unsigned a=0; a<cch->cch_arc_count(); ++a)
 			forall_upper_triangles_of_arc(*cch, a, LowerTriangleInequalityVerifier(metric));
@@ -944,6 +1662,128 @@ CustomizableContractionHierarchyParallelization& CustomizableContractionHierarch
 	return *this;
 }
 
+CustomizableContractionHierarchyTriangles::CustomizableContractionHierarchyTriangles(const CustomizableContractionHierarchy&cch, std::function<void(const std::string&)>log_message){
+	long long timer = 0;
+
+	if(log_message){
+		log_message("Start enumerating lower triangles");
+		timer = -get_micro_time();
+	}
+
+	order_nodes_by_elimination_tree_height(cch.elimination_tree_parent, node_by_height, first_node_of_height);
+
+	const unsigned node_count = cch.node_count();
+	std::vector<unsigned>arc_id_cache(node_count, invalid_id);
+
+	// The runs are enumerated twice, first to count and then to store them, so that the possibly very
+	// large run vector is allocated only once.
+	first_run.resize(node_count+1);
+	first_run[0] = 0;
+	stored_triangle_count = 0;
+	for(unsigned i=0; i<node_count; ++i){
+		unsigned long long n = 0;
+		forall_lower_triangle_runs_of_node(
+			cch, arc_id_cache.data(), node_by_height[i],
+			[&](unsigned, unsigned, unsigned, unsigned length){
+				++n;
+				stored_triangle_count += length;
+			}
+		);
+		first_run[i+1] = first_run[i] + n;
+	}
+
+	run.resize(first_run[node_count]);
+	for(unsigned i=0; i<node_count; ++i){
+		TriangleRun*r = run.data() + first_run[i];
+		forall_lower_triangle_runs_of_node(
+			cch, arc_id_cache.data(), node_by_height[i],
+			[&](unsigned yx, unsigned yz, unsigned xz, unsigned length){
+				*r++ = {yx, yz, xz, length};
+			}
+		);
+	}
+
+	this->cch = &cch;
+
+	if(log_message){
+		timer += get_micro_time();
+		log_message("Finished enumerating lower triangles, needed "+std::to_string(timer)+"musec");
+
+		const unsigned arc_count = cch.cch_arc_count();
+		const unsigned long long triangle_memory = run.size()*sizeof(TriangleRun) + first_run.size()*sizeof(unsigned long long);
+		const unsigned long long metric_memory = 2ull*arc_count*sizeof(unsigned);
+		log_message("Stored "+std::to_string(triangle_count())+" lower triangles of "+std::to_string(arc_count)+" arcs as "+std::to_string(run_count())+" runs");
+		if(run_count() != 0)
+			log_message("The average length of a run is "+std::to_string(triangle_count()/run_count()));
+		log_message("The triangles need "+std::to_string(triangle_memory>>20)+"MiB of memory");
+		if(metric_memory != 0)
+			log_message("This is "+std::to_string(triangle_memory/metric_memory)+" times the memory of a metric");
+	}
+}
+
+CustomizableContractionHierarchyTriangles& CustomizableContractionHierarchyTriangles::customize(CustomizableContractionHierarchyMetric&metric){
+	// If OpenMP is enabled, it is used to parallelize the code. If OpenMP is disabled, the code will compile but will run sequentially.
+	#ifdef _OPENMP
+	customize(metric, omp_get_num_procs());
+	#else
+	customize(metric, 1);
+	#endif
+	return *this;
+}
+
+CustomizableContractionHierarchyTriangles& CustomizableContractionHierarchyTriangles::customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count){
+	assert(cch == metric.cch);
+	assert(thread_count != 0);
+	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
+
+	const unsigned height_count = first_node_of_height.size()-1;
+	unsigned*forward = metric.forward.data();
+	unsigned*backward = metric.backward.data();
+
+	#ifdef _OPENMP
+	#pragma omp parallel num_threads(thread_count) if(thread_count > 1)
+	#endif
+	{
+		#ifdef _OPENMP
+		#pragma omp for
+		#endif
+		for(unsigned cch_arc=0; cch_arc<cch->cch_arc_count(); ++cch_arc){
+			extract_initial_metric_of_cch_arc(*cch, metric, cch_arc);
+		}
+
+		// The down neighbors y of x are in the subtree of x and have a smaller height. Every up arc xz is
+		// only written by the thread that processes x.
+		for(unsigned h=0; h<height_count; ++h){
+			#ifdef _OPENMP
+			#pragma omp for schedule(dynamic,16)
+			#endif
+			for(unsigned i=first_node_of_height[h]; i<first_node_of_height[h+1]; ++i){
+				const TriangleRun*r = run.data() + first_run[i];
+				const TriangleRun*r_end = run.data() + first_run[i+1];
+				for(; r != r_end; ++r){
+					const unsigned yx_forward = forward[r->yx];
+					const unsigned yx_backward = backward[r->yx];
+					unsigned l = 0;
+					for(; l + triangle_lane_count <= r->length; l += triangle_lane_count){
+						relax_triangle_lanes(forward + r->xz + l, yx_backward, forward + r->yz + l);
+						relax_triangle_lanes(backward + r->xz + l, yx_forward, backward + r->yz + l);
+					}
+					for(; l < r->length; ++l){
+						min_to(forward[r->xz+l], yx_backward + forward[r->yz+l]);
+						min_to(backward[r->xz+l], yx_forward + backward[r->yz+l]);
+					}
+				}
+			}
+		}
+	}
+
+	#ifndef NDEBUG
+	for(unsigned a=0; a<cch->cch_arc_count(); ++a)
+		forall_upper_triangles_of_arc(*cch, a, LowerTriangleInequalityVerifier(metric));
+	#endif
+	return *this;
+}
+
 CustomizableContractionHierarchyPartialCustomization::CustomizableContractionHierarchyPartialCustomization(const CustomizableContractionHierarchy&cch_):
 	q(cch_.cch_arc_count()),
 	cch(&cch_){
@@ -1040,6 +1880,208 @@ CustomizableContractionHierarchyPartialCustomization&CustomizableContractionHier
 	return *this;
 }
 
+CustomizableContractionHierarchyParallelPartialCustomization::CustomizableContractionHierarchyParallelPartialCustomization(const CustomizableContractionHierarchy&cch_):
+	arc_level(cch_.cch_arc_count()),
+	is_arc_dirty(cch_.cch_arc_count(), false),
+	old_forward(cch_.cch_arc_count()),
+	old_backward(cch_.cch_arc_count()),
+	cch(&cch_){
+
+	unsigned level_count;
+	std::vector<unsigned>node_level = compute_node_level(cch_, level_count);
+	for(unsigned xy=0; xy<cch_.cch_arc_count(); ++xy)
+		arc_level[xy] = node_level[cch_.up_tail[xy]];
+	dirty_arc_of_level.resize(level_count);
+}
+
+CustomizableContractionHierarchyParallelPartialCustomization&CustomizableContractionHierarchyParallelPartialCustomization::reset(){
+	for(auto&l:dirty_arc_of_level){
+		for(unsigned xy:l)
+			is_arc_dirty[xy] = false;
+		l.clear();
+	}
+	return *this;
+}
+
+CustomizableContractionHierarchyParallelPartialCustomization&CustomizableContractionHierarchyParallelPartialCustomization::reset(const CustomizableContractionHierarchy&cch_){
+	*this = CustomizableContractionHierarchyParallelPartialCustomization(cch_);
+	return *this;
+}
+
+CustomizableContractionHierarchyParallelPartialCustomization&CustomizableContractionHierarchyParallelPartialCustomization::update_arc(unsigned input_arc){
+	assert(input_arc < cch->input_arc_count() && "input arc out of bounds");
+	unsigned xy = cch->input_arc_to_cch_arc[input_arc];
+	if(xy != invalid_id && !is_arc_dirty[xy]){
+		is_arc_dirty[xy] = true;
+		dirty_arc_of_level[arc_level[xy]].push_back(xy);
+	}
+	return *this;
+}
+
+CustomizableContractionHierarchyParallelPartialCustomization&CustomizableContractionHierarchyParallelPartialCustomization::update_weights(std::vector<unsigned>&input_weight, const std::vector<unsigned>&input_arc, const std::vector<unsigned>&new_weight){
+	assert(input_weight.size() == cch->input_arc_count() && "Input weight vector has the wrong size");
+	assert(input_arc.size() == new_weight.size() && "input_arc and new_weight must have the same size");
+	for(unsigned i=0; i<input_arc.size(); ++i){
+		input_weight[input_arc[i]] = new_weight[i];
+		update_arc(input_arc[i]);
+	}
+	return *this;
+}
+
+CustomizableContractionHierarchyParallelPartialCustomization&CustomizableContractionHierarchyParallelPartialCustomization::customize(CustomizableContractionHierarchyMetric&metric){
+	// If OpenMP is enabled, it is used to parallelize the code. If OpenMP is disabled, the code will compile but will run sequentially.
+	#ifdef _OPENMP
+	customize(metric, omp_get_num_procs());
+	#else
+	customize(metric, 1);
+	#endif
+	return *this;
+}
+
+CustomizableContractionHierarchyParallelPartialCustomization&CustomizableContractionHierarchyParallelPartialCustomization::customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count){
+	assert(cch == metric.cch);
+	assert(thread_count != 0);
+	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
+
+	#ifndef _OPENMP
+	thread_count = 1;
+	#endif
+
+	changed_cch_arc.clear();
+
+	// The arcs that a thread marked as dirty and the arcs whose weight it changed while processing
+	// the current level.
+	std::vector<std::vector<unsigned>>newly_dirty_arc(thread_count);
+	std::vector<std::vector<unsigned>>newly_changed_arc(thread_count);
+
+	// Processing an arc only marks arcs on higher levels. The arcs of a level are therefore final once
+	// the level is done. Every arc is processed at most once.
+	#ifdef _OPENMP
+	#pragma omp parallel num_threads(thread_count) if(thread_count > 1)
+	#endif
+	{
+		#ifdef _OPENMP
+		const unsigned thread_id = omp_get_thread_num();
+		#else
+		const unsigned thread_id = 0;
+		#endif
+
+		for(unsigned l=0; l<dirty_arc_of_level.size(); ++l){
+			const std::vector<unsigned>&level_arc = dirty_arc_of_level[l];
+			if(level_arc.empty())
+				continue;
+
+			// Recompute the weights of the level. Only the lower levels are read.
+			#ifdef _OPENMP
+			#pragma omp for schedule(dynamic,64)
+			#endif
+			for(unsigned i=0; i<level_arc.size(); ++i){
+				const unsigned xy = level_arc[i];
+				old_forward[xy] = metric.forward[xy];
+				old_backward[xy] = metric.backward[xy];
+
+				metric.forward[xy] = inf_weight;
+				metric.backward[xy] = inf_weight;
+				extract_initial_metric_of_cch_arc(*cch, metric, xy);
+				forall_lower_triangles_of_arc(*cch, xy, LowerTriangleRelaxer(metric));
+			}
+
+			// Mark the arcs on higher levels that might change. The other arc of such a triangle is on
+			// the same level. Triangles whose old weight was tight or whose new weight is shorter are
+			// looked at, where old and new refer to both arcs of the level.
+			#ifdef _OPENMP
+			#pragma omp for schedule(dynamic,64)
+			#endif
+			for(unsigned i=0; i<level_arc.size(); ++i){
+				const unsigned xy = level_arc[i];
+				const unsigned old_xy_forward = old_forward[xy];
+				const unsigned old_xy_backward = old_backward[xy];
+				const unsigned new_xy_forward = metric.forward[xy];
+				const unsigned new_xy_backward = metric.backward[xy];
+
+				if(old_xy_forward == new_xy_forward && old_xy_backward == new_xy_backward)
+					continue;
+
+				newly_changed_arc[thread_id].push_back(xy);
+
+				auto old_forward_of = [&](unsigned a){ return is_arc_dirty[a] ? old_forward[a] : metric.forward[a]; };
+				auto old_backward_of = [&](unsigned a){ return is_arc_dirty[a] ? old_backward[a] : metric.backward[a]; };
+
+				auto mark = [&](unsigned top_arc){
+					if(!__atomic_load_n(&is_arc_dirty[top_arc], __ATOMIC_RELAXED) && __sync_bool_compare_and_swap(&is_arc_dirty[top_arc], (unsigned char)false, (unsigned char)true))
+						newly_dirty_arc[thread_id].push_back(top_arc);
+				};
+
+				forall_intermediate_triangles_of_arc(
+					*cch, xy,
+					[&](
+						unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
+						unsigned bottom_node, unsigned mid_node, unsigned top_node
+					){
+						assert(mid_arc == xy);
+						if(
+							old_backward_of(bottom_arc) + old_xy_forward == metric.forward[top_arc] ||
+							old_forward_of(bottom_arc) + old_xy_backward == metric.backward[top_arc] ||
+							metric.backward[bottom_arc] + new_xy_forward < metric.forward[top_arc] ||
+							metric.forward[bottom_arc] + new_xy_backward < metric.backward[top_arc]
+						){
+							mark(top_arc);
+						}
+						return true;
+					}
+				);
+				forall_upper_triangles_of_arc(
+					*cch, xy,
+					[&](
+						unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
+						unsigned bottom_node, unsigned mid_node, unsigned top_node
+					){
+						assert(bottom_arc == xy);
+						if(
+							old_forward_of(mid_arc) + old_xy_backward == metric.forward[top_arc] ||
+							old_backward_of(mid_arc) + old_xy_forward == metric.backward[top_arc] ||
+							metric.forward[mid_arc] + new_xy_backward < metric.forward[top_arc] ||
+							metric.backward[mid_arc] + new_xy_forward < metric.backward[top_arc]
+						){
+							mark(top_arc);
+						}
+						return true;
+					}
+				);
+			}
+
+			#ifdef _OPENMP
+			#pragma omp single
+			#endif
+			{
+				for(unsigned xy:dirty_arc_of_level[l])
+					is_arc_dirty[xy] = false;
+				dirty_arc_of_level[l].clear();
+
+				for(auto&v:newly_dirty_arc){
+					for(unsigned xy:v){
+						assert(arc_level[xy] > l);
+						dirty_arc_of_level[arc_level[xy]].push_back(xy);
+					}
+					v.clear();
+				}
+				for(auto&v:newly_changed_arc){
+					changed_cch_arc.insert(changed_cch_arc.end(), v.begin(), v.end());
+					v.clear();
+				}
+			}
+		}
+	}
+
+	std::sort(changed_cch_arc.begin(), changed_cch_arc.end());
+
+	#ifndef NDEBUG
+	for(unsigned a=0; a<cch->cch_arc_count(); ++a)
+		forall_upper_triangles_of_arc(*cch, a, LowerTriangleInequalityVerifier(metric));
+	#endif
+	return *this;
+}
+
 namespace{
 	const unsigned query_state_initialized = 0;
 	const unsigned query_state_run = 1;
@@ -1226,6 +2268,8 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ru
 			cch->elimination_tree_parent,
 			source_node[i], source_elimination_tree_end[i],
 			[&](unsigned x){
+				ROUTING_KIT_RECORD_QUERY_STATISTICS(++statistics.forward.elimination_tree_node_count);
+				ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.forward.relaxed_arc_count += cch->up_first_out[x+1] - cch->up_first_out[x]);
 
 				relax_outgoing_arcs(
 					cch->up_first_out, cch->up_head, metric->forward,
@@ -1252,6 +2296,8 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ru
 			cch->elimination_tree_parent,
 			target_node[i], target_elimination_tree_end[i],
 			[&](unsigned x){
+				ROUTING_KIT_RECORD_QUERY_STATISTICS(++statistics.backward.elimination_tree_node_count);
+				ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.backward.relaxed_arc_count += cch->up_first_out[x+1] - cch->up_first_out[x]);
 				relax_outgoing_arcs(
 					cch->up_first_out, cch->up_head, metric->backward,
 					backward_tentative_distance, [&](unsigned a, unsigned b){backward_predecessor_node[a] = b;},
@@ -1339,8 +2385,9 @@ namespace{
 		unsigned*bottom_node_, *bottom_arc_, *mid_arc_;
 	};
 
+	// Returns the number of nested shortcuts of xy. Arcs of the input graph have depth zero.
 	template<class OnNewSegment>
-	void unpack_arc(
+	unsigned unpack_arc(
 		const CustomizableContractionHierarchy&cch, const CustomizableContractionHierarchyMetric&metric,
 		bool is_forward,
 		unsigned x, unsigned y, unsigned xy,
@@ -1380,22 +2427,27 @@ namespace{
 				on_new_segment(x, xy, true);
 			else
 				on_new_segment(y, xy, false);
+			return 0;
 		} else {
+			unsigned first_depth, second_depth;
 			if(is_forward){
-				unpack_arc(cch, metric, false, bottom_node, x, bottom_arc, on_new_segment);
-				unpack_arc(cch, metric, true, bottom_node, y, mid_arc, on_new_segment);
+				first_depth = unpack_arc(cch, metric, false, bottom_node, x, bottom_arc, on_new_segment);
+				second_depth = unpack_arc(cch, metric, true, bottom_node, y, mid_arc, on_new_segment);
 			}else{
-				unpack_arc(cch, metric, false, bottom_node, y, mid_arc, on_new_segment);
-				unpack_arc(cch, metric, true, bottom_node, x, bottom_arc, on_new_segment);
+				first_depth = unpack_arc(cch, metric, false, bottom_node, y, mid_arc, on_new_segment);
+				second_depth = unpack_arc(cch, metric, true, bottom_node, x, bottom_arc, on_new_segment);
 			}
+			return 1 + std::max(first_depth, second_depth);
 		}
 	}
 
+	// Returns the last node of the path and stores the largest unpacking depth of its arcs in unpacking_depth.
 	template<class OnNewSegment>
 	unsigned unpack_shortest_path(
 		const CustomizableContractionHierarchy&cch, const CustomizableContractionHierarchyMetric&metric, const CustomizableContractionHierarchyQuery&query,
-		const OnNewSegment&on_new_segment
+		const OnNewSegment&on_new_segment, unsigned&unpacking_depth
 	){
+		unpacking_depth = 0;
 		if(query.shortest_path_meeting_node == invalid_id)
 			return invalid_id;
 
@@ -1409,24 +2461,26 @@ namespace{
 			}
 
 			for(unsigned i=up_path.size()-1; i!=0; --i){
-				unpack_arc(
+				unsigned depth = unpack_arc(
 					cch, metric,
 					true,
 					up_path[i], up_path[i-1], find_arc_given_sorted_head(cch.up_first_out, cch.up_head, up_path[i], up_path[i-1]),
 					on_new_segment
 				);
+				unpacking_depth = std::max(unpacking_depth, depth);
 			}
 		}
 		{
 			unsigned x = query.shortest_path_meeting_node;
 			unsigned y = query.backward_predecessor_node[x];
 			while(y != invalid_id){
-				unpack_arc(
+				unsigned depth = unpack_arc(
 					cch, metric,
 					false,
 					y, x, find_arc_given_sorted_head(cch.up_first_out, cch.up_head, y, x),
 					on_new_segment
 				);
+				unpacking_depth = std::max(unpacking_depth, depth);
 				x = y;
 				y = query.backward_predecessor_node[y];
 			}
@@ -1437,17 +2491,23 @@ namespace{
 
 std::vector<unsigned>CustomizableContractionHierarchyQuery::get_node_path(){
 	assert(state == query_state_run);
+	ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_time -= get_micro_time());
 	std::vector<unsigned>path;
+	unsigned unpacking_depth;
 	unsigned last = unpack_shortest_path(
 		*cch, *metric, *this,
 		[&](unsigned cch_node, unsigned cch_arc, bool forward){
 			path.push_back(cch->order[cch_node]);
 			(void)forward;
 			(void)cch_arc;
-		}
+		},
+		unpacking_depth
 	);
 	if(last != invalid_id)
 		path.push_back(cch->order[last]);
+	ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_time += get_micro_time());
+	ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_depth = unpacking_depth);
+	(void)unpacking_depth;
 	return path; // NVRO
 }
 
@@ -1516,7 +2576,9 @@ namespace{
 
 std::vector<unsigned>CustomizableContractionHierarchyQuery::get_arc_path(){
 	assert(state == query_state_run);
+	ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_time -= get_micro_time());
 	std::vector<unsigned>path;
+	unsigned unpacking_depth;
 	unpack_shortest_path(
 		*cch, *metric, *this,
 		[&](unsigned cch_node, unsigned cch_arc, bool is_forward){
@@ -1531,8 +2593,12 @@ std::vector<unsigned>CustomizableContractionHierarchyQuery::get_arc_path(){
 			unsigned arc = unpack_original_arc(*cch, *metric, cch_arc, is_forward);
 			assert(arc != invalid_id);
 			path.push_back(arc);
-		}
+		},
+		unpacking_depth
 	);
+	ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_time += get_micro_time());
+	ROUTING_KIT_RECORD_QUERY_STATISTICS(statistics.unpacking_depth = unpacking_depth);
+	(void)unpacking_depth;
 	return path; // NVRO
 }
 
@@ -1606,6 +2672,7 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::re
 
 	reset_source_list(cch->elimination_tree_parent, source_node, source_elimination_tree_end, in_forward_search_space, forward_tentative_distance);
 	reset_target_distances(cch->elimination_tree_parent, target_node, target_elimination_tree_end, forward_tentative_distance);
+	statistics.clear();
 
 	state = query_state_target_pinned;
 	return *this;
@@ -1616,6 +2683,7 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::re
 
 	reset_source_list(cch->elimination_tree_parent, target_node, target_elimination_tree_end, in_backward_search_space, backward_tentative_distance);
 	reset_target_distances(cch->elimination_tree_parent, source_node, source_elimination_tree_end, backward_tentative_distance);
+	statistics.clear();
 
 	state = query_state_source_pinned;
 	return *this;
@@ -1627,13 +2695,18 @@ namespace{
 		const std::vector<unsigned>&forward_weight, const std::vector<unsigned>&backward_weight,
 		std::vector<unsigned>&forward_tentative_distance, std::vector<unsigned>&backward_tentative_distance,
 		const std::vector<unsigned>&source_node, const std::vector<unsigned>&source_elimination_tree_end,
-		const std::vector<unsigned>&target_node, const std::vector<unsigned>&target_elimination_tree_end
+		const std::vector<unsigned>&target_node, const std::vector<unsigned>&target_elimination_tree_end,
+		QueryStatistics::Direction&forward_statistics, QueryStatistics::Direction&backward_statistics
 	){
+		(void)forward_statistics;
+		(void)backward_statistics;
 		for(unsigned i = source_node.size()-1; i!=(unsigned)-1; --i){
 			forall_ancestors(
 				cch.elimination_tree_parent,
 				source_node[i], source_elimination_tree_end[i],
 				[&](unsigned x){
+					ROUTING_KIT_RECORD_QUERY_STATISTICS(++forward_statistics.elimination_tree_node_count);
+					ROUTING_KIT_RECORD_QUERY_STATISTICS(forward_statistics.relaxed_arc_count += cch.up_first_out[x+1] - cch.up_first_out[x]);
 					relax_outgoing_arcs(
 						cch.up_first_out, cch.up_head, forward_weight,
 						forward_tentative_distance, [](unsigned,unsigned){},
@@ -1661,6 +2734,8 @@ namespace{
 			--stack_end;
 			unsigned x = stack[stack_end];
 			stack[stack_end] = inf_weight;
+			ROUTING_KIT_RECORD_QUERY_STATISTICS(++backward_statistics.elimination_tree_node_count);
+			ROUTING_KIT_RECORD_QUERY_STATISTICS(backward_statistics.relaxed_arc_count += cch.up_first_out[x+1] - cch.up_first_out[x]);
 			relax_incoming_arcs(
 				cch.up_first_out, cch.up_head, backward_weight,
 				forward_tentative_distance, [](unsigned,unsigned){},
@@ -1677,7 +2752,8 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ru
 		metric->forward, metric->backward,
 		forward_tentative_distance, backward_tentative_distance,
 		source_node, source_elimination_tree_end,
-		target_node, target_elimination_tree_end
+		target_node, target_elimination_tree_end,
+		statistics.forward, statistics.backward
 	);
 	state = query_state_target_run;
 	return *this;
@@ -1690,7 +2766,8 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ru
 		metric->backward, metric->forward,
 		backward_tentative_distance, forward_tentative_distance,
 		target_node, target_elimination_tree_end,
-		source_node, source_elimination_tree_end
+		source_node, source_elimination_tree_end,
+		statistics.backward, statistics.forward
 	);
 	state = query_state_source_run;
 	return *this;
@@ -1724,6 +2801,103 @@ std::vector<unsigned> CustomizableContractionHierarchyQuery::get_distances_to_so
 	return v;
 }
 
+namespace{
+	// Number of sources that share one sweep. The loops over the lanes have a fixed length
+	// and no branches, so that the compiler can map them to SIMD min and add instructions.
+	const unsigned batch_lane_count = 16;
+}
+
+CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::get_distances_from_sources_to_pinned_targets(const std::vector<unsigned>&source_list, unsigned*dist){
+	assert(state == query_state_target_pinned || state == query_state_target_run);
+
+	reset_source();
+
+	// The search space of the targets ordered such that every node comes after all its ancestors.
+	batch_node.clear();
+	for(unsigned i = target_node.size()-1; i!=(unsigned)-1; --i){
+		forall_ancestors(
+			cch->elimination_tree_parent,
+			target_node[i], target_elimination_tree_end[i],
+			[&](unsigned x){
+				batch_node.push_back(x);
+				return true;
+			}
+		);
+	}
+	std::reverse(batch_node.begin(), batch_node.end());
+
+	const unsigned search_space_size = batch_node.size();
+	batch_position.resize(cch->node_count());
+	for(unsigned i=0; i<search_space_size; ++i)
+		batch_position[batch_node[i]] = i;
+	batch_distance.resize((unsigned long long)search_space_size * batch_lane_count);
+
+	const unsigned source_count = source_list.size();
+	const unsigned target_count = target_node.size();
+
+	for(unsigned first_source = 0; first_source < source_count; first_source += batch_lane_count){
+		const unsigned lane_count = std::min(batch_lane_count, source_count - first_source);
+
+		for(unsigned l=0; l<batch_lane_count; ++l){
+			if(l < lane_count){
+				assert(source_list[first_source+l] < cch->node_count());
+				internal_add_source(
+					source_list[first_source+l], 0,
+					cch->rank,
+					cch->elimination_tree_parent,
+					forward_tentative_distance,
+					forward_predecessor_node,
+					in_forward_search_space,
+					source_node,
+					source_elimination_tree_end
+				);
+				forall_ancestors(
+					cch->elimination_tree_parent,
+					source_node[0], source_elimination_tree_end[0],
+					[&](unsigned x){
+						relax_outgoing_arcs(
+							cch->up_first_out, cch->up_head, metric->forward,
+							forward_tentative_distance, [](unsigned,unsigned){},
+							x
+						);
+						return true;
+					}
+				);
+				for(unsigned i=0; i<search_space_size; ++i)
+					batch_distance[(unsigned long long)i*batch_lane_count + l] = forward_tentative_distance[batch_node[i]];
+				reset_source_list(cch->elimination_tree_parent, source_node, source_elimination_tree_end, in_forward_search_space, forward_tentative_distance);
+			}else{
+				for(unsigned i=0; i<search_space_size; ++i)
+					batch_distance[(unsigned long long)i*batch_lane_count + l] = inf_weight;
+			}
+		}
+
+		for(unsigned i=0; i<search_space_size; ++i){
+			unsigned x = batch_node[i];
+			unsigned*dist_x = &batch_distance[(unsigned long long)i*batch_lane_count];
+			for(unsigned xy=cch->up_first_out[x]; xy<cch->up_first_out[x+1]; ++xy){
+				const unsigned*dist_y = &batch_distance[(unsigned long long)batch_position[cch->up_head[xy]]*batch_lane_count];
+				const unsigned w = metric->backward[xy];
+				for(unsigned l=0; l<batch_lane_count; ++l)
+					dist_x[l] = std::min(dist_x[l], dist_y[l] + w);
+			}
+		}
+
+		for(unsigned l=0; l<lane_count; ++l)
+			for(unsigned t=0; t<target_count; ++t)
+				dist[(unsigned long long)(first_source+l)*target_count + t] = batch_distance[(unsigned long long)batch_position[target_node[t]]*batch_lane_count + l];
+	}
+
+	state = query_state_target_pinned;
+	return *this;
+}
+
+std::vector<unsigned> CustomizableContractionHierarchyQuery::get_distances_from_sources_to_pinned_targets(const std::vector<unsigned>&source_list){
+	std::vector<unsigned>v((unsigned long long)source_list.size()*target_node.size());
+	get_distances_from_sources_to_pinned_targets(source_list, v.data());
+	return v;
+}
+
 ContractionHierarchy CustomizableContractionHierarchyMetric::build_contraction_hierarchy_using_perfect_witness_search(){
 	customize();
 
@@ -1805,18 +2979,20 @@ ContractionHierarchy CustomizableContractionHierarchyMetric::build_contraction_h
 	LocalIDMapper backward_map(keep_backward_arc);
 
 	ch.forward.head = keep_element_of_vector_if(keep_forward_arc, cch->up_head);
-	ch.forward.first_out = invert_vector(keep_element_of_vector_if(keep_forward_arc, cch->up_tail), cch->node_count());
+	auto forward_first_out = invert_vector(keep_element_of_vector_if(keep_forward_arc, cch->up_tail), cch->node_count());
+	ch.forward.first_out.assign(forward_first_out.begin(), forward_first_out.end());
 	ch.forward.weight = keep_element_of_vector_if(keep_forward_arc, forward);
 	ch.forward.is_shortcut_an_original_arc = BitVector(ch.forward.head.size(), false);
-	ch.forward.shortcut_first_arc = std::vector<unsigned>(forward_map.local_id_count());
-	ch.forward.shortcut_second_arc = std::vector<unsigned>(forward_map.local_id_count());
+	ch.forward.shortcut_first_arc = std::vector<CHArcID>(forward_map.local_id_count());
+	ch.forward.shortcut_second_arc = std::vector<CHArcID>(forward_map.local_id_count());
 
 	ch.backward.head = keep_element_of_vector_if(keep_backward_arc, cch->up_head);
-	ch.backward.first_out = invert_vector(keep_element_of_vector_if(keep_backward_arc, cch->up_tail), cch->node_count());
+	auto backward_first_out = invert_vector(keep_element_of_vector_if(keep_backward_arc, cch->up_tail), cch->node_count());
+	ch.backward.first_out.assign(backward_first_out.begin(), backward_first_out.end());
 	ch.backward.weight = keep_element_of_vector_if(keep_backward_arc, backward);
 	ch.backward.is_shortcut_an_original_arc = BitVector(ch.backward.head.size(), false);
-	ch.backward.shortcut_first_arc = std::vector<unsigned>(backward_map.local_id_count());
-	ch.backward.shortcut_second_arc = std::vector<unsigned>(backward_map.local_id_count());
+	ch.backward.shortcut_first_arc = std::vector<CHArcID>(backward_map.local_id_count());
+	ch.backward.shortcut_second_arc = std::vector<CHArcID>(backward_map.local_id_count());
 
 	for(unsigned cch_arc=0; cch_arc<cch->cch_arc_count(); ++cch_arc){
 		if(keep_forward_arc.is_set(cch_arc)){
@@ -1899,6 +3075,7 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::re
 	}
 	reset_source_list(cch->elimination_tree_parent, source_node, source_elimination_tree_end, in_forward_search_space, forward_tentative_distance);
 	reset_source_list(cch->elimination_tree_parent, target_node, target_elimination_tree_end, in_backward_search_space, backward_tentative_distance);
+	statistics.clear();
 	state = query_state_initialized;
 	return *this;
 }
@@ -0,0 +1,184 @@
+#include <routingkit/customizable_contraction_hierarchy_metric_double_buffer.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <assert.h>
+
+namespace RoutingKit{
+
+struct CustomizableContractionHierarchyMetricDoubleBuffer::Impl{
+	const CustomizableContractionHierarchy*cch;
+
+	std::vector<unsigned>input_weight[2];
+	CustomizableContractionHierarchyMetric metric[2];
+	unsigned long long epoch[2];
+
+	// The buffer that new snapshots use. The other buffer is only written by updates once its
+	// reader count has dropped to zero.
+	std::atomic<unsigned>current;
+	std::atomic<unsigned>reader_count[2];
+	std::atomic<unsigned long long>current_epoch;
+
+	std::mutex update_lock;
+
+	// The back buffer is two epochs old. If the last update was partial, it is brought up to date
+	// by also applying the weight changes of the last update.
+	CustomizableContractionHierarchyPartialCustomization partial_customization;
+	std::vector<unsigned>last_changed_arc;
+	bool was_last_update_partial;
+
+	// Waits until no snapshot of the back buffer is left. As current does not point to the back
+	// buffer, no new snapshots of it can be taken.
+	unsigned wait_for_back_buffer(){
+		unsigned back = 1 - current.load();
+		while(reader_count[back].load() != 0)
+			std::this_thread::yield();
+		return back;
+	}
+
+	unsigned long long publish(unsigned back){
+		epoch[back] = epoch[1-back] + 1;
+		current.store(back);
+		current_epoch.store(epoch[back]);
+		return epoch[back];
+	}
+};
+
+CustomizableContractionHierarchyMetricDoubleBuffer::Snapshot::Snapshot(Snapshot&&o):impl(o.impl), buffer(o.buffer){
+	o.impl = nullptr;
+}
+
+CustomizableContractionHierarchyMetricDoubleBuffer::Snapshot&CustomizableContractionHierarchyMetricDoubleBuffer::Snapshot::operator=(Snapshot&&o){
+	if(this != &o){
+		release();
+		impl = o.impl;
+		buffer = o.buffer;
+		o.impl = nullptr;
+	}
+	return *this;
+}
+
+void CustomizableContractionHierarchyMetricDoubleBuffer::Snapshot::release(){
+	if(impl != nullptr){
+		impl->reader_count[buffer].fetch_sub(1);
+		impl = nullptr;
+	}
+}
+
+const CustomizableContractionHierarchyMetric&CustomizableContractionHierarchyMetricDoubleBuffer::Snapshot::get_metric()const{
+	assert(impl != nullptr && "snapshot was released");
+	return impl->metric[buffer];
+}
+
+unsigned long long CustomizableContractionHierarchyMetricDoubleBuffer::Snapshot::get_epoch()const{
+	assert(impl != nullptr && "snapshot was released");
+	return impl->epoch[buffer];
+}
+
+CustomizableContractionHierarchyMetricDoubleBuffer::CustomizableContractionHierarchyMetricDoubleBuffer(){}
+
+CustomizableContractionHierarchyMetricDoubleBuffer::CustomizableContractionHierarchyMetricDoubleBuffer(const CustomizableContractionHierarchy&cch, std::vector<unsigned>input_weight):
+	impl(new Impl){
+	assert(input_weight.size() == cch.input_arc_count() && "Input weight vector has the wrong size");
+
+	impl->cch = &cch;
+	impl->input_weight[0] = std::move(input_weight);
+	impl->metric[0].reset(cch, impl->input_weight[0]);
+	impl->metric[0].customize();
+	impl->epoch[0] = 0;
+
+	impl->input_weight[1] = impl->input_weight[0];
+	impl->metric[1] = impl->metric[0];
+	impl->metric[1].reset(impl->input_weight[1]);
+	impl->epoch[1] = 0;
+
+	impl->current.store(0);
+	impl->reader_count[0].store(0);
+	impl->reader_count[1].store(0);
+	impl->current_epoch.store(0);
+
+	impl->partial_customization.reset(cch);
+	impl->was_last_update_partial = true;
+}
+
+CustomizableContractionHierarchyMetricDoubleBuffer::CustomizableContractionHierarchyMetricDoubleBuffer(CustomizableContractionHierarchyMetricDoubleBuffer&&) = default;
+CustomizableContractionHierarchyMetricDoubleBuffer&CustomizableContractionHierarchyMetricDoubleBuffer::operator=(CustomizableContractionHierarchyMetricDoubleBuffer&&) = default;
+
+CustomizableContractionHierarchyMetricDoubleBuffer::~CustomizableContractionHierarchyMetricDoubleBuffer(){
+	assert((!impl || (impl->reader_count[0].load() == 0 && impl->reader_count[1].load() == 0)) && "all snapshots must be released before the double buffer is destroyed");
+}
+
+CustomizableContractionHierarchyMetricDoubleBuffer::Snapshot CustomizableContractionHierarchyMetricDoubleBuffer::get_snapshot()const{
+	assert(impl && "double buffer is not initialized");
+	for(;;){
+		unsigned buffer = impl->current.load();
+		impl->reader_count[buffer].fetch_add(1);
+		// If an update published the other buffer in the meantime, it might already be overwriting
+		// this one. The update cannot have missed our reader count otherwise.
+		if(impl->current.load() == buffer)
+			return Snapshot(impl.get(), buffer);
+		impl->reader_count[buffer].fetch_sub(1);
+	}
+}
+
+unsigned long long CustomizableContractionHierarchyMetricDoubleBuffer::get_epoch()const{
+	assert(impl && "double buffer is not initialized");
+	return impl->current_epoch.load();
+}
+
+unsigned long long CustomizableContractionHierarchyMetricDoubleBuffer::update_all_weights(std::vector<unsigned>input_weight){
+	assert(impl && "double buffer is not initialized");
+	assert(input_weight.size() == impl->cch->input_arc_count() && "Input weight vector has the wrong size");
+
+	std::lock_guard<std::mutex>guard(impl->update_lock);
+	unsigned back = impl->wait_for_back_buffer();
+
+	impl->input_weight[back] = std::move(input_weight);
+	impl->metric[back].reset(impl->input_weight[back]);
+	impl->metric[back].customize();
+
+	impl->last_changed_arc.clear();
+	impl->was_last_update_partial = false;
+
+	return impl->publish(back);
+}
+
+unsigned long long CustomizableContractionHierarchyMetricDoubleBuffer::update_some_weights(const std::vector<unsigned>&arc, const std::vector<unsigned>&weight){
+	assert(impl && "double buffer is not initialized");
+	assert(arc.size() == weight.size() && "arc and weight must have the same size");
+
+	std::lock_guard<std::mutex>guard(impl->update_lock);
+	unsigned back = impl->wait_for_back_buffer();
+	unsigned front = 1 - back;
+
+	CustomizableContractionHierarchyMetric&metric = impl->metric[back];
+
+	if(impl->was_last_update_partial){
+		for(unsigned a:impl->last_changed_arc){
+			impl->input_weight[back][a] = impl->input_weight[front][a];
+			impl->partial_customization.update_arc(a);
+		}
+	}else{
+		// A partial customization cannot catch up with a full update, so the current metric is copied.
+		impl->input_weight[back] = impl->input_weight[front];
+		metric.forward = impl->metric[front].forward;
+		metric.backward = impl->metric[front].backward;
+		metric.reset(impl->input_weight[back]);
+	}
+
+	for(unsigned i=0; i<arc.size(); ++i){
+		assert(arc[i] < impl->cch->input_arc_count() && "arc out of bounds");
+		impl->input_weight[back][arc[i]] = weight[i];
+		impl->partial_customization.update_arc(arc[i]);
+	}
+	impl->partial_customization.customize(metric);
+
+	impl->last_changed_arc = arc;
+	impl->was_last_update_partial = true;
+
+	return impl->publish(back);
+}
+
+} // namespace RoutingKit
@@ -31,10 +31,16 @@ namespace RoutingKit{namespace detail{
 		return 0;
 	}
 
+	// All emulated atomic operations share one mutex, so that they are atomic with respect to each other.
+	inline
+	std::mutex&get_emulated_atomic_mutex(){
+		static std::mutex m;
+		return m;
+	}
+
 	template<class T>
 	bool emulated_sync_bool_compare_and_swap(T*var, T comp_value, T new_value){
-		static std::mutex m;
-		std::lock_guard<std::mutex> lock(m);
+		std::lock_guard<std::mutex> lock(get_emulated_atomic_mutex());
 
 		std::atomic_thread_fence(std::memory_order_seq_cst);
 
@@ -48,6 +54,18 @@ namespace RoutingKit{namespace detail{
 		}
 	}
 
+	template<class T>
+	T emulated_atomic_load_n(const T*var){
+		std::lock_guard<std::mutex> lock(get_emulated_atomic_mutex());
+		return *var;
+	}
+
+	template<class T>
+	void emulated_atomic_store_n(T*var, T value){
+		std::lock_guard<std::mutex> lock(get_emulated_atomic_mutex());
+		*var = value;
+	}
+
 }}
 
 #define __builtin_popcount(x) ::RoutingKit::detail::emulated_builtin_popcount(x)
@@ -58,5 +76,10 @@ namespace RoutingKit{namespace detail{
 
 #define __sync_bool_compare_and_swap(x, y, z) ::RoutingKit::detail::emulated_sync_bool_compare_and_swap(x, y, z)
 
+// The memory order is ignored, as the emulation is always sequentially consistent.
+#define __atomic_load_n(x, y) ::RoutingKit::detail::emulated_atomic_load_n(x)
+
+#define __atomic_store_n(x, y, z) ::RoutingKit::detail::emulated_atomic_store_n(x, y)
+
 #endif
 #endif
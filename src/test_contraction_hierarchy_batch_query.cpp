@@ -0,0 +1,113 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+
+	try{
+		string ch_file;
+		string source_file;
+		string target_file;
+		string distance_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " ch_file source_file target_file distance_file" << endl;
+			return 1;
+		}else{
+			ch_file = argv[1];
+			source_file = argv[2];
+			target_file = argv[3];
+			distance_file = argv[4];
+		}
+
+		cout << "Loading Contraction Hierarchy ... " << flush;
+
+		ContractionHierarchy ch = ContractionHierarchy::load_file(ch_file);
+
+		cout << "done" << endl;
+
+		cout << "Loading test queries ... " << flush;
+
+		auto source = load_vector<unsigned>(source_file);
+		auto target = load_vector<unsigned>(target_file);
+		auto ref_distance = load_vector<unsigned>(distance_file);
+
+		cout << "done" << endl;
+
+		const unsigned query_count = source.size();
+
+		ContractionHierarchyQuery ch_query(ch);
+
+		for(unsigned thread_count : {1u, 4u, 0u}){
+			ContractionHierarchyBatchQuery batch_query(ch, thread_count);
+
+			cout << "Running test queries with " << batch_query.get_thread_count() << " threads ... " << flush;
+
+			long long time = -get_micro_time();
+			auto distance = batch_query.get_distances(source, target);
+			time += get_micro_time();
+
+			cout << "done" << endl;
+			cout << "avg time per query : " << time/query_count << "musec" << endl;
+
+			if(distance != ref_distance)
+				throw runtime_error("Batch distances are wrong");
+
+			auto node_path = batch_query.get_node_paths(source, target);
+			auto arc_path = batch_query.get_arc_paths(source, target);
+			vector<unsigned>path_distance(query_count);
+			vector<vector<unsigned>>tmp_path(query_count);
+			batch_query.get_arc_paths(source, target, path_distance.data(), tmp_path.data());
+
+			if(path_distance != ref_distance)
+				throw runtime_error("Distances returned along with the paths are wrong");
+			if(tmp_path != arc_path)
+				throw runtime_error("The arc paths of both interfaces differ");
+
+			for(unsigned i=0; i<query_count; ++i){
+				ch_query.reset().add_source(source[i]).add_target(target[i]).run();
+				if(node_path[i] != ch_query.get_node_path())
+					throw runtime_error("Node path of query "+std::to_string(i)+" is wrong");
+				if(arc_path[i] != ch_query.get_arc_path())
+					throw runtime_error("Arc path of query "+std::to_string(i)+" is wrong");
+			}
+
+			vector<unsigned>sub_source(source.begin(), source.begin() + std::min(query_count, 100u));
+			vector<unsigned>sub_target(target.begin(), target.begin() + std::min(query_count, 20u));
+
+			auto table = batch_query.get_distances_to_targets(sub_source, sub_target);
+			if(table.size() != sub_source.size()*sub_target.size())
+				throw runtime_error("One-to-many table has the wrong size");
+
+			for(unsigned s=0; s<sub_source.size(); ++s){
+				for(unsigned t=0; t<sub_target.size(); ++t){
+					ch_query.reset().add_source(sub_source[s]).add_target(sub_target[t]).run();
+					if(table[s*sub_target.size()+t] != ch_query.get_distance())
+						throw runtime_error("One-to-many distance from "+std::to_string(s)+" to "+std::to_string(t)+" is wrong");
+				}
+			}
+		}
+
+		{
+			ContractionHierarchyBatchQuery batch_query(ch, 4);
+			if(!batch_query.get_distances({}, {}).empty())
+				throw runtime_error("Empty batch gives non-empty result");
+			if(!batch_query.get_distances_to_targets({}, target).empty())
+				throw runtime_error("Empty one-to-many batch gives non-empty result");
+		}
+
+		cout << "No error with batch queries found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
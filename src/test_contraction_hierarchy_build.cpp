@@ -0,0 +1,81 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+using namespace RoutingKit;
+using namespace std;
+
+namespace{
+	string serialize(const ContractionHierarchy&ch){
+		string data;
+		ch.write([&](const char*p, unsigned long long n){ data.append(p, n); });
+		return data;
+	}
+}
+
+int main(int argc, char*argv[]){
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string reference_ch_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " first_out head weight_file reference_ch" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			reference_ch_file = argv[4];
+		}
+
+		cout << "Loading Graph ... " << flush;
+
+		auto first_out = load_vector<unsigned>(first_out_file);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(head_file);
+		auto weight = load_vector<unsigned>(weight_file);
+		const unsigned node_count = first_out.size()-1;
+
+		cout << "done" << endl;
+
+		cout << "Loading reference CH ... " << flush;
+
+		auto reference_ch = ContractionHierarchy::load_file(reference_ch_file);
+
+		cout << "done" << endl;
+
+		cout << "Building CH ... " << flush;
+
+		long long timer = -get_micro_time();
+		auto ch = ContractionHierarchy::build(node_count, tail, head, weight, [](const std::string&){}, ContractionHierarchy::default_max_pop_count, 1);
+		timer += get_micro_time();
+
+		cout << "done [" << timer << "musec]" << endl;
+
+		// The construction is deterministic. Changes to how the graph is stored during the contraction
+		// must not change the order or the arcs of the CH.
+		if(ch.order != reference_ch.order)
+			throw runtime_error("The order of the built CH differs from the reference CH");
+		if(ch.forward.head != reference_ch.forward.head || ch.forward.weight != reference_ch.forward.weight || ch.forward.first_out != reference_ch.forward.first_out)
+			throw runtime_error("The forward arcs of the built CH differ from the reference CH");
+		if(ch.backward.head != reference_ch.backward.head || ch.backward.weight != reference_ch.backward.weight || ch.backward.first_out != reference_ch.backward.first_out)
+			throw runtime_error("The backward arcs of the built CH differ from the reference CH");
+		if(serialize(ch) != serialize(reference_ch))
+			throw runtime_error("The built CH differs from the reference CH");
+
+		cout << "Built CH is identical to the reference CH" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
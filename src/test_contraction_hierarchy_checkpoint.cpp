@@ -0,0 +1,157 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <experimental/filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+namespace fs = std::experimental::filesystem;
+
+using namespace RoutingKit;
+using namespace std;
+
+namespace{
+	string serialize(const ContractionHierarchy&ch){
+		string data;
+		ch.write([&](const char*p, unsigned long long n){ data.append(p, n); });
+		return data;
+	}
+
+	struct AbortBuild{};
+
+	bool starts_with(const string&s, const string&prefix){
+		return s.compare(0, prefix.size(), prefix) == 0;
+	}
+}
+
+int main(int argc, char*argv[]){
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+
+		if(argc != 4){
+			cerr << argv[0] << " first_out head weight_file" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+		}
+
+		cout << "Loading Graph ... " << flush;
+
+		auto first_out = load_vector<unsigned>(first_out_file);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(head_file);
+		auto weight = load_vector<unsigned>(weight_file);
+		const unsigned node_count = first_out.size()-1;
+
+		cout << "done" << endl;
+
+		const string checkpoint_dir = (fs::temp_directory_path() / "routingkit_test_contraction_hierarchy_checkpoint").string();
+		const string checkpoint_file = (fs::path(checkpoint_dir) / "ch_build_checkpoint").string();
+		fs::remove_all(checkpoint_dir);
+
+		long long timer;
+
+		cout << "Building reference CH ... " << flush;
+		timer = -get_micro_time();
+		string reference_ch = serialize(ContractionHierarchy::build(node_count, tail, head, weight));
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		// A checkpoint interval of zero writes a checkpoint after every contraction. The build is aborted
+		// by throwing from the log callback once enough checkpoints have been written.
+		const unsigned abort_after_checkpoint_count = 100;
+		auto build_and_abort = [&]{
+			cout << "Building CH and aborting after " << abort_after_checkpoint_count << " checkpoints ... " << flush;
+			unsigned checkpoint_count = 0;
+			try{
+				ContractionHierarchy::build_with_checkpoints(
+					node_count, tail, head, weight, checkpoint_dir, 0,
+					[&](const std::string&msg){
+						if(starts_with(msg, "Wrote checkpoint") && ++checkpoint_count == abort_after_checkpoint_count)
+							throw AbortBuild();
+					}
+				);
+				throw runtime_error("The build was not aborted");
+			}catch(AbortBuild&){}
+			if(!fs::exists(checkpoint_file))
+				throw runtime_error("The aborted build did not leave a checkpoint behind");
+			cout << "done" << endl;
+		};
+
+		build_and_abort();
+
+		cout << "Resuming CH build ... " << flush;
+		timer = -get_micro_time();
+		bool was_resumed = false;
+		ContractionHierarchy resumed_ch = ContractionHierarchy::build_with_checkpoints(
+			node_count, tail, head, weight, checkpoint_dir, 3600,
+			[&](const std::string&msg){
+				if(msg == "Resumed from checkpoint. " + std::to_string(abort_after_checkpoint_count) + " of " + std::to_string(node_count) + " nodes are already contracted.")
+					was_resumed = true;
+			}
+		);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		if(!was_resumed)
+			throw runtime_error("The build did not resume from the checkpoint");
+		if(fs::exists(checkpoint_file))
+			throw runtime_error("The checkpoint was not removed after the build completed");
+		if(serialize(resumed_ch) != reference_ch)
+			throw runtime_error("The resumed CH differs from the CH built without interruption");
+		cout << "Resumed CH is identical to the CH built without interruption" << endl;
+
+		build_and_abort();
+
+		cout << "Resuming CH build with a different input graph ... " << flush;
+		{
+			auto other_weight = weight;
+			++other_weight[0];
+			bool was_rejected = false;
+			try{
+				ContractionHierarchy::build_with_checkpoints(node_count, tail, head, other_weight, checkpoint_dir, 3600);
+			}catch(runtime_error&){
+				was_rejected = true;
+			}
+			if(!was_rejected)
+				throw runtime_error("A checkpoint of a different input graph was accepted");
+		}
+		cout << "done" << endl;
+		cout << "Checkpoint of a different input graph was rejected" << endl;
+
+		cout << "Resuming CH build from truncated checkpoints ... " << flush;
+		{
+			const unsigned long long checkpoint_size = fs::file_size(checkpoint_file);
+			for(unsigned long long truncated_size : {checkpoint_size - 1, checkpoint_size / 2, 12ull, 0ull}){
+				fs::resize_file(checkpoint_file, truncated_size);
+				bool was_rejected = false;
+				try{
+					ContractionHierarchy::build_with_checkpoints(node_count, tail, head, weight, checkpoint_dir, 3600);
+				}catch(runtime_error&){
+					was_rejected = true;
+				}
+				if(!was_rejected)
+					throw runtime_error("A checkpoint truncated to "+std::to_string(truncated_size)+" of "+std::to_string(checkpoint_size)+" bytes was accepted");
+			}
+		}
+		cout << "done" << endl;
+		cout << "Truncated checkpoints were rejected" << endl;
+
+		fs::remove_all(checkpoint_dir);
+
+		cout << "No error with CH checkpoints found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,279 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/min_max.h>
+#include <routingkit/timer.h>
+
+#include <experimental/filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = std::experimental::filesystem;
+
+using namespace RoutingKit;
+using namespace std;
+
+namespace{
+	template<class F>
+	bool throws_runtime_error(const F&f){
+		try{
+			f();
+		}catch(runtime_error&){
+			return true;
+		}
+		return false;
+	}
+
+	string read_file(const string&file_name){
+		string data;
+		auto bytes = load_vector<char>(file_name);
+		data.assign(bytes.begin(), bytes.end());
+		return data;
+	}
+}
+
+int main(int argc, char*argv[]){
+
+	try{
+		string ch_file;
+		string source_file;
+		string target_file;
+		string distance_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " ch_file source_file target_file distance_file" << endl;
+			return 1;
+		}else{
+			ch_file = argv[1];
+			source_file = argv[2];
+			target_file = argv[3];
+			distance_file = argv[4];
+		}
+
+		cout << "Loading Contraction Hierarchy ... " << flush;
+
+		ContractionHierarchy ch = ContractionHierarchy::load_file(ch_file);
+
+		cout << "done" << endl;
+
+		cout << "Loading test queries ... " << flush;
+
+		auto source = load_vector<unsigned>(source_file);
+		auto target = load_vector<unsigned>(target_file);
+		auto ref_distance = load_vector<unsigned>(distance_file);
+
+		cout << "done" << endl;
+
+		const unsigned query_count = source.size();
+
+		unsigned long long full_size, distance_only_size, compressed_size;
+		{
+			ostringstream out;
+			ch.write(out);
+			full_size = out.str().size();
+		}
+
+		cout << "Writing and reading distance-only CH ... " << flush;
+
+		ContractionHierarchy distance_only_ch;
+		{
+			stringstream buffer;
+			ch.write_distance_only(buffer);
+			distance_only_size = buffer.str().size();
+			distance_only_ch = ContractionHierarchy::read(buffer, distance_only_size);
+		}
+
+		cout << "done" << endl;
+
+		if(distance_only_ch.has_path_data())
+			throw runtime_error("distance-only CH claims to have path data");
+		if(!ch.has_path_data())
+			throw runtime_error("full CH claims to have no path data");
+		check_contraction_hierarchy_for_errors(distance_only_ch);
+
+		{
+			ostringstream out;
+			distance_only_ch.write(out);
+			if(out.str().size() != distance_only_size)
+				throw runtime_error("writing a distance-only CH does not give a distance-only file");
+		}
+
+		cout << "Building and writing compressed CH ... " << flush;
+
+		CompressedContractionHierarchy compressed_ch;
+		{
+			CompressedContractionHierarchy tmp(ch);
+			string buffer;
+			tmp.write([&](const char*p, unsigned long long l){buffer.append(p, l);});
+			compressed_size = buffer.size();
+			unsigned long long pos = 0;
+			compressed_ch = CompressedContractionHierarchy::read([&](char*p, unsigned long long l){
+				if(pos + l > buffer.size())
+					throw runtime_error("read past end of compressed CH");
+				std::copy(buffer.begin() + pos, buffer.begin() + pos + l, p);
+				pos += l;
+			});
+			if(pos != buffer.size())
+				throw runtime_error("compressed CH was not read completely");
+		}
+
+		cout << "done" << endl;
+
+		cout << "Saving, loading, and mapping distance-only and compressed CH files ... " << flush;
+
+		const string tmp_dir = (fs::temp_directory_path() / "routingkit_test_contraction_hierarchy_distance_only").string();
+		fs::remove_all(tmp_dir);
+		fs::create_directories(tmp_dir);
+		const string distance_only_file = tmp_dir + "/distance_only_ch";
+		const string resaved_distance_only_file = tmp_dir + "/resaved_distance_only_ch";
+		const string compressed_file = tmp_dir + "/compressed_ch";
+
+		ch.save_distance_only_file(distance_only_file);
+		ContractionHierarchy loaded_distance_only_ch = ContractionHierarchy::load_file(distance_only_file);
+		ContractionHierarchyView mapped_distance_only_ch = ContractionHierarchyView::map_file(distance_only_file);
+		loaded_distance_only_ch.save_file(resaved_distance_only_file);
+
+		compressed_ch.save_file(compressed_file);
+		CompressedContractionHierarchy loaded_compressed_ch = CompressedContractionHierarchy::load_file(compressed_file);
+
+		cout << "done" << endl;
+
+		if(loaded_distance_only_ch.has_path_data() || mapped_distance_only_ch.has_path_data())
+			throw runtime_error("loaded or mapped distance-only CH claims to have path data");
+		if(fs::file_size(distance_only_file) != distance_only_size)
+			throw runtime_error("save_distance_only_file and write_distance_only produce files of different size");
+		if(read_file(resaved_distance_only_file) != read_file(distance_only_file))
+			throw runtime_error("saving a loaded distance-only CH with save_file does not reproduce the distance-only file");
+		if(
+			loaded_distance_only_ch.rank != ch.rank || loaded_distance_only_ch.order != ch.order ||
+			loaded_distance_only_ch.forward.first_out != ch.forward.first_out || loaded_distance_only_ch.forward.head != ch.forward.head || loaded_distance_only_ch.forward.weight != ch.forward.weight ||
+			loaded_distance_only_ch.backward.first_out != ch.backward.first_out || loaded_distance_only_ch.backward.head != ch.backward.head || loaded_distance_only_ch.backward.weight != ch.backward.weight
+		)
+			throw runtime_error("loaded distance-only CH differs from the full CH");
+		check_contraction_hierarchy_for_errors(loaded_distance_only_ch);
+
+		if(fs::file_size(compressed_file) != compressed_size)
+			throw runtime_error("save_file and write of the compressed CH produce files of different size");
+		if(
+			loaded_compressed_ch.rank != compressed_ch.rank || loaded_compressed_ch.weight_byte_count != compressed_ch.weight_byte_count ||
+			loaded_compressed_ch.forward.block_first_byte != compressed_ch.forward.block_first_byte || loaded_compressed_ch.forward.first_byte != compressed_ch.forward.first_byte || loaded_compressed_ch.forward.arc_data != compressed_ch.forward.arc_data ||
+			loaded_compressed_ch.backward.block_first_byte != compressed_ch.backward.block_first_byte || loaded_compressed_ch.backward.first_byte != compressed_ch.backward.first_byte || loaded_compressed_ch.backward.arc_data != compressed_ch.backward.arc_data
+		)
+			throw runtime_error("loaded compressed CH differs from the written compressed CH");
+
+		cout << "full file size : " << full_size << " bytes" << endl;
+		cout << "distance-only file size : " << distance_only_size << " bytes" << endl;
+		cout << "compressed file size : " << compressed_size << " bytes" << endl;
+		cout << "compressed weight byte count : " << compressed_ch.weight_byte_count << endl;
+
+		ContractionHierarchyQuery ch_query(ch);
+		ContractionHierarchyQuery distance_only_query(distance_only_ch);
+		ContractionHierarchyQuery mapped_distance_only_query(mapped_distance_only_ch);
+		CompressedContractionHierarchyQuery compressed_query(compressed_ch);
+		CompressedContractionHierarchyQuery loaded_compressed_query(loaded_compressed_ch);
+
+		long long ch_time = 0, compressed_time = 0;
+		long long ch_settled_node_sum = 0, compressed_settled_node_sum = 0;
+
+		cout << "Running test queries ... " << flush;
+
+		for(unsigned i=0; i<query_count; ++i){
+			ch_time -= get_micro_time();
+			ch_query.reset().add_source(source[i]).add_target(target[i]).run();
+			ch_time += get_micro_time();
+			ch_settled_node_sum += ch_query.get_settled_node_count();
+
+			if(ch_query.get_distance() != ref_distance[i])
+				throw runtime_error("Distance query "+std::to_string(i)+" is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(ch_query.get_distance()));
+
+			distance_only_query.reset().add_source(source[i]).add_target(target[i]).run();
+			if(distance_only_query.get_distance() != ref_distance[i])
+				throw runtime_error("Distance query "+std::to_string(i)+" on the distance-only CH is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(distance_only_query.get_distance()));
+			if(ref_distance[i] != inf_weight && distance_only_query.get_used_source() != source[i])
+				throw runtime_error("get_used_source on the distance-only CH returns wrong value");
+
+			mapped_distance_only_query.reset().add_source(source[i]).add_target(target[i]).run();
+			if(mapped_distance_only_query.get_distance() != ref_distance[i])
+				throw runtime_error("Distance query "+std::to_string(i)+" on the mapped distance-only CH is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(mapped_distance_only_query.get_distance()));
+
+			compressed_time -= get_micro_time();
+			compressed_query.reset().add_source(source[i]).add_target(target[i]).run();
+			compressed_time += get_micro_time();
+			compressed_settled_node_sum += compressed_query.get_settled_node_count();
+
+			if(compressed_query.get_distance() != ref_distance[i])
+				throw runtime_error("Distance query "+std::to_string(i)+" on the compressed CH is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(compressed_query.get_distance()));
+
+			loaded_compressed_query.reset().add_source(source[i]).add_target(target[i]).run();
+			if(loaded_compressed_query.get_distance() != ref_distance[i])
+				throw runtime_error("Distance query "+std::to_string(i)+" on the loaded compressed CH is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(loaded_compressed_query.get_distance()));
+		}
+
+		cout << "done" << endl;
+
+		cout << "Running test queries with two sources and two targets ... " << flush;
+
+		// Every test query is paired with the next one. The reference distance of the pair is the minimum
+		// over the four combinations of sources and targets. The two crossed ones are computed on the full CH.
+		for(unsigned i=0; i+1<query_count; ++i){
+			unsigned expected = std::min(ref_distance[i], ref_distance[i+1]);
+			min_to(expected, ch_query.reset().add_source(source[i]).add_target(target[i+1]).run().get_distance());
+			min_to(expected, ch_query.reset().add_source(source[i+1]).add_target(target[i]).run().get_distance());
+
+			ch_query.reset().add_source(source[i]).add_source(source[i+1]).add_target(target[i]).add_target(target[i+1]).run();
+			if(ch_query.get_distance() != expected)
+				throw runtime_error("Query with two sources and two targets "+std::to_string(i)+" is wrong");
+
+			distance_only_query.reset().add_source(source[i]).add_source(source[i+1]).add_target(target[i]).add_target(target[i+1]).run();
+			if(distance_only_query.get_distance() != expected)
+				throw runtime_error("Query with two sources and two targets "+std::to_string(i)+" on the distance-only CH is wrong");
+
+			compressed_query.reset().add_source(source[i]).add_source(source[i+1]).add_target(target[i]).add_target(target[i+1]).run();
+			if(compressed_query.get_distance() != expected)
+				throw runtime_error("Query with two sources and two targets "+std::to_string(i)+" on the compressed CH is wrong");
+		}
+
+		cout << "done" << endl;
+
+		cout << "Extracting paths from distance-only CHs ... " << flush;
+
+		distance_only_query.reset().add_source(source[0]).add_target(target[0]).run();
+		mapped_distance_only_query.reset().add_source(source[0]).add_target(target[0]).run();
+		if(
+			!throws_runtime_error([&]{distance_only_query.get_arc_path();}) ||
+			!throws_runtime_error([&]{distance_only_query.get_node_path();}) ||
+			!throws_runtime_error([&]{mapped_distance_only_query.get_arc_path();}) ||
+			!throws_runtime_error([&]{mapped_distance_only_query.get_node_path();})
+		)
+			throw runtime_error("extracting a path from a distance-only CH does not throw");
+
+		{
+			ContractionHierarchyBatchQuery batch_query(distance_only_ch, 2);
+			if(
+				!throws_runtime_error([&]{batch_query.get_node_paths(source, target);}) ||
+				!throws_runtime_error([&]{batch_query.get_arc_paths(source, target);})
+			)
+				throw runtime_error("extracting batch paths from a distance-only CH does not throw");
+			if(batch_query.get_distances(source, target) != ref_distance)
+				throw runtime_error("batch distance queries on the distance-only CH are wrong");
+		}
+
+		cout << "done" << endl;
+
+		if(ch_settled_node_sum != compressed_settled_node_sum)
+			throw runtime_error("The compressed query settles a different number of nodes");
+
+		cout << "avg running time : " << ch_time/query_count << "musec" << endl;
+		cout << "avg compressed running time : " << compressed_time/query_count << "musec" << endl;
+
+		fs::remove_all(tmp_dir);
+
+		cout << "No error with distance-only CHs found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,139 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+
+	try{
+		string ch_file;
+
+		if(argc != 2){
+			cerr << argv[0] << " ch_file" << endl;
+			return 1;
+		}else{
+			ch_file = argv[1];
+		}
+
+		cout << "Loading Contraction Hierarchy ... " << flush;
+
+		ContractionHierarchy ch = ContractionHierarchy::load_file(ch_file);
+
+		cout << "done" << endl;
+
+		cout << "Generating queries ... " << flush;
+
+		const unsigned
+			source_count = 300,
+			target_count = 500;
+
+		std::vector<unsigned>
+			source_set(source_count),
+			target_set(target_count);
+
+		for(unsigned i=0; i<source_count; ++i)
+			source_set[i] = rand() % ch.node_count();
+		for(unsigned i=0; i<target_count; ++i)
+			target_set[i] = rand() % ch.node_count();
+
+		cout << "done" << endl;
+
+		std::vector<unsigned>pinned_result(source_count * target_count);
+
+		{
+			long long time = -get_micro_time();
+			cout << "Running pinned targets baseline ... " << flush;
+
+			ContractionHierarchyQuery ch_query(ch);
+			ch_query.reset().pin_targets(target_set);
+			for(unsigned s=0; s<source_count; ++s){
+				auto d = ch_query.reset_source().add_source(source_set[s]).run_to_pinned_targets().get_distances_to_targets();
+				for(unsigned t=0; t<target_count; ++t)
+					pinned_result[s*target_count + t] = d[t];
+			}
+
+			time += get_micro_time();
+
+			cout << "done ["<<time << "musec]" << endl;
+		}
+
+		std::vector<unsigned>many_to_many_result;
+		ContractionHierarchyManyToMany many_to_many(ch);
+
+		{
+			long long time = -get_micro_time();
+			cout << "Running bucket many-to-many ... " << flush;
+
+			many_to_many.reset().pin_targets(target_set);
+			long long pin_time = time + get_micro_time();
+			many_to_many_result = many_to_many.run(source_set).get_distances();
+
+			time += get_micro_time();
+
+			cout << "done ["<<time << "musec]" << endl;
+			cout << "pin_time" << " : " << pin_time << "musec" << endl;
+		}
+
+		if(many_to_many_result != pinned_result)
+			throw runtime_error("Many-to-many distances are not correct");
+
+		for(unsigned s=0; s<source_count; s+=37)
+			for(unsigned t=0; t<target_count; t+=41)
+				if(many_to_many.get_distance(s, t) != pinned_result[s*target_count + t])
+					throw runtime_error("get_distance returns wrong value");
+
+		{
+			auto used_source = many_to_many.get_used_sources_to_targets();
+			for(unsigned t=0; t<target_count; ++t){
+				unsigned best = inf_weight;
+				for(unsigned s=0; s<source_count; ++s)
+					best = std::min(best, pinned_result[s*target_count + t]);
+				if(best == inf_weight){
+					if(used_source[t] != invalid_id)
+						throw runtime_error("used source found for an unreachable target");
+				}else{
+					unsigned d = ContractionHierarchyQuery(ch).add_source(used_source[t]).add_target(target_set[t]).run().get_distance();
+					if(d != best)
+						throw runtime_error("used source is not the closest source");
+				}
+			}
+		}
+
+		{
+			auto used_target = many_to_many.get_used_targets_to_sources();
+			for(unsigned s=0; s<source_count; ++s){
+				unsigned best = inf_weight;
+				for(unsigned t=0; t<target_count; ++t)
+					best = std::min(best, pinned_result[s*target_count + t]);
+				if(best == inf_weight){
+					if(used_target[s] != invalid_id)
+						throw runtime_error("used target found for an unreachable source");
+				}else{
+					unsigned d = ContractionHierarchyQuery(ch).add_source(source_set[s]).add_target(used_target[s]).run().get_distance();
+					if(d != best)
+						throw runtime_error("used target is not the closest target");
+				}
+			}
+		}
+
+		{
+			std::vector<unsigned>first_half(source_set.begin(), source_set.begin() + source_count/2);
+			auto d = many_to_many.run(first_half).get_distances();
+			if(!std::equal(d.begin(), d.end(), pinned_result.begin()))
+				throw runtime_error("Rerunning with other sources on the same pinned targets gives wrong distances");
+		}
+
+		cout << "No error with many-to-many found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,129 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string ch_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " first_out_file head_file weight_file ch_file" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			ch_file = argv[4];
+		}
+
+		cout << "Loading graph ... " << flush;
+
+		vector<unsigned>first_out = load_vector<unsigned>(first_out_file);
+		vector<unsigned>head = load_vector<unsigned>(head_file);
+		vector<unsigned>weight = load_vector<unsigned>(weight_file);
+		vector<unsigned>tail = invert_inverse_vector(first_out);
+
+		cout << "done" << endl;
+
+		cout << "Loading Contraction Hierarchy ... " << flush;
+
+		ContractionHierarchy ch = ContractionHierarchy::load_file(ch_file);
+
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+		if(ch.node_count() != node_count)
+			throw runtime_error("graph and CH have a different node count");
+
+		const unsigned source_count = 20;
+
+		std::vector<unsigned>source_list(source_count);
+		for(unsigned i=0; i<source_count; ++i)
+			source_list[i] = rand() % node_count;
+
+		std::vector<unsigned>dijkstra_result((unsigned long long)source_count * node_count);
+
+		{
+			long long time = -get_micro_time();
+			cout << "Running Dijkstra baseline ... " << flush;
+
+			Dijkstra dij(first_out, tail, head);
+			for(unsigned s=0; s<source_count; ++s){
+				dij.reset().add_source(source_list[s]);
+				while(!dij.is_finished())
+					dij.settle(ScalarGetWeight(weight));
+				for(unsigned x=0; x<node_count; ++x)
+					dijkstra_result[(unsigned long long)s*node_count + x] = dij.get_distance_to(x);
+			}
+
+			time += get_micro_time();
+
+			cout << "done ["<<time << "musec]" << endl;
+		}
+
+		ContractionHierarchyOneToAll one_to_all(ch);
+
+		{
+			long long time = -get_micro_time();
+			cout << "Running PHAST ... " << flush;
+
+			for(unsigned s=0; s<source_count; ++s){
+				auto d = one_to_all.reset().add_source(source_list[s]).run().get_distances();
+				if(!std::equal(d.begin(), d.end(), dijkstra_result.begin() + (unsigned long long)s*node_count))
+					throw runtime_error("PHAST distances are not correct");
+			}
+
+			time += get_micro_time();
+
+			cout << "done ["<<time << "musec]" << endl;
+		}
+
+		{
+			long long time = -get_micro_time();
+			cout << "Running batched PHAST ... " << flush;
+
+			auto d = one_to_all.get_distances_from_sources(source_list);
+
+			time += get_micro_time();
+
+			cout << "done ["<<time << "musec]" << endl;
+
+			if(d != dijkstra_result)
+				throw runtime_error("Batched PHAST distances are not correct");
+		}
+
+		{
+			one_to_all.reset();
+			for(unsigned s=0; s<source_count; ++s)
+				one_to_all.add_source(source_list[s]);
+			one_to_all.run();
+			for(unsigned x=0; x<node_count; ++x){
+				unsigned best = inf_weight;
+				for(unsigned s=0; s<source_count; ++s)
+					best = std::min(best, dijkstra_result[(unsigned long long)s*node_count + x]);
+				if(one_to_all.get_distance(x) != best)
+					throw runtime_error("Multi-source PHAST distances are not correct");
+			}
+		}
+
+		cout << "No error with one-to-all found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+using namespace RoutingKit;
+using namespace std;
+
+namespace{
+	string serialize(const ContractionHierarchy&ch){
+		string data;
+		ch.write([&](const char*p, unsigned long long n){ data.append(p, n); });
+		return data;
+	}
+
+	void check_queries(const ContractionHierarchy&ch, const string&name, const vector<unsigned>&source, const vector<unsigned>&target, const vector<unsigned>&ref_distance){
+		check_contraction_hierarchy_for_errors(ch);
+
+		ContractionHierarchyQuery query(ch);
+		for(unsigned i=0; i<source.size(); ++i){
+			query.reset().add_source(source[i]).add_target(target[i]).run();
+			if(query.get_distance() != ref_distance[i])
+				throw runtime_error("Distance query "+std::to_string(i)+" on the "+name+" is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(query.get_distance()));
+		}
+	}
+}
+
+int main(int argc, char*argv[]){
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string source_file;
+		string target_file;
+		string distance_file;
+
+		if(argc != 7){
+			cerr << argv[0] << " first_out head weight_file source_file target_file distance_file" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			source_file = argv[4];
+			target_file = argv[5];
+			distance_file = argv[6];
+		}
+
+		cout << "Loading Graph ... " << flush;
+
+		auto first_out = load_vector<unsigned>(first_out_file);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(head_file);
+		auto weight = load_vector<unsigned>(weight_file);
+		const unsigned node_count = first_out.size()-1;
+
+		auto source = load_vector<unsigned>(source_file);
+		auto target = load_vector<unsigned>(target_file);
+		auto ref_distance = load_vector<unsigned>(distance_file);
+
+		cout << "done" << endl;
+
+		const unsigned thread_count = 4;
+		long long timer;
+
+		auto build = [&](unsigned thread_count, bool contract_independent_node_sets){
+			cout << "Building CH using " << thread_count << " threads" << (thread_count > 1 && contract_independent_node_sets ? " and independent node sets" : "") << " ... " << flush;
+			timer = -get_micro_time();
+			auto ch = ContractionHierarchy::build(node_count, tail, head, weight, [](const std::string&){}, ContractionHierarchy::default_max_pop_count, thread_count, contract_independent_node_sets);
+			timer += get_micro_time();
+			cout << "done [" << timer << "musec]" << endl;
+			return ch;
+		};
+
+		ContractionHierarchy sequential_ch = build(1, true);
+		check_queries(sequential_ch, "sequentially built CH", source, target, ref_distance);
+
+		// Only the priorities are computed in parallel. The order and the CH are the same as with one thread.
+		ContractionHierarchy parallel_priority_ch = build(thread_count, false);
+		if(parallel_priority_ch.order != sequential_ch.order)
+			throw runtime_error("The order of the CH built with parallel priorities differs from the sequential order");
+		if(serialize(parallel_priority_ch) != serialize(sequential_ch))
+			throw runtime_error("The CH built with parallel priorities differs from the sequentially built CH");
+		cout << "CH built with parallel priorities is identical to the sequentially built CH" << endl;
+
+		// Independent node sets yield a different order, but the CH does not depend on the number of threads.
+		ContractionHierarchy independent_set_ch = build(thread_count, true);
+		check_queries(independent_set_ch, "CH built with independent node sets", source, target, ref_distance);
+		ContractionHierarchy two_thread_independent_set_ch = build(2, true);
+		if(serialize(two_thread_independent_set_ch) != serialize(independent_set_ch))
+			throw runtime_error("The CH built with independent node sets depends on the number of threads");
+		cout << "CH built with independent node sets is correct and does not depend on the number of threads" << endl;
+
+		cout << "Building CH given the order using " << thread_count << " threads ... " << flush;
+		timer = -get_micro_time();
+		ContractionHierarchy given_order_ch = ContractionHierarchy::build_given_order(sequential_ch.order, tail, head, weight, [](const std::string&){}, ContractionHierarchy::default_max_pop_count, thread_count);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+		if(given_order_ch.order != sequential_ch.order)
+			throw runtime_error("build_given_order did not use the given order");
+		check_queries(given_order_ch, "CH built given the order", source, target, ref_distance);
+
+		cout << "No error with parallel CH construction found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -51,6 +51,14 @@ int main(int argc, char*argv[]){
 
 		cout << "done" << endl;
 
+		cout << "Memory mapping Contraction Hierarchy ... " << flush;
+
+		long long map_time = -get_micro_time();
+		ContractionHierarchyView mapped_ch = ContractionHierarchyView::map_file(ch_file);
+		map_time += get_micro_time();
+
+		cout << "done ["<<map_time << "musec]" << endl;
+
 		cout << "Loading test queries ... " << flush;
 
 		auto source = load_vector<unsigned>(source_file);
@@ -65,6 +73,10 @@ int main(int argc, char*argv[]){
 
 		vector<unsigned>distance(query_count);
 		ContractionHierarchyQuery ch_query(ch);
+		ContractionHierarchyQuery no_stall_ch_query(ch);
+		no_stall_ch_query.set_stall_on_demand(false);
+		BasicContractionHierarchyQuery<RadixMinIDQueue> radix_ch_query(ch);
+		ContractionHierarchyQuery mapped_ch_query(mapped_ch);
 
 		cout << "Running test queries ... " << flush;
 
@@ -77,6 +89,9 @@ int main(int argc, char*argv[]){
 		long long node_path_time_max = 0;
 		long long node_path_time_sum = 0;
 
+		long long settled_node_sum = 0;
+		long long stalled_node_sum = 0;
+		long long no_stall_settled_node_sum = 0;
 
 		for(unsigned i=0; i<query_count; ++i){
 
@@ -91,6 +106,24 @@ int main(int argc, char*argv[]){
 				if(ch_query.get_distance() != ref_distance[i])
 					throw runtime_error("Distance query "+std::to_string(i)+" is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(ch_query.get_distance()));
 
+				settled_node_sum += ch_query.get_settled_node_count();
+				stalled_node_sum += ch_query.get_stalled_node_count();
+
+				no_stall_ch_query.reset().add_source(source[i]).add_target(target[i]).run();
+				if(no_stall_ch_query.get_distance() != ref_distance[i])
+					throw runtime_error("Distance query "+std::to_string(i)+" without stall-on-demand is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(no_stall_ch_query.get_distance()));
+				if(no_stall_ch_query.get_stalled_node_count() != 0)
+					throw runtime_error("nodes were stalled even though stall-on-demand is disabled");
+				no_stall_settled_node_sum += no_stall_ch_query.get_settled_node_count();
+
+				radix_ch_query.reset().add_source(source[i]).add_target(target[i]).run();
+				if(radix_ch_query.get_distance() != ref_distance[i])
+					throw runtime_error("Distance query "+std::to_string(i)+" with a radix queue is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(radix_ch_query.get_distance()));
+
+				mapped_ch_query.reset().add_source(source[i]).add_target(target[i]).run();
+				if(mapped_ch_query.get_distance() != ref_distance[i])
+					throw runtime_error("Distance query "+std::to_string(i)+" on the memory mapped CH is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(mapped_ch_query.get_distance()));
+
 				time = -get_micro_time();
 				auto arc_path = ch_query.get_arc_path();
 				time += get_micro_time();					
@@ -102,9 +135,42 @@ int main(int argc, char*argv[]){
 				auto node_path = ch_query.get_node_path();
 				time += get_micro_time();
 
+				if(mapped_ch_query.get_arc_path() != arc_path)
+					throw runtime_error("the memory mapped CH gives a different arc path");
+
 				node_path_time_max = std::max(node_path_time_max, time);
 				node_path_time_sum += time;
 
+				const QueryStatistics&statistics = ch_query.get_statistics();
+				#ifdef ROUTING_KIT_QUERY_STATISTICS
+				if(statistics.forward.settled_node_count + statistics.backward.settled_node_count != ch_query.get_settled_node_count())
+					throw runtime_error("statistics have a wrong number of settled nodes");
+				if(statistics.forward.stalled_node_count + statistics.backward.stalled_node_count != ch_query.get_stalled_node_count())
+					throw runtime_error("statistics have a wrong number of stalled nodes");
+				if(statistics.forward.settled_node_count + statistics.backward.settled_node_count == 0)
+					throw runtime_error("statistics have no settled nodes");
+				for(const QueryStatistics::Direction&dir:{statistics.forward, statistics.backward}){
+					if(dir.stalled_node_count > dir.settled_node_count)
+						throw runtime_error("statistics have more stalled than settled nodes");
+					// Only the source is settled without having been pushed by an arc relaxation.
+					if(dir.settled_node_count > dir.queue_push_count + 1)
+						throw runtime_error("statistics have more settled nodes than queue pushes");
+					if(dir.queue_push_count + dir.decrease_key_count > dir.relaxed_arc_count)
+						throw runtime_error("statistics have more queue operations than relaxed arcs");
+				}
+				if(source[i] != target[i] && ref_distance[i] != inf_weight && statistics.forward.relaxed_arc_count + statistics.backward.relaxed_arc_count == 0)
+					throw runtime_error("statistics have no relaxed arcs even though a path was found");
+				if(!arc_path.empty() && statistics.unpacking_depth >= arc_path.size())
+					throw runtime_error("statistics have an unpacking depth that is too large for the path");
+				#else
+				if(
+					statistics.forward.settled_node_count != 0 || statistics.backward.settled_node_count != 0 ||
+					statistics.forward.relaxed_arc_count != 0 || statistics.backward.relaxed_arc_count != 0 ||
+					statistics.unpacking_depth != 0 || statistics.unpacking_time != 0
+				)
+					throw runtime_error("statistics are recorded even though ROUTING_KIT_QUERY_STATISTICS is not defined");
+				#endif
+
 				if(source[i] == target[i]){
 					if(!arc_path.empty())
 						throw runtime_error("if s == t then the path should be empty");
@@ -156,6 +222,10 @@ int main(int argc, char*argv[]){
 		cout << "max arc path running time : " << arc_path_time_max << "musec" << endl;
 		cout << "avg arc path running time : " << arc_path_time_sum/query_count << "musec" << endl;
 
+		cout << "avg settled nodes : " << settled_node_sum/query_count << endl;
+		cout << "avg stalled nodes : " << stalled_node_sum/query_count << endl;
+		cout << "avg settled nodes without stall-on-demand : " << no_stall_settled_node_sum/query_count << endl;
+
 	}catch(exception&err){
 		cerr << "Stopped on exception : " << err.what() << endl;
 		return 1;
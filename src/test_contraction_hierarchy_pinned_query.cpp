@@ -55,6 +55,7 @@ int main(int argc, char*argv[]){
 			cout << "Running baseline ... " << flush;
 		
 			ContractionHierarchyQuery ch_query(ch);
+			ch_query.set_stall_on_demand(false);
 			for(unsigned s=0; s<source_count; ++s){
 				for(unsigned t=0; t<target_count; ++t){
 					optimal_result[s*target_count + t] = ch_query.reset().add_source(source_set[s]).add_target(target_set[t]).run().get_distance();
@@ -160,6 +161,27 @@ int main(int argc, char*argv[]){
 			cout << "No error with pinned target found" << endl;
 		}
 
+		std::vector<unsigned>batched_source_result;
+
+		{
+			long long time = -get_micro_time();
+			cout << "Running batched sources to pinned targets ... " << flush;
+
+			ContractionHierarchyQuery ch_query(ch);
+			ch_query.reset().pin_targets(target_set);
+			batched_source_result = ch_query.get_distances_from_sources_to_pinned_targets(source_set);
+
+			time += get_micro_time();
+
+			cout << "done [" << time << "musec]" << endl;
+		}
+
+		if(batched_source_result != optimal_result){
+			cout << "Batched sources are not correct" << endl;
+		} else {
+			cout << "No error with batched sources found" << endl;
+		}
+
 	}catch(exception&err){
 		cerr << "Stopped on exception : " << err.what() << endl;
 		return 1;
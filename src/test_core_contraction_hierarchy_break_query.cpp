@@ -0,0 +1,193 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/bit_vector.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <queue>
+#include <tuple>
+#include <functional>
+
+using namespace RoutingKit;
+using namespace std;
+
+// Label-setting search on the input graph with labels (travel time, driving time since the last break).
+unsigned compute_break_distance(
+	const vector<unsigned>&first_out, const vector<unsigned>&head, const vector<unsigned>&weight,
+	const BitVector&is_parking_node, unsigned max_driving_time, unsigned break_duration,
+	unsigned s, unsigned t
+){
+	typedef tuple<unsigned, unsigned, unsigned> Label; // travel time, driving time, node
+	priority_queue<Label, vector<Label>, greater<Label>>queue;
+	vector<vector<pair<unsigned, unsigned>>>bag(first_out.size()-1);
+
+	auto add_label = [&](unsigned x, unsigned travel_time, unsigned driving_time){
+		for(auto l:bag[x])
+			if(l.first <= travel_time && l.second <= driving_time)
+				return;
+		bag[x].push_back({travel_time, driving_time});
+		queue.push(Label{travel_time, driving_time, x});
+	};
+
+	add_label(s, 0, 0);
+	while(!queue.empty()){
+		unsigned travel_time, driving_time, x;
+		tie(travel_time, driving_time, x) = queue.top();
+		queue.pop();
+		if(x == t)
+			return travel_time;
+		if(is_parking_node.is_set(x) && driving_time != 0)
+			add_label(x, travel_time + break_duration, 0);
+		for(unsigned xy=first_out[x]; xy<first_out[x+1]; ++xy)
+			if(driving_time + weight[xy] <= max_driving_time)
+				add_label(head[xy], travel_time + weight[xy], driving_time + weight[xy]);
+	}
+	return inf_weight;
+}
+
+int main(int argc, char*argv[]){
+
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string ch_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " first_out_file head_file weight_file ch_file" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			ch_file = argv[4];
+		}
+
+		cout << "Loading graph ... " << flush;
+
+		vector<unsigned>first_out = load_vector<unsigned>(first_out_file);
+		vector<unsigned>head = load_vector<unsigned>(head_file);
+		vector<unsigned>weight = load_vector<unsigned>(weight_file);
+		vector<unsigned>tail = invert_inverse_vector(first_out);
+
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+
+		cout << "Building core CH ... " << flush;
+
+		ContractionHierarchy ch = ContractionHierarchy::load_file(ch_file);
+
+		BitVector is_parking_node(node_count, false);
+		for(unsigned i=0; i<node_count/50; ++i)
+			is_parking_node.set(rand() % node_count);
+
+		std::vector<unsigned>core;
+		ContractionHierarchy core_ch;
+		std::tie(core, core_ch) = ContractionHierarchy::build_excluding_core(ch.rank, is_parking_node, tail, head, weight);
+
+		cout << "done" << endl;
+
+		// Choose the driving time limit such that many routes need one or more breaks.
+		unsigned max_driving_time;
+		{
+			ContractionHierarchyQuery ch_query(ch);
+			std::vector<unsigned>d;
+			for(unsigned i=0; i<100; ++i)
+				d.push_back(ch_query.reset().add_source(rand() % node_count).add_target(rand() % node_count).run().get_distance());
+			std::sort(d.begin(), d.end());
+			max_driving_time = d[30];
+		}
+		const unsigned break_duration = max_driving_time / 8;
+
+		CoreContractionHierarchyBreakQuery query(core_ch, core.size(), is_parking_node, max_driving_time, break_duration);
+
+		const unsigned query_count = 100;
+		unsigned route_with_break_count = 0;
+		unsigned infeasible_count = 0;
+		long long created_label_count = 0;
+		long long pruned_label_count = 0;
+
+		long long time = 0;
+		cout << "Running break queries ... " << flush;
+
+		for(unsigned i=0; i<query_count; ++i){
+			unsigned s = rand() % node_count;
+			unsigned t = rand() % node_count;
+
+			time -= get_micro_time();
+			query.reset().add_source(s).add_target(t).run();
+			time += get_micro_time();
+
+			created_label_count += query.get_created_label_count();
+			pruned_label_count += query.get_pruned_label_count();
+
+			unsigned expected = compute_break_distance(first_out, head, weight, is_parking_node, max_driving_time, break_duration, s, t);
+			if(query.get_distance() != expected)
+				throw runtime_error("Break query distance is not correct");
+
+			if(expected == inf_weight){
+				++infeasible_count;
+				if(!query.get_arc_path().empty() || !query.get_node_path().empty())
+					throw runtime_error("Path found for infeasible query");
+				continue;
+			}
+
+			auto break_nodes = query.get_break_nodes();
+			if(query.get_break_count() != break_nodes.size())
+				throw runtime_error("Break count does not match break nodes");
+			if(!break_nodes.empty())
+				++route_with_break_count;
+			for(auto x:break_nodes)
+				if(!is_parking_node.is_set(x))
+					throw runtime_error("Break at a node that is no parking");
+
+			auto arc_path = query.get_arc_path();
+			auto node_path = query.get_node_path();
+			if(node_path.size() != arc_path.size()+1)
+				throw runtime_error("Node and arc path do not fit together");
+			if(node_path.front() != s || node_path.back() != t)
+				throw runtime_error("Path does not connect source and target");
+
+			unsigned driving_time = 0;
+			unsigned total_time = 0;
+			unsigned next_break = 0;
+			for(unsigned j=0; j<arc_path.size(); ++j){
+				if(next_break < break_nodes.size() && node_path[j] == break_nodes[next_break]){
+					driving_time = 0;
+					total_time += break_duration;
+					++next_break;
+				}
+				if(tail[arc_path[j]] != node_path[j] || head[arc_path[j]] != node_path[j+1])
+					throw runtime_error("Path is not connected");
+				driving_time += weight[arc_path[j]];
+				total_time += weight[arc_path[j]];
+				if(driving_time > max_driving_time)
+					throw runtime_error("Path exceeds the driving time limit");
+			}
+			if(next_break != break_nodes.size())
+				throw runtime_error("Break nodes are not on the path");
+			if(total_time != expected)
+				throw runtime_error("Path length is not correct");
+		}
+
+		cout << "done ["<<time << "musec]" << endl;
+		cout << "routes with break : " << route_with_break_count << endl;
+		cout << "infeasible routes : " << infeasible_count << endl;
+		cout << "created labels : " << created_label_count << endl;
+		cout << "pruned labels : " << pruned_label_count << endl;
+
+		if(route_with_break_count == 0)
+			throw runtime_error("No route needed a break, the test is not meaningful");
+
+		cout << "No error with break queries found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,151 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/bit_vector.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string ch_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " first_out_file head_file weight_file ch_file" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			ch_file = argv[4];
+		}
+
+		cout << "Loading graph ... " << flush;
+
+		vector<unsigned>first_out = load_vector<unsigned>(first_out_file);
+		vector<unsigned>head = load_vector<unsigned>(head_file);
+		vector<unsigned>weight = load_vector<unsigned>(weight_file);
+		vector<unsigned>tail = invert_inverse_vector(first_out);
+
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+
+		cout << "Building core CH ... " << flush;
+
+		std::vector<unsigned>rank = ContractionHierarchy::load_file(ch_file).rank;
+
+		BitVector is_core_node(node_count, false);
+		for(unsigned i=0; i<node_count/100; ++i)
+			is_core_node.set(rand() % node_count);
+
+		std::vector<unsigned>core;
+		ContractionHierarchy core_ch;
+		std::tie(core, core_ch) = ContractionHierarchy::build_excluding_core(rank, is_core_node, tail, head, weight, 0.02);
+
+		cout << "done" << endl;
+
+		if(!std::equal(core.begin(), core.end(), core_ch.order.end() - core.size()))
+			throw runtime_error("core nodes are not the highest ranked nodes");
+		for(unsigned x=0; x<node_count; ++x)
+			if(is_core_node.is_set(x) && core_ch.rank[x] < node_count - core.size())
+				throw runtime_error("node that must be in the core was contracted");
+
+		CoreContractionHierarchyQuery query(core_ch, core.size());
+		Dijkstra dij(first_out, tail, head);
+
+		const unsigned query_count = 200;
+
+		{
+			long long time = -get_micro_time();
+			cout << "Running one-to-one queries ... " << flush;
+
+			for(unsigned i=0; i<query_count; ++i){
+				unsigned s = rand() % node_count;
+				unsigned t = rand() % node_count;
+
+				dij.reset().add_source(s);
+				while(!dij.is_finished() && !dij.was_node_reached(t))
+					dij.settle(ScalarGetWeight(weight));
+				unsigned expected = dij.get_distance_to(t);
+
+				query.reset().add_source(s).add_target(t).run();
+				if(query.get_distance() != expected)
+					throw runtime_error("Core CH distance is not correct");
+
+				if(expected == inf_weight)
+					continue;
+
+				if(query.get_used_source() != s || query.get_used_target() != t)
+					throw runtime_error("Wrong used source or target");
+
+				auto arc_path = query.get_arc_path();
+				auto node_path = query.get_node_path();
+				if(node_path.size() != arc_path.size()+1)
+					throw runtime_error("Node and arc path do not fit together");
+				if(node_path.front() != s || node_path.back() != t)
+					throw runtime_error("Path does not connect source and target");
+
+				unsigned path_length = 0;
+				for(unsigned j=0; j<arc_path.size(); ++j){
+					if(tail[arc_path[j]] != node_path[j] || head[arc_path[j]] != node_path[j+1])
+						throw runtime_error("Path is not connected");
+					path_length += weight[arc_path[j]];
+				}
+				if(path_length != expected)
+					throw runtime_error("Path length is not correct");
+			}
+
+			time += get_micro_time();
+
+			cout << "done ["<<time << "musec]" << endl;
+		}
+
+		{
+			const unsigned
+				source_count = 20,
+				target_count = 100;
+
+			std::vector<unsigned>target_list(target_count);
+			for(unsigned i=0; i<target_count; ++i)
+				target_list[i] = rand() % node_count;
+
+			long long time = -get_micro_time();
+			cout << "Running pinned target queries ... " << flush;
+
+			query.reset().pin_targets(target_list);
+			for(unsigned i=0; i<source_count; ++i){
+				unsigned s = rand() % node_count;
+				auto d = query.reset_source().add_source(s).run_to_pinned_targets().get_distances_to_targets();
+
+				dij.reset().add_source(s);
+				while(!dij.is_finished())
+					dij.settle(ScalarGetWeight(weight));
+				for(unsigned j=0; j<target_count; ++j)
+					if(d[j] != dij.get_distance_to(target_list[j]))
+						throw runtime_error("Core CH pinned target distance is not correct");
+			}
+
+			time += get_micro_time();
+
+			cout << "done ["<<time << "musec]" << endl;
+		}
+
+		cout << "No error with core CH queries found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
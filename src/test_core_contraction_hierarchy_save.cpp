@@ -0,0 +1,189 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/bit_vector.h>
+#include <routingkit/min_max.h>
+#include <routingkit/timer.h>
+
+#include <experimental/filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = std::experimental::filesystem;
+
+using namespace RoutingKit;
+using namespace std;
+
+namespace{
+	// A saved core CH consists of a forward and a backward graph over the ranks. The contracted nodes only
+	// have upward arcs and the core nodes have all their arcs. A shortest path therefore consists of a
+	// path in the forward graph and a path in the backward graph that meet in some node.
+	struct SavedCoreCH{
+		explicit SavedCoreCH(const string&dir){
+			rank = load_vector<unsigned>(dir + "/rank");
+			order = load_vector<unsigned>(dir + "/order");
+			core = load_vector<unsigned>(dir + "/core");
+			// The first_out vectors are stored with the width of CHArcID.
+			for(CHArcID a : load_vector<CHArcID>(dir + "/forward/first_out"))
+				forward_first_out.push_back(a);
+			forward_head = load_vector<unsigned>(dir + "/forward/head");
+			forward_weight = load_vector<unsigned>(dir + "/forward/travel_time");
+			for(CHArcID a : load_vector<CHArcID>(dir + "/backward/first_out"))
+				backward_first_out.push_back(a);
+			backward_head = load_vector<unsigned>(dir + "/backward/head");
+			backward_weight = load_vector<unsigned>(dir + "/backward/travel_time");
+
+			const unsigned node_count = rank.size();
+			if(order.size() != node_count || forward_first_out.size() != node_count+1 || backward_first_out.size() != node_count+1)
+				throw runtime_error("The core CH in "+dir+" has inconsistent node counts");
+			if(forward_first_out.back() != forward_head.size() || forward_head.size() != forward_weight.size())
+				throw runtime_error("The forward graph of the core CH in "+dir+" is inconsistent");
+			if(backward_first_out.back() != backward_head.size() || backward_head.size() != backward_weight.size())
+				throw runtime_error("The backward graph of the core CH in "+dir+" is inconsistent");
+			if(!core.empty() && (!std::equal(core.begin(), core.end(), order.end() - core.size())))
+				throw runtime_error("The core nodes of the core CH in "+dir+" are not the highest ranked nodes");
+
+			const unsigned first_core_rank = node_count - core.size();
+			for(unsigned x=0; x<first_core_rank; ++x){
+				for(unsigned xy=forward_first_out[x]; xy<forward_first_out[x+1]; ++xy)
+					if(forward_head[xy] <= x)
+						throw runtime_error("The forward graph of the core CH in "+dir+" has a downward arc at a contracted node");
+				for(unsigned xy=backward_first_out[x]; xy<backward_first_out[x+1]; ++xy)
+					if(backward_head[xy] <= x)
+						throw runtime_error("The backward graph of the core CH in "+dir+" has a downward arc at a contracted node");
+			}
+		}
+
+		vector<unsigned>rank, order, core;
+		vector<unsigned>forward_first_out, forward_head, forward_weight;
+		vector<unsigned>backward_first_out, backward_head, backward_weight;
+	};
+
+	void check_saved_core_ch(const string&dir, unsigned expected_core_size, const BitVector&is_core_node, const vector<unsigned>&first_out, const vector<unsigned>&tail, const vector<unsigned>&head, const vector<unsigned>&weight){
+		cout << "Checking core CH in " << dir << " ... " << flush;
+
+		SavedCoreCH core_ch(dir);
+		const unsigned node_count = first_out.size()-1;
+
+		if(core_ch.rank.size() != node_count)
+			throw runtime_error("The core CH in "+dir+" has the wrong node count");
+		if(core_ch.core.size() != expected_core_size)
+			throw runtime_error("The core CH in "+dir+" has "+std::to_string(core_ch.core.size())+" core nodes instead of "+std::to_string(expected_core_size));
+		for(unsigned x=0; x<node_count; ++x)
+			if(is_core_node.is_set(x) && core_ch.rank[x] < node_count - core_ch.core.size())
+				throw runtime_error("A node that must be in the core was contracted in "+dir);
+
+		Dijkstra dij(first_out, tail, head);
+		Dijkstra forward_dij(core_ch.forward_first_out, invert_inverse_vector(core_ch.forward_first_out), core_ch.forward_head);
+		Dijkstra backward_dij(core_ch.backward_first_out, invert_inverse_vector(core_ch.backward_first_out), core_ch.backward_head);
+
+		const unsigned query_count = 20;
+		for(unsigned i=0; i<query_count; ++i){
+			unsigned s = rand() % node_count;
+			unsigned t = rand() % node_count;
+
+			dij.reset().add_source(s);
+			while(!dij.is_finished() && !dij.was_node_reached(t))
+				dij.settle(ScalarGetWeight(weight));
+			unsigned expected = dij.get_distance_to(t);
+
+			forward_dij.reset().add_source(core_ch.rank[s]);
+			while(!forward_dij.is_finished())
+				forward_dij.settle(ScalarGetWeight(core_ch.forward_weight));
+			backward_dij.reset().add_source(core_ch.rank[t]);
+			while(!backward_dij.is_finished())
+				backward_dij.settle(ScalarGetWeight(core_ch.backward_weight));
+
+			unsigned distance = inf_weight;
+			for(unsigned x=0; x<node_count; ++x)
+				if(forward_dij.was_node_reached(x) && backward_dij.was_node_reached(x))
+					min_to(distance, forward_dij.get_distance_to(x) + backward_dij.get_distance_to(x));
+
+			if(distance != expected)
+				throw runtime_error("The distance from "+std::to_string(s)+" to "+std::to_string(t)+" in the core CH in "+dir+" is "+std::to_string(distance)+" but should be "+std::to_string(expected));
+		}
+
+		cout << "done" << endl;
+	}
+}
+
+int main(int argc, char*argv[]){
+
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string ch_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " first_out_file head_file weight_file ch_file" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			ch_file = argv[4];
+		}
+
+		cout << "Loading graph ... " << flush;
+
+		vector<unsigned>first_out = load_vector<unsigned>(first_out_file);
+		vector<unsigned>head = load_vector<unsigned>(head_file);
+		vector<unsigned>weight = load_vector<unsigned>(weight_file);
+		vector<unsigned>tail = invert_inverse_vector(first_out);
+
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+
+		std::vector<unsigned>rank = ContractionHierarchy::load_file(ch_file).rank;
+
+		BitVector is_core_node(node_count, false);
+		for(unsigned i=0; i<node_count/100; ++i)
+			is_core_node.set(rand() % node_count);
+
+		const string export_dir = (fs::temp_directory_path() / "routingkit_test_core_contraction_hierarchy_save").string();
+		fs::remove_all(export_dir);
+
+		const vector<double>rel_core_sizes = {0.2, 0.1, 0.05};
+		const vector<string>core_ch_dir_names = {"core_ch_0.2", "core_ch_0.1", "core_ch_0.05"};
+
+		cout << "Building and saving core CHs ... " << flush;
+		long long timer = -get_micro_time();
+		ContractionHierarchy::build_and_save_core_contraction_hierarchies(rank, is_core_node, tail, head, weight, export_dir, rel_core_sizes);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		for(unsigned i=0; i<rel_core_sizes.size(); ++i){
+			// A core CH is saved after the node at position (1-rel_core_size)*node_count in the order is contracted.
+			const unsigned expected_core_size = node_count - (unsigned)((1.0 - rel_core_sizes[i]) * node_count) - 1;
+			check_saved_core_ch(export_dir + "/" + core_ch_dir_names[i], expected_core_size, is_core_node, first_out, tail, head, weight);
+		}
+		check_saved_core_ch(export_dir + "/core_ch", is_core_node.count_true(), is_core_node, first_out, tail, head, weight);
+
+		cout << "Building core CHs with unreachable core sizes ... " << flush;
+		for(double rel_core_size : {0.001, 1.5, -0.5}){
+			bool was_rejected = false;
+			try{
+				ContractionHierarchy::build_and_save_core_contraction_hierarchies(rank, is_core_node, tail, head, weight, export_dir, {0.1, rel_core_size});
+			}catch(runtime_error&){
+				was_rejected = true;
+			}
+			if(!was_rejected)
+				throw runtime_error("The unreachable core size "+std::to_string(rel_core_size)+" was accepted");
+		}
+		cout << "done" << endl;
+		cout << "Unreachable core sizes were rejected" << endl;
+
+		fs::remove_all(export_dir);
+
+		cout << "No error with saved core CHs found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
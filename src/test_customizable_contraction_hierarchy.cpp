@@ -8,6 +8,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <vector>
+#include <string>
 
 using namespace RoutingKit;
 using namespace std;
@@ -49,7 +50,26 @@ int main(int argc, char*argv[]){
 		timer += get_micro_time();
 
 		cout << "Total time spent building CCH is " << timer << "musec" << endl;
-		
+
+		cout << "Building CCH using 4 threads ... " << flush;
+
+		timer = -get_micro_time();
+		CustomizableContractionHierarchy parallel_cch(cch_order, invert_inverse_vector(first_out), head, [](const std::string&){}, true, 4);
+		timer += get_micro_time();
+
+		cout << "done [" << timer << "musec]" << endl;
+
+		auto serialize = [](const CustomizableContractionHierarchy&x){
+			std::string data;
+			x.write([&](const char*p, unsigned long long n){ data.append(p, n); });
+			return data;
+		};
+
+		if(serialize(cch) != serialize(parallel_cch))
+			throw std::runtime_error("Parallel CCH construction is broken");
+		else
+			cout << "Parallel CCH construction is ok" << endl;
+
 
 	}catch(exception&err){
 		cerr << "Stopped on exception : " << err.what() << endl;
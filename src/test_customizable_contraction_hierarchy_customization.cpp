@@ -87,6 +87,74 @@ int main(int argc, char*argv[]){
 		}
 		#endif
 
+		cout << "Constructing Subtree Parallelization data structures ... " << flush;
+		timer = -get_micro_time();
+		CustomizableContractionHierarchySubtreeParallelization subtree_customization(cch);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		cout << "Subtree Parallel CCH Customization ... " << flush;
+		timer = -get_micro_time();
+		CustomizableContractionHierarchyMetric subtree_metric(cch, weight);
+		subtree_customization.customize(subtree_metric, 4);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		if(reference_metric.forward != subtree_metric.forward || reference_metric.backward != subtree_metric.backward){
+			throw std::runtime_error("Subtree Parallel Customization is broken");
+		}else{
+			cout << "Subtree Parallel Customization is ok" << endl;
+		}
+
+		cout << "Subtree Parallel CCH Customization with filtered arcs ... " << flush;
+		{
+			CustomizableContractionHierarchy filtered_cch(cch_order, invert_inverse_vector(first_out), head, [](const std::string&){}, true);
+			CustomizableContractionHierarchyMetric filtered_reference_metric(filtered_cch, weight);
+			filtered_reference_metric.customize();
+			CustomizableContractionHierarchyMetric filtered_subtree_metric(filtered_cch, weight);
+			CustomizableContractionHierarchySubtreeParallelization(filtered_cch).customize(filtered_subtree_metric, 4);
+			cout << "done" << endl;
+
+			if(filtered_reference_metric.forward != filtered_subtree_metric.forward || filtered_reference_metric.backward != filtered_subtree_metric.backward)
+				throw std::runtime_error("Subtree Parallel Customization with filtered arcs is broken");
+			else
+				cout << "Subtree Parallel Customization with filtered arcs is ok" << endl;
+		}
+
+		cout << "Enumerating lower triangles ... " << flush;
+		timer = -get_micro_time();
+		CustomizableContractionHierarchyTriangles triangles(cch);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec, " << triangles.triangle_count() << " triangles in " << triangles.run_count() << " runs]" << endl;
+
+		for(unsigned thread_count : {1, 4}){
+			cout << "CCH Customization using stored triangles on " << thread_count << " threads ... " << flush;
+			timer = -get_micro_time();
+			CustomizableContractionHierarchyMetric triangle_metric(cch, weight);
+			triangles.customize(triangle_metric, thread_count);
+			timer += get_micro_time();
+			cout << "done [" << timer << "musec]" << endl;
+
+			if(reference_metric.forward != triangle_metric.forward || reference_metric.backward != triangle_metric.backward)
+				throw std::runtime_error("Customization using stored triangles is broken");
+		}
+		cout << "Customization using stored triangles is ok" << endl;
+
+		cout << "CCH Customization using stored triangles with filtered arcs ... " << flush;
+		{
+			CustomizableContractionHierarchy filtered_cch(cch_order, invert_inverse_vector(first_out), head, [](const std::string&){}, true);
+			CustomizableContractionHierarchyMetric filtered_reference_metric(filtered_cch, weight);
+			filtered_reference_metric.customize();
+			CustomizableContractionHierarchyMetric filtered_triangle_metric(filtered_cch, weight);
+			CustomizableContractionHierarchyTriangles(filtered_cch).customize(filtered_triangle_metric, 4);
+			cout << "done" << endl;
+
+			if(filtered_reference_metric.forward != filtered_triangle_metric.forward || filtered_reference_metric.backward != filtered_triangle_metric.backward)
+				throw std::runtime_error("Customization using stored triangles with filtered arcs is broken");
+			else
+				cout << "Customization using stored triangles with filtered arcs is ok" << endl;
+		}
+
 		CustomizableContractionHierarchyMetric partial_metric = reference_metric;
 		CustomizableContractionHierarchyPartialCustomization partial_update(cch);
 
@@ -139,6 +207,49 @@ int main(int argc, char*argv[]){
 		}
 		cout << "Partial Customization is ok" << endl;
 
+		cout << "Constructing Parallel Partial Customization data structures ... " << flush;
+		timer = -get_micro_time();
+		CustomizableContractionHierarchyParallelPartialCustomization parallel_partial_update(cch);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		CustomizableContractionHierarchyMetric parallel_partial_metric = reference_metric;
+		CustomizableContractionHierarchyMetric old_metric = reference_metric;
+
+		cout << "Parallel Partial Customization ... " << flush;
+		{
+			vector<unsigned>changed_arc, changed_weight;
+			for(unsigned i=0; i<10000; ++i){
+				changed_arc.push_back(rand()%head.size());
+				changed_weight.push_back(rand()%1000);
+			}
+			timer = -get_micro_time();
+			parallel_partial_update.update_weights(weight, changed_arc, changed_weight);
+			parallel_partial_update.customize(parallel_partial_metric, 4);
+			timer += get_micro_time();
+		}
+		cout << "done [" << timer << "musec]" << endl;
+
+		reference_metric.customize();
+
+		if(reference_metric.forward != parallel_partial_metric.forward || reference_metric.backward != parallel_partial_metric.backward)
+			throw std::runtime_error("Parallel Partial Customization is broken");
+
+		{
+			vector<unsigned>expected_changed_arc;
+			for(unsigned a=0; a<reference_metric.forward.size(); ++a)
+				if(reference_metric.forward[a] != old_metric.forward[a] || reference_metric.backward[a] != old_metric.backward[a])
+					expected_changed_arc.push_back(a);
+			if(expected_changed_arc != parallel_partial_update.get_changed_cch_arcs())
+				throw std::runtime_error("Parallel Partial Customization reports the wrong changed arcs");
+		}
+
+		parallel_partial_update.customize(parallel_partial_metric, 4);
+		if(!parallel_partial_update.get_changed_cch_arcs().empty() || reference_metric.forward != parallel_partial_metric.forward)
+			throw std::runtime_error("Nop Parallel Partial Customization is broken");
+
+		cout << "Parallel Partial Customization is ok" << endl;
+
 	}catch(exception&err){
 		cerr << "Stopped on exception : " << err.what() << endl;
 		return 1;
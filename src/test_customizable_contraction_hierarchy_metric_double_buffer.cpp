@@ -0,0 +1,169 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+#include <routingkit/customizable_contraction_hierarchy_metric_double_buffer.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <random>
+#include <thread>
+#include <atomic>
+
+using namespace RoutingKit;
+using namespace std;
+
+namespace{
+	struct QueryResult{
+		unsigned long long epoch;
+		unsigned source, target, distance;
+	};
+}
+
+int main(int argc, char*argv[]){
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string cch_order_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " first_out head weight_file cch_order" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			cch_order_file = argv[4];
+		}
+
+		long long timer;
+
+		cout << "Loading Graph ... " << flush;
+
+		auto first_out = load_vector<unsigned>(first_out_file);
+		auto head = load_vector<unsigned>(head_file);
+		auto weight = load_vector<unsigned>(weight_file);
+
+		cout << "done" << endl;
+
+		cout << "Loading order ... " << flush;
+
+		auto cch_order = load_vector<unsigned>(cch_order_file);
+
+		cout << "done" << endl;
+
+		cout << "Building CCH ... " << flush;
+
+		CustomizableContractionHierarchy cch(cch_order, invert_inverse_vector(first_out), head);
+
+		cout << "done" << endl;
+
+		const unsigned node_count = cch.node_count();
+		const unsigned arc_count = cch.input_arc_count();
+		const unsigned update_count = 8;
+		const unsigned reader_count = 3;
+
+		// The input weights of every epoch, used to check the queries afterwards.
+		vector<vector<unsigned>>epoch_weight = {weight};
+
+		CustomizableContractionHierarchyMetricDoubleBuffer metric_buffer(cch, weight);
+
+		if(metric_buffer.get_epoch() != 0)
+			throw runtime_error("Initial epoch is not 0");
+
+		atomic<bool>stop(false);
+		vector<vector<QueryResult>>result(reader_count);
+		vector<thread>reader;
+		for(unsigned r=0; r<reader_count; ++r){
+			reader.emplace_back(
+				[&, r]{
+					std::minstd_rand gen(r);
+					CustomizableContractionHierarchyQuery query;
+					while(!stop.load()){
+						auto snapshot = metric_buffer.get_snapshot();
+						unsigned s = gen() % node_count;
+						unsigned t = gen() % node_count;
+						query.reset(snapshot.get_metric()).add_source(s).add_target(t).run();
+						result[r].push_back({snapshot.get_epoch(), s, t, query.get_distance()});
+					}
+				}
+			);
+		}
+
+		cout << "Updating weights while querying ... " << flush;
+
+		std::minstd_rand gen(42);
+		timer = -get_micro_time();
+		for(unsigned i=0; i<update_count; ++i){
+			vector<unsigned>w = epoch_weight.back();
+			unsigned long long epoch;
+			if(i % 3 == 2){
+				for(auto&x:w)
+					x = x * (1 + gen() % 2);
+				epoch = metric_buffer.update_all_weights(w);
+			}else{
+				vector<unsigned>changed_arc, changed_weight;
+				for(unsigned j=0; j<100; ++j){
+					unsigned a = gen() % arc_count;
+					changed_arc.push_back(a);
+					changed_weight.push_back(gen() % 1000);
+					w[a] = changed_weight.back();
+				}
+				epoch = metric_buffer.update_some_weights(changed_arc, changed_weight);
+			}
+			epoch_weight.push_back(w);
+			if(epoch != i+1 || metric_buffer.get_epoch() != i+1)
+				throw runtime_error("Update "+std::to_string(i)+" has the wrong epoch");
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		timer += get_micro_time();
+		stop.store(true);
+		for(auto&t:reader)
+			t.join();
+
+		cout << "done [" << timer << "musec]" << endl;
+
+		cout << "Checking queries ... " << flush;
+
+		vector<CustomizableContractionHierarchyMetric>reference_metric;
+		for(auto&w:epoch_weight){
+			reference_metric.emplace_back(cch, w);
+			reference_metric.back().customize();
+		}
+
+		unsigned long long query_count = 0;
+		CustomizableContractionHierarchyQuery reference_query;
+		for(unsigned r=0; r<reader_count; ++r){
+			unsigned long long last_epoch = 0;
+			for(auto&q:result[r]){
+				if(q.epoch > update_count)
+					throw runtime_error("Snapshot has an unknown epoch");
+				if(q.epoch < last_epoch)
+					throw runtime_error("Epoch of the snapshots of one thread went backwards");
+				last_epoch = q.epoch;
+				reference_query.reset(reference_metric[q.epoch]).add_source(q.source).add_target(q.target).run();
+				if(reference_query.get_distance() != q.distance)
+					throw runtime_error("Query on epoch "+std::to_string(q.epoch)+" is wrong; reference = "+std::to_string(reference_query.get_distance())+" computed = "+std::to_string(q.distance));
+				++query_count;
+			}
+		}
+
+		cout << "done [" << query_count << " queries]" << endl;
+
+		auto snapshot = metric_buffer.get_snapshot();
+		if(snapshot.get_epoch() != update_count)
+			throw runtime_error("Snapshot does not have the last epoch");
+		if(snapshot.get_metric().forward != reference_metric.back().forward || snapshot.get_metric().backward != reference_metric.back().backward)
+			throw runtime_error("Metric of the last epoch is wrong");
+		snapshot.release();
+
+		cout << "No error with double buffered metrics found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
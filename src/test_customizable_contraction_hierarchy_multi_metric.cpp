@@ -0,0 +1,130 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <random>
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string cch_order_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " first_out head weight_file cch_order" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			cch_order_file = argv[4];
+		}
+
+		long long timer;
+
+		cout << "Loading Graph ... " << flush;
+
+		auto first_out = load_vector<unsigned>(first_out_file);
+		auto head = load_vector<unsigned>(head_file);
+		auto weight = load_vector<unsigned>(weight_file);
+
+		cout << "done" << endl;
+
+		cout << "Loading order ... " << flush;
+
+		auto cch_order = load_vector<unsigned>(cch_order_file);
+
+		cout << "done" << endl;
+
+		cout << "Building CCH ... " << flush;
+
+		timer = -get_micro_time();
+		CustomizableContractionHierarchy cch(cch_order, invert_inverse_vector(first_out), head);
+		timer += get_micro_time();
+
+		cout << "done [" << timer << "musec]" << endl;
+
+		// More metrics than fit into one group, so that a partially filled group is also tested.
+		const unsigned metric_count = 11;
+
+		std::minstd_rand gen(42);
+		vector<vector<unsigned>>input_weight(metric_count, weight);
+		for(unsigned i=1; i<metric_count; ++i){
+			for(auto&w:input_weight[i]){
+				if(i % 4 == 1)
+					w = gen() % 1000;
+				else if(i % 4 == 2)
+					w = w * (1 + gen() % 3);
+				else if(i % 4 == 3 && gen() % 100 == 0)
+					w = inf_weight;
+			}
+		}
+
+		cout << "Separate CCH Customizations ... " << flush;
+
+		vector<CustomizableContractionHierarchyMetric>reference_metric;
+		timer = -get_micro_time();
+		for(unsigned i=0; i<metric_count; ++i){
+			reference_metric.emplace_back(cch, input_weight[i]);
+			reference_metric.back().customize();
+		}
+		timer += get_micro_time();
+
+		cout << "done [" << timer << "musec]" << endl;
+
+		cout << "Multi-Metric CCH Customization ... " << flush;
+
+		timer = -get_micro_time();
+		CustomizableContractionHierarchyMultiMetric multi_metric(cch, input_weight);
+		multi_metric.customize();
+		timer += get_micro_time();
+
+		cout << "done [" << timer << "musec]" << endl;
+
+		if(multi_metric.metric_count() != metric_count)
+			throw std::runtime_error("Multi-Metric has the wrong number of metrics");
+
+		for(unsigned i=0; i<metric_count; ++i){
+			if(reference_metric[i].forward != multi_metric.get_metric(i).forward || reference_metric[i].backward != multi_metric.get_metric(i).backward)
+				throw std::runtime_error("Multi-Metric Customization is broken for metric "+std::to_string(i));
+		}
+
+		cout << "Multi-Metric Customization is ok" << endl;
+
+		cout << "Running queries ... " << flush;
+
+		CustomizableContractionHierarchyQuery reference_query(reference_metric[0]);
+		CustomizableContractionHierarchyQuery multi_metric_query(multi_metric.get_metric(0));
+		const unsigned node_count = cch.node_count();
+		for(unsigned q=0; q<1000; ++q){
+			unsigned s = gen() % node_count;
+			unsigned t = gen() % node_count;
+			unsigned i = q % metric_count;
+
+			reference_query.reset(reference_metric[i]).add_source(s).add_target(t).run();
+			multi_metric_query.reset(multi_metric.get_metric(i)).add_source(s).add_target(t).run();
+
+			if(reference_query.get_distance() != multi_metric_query.get_distance())
+				throw std::runtime_error("Query on metric "+std::to_string(i)+" selected from the Multi-Metric is wrong");
+			if(reference_query.get_arc_path() != multi_metric_query.get_arc_path())
+				throw std::runtime_error("Path on metric "+std::to_string(i)+" selected from the Multi-Metric is wrong");
+		}
+
+		cout << "done" << endl;
+
+		cout << "No error with Multi-Metric CCH found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -115,6 +115,30 @@ int main(int argc, char*argv[]){
 
 				auto arc_path = cch_query.get_arc_path();
 
+				const QueryStatistics&statistics = cch_query.get_statistics();
+				#ifdef ROUTING_KIT_QUERY_STATISTICS
+				for(const QueryStatistics::Direction&dir:{statistics.forward, statistics.backward}){
+					if(dir.elimination_tree_node_count == 0)
+						throw runtime_error("statistics have no elimination tree nodes");
+					if(dir.elimination_tree_node_count > cch.node_count())
+						throw runtime_error("statistics have more elimination tree nodes than the graph has nodes");
+					// Every elimination tree node except for the root has an upward arc to its parent.
+					if(dir.relaxed_arc_count + 1 < dir.elimination_tree_node_count)
+						throw runtime_error("statistics have fewer relaxed arcs than elimination tree nodes");
+					if(dir.settled_node_count != 0 || dir.queue_push_count != 0)
+						throw runtime_error("statistics have queue operations even though a CCH query uses no queue");
+				}
+				if(!arc_path.empty() && statistics.unpacking_depth >= arc_path.size())
+					throw runtime_error("statistics have an unpacking depth that is too large for the path");
+				#else
+				if(
+					statistics.forward.elimination_tree_node_count != 0 || statistics.backward.elimination_tree_node_count != 0 ||
+					statistics.forward.relaxed_arc_count != 0 || statistics.backward.relaxed_arc_count != 0 ||
+					statistics.unpacking_depth != 0 || statistics.unpacking_time != 0
+				)
+					throw runtime_error("statistics are recorded even though ROUTING_KIT_QUERY_STATISTICS is not defined");
+				#endif
+
 				if(source[i] == target[i]){
 					if(!arc_path.empty())
 						throw runtime_error("if s == t then the path should be empty");
@@ -195,6 +195,27 @@ int main(int argc, char*argv[]){
 			cout << "No error with pinned target found" << endl;
 		}
 
+		std::vector<unsigned>batched_source_result;
+
+		{
+			timer = -get_micro_time();
+			cout << "Running batched sources to pinned targets ... " << flush;
+
+			CustomizableContractionHierarchyQuery ch_query(metric);
+			ch_query.reset().pin_targets(target_set);
+			batched_source_result = ch_query.get_distances_from_sources_to_pinned_targets(source_set);
+
+			timer += get_micro_time();
+
+			cout << "done [" << timer << "musec]" << endl;
+		}
+
+		if(batched_source_result != optimal_result){
+			cout << "Batched sources are not correct" << endl;
+		} else {
+			cout << "No error with batched sources found" << endl;
+		}
+
 	}catch(exception&err){
 		cerr << "Stopped on exception : " << err.what() << endl;
 		return 1;
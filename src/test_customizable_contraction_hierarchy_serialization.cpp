@@ -0,0 +1,179 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+using namespace RoutingKit;
+using namespace std;
+
+namespace{
+	struct MemoryFile{
+		string data;
+		unsigned long long pos = 0;
+
+		std::function<void(const char*, unsigned long long)> writer(){
+			return [this](const char*p, unsigned long long l){ data.append(p, l); };
+		}
+
+		std::function<void(char*, unsigned long long)> reader(){
+			pos = 0;
+			return [this](char*p, unsigned long long l){
+				if(pos + l > data.size())
+					throw runtime_error("read past the end of the file");
+				std::copy(data.begin() + pos, data.begin() + pos + l, p);
+				pos += l;
+			};
+		}
+	};
+
+	template<class T>
+	void check_equal(const T&l, const T&r, const string&name){
+		if(!(l == r))
+			throw runtime_error(name+" differs after reading the CCH");
+	}
+}
+
+int main(int argc, char*argv[]){
+
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string cch_order_file;
+		string source_file;
+		string target_file;
+		string distance_file;
+
+		if(argc != 8){
+			cerr << argv[0] << " first_out head weight cch_order source target distance" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			cch_order_file = argv[4];
+			source_file = argv[5];
+			target_file = argv[6];
+			distance_file = argv[7];
+		}
+
+		cout << "Loading Graph ... " << flush;
+
+		auto first_out = load_vector<unsigned>(first_out_file);
+		auto head = load_vector<unsigned>(head_file);
+		auto weight = load_vector<unsigned>(weight_file);
+		auto cch_order = load_vector<unsigned>(cch_order_file);
+		auto source = load_vector<unsigned>(source_file);
+		auto target = load_vector<unsigned>(target_file);
+		auto ref_distance = load_vector<unsigned>(distance_file);
+
+		cout << "done" << endl;
+
+		long long build_time = -get_micro_time();
+		CustomizableContractionHierarchy cch(cch_order, invert_inverse_vector(first_out), head);
+		build_time += get_micro_time();
+
+		MemoryFile cch_file;
+		cch.write(cch_file.writer());
+
+		long long read_time = -get_micro_time();
+		CustomizableContractionHierarchy read_cch = CustomizableContractionHierarchy::read(cch_file.reader(), cch_file.data.size());
+		read_time += get_micro_time();
+
+		if(cch_file.pos != cch_file.data.size())
+			throw runtime_error("CCH file was not read completely");
+
+		cout << "CCH file size : " << cch_file.data.size() << " bytes" << endl;
+		cout << "building CCH : " << build_time << "musec" << endl;
+		cout << "reading CCH : " << read_time << "musec" << endl;
+
+		check_equal(read_cch.order, cch.order, "order");
+		check_equal(read_cch.rank, cch.rank, "rank");
+		check_equal(read_cch.elimination_tree_parent, cch.elimination_tree_parent, "elimination_tree_parent");
+		check_equal(read_cch.up_first_out, cch.up_first_out, "up_first_out");
+		check_equal(read_cch.up_head, cch.up_head, "up_head");
+		check_equal(read_cch.up_tail, cch.up_tail, "up_tail");
+		check_equal(read_cch.down_first_out, cch.down_first_out, "down_first_out");
+		check_equal(read_cch.down_head, cch.down_head, "down_head");
+		check_equal(read_cch.down_to_up, cch.down_to_up, "down_to_up");
+		check_equal(read_cch.input_arc_to_cch_arc, cch.input_arc_to_cch_arc, "input_arc_to_cch_arc");
+		check_equal(read_cch.is_input_arc_upward, cch.is_input_arc_upward, "is_input_arc_upward");
+		check_equal(read_cch.does_cch_arc_have_input_arc, cch.does_cch_arc_have_input_arc, "does_cch_arc_have_input_arc");
+		check_equal(read_cch.forward_input_arc_of_cch, cch.forward_input_arc_of_cch, "forward_input_arc_of_cch");
+		check_equal(read_cch.backward_input_arc_of_cch, cch.backward_input_arc_of_cch, "backward_input_arc_of_cch");
+		check_equal(read_cch.does_cch_arc_have_extra_input_arc, cch.does_cch_arc_have_extra_input_arc, "does_cch_arc_have_extra_input_arc");
+		check_equal(read_cch.first_extra_forward_input_arc_of_cch, cch.first_extra_forward_input_arc_of_cch, "first_extra_forward_input_arc_of_cch");
+		check_equal(read_cch.first_extra_backward_input_arc_of_cch, cch.first_extra_backward_input_arc_of_cch, "first_extra_backward_input_arc_of_cch");
+		check_equal(read_cch.extra_forward_input_arc_of_cch, cch.extra_forward_input_arc_of_cch, "extra_forward_input_arc_of_cch");
+		check_equal(read_cch.extra_backward_input_arc_of_cch, cch.extra_backward_input_arc_of_cch, "extra_backward_input_arc_of_cch");
+
+		for(unsigned a=0; a<cch.cch_arc_count(); ++a){
+			if(read_cch.does_cch_arc_have_input_arc.is_set(a) && read_cch.does_cch_arc_have_input_arc_mapper.to_local(a) != cch.does_cch_arc_have_input_arc_mapper.to_local(a))
+				throw runtime_error("does_cch_arc_have_input_arc_mapper differs after reading the CCH");
+			if(read_cch.does_cch_arc_have_extra_input_arc.is_set(a) && read_cch.does_cch_arc_have_extra_input_arc_mapper.to_local(a) != cch.does_cch_arc_have_extra_input_arc_mapper.to_local(a))
+				throw runtime_error("does_cch_arc_have_extra_input_arc_mapper differs after reading the CCH");
+		}
+
+		CustomizableContractionHierarchyMetric metric(cch, weight);
+		metric.customize();
+
+		MemoryFile metric_file;
+		metric.write(metric_file.writer());
+
+		CustomizableContractionHierarchyMetric read_metric(read_cch, weight);
+		read_metric.read(metric_file.reader(), metric_file.data.size());
+
+		check_equal(read_metric.forward, metric.forward, "forward metric");
+		check_equal(read_metric.backward, metric.backward, "backward metric");
+
+		{
+			MemoryFile broken_file = cch_file;
+			broken_file.data.pop_back();
+			bool thrown = false;
+			try{
+				CustomizableContractionHierarchy::read(broken_file.reader(), broken_file.data.size());
+			}catch(std::runtime_error&){
+				thrown = true;
+			}
+			if(!thrown)
+				throw runtime_error("a truncated CCH file was accepted");
+		}
+
+		{
+			MemoryFile broken_file = cch_file;
+			broken_file.data[8] ^= 1;
+			bool thrown = false;
+			try{
+				CustomizableContractionHierarchy::read(broken_file.reader(), broken_file.data.size());
+			}catch(std::runtime_error&){
+				thrown = true;
+			}
+			if(!thrown)
+				throw runtime_error("a CCH file with a different version was accepted");
+		}
+
+		CustomizableContractionHierarchyQuery query(metric), read_query(read_metric);
+
+		for(unsigned i=0; i<source.size(); ++i){
+			query.reset().add_source(source[i]).add_target(target[i]).run();
+			read_query.reset().add_source(source[i]).add_target(target[i]).run();
+
+			if(read_query.get_distance() != ref_distance[i])
+				throw runtime_error("Distance query "+std::to_string(i)+" on the read CCH is wrong; reference = "+std::to_string(ref_distance[i])+" computed = "+std::to_string(read_query.get_distance()));
+			if(read_query.get_arc_path() != query.get_arc_path())
+				throw runtime_error("Arc path of query "+std::to_string(i)+" on the read CCH is wrong");
+		}
+
+		cout << "No error with CCH serialization found" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -52,6 +52,7 @@ int main(int argc, char*argv[]){
 		uniform_int_distribution<unsigned>node_dist(0, node_count-isolated_node_count-1);
 
 		Dijkstra dij(first_out, tail, head);
+		BasicDijkstra<RadixMinIDQueue> radix_dij(first_out, tail, head);
 		EXPECT(dij.is_finished());
 		for(unsigned test_num=0; test_num < test_count; ++test_num){
 			vector<unsigned>dist(node_count, inf_weight);
@@ -76,6 +77,12 @@ int main(int argc, char*argv[]){
 			for(unsigned x=0; x<node_count; ++x)
 				EXPECT_CMP(dist[x], ==, dij.get_distance_to(x));
 
+			radix_dij.reset().add_source(source_node, source_time);
+			while(!radix_dij.is_finished())
+				radix_dij.settle(ScalarGetWeight(weight));
+			for(unsigned x=0; x<node_count; ++x)
+				EXPECT_CMP(dist[x], ==, radix_dij.get_distance_to(x));
+
 			{
 				BitVector witness_found(node_count, false);
 				for(unsigned xy=0; xy<arc_count; ++xy){
@@ -0,0 +1,104 @@
+#include <routingkit/id_queue.h>
+
+#include "expect.h"
+
+#include <iostream>
+#include <random>
+
+using namespace RoutingKit;
+using namespace std;
+
+// Runs the same random sequence of monotone operations on a MinIDQueue and a RadixMinIDQueue
+// and checks that both pop the same elements. The low digits of every key encode the id,
+// so there are no ties and the pop order is unique.
+void run_random_operations(unsigned id_count, unsigned seed, unsigned operation_count){
+	std::minstd_rand gen(seed);
+	MinIDQueue heap(id_count);
+	RadixMinIDQueue radix(id_count);
+	unsigned last_key = 0;
+
+	for(unsigned i=0; i<operation_count; ++i){
+		unsigned id = gen() % id_count;
+		unsigned op = gen() % 3;
+		unsigned new_key = (last_key / id_count + 1 + gen() % 64) * id_count + id;
+		if(op == 0 && !heap.empty()){
+			auto p = heap.pop();
+			auto q = radix.pop();
+			EXPECT_CMP(p.id, ==, q.id);
+			EXPECT_CMP(p.key, ==, q.key);
+			EXPECT(!radix.contains_id(q.id));
+			last_key = p.key;
+		}else if(!heap.contains_id(id)){
+			EXPECT(!radix.contains_id(id));
+			heap.push({id, new_key});
+			radix.push({id, new_key});
+		}else{
+			EXPECT(radix.contains_id(id));
+			EXPECT_CMP(heap.decrease_key({id, new_key}), ==, radix.decrease_key({id, new_key}));
+			EXPECT_CMP(heap.get_key(id), ==, radix.get_key(id));
+		}
+		EXPECT_CMP(heap.size(), ==, radix.size());
+	}
+
+	while(!heap.empty()){
+		EXPECT_CMP(heap.peek().id, ==, radix.peek().id);
+		auto p = heap.pop();
+		auto q = radix.pop();
+		EXPECT_CMP(p.id, ==, q.id);
+		EXPECT_CMP(p.key, ==, q.key);
+	}
+	EXPECT(radix.empty());
+}
+
+int main(){
+	try{
+		{
+			RadixMinIDQueue q(100);
+			EXPECT_CMP(q.id_count(), ==, 100);
+			EXPECT(q.empty());
+
+			q.push({3, 30});
+			q.push({8, 5});
+			q.push({77, 1000});
+			q.push({2, 5});
+			EXPECT_CMP(q.size(), ==, 4);
+			EXPECT(q.contains_id(77));
+			EXPECT(!q.contains_id(78));
+
+			EXPECT(q.decrease_key({77, 7}));
+			EXPECT(!q.decrease_key({3, 40}));
+			EXPECT_CMP(q.get_key(77), ==, 7);
+
+			EXPECT_CMP(q.pop().key, ==, 5);
+			EXPECT_CMP(q.pop().key, ==, 5);
+			EXPECT_CMP(q.peek().id, ==, 77);
+			EXPECT_CMP(q.pop().id, ==, 77);
+
+			q.push({15, 7});
+			q.push({16, 4000000000u});
+			EXPECT_CMP(q.pop().id, ==, 15);
+			EXPECT_CMP(q.pop().id, ==, 3);
+			EXPECT_CMP(q.pop().id, ==, 16);
+			EXPECT(q.empty());
+
+			// Keys must not be smaller than the last popped key until the queue is cleared
+			q.push({4, 4000000001u});
+			q.clear();
+			EXPECT(q.empty());
+			EXPECT(!q.contains_id(4));
+
+			// After clear the keys start over
+			q.push({4, 1});
+			EXPECT_CMP(q.pop().key, ==, 1);
+		}
+
+		for(unsigned seed=0; seed<20; ++seed)
+			run_random_operations(1000, seed, 50000);
+
+		cout << "All finished" << endl;
+	}catch(std::exception&err){
+		cout << "exception" << ":" << err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}